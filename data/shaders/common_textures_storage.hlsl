@@ -136,4 +136,14 @@ RWTexture2DArray<float4> tex_uav_sss                       : register(u6);
 globallycoherent RWStructuredBuffer<uint> g_atomic_counter : register(u7); // used by FidelityFX SPD
 globallycoherent RWTexture2D<float4> tex_uav_mips[12]      : register(u8); // used by FidelityFX SPD
 
+// instance culling, see culling.hlsl
+RWStructuredBuffer<float4> culling_bounds            : register(u20); // two per instance, min and max
+RWStructuredBuffer<float4> culling_instances         : register(u21); // four per instance, the rows of the transform
+RWStructuredBuffer<float4> culling_instances_visible : register(u22); // the compacted instances
+RWStructuredBuffer<uint> culling_arguments           : register(u23); // indexed indirect draw arguments
+
+// light clusters, see light.hlsl
+RWStructuredBuffer<uint2> light_clusters      : register(u24); // offset and count into the index list, per cluster
+RWStructuredBuffer<uint> light_cluster_indices : register(u25); // the lights of each cluster, sorted
+
 #endif // SPARTAN_COMMON_TEXTURES
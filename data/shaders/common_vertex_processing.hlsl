@@ -75,14 +75,15 @@ struct vertex_processing
             return lerp(hash(i), hash(i + 1.0), f);
         }
 
-        static float3 apply_wind(uint instance_id, float3 position_vertex, float3 animation_pivot, float time)
+        static float3 apply_wind(float3 position_vertex, float3 animation_pivot, float time)
         {
             const float3 base_wind_direction    = float3(1, 0, 0);
             const float wind_vertex_sway_extent = 0.4f; // oscillation amplitude
             const float wind_vertex_sway_speed  = 4.0f; // oscillation frequency
         
             // base oscillation, a combination of two sine waves with a phase difference
-            float phase_offset = float(instance_id) * PI_HALF;
+            // the phase comes from the pivot, instance ids are not stable as gpu culling compacts the instances
+            float phase_offset = hash(dot(animation_pivot.xz, float2(12.9898f, 78.233f))) * PI2;
             float phase1       = (time * wind_vertex_sway_speed) + position_vertex.x + phase_offset;
             
             // phase difference to ensure continuous motion
@@ -214,11 +215,11 @@ struct vertex_processing
         }
     };
 
-    static float3 ambient_animation(Surface surface, float3 position, float3 animation_pivot, uint instance_id, float time)
+    static float3 ambient_animation(Surface surface, float3 position, float3 animation_pivot, float time)
     {
         if (surface.vertex_animate_wind())
         {
-            position = vegetation::apply_wind(instance_id, position, animation_pivot, time);
+            position = vegetation::apply_wind(position, animation_pivot, time);
             position = vegetation::apply_player_bend(position, animation_pivot);
         }
     
@@ -422,9 +423,9 @@ gbuffer_vertex transform_to_clip_space(gbuffer_vertex vertex)
     Surface surface; surface.flags = material.flags;
     
      // apply ambient animation - done here so it can benefit from potentially tessellated surfaces
-    vertex.position          = vertex_processing::ambient_animation(surface, vertex.position, extract_position(vertex.transform), vertex.instance_id, (float)buffer_frame.time);
+    vertex.position          = vertex_processing::ambient_animation(surface, vertex.position, extract_position(vertex.transform), (float)buffer_frame.time);
 #ifndef TRANSFORM_IGNORE_PREVIOUS_POSITION
-    vertex.position_previous = vertex_processing::ambient_animation(surface, vertex.position_previous, extract_position(vertex.transform_previous), vertex.instance_id, (float)buffer_frame.time - buffer_frame.delta_time);
+    vertex.position_previous = vertex_processing::ambient_animation(surface, vertex.position_previous, extract_position(vertex.transform_previous), (float)buffer_frame.time - buffer_frame.delta_time);
 #endif
     
     vertex.position_clip          = mul(float4(vertex.position, 1.0f), buffer_frame.view_projection);
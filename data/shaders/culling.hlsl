@@ -0,0 +1,168 @@
+/*
+Copyright(c) 2016-2024 Panos Karabelas
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+copies of the Software, and to permit persons to whom the Software is furnished
+to do so, subject to the following conditions :
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE AUTHORS OR
+COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+
+//= INCLUDES =========
+#include "common.hlsl"
+//====================
+
+// per-instance culling, InstanceCulling.h is the cpu reference of this kernel and the two must stay in sync,
+// the thread group size and the instance offset come from there as defines
+
+static const uint instance_offset = CULLING_INSTANCE_OFFSET; // the first instance slot, the vertex shaders treat an instance id of 0 as non-instanced
+
+#if DEPTH_PYRAMID
+
+// reduces the depth buffer into the first mip of the (power of two) depth pyramid, the rest is done by spd
+[numthreads(THREAD_GROUP_COUNT_X, THREAD_GROUP_COUNT_Y, 1)]
+void main_cs(uint3 thread_id : SV_DispatchThreadID)
+{
+    float2 resolution_out;
+    tex_uav.GetDimensions(resolution_out.x, resolution_out.y);
+    if (any(thread_id.xy >= uint2(resolution_out)))
+        return;
+
+    // each texel covers up to 3x3 depth texels, keep the farthest one (reverse-z) so that the test stays conservative
+    float2 resolution_depth = buffer_frame.resolution_render * buffer_frame.resolution_scale;
+    float2 scale            = resolution_depth / resolution_out;
+    uint2 start             = uint2(floor(thread_id.xy * scale));
+    uint2 end               = min(uint2(ceil((thread_id.xy + 1.0f) * scale)), uint2(resolution_depth));
+
+    float depth_farthest = 1.0f;
+    for (uint y = start.y; y < end.y; y++)
+    {
+        for (uint x = start.x; x < end.x; x++)
+        {
+            depth_farthest = min(depth_farthest, tex_depth[uint2(x, y)].r);
+        }
+    }
+
+    tex_uav[thread_id.xy] = float4(depth_farthest, 0.0f, 0.0f, 0.0f);
+}
+
+#else
+
+bool is_visible(float3 box_min, float3 box_max)
+{
+    // project the corners, an instance is outside if all of them are beyond the same clip plane
+    uint outcode_all   = 0x3F;
+    bool behind_camera = false;
+    float3 ndc_min     = 1e30f;
+    float3 ndc_max     = -1e30f;
+    for (uint i = 0; i < 8; i++)
+    {
+        float3 corner = float3(
+            (i & 1) ? box_max.x : box_min.x,
+            (i & 2) ? box_max.y : box_min.y,
+            (i & 4) ? box_max.z : box_min.z
+        );
+        float4 clip = mul(float4(corner, 1.0f), buffer_frame.view_projection_unjittered);
+
+        uint outcode  = 0;
+        outcode      |= clip.x < -clip.w ? 1  : 0;
+        outcode      |= clip.x >  clip.w ? 2  : 0;
+        outcode      |= clip.y < -clip.w ? 4  : 0;
+        outcode      |= clip.y >  clip.w ? 8  : 0;
+        outcode      |= clip.z <  0.0f   ? 16 : 0; // beyond the far plane (reverse-z)
+        outcode      |= clip.z >  clip.w ? 32 : 0; // before the near plane (reverse-z)
+        outcode_all  &= outcode;
+
+        behind_camera = behind_camera || clip.w <= 0.0f;
+        float3 ndc    = clip.xyz / clip.w;
+        ndc_min       = min(ndc_min, ndc);
+        ndc_max       = max(ndc_max, ndc);
+    }
+
+    if (outcode_all != 0)
+        return false;
+
+#if OCCLUSION
+    // the projected rectangle is meaningless if the bounds cross the camera plane
+    if (behind_camera)
+        return true;
+
+    // screen space rectangle
+    float2 uv_min = saturate(float2(ndc_min.x, ndc_max.y) * float2(0.5f, -0.5f) + 0.5f);
+    float2 uv_max = saturate(float2(ndc_max.x, ndc_min.y) * float2(0.5f, -0.5f) + 0.5f);
+
+    // pick the mip where the rectangle spans at most 2x2 texels
+    float3 pyramid   = pass_get_f3_value2(); // width, height, mip count
+    float2 size      = (uv_max - uv_min) * pyramid.xy;
+    uint mip         = (uint)min(ceil(log2(max(max(size.x, size.y), 1.0f))), pyramid.z - 1.0f);
+    uint2 mip_size   = max(uint2(pyramid.xy) >> mip, 1);
+    uint2 texel_min  = min(uint2(uv_min * mip_size), mip_size - 1);
+    uint2 texel_max  = min(uint2(uv_max * mip_size), mip_size - 1);
+    if (any(texel_max - texel_min > 1))
+        return true;
+
+    float depth_farthest = min(
+        min(tex.Load(int3(texel_min, mip)).r,                tex.Load(int3(texel_max.x, texel_min.y, mip)).r),
+        min(tex.Load(int3(texel_min.x, texel_max.y, mip)).r, tex.Load(int3(texel_max, mip)).r)
+    );
+
+    // occluded if the nearest point of the bounds is behind everything it covers
+    return ndc_max.z >= depth_farthest;
+#else
+    return true;
+#endif
+}
+
+[numthreads(CULLING_THREAD_GROUP_SIZE, 1, 1)]
+void main_cs(uint3 thread_id : SV_DispatchThreadID)
+{
+    float3 parameters = pass_get_f3_value(); // instance count, reset
+
+    // reset the draw arguments, this runs as a separate dispatch before the culling one
+    if (parameters.y == 1.0f)
+    {
+        if (thread_id.x == 0)
+        {
+            uint4 arguments      = asuint(pass_get_f4_value()); // index count, index offset, vertex offset
+            culling_arguments[0] = arguments.x;
+            culling_arguments[1] = 0;
+            culling_arguments[2] = arguments.y;
+            culling_arguments[3] = arguments.z;
+            culling_arguments[4] = instance_offset;
+        }
+
+        return;
+    }
+
+    uint index = thread_id.x;
+    if (index >= (uint)parameters.x)
+        return;
+
+    if (!is_visible(culling_bounds[index * 2 + 0].xyz, culling_bounds[index * 2 + 1].xyz))
+        return;
+
+    // append
+    uint slot;
+    InterlockedAdd(culling_arguments[1], 1, slot);
+    slot += instance_offset;
+
+    [unroll]
+    for (uint row = 0; row < 4; row++)
+    {
+        culling_instances_visible[slot * 4 + row] = culling_instances[index * 4 + row];
+    }
+}
+
+#endif
@@ -49,6 +49,44 @@ float3 subsurface_scattering(Surface surface, Light light, AngularInfo angular_i
     return sss_color * F * diffuse_energy;
 }
 
+// must match LightClusters.h
+static const uint3 light_cluster_grid = uint3(16, 9, 24);
+
+bool is_in_light_cluster(Surface surface, uint light_index)
+{
+    // the clusters are only valid if the cpu built them this frame
+    if (pass_get_f3_value2().z == 0.0f)
+        return true;
+
+    // tile, and an exponential depth slice
+    float depth   = mul(float4(surface.position, 1.0f), buffer_frame.view).z;
+    float slice   = log(max(depth, buffer_frame.camera_near) / buffer_frame.camera_near) / log(buffer_frame.camera_far / buffer_frame.camera_near);
+    uint3 cluster = min(uint3(surface.uv * light_cluster_grid.xy, slice * light_cluster_grid.z), light_cluster_grid - 1);
+    uint2 range   = light_clusters[(cluster.z * light_cluster_grid.y + cluster.y) * light_cluster_grid.x + cluster.x];
+
+    // binary search
+    uint first = range.x;
+    uint last  = range.x + range.y;
+    while (first < last)
+    {
+        uint middle = (first + last) / 2;
+        uint index  = light_cluster_indices[middle];
+        if (index == light_index)
+            return true;
+
+        if (index < light_index)
+        {
+            first = middle + 1;
+        }
+        else
+        {
+            last = middle;
+        }
+    }
+
+    return false;
+}
+
 [numthreads(THREAD_GROUP_COUNT_X, THREAD_GROUP_COUNT_Y, 1)]
 void main_cs(uint3 thread_id : SV_DispatchThreadID)
 {
@@ -68,6 +106,10 @@ void main_cs(uint3 thread_id : SV_DispatchThreadID)
     Light light;
     light.Build(surface);
 
+    // pixels outside the light's clusters receive nothing, volumetric fog is gathered along the whole view ray though
+    if (!light.is_directional() && !light.is_volumetric() && !is_in_light_cluster(surface, (uint)pass_get_f3_value2().x))
+        return;
+
     float4 shadow           = 1.0f;
     float3 light_diffuse    = 0.0f;
     float3 light_specular   = 0.0f;
@@ -35,9 +35,16 @@ CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 namespace ImGui::TransformGizmo
 {
     bool first_use = true;
-    Spartan::Math::Vector3 position_previous;
-    Spartan::Math::Quaternion rotation_previous;
-    Spartan::Math::Vector3 scale_previous;
+
+    // a drag ends when the mouse is released or when the gizmo lets go (e.g. the entity was deselected)
+    void end_interaction()
+    {
+        if (first_use)
+            return;
+
+        Spartan::CommandStack::EndInteraction();
+        first_use = true;
+    }
 
     void apply_style()
     {
@@ -66,11 +73,17 @@ namespace ImGui::TransformGizmo
     static void tick()
     {
         if (Spartan::Engine::IsFlagSet(Spartan::EngineMode::Game))
+        {
+            end_interaction();
             return;
+        }
 
         std::shared_ptr<Spartan::Camera> camera = Spartan::Renderer::GetCamera();
         if (!camera)
+        {
+            end_interaction();
             return;
+        }
 
         // get selected entity
         std::shared_ptr<Spartan::Entity> entity = camera->GetSelectedEntity();
@@ -79,6 +92,7 @@ namespace ImGui::TransformGizmo
         ImGuizmo::Enable(entity != nullptr);
         if (!entity)
         {
+            end_interaction();
             return;
         }
 
@@ -127,28 +141,34 @@ namespace ImGui::TransformGizmo
         // map imguizmo to transform
         if (ImGuizmo::IsUsing())
         {
-            // start of handling - save the initial transform
             if (first_use)
             {
-                position_previous = entity->GetPosition();
-                rotation_previous = entity->GetRotation();
-                scale_previous    = entity->GetScale();
-
+                Spartan::CommandStack::BeginInteraction();
                 first_use = false;
             }
 
+            // the transform before this frame's change
+            Spartan::Math::Vector3 position_local_previous    = entity->GetPositionLocal();
+            Spartan::Math::Quaternion rotation_local_previous = entity->GetRotationLocal();
+            Spartan::Math::Vector3 scale_local_previous       = entity->GetScaleLocal();
+
             transform_matrix.Transposed().Decompose(scale, rotation, position);
             entity->SetPosition(position);
             entity->SetRotation(rotation);
             entity->SetScale(scale);
 
-            // end of handling - add the current and previous transforms to the command stack
-            if (Spartan::Input::GetKeyUp(Spartan::KeyCode::Click_Left))
+            // a command per changed frame, the stack merges them into the first one of the interaction, so the drag is a single undo step
+            bool changed = entity->GetPositionLocal() != position_local_previous || entity->GetRotationLocal() != rotation_local_previous || entity->GetScaleLocal() != scale_local_previous;
+            if (changed)
             {
-                Spartan::CommandStack::Add<Spartan::CommandTransform>(entity.get(), position_previous, rotation_previous, scale_previous);
-                first_use = true;
+                Spartan::CommandStack::Add<Spartan::CommandTransform>(entity.get(), position_local_previous, rotation_local_previous, scale_local_previous);
             }
         }
+
+        if (!ImGuizmo::IsUsing() || Spartan::Input::GetKeyUp(Spartan::KeyCode::Click_Left))
+        {
+            end_interaction();
+        }
     }
 
     static bool allow_picking()
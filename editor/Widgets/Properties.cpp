@@ -370,6 +370,8 @@ void Properties::ShowRenderable(shared_ptr<Renderable> renderable) const
         Material* material           = renderable->GetMaterial();
         uint32_t instance_count      = renderable->GetInstanceCount();
         uint32_t instance_partitions = renderable->GetInstancePartitionCount();
+        uint32_t lod_count           = renderable->GetLodCount();
+        uint32_t lod_index           = renderable->GetLodIndex();
         string name_material         = material ? material->GetObjectName() : "N/A";
         bool cast_shadows            = renderable->HasFlag(RenderableFlags::CastsShadows);
         bool is_visible              = renderable->IsVisible();
@@ -380,6 +382,14 @@ void Properties::ShowRenderable(shared_ptr<Renderable> renderable) const
         ImGui::SameLine(column_pos_x);
         ImGui::InputText("##renderable_mesh", &name_mesh, ImGuiInputTextFlags_AutoSelectAll | ImGuiInputTextFlags_ReadOnly);
 
+        // lods
+        if (lod_count > 1)
+        {
+            ImGui::Text("LOD");
+            ImGui::SameLine(column_pos_x);
+            ImGui::LabelText("##renderable_lod", (to_string(lod_index) + "/" + to_string(lod_count - 1)).c_str());
+        }
+
         // instancing
         if (instance_count != 0)
         {
@@ -408,7 +408,9 @@ void RenderOptions::OnTickVisible()
             option_check_box("Physics",                 Renderer_Option::Physics);
             option_check_box("AABBs",                   Renderer_Option::Aabb);
             option_check_box("Wireframe",               Renderer_Option::Wireframe);
-            option_check_box("Occlusion Culling (WIP)", Renderer_Option::OcclusionCulling);
+            option_check_box("Occlusion Culling",       Renderer_Option::OcclusionCulling);
+            option_check_box("GPU Culling (WIP)",       Renderer_Option::GpuCulling);
+            option_check_box("Auto Instancing",         Renderer_Option::AutoInstancing);
         }
 
         ImGui::EndTable();
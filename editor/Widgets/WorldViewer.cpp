@@ -32,6 +32,7 @@ CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 #include "World/Components/Constraint.h"
 #include "World/Components/Terrain.h"
 #include "Commands/CommandStack.h"
+#include "Commands/CommandTransform.h"
 #include "FileSystem.h"
 #include "Resource/ResourceCache.h"
 #include "../ImGui/ImGuiExtension.h"
@@ -377,6 +378,11 @@ void WorldViewer::PopupContextMenu() const
         Spartan::Renderer::GetCamera()->FocusOnSelectedEntity();
     }
 
+    if (ImGui::MenuItem("Reset Transform") && on_entity)
+    {
+        ActionEntityResetTransform(selected_entity);
+    }
+
     if (ImGui::MenuItem("Delete", "Delete") && on_entity)
     {
         ActionEntityDelete(selected_entity);
@@ -570,6 +576,30 @@ void WorldViewer::ActionEntityDelete(const shared_ptr<Spartan::Entity> entity)
     Spartan::World::RemoveEntity(entity.get());
 }
 
+void WorldViewer::ActionEntityResetTransform(const shared_ptr<Spartan::Entity> entity)
+{
+    SP_ASSERT_MSG(entity != nullptr, "Entity is null");
+
+    vector<Spartan::Entity*> entities = { entity.get() };
+    entity->GetDescendants(&entities);
+
+    // the entity and its descendants are undone/redone as a single step
+    Spartan::CommandStack::BeginBatch();
+    for (Spartan::Entity* entity_reset : entities)
+    {
+        Spartan::Math::Vector3 position_local    = entity_reset->GetPositionLocal();
+        Spartan::Math::Quaternion rotation_local = entity_reset->GetRotationLocal();
+        Spartan::Math::Vector3 scale_local       = entity_reset->GetScaleLocal();
+
+        entity_reset->SetPositionLocal(Spartan::Math::Vector3::Zero);
+        entity_reset->SetRotationLocal(Spartan::Math::Quaternion::Identity);
+        entity_reset->SetScaleLocal(Spartan::Math::Vector3::One);
+
+        Spartan::CommandStack::Add<Spartan::CommandTransform>(entity_reset, position_local, rotation_local, scale_local);
+    }
+    Spartan::CommandStack::EndBatch();
+}
+
 Spartan::Entity* WorldViewer::ActionEntityCreateEmpty()
 {
     shared_ptr<Spartan::Entity> entity = Spartan::World::CreateEntity();
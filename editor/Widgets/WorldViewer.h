@@ -54,6 +54,7 @@ class WorldViewer : public Widget
 
     // Context menu actions
     static void ActionEntityDelete(const std::shared_ptr<Spartan::Entity> entity);
+    static void ActionEntityResetTransform(const std::shared_ptr<Spartan::Entity> entity);
     static Spartan::Entity* ActionEntityCreateEmpty();
     static void ActionEntityCreateCube();
     static void ActionEntityCreateQuad();
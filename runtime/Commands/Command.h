@@ -30,7 +30,12 @@ namespace Spartan
     class SP_CLASS Command
     {
     public:
+        virtual ~Command() = default;
+
         virtual void OnApply()  = 0;
         virtual void OnRevert() = 0;
+
+        // folds a newer command into this one (e.g. consecutive edits of the same entity), returns true if it did
+        virtual bool Merge(const Command&) { return false; }
     };
 }
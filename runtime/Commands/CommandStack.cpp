@@ -30,38 +30,254 @@ using namespace std;
 
 namespace Spartan
 {
-    void CommandStack::Undo()
+    namespace
     {
-        if (m_undo_buffer.size() == 0)
-            return;
+        struct Entry
+        {
+            Command* command        = nullptr;
+            uint32_t offset         = 0;    // into the arena
+            uint32_t end            = 0;    // offset + sizeof the command
+            uint32_t size           = 0;    // bytes accounted to the entry, including padding and skipped space
+            bool batch_continuation = false; // undone/redone together with the previous entry
+            uint64_t interaction    = 0;     // the interaction the command was added in, 0 for none
+        };
+
+        // commands live in a circular byte arena, their entries in a ring of fixed capacity,
+        // the oldest entry is at index first, entries [0, cursor) are applied and [cursor, count) can be redone
+        vector<uint8_t> arena;
+        array<Entry, command_stack_max_commands> entries;
+        uint32_t first             = 0;
+        uint32_t count             = 0;
+        uint32_t cursor            = 0;
+        uint32_t used_bytes        = 0;
+        uint32_t batch_depth       = 0;
+        bool batch_has_first       = false;
+        uint64_t interaction       = 0; // the one in progress, 0 if none
+        uint64_t interaction_count = 0;
+
+        Entry& get_entry(const uint32_t index)
+        {
+            return entries[(first + index) % command_stack_max_commands];
+        }
+
+        void destroy(Entry& entry)
+        {
+            entry.command->~Command();
+            used_bytes    -= entry.size;
+            entry          = Entry();
+        }
+
+        void evict_oldest()
+        {
+            // evict a whole batch, a partially undoable step is worse than none
+            do
+            {
+                destroy(get_entry(0));
+                first  = (first + 1) % command_stack_max_commands;
+                count--;
+                cursor = cursor > 0 ? cursor - 1 : 0;
+            } while (count > 0 && get_entry(0).batch_continuation);
+        }
+
+        bool try_allocate(const uint32_t size, const uint32_t alignment, uint32_t* offset_out, uint32_t* size_out)
+        {
+            const uint32_t arena_size = static_cast<uint32_t>(arena.size());
+
+            if (count == 0)
+            {
+                *offset_out = 0;
+                *size_out   = size;
+                return size <= arena_size;
+            }
+
+            const uint32_t head    = get_entry(0).offset;
+            const Entry& last      = get_entry(count - 1);
+            const uint32_t tail    = last.end;
+            const uint32_t aligned = (tail + alignment - 1) & ~(alignment - 1);
+
+            // not wrapped, the free space is after the tail and before the head
+            if (tail > head)
+            {
+                if (aligned + size <= arena_size)
+                {
+                    *offset_out = aligned;
+                    *size_out   = aligned - tail + size;
+                    return true;
+                }
+
+                if (size <= head)
+                {
+                    // the skipped space at the end of the arena is accounted to this entry
+                    *offset_out = 0;
+                    *size_out   = arena_size - tail + size;
+                    return true;
+                }
+
+                return false;
+            }
+
+            // wrapped, the free space is between the tail and the head
+            if (aligned + size <= head)
+            {
+                *offset_out = aligned;
+                *size_out   = aligned - tail + size;
+                return true;
+            }
+
+            return false;
+        }
+    }
+
+    void CommandStack::BeginBatch()
+    {
+        if (batch_depth++ == 0)
+        {
+            batch_has_first = false;
+        }
+    }
+
+    void CommandStack::EndBatch()
+    {
+        SP_ASSERT_MSG(batch_depth > 0, "EndBatch() called without a matching BeginBatch()");
+        batch_depth--;
+    }
 
-        // fetch
-        shared_ptr<Command> undo_command = m_undo_buffer.back();
-        m_undo_buffer.pop_back();
+    void CommandStack::BeginInteraction()
+    {
+        // an unterminated interaction simply ends here
+        interaction = ++interaction_count;
+    }
 
-        // undo
-        undo_command->OnRevert();
+    void CommandStack::EndInteraction()
+    {
+        interaction = 0;
+    }
+
+    void CommandStack::Undo()
+    {
+        if (cursor == 0)
+            return;
 
-        // push it to the top of the redo stack
-        m_redo_buffer.push_back(undo_command);
+        // revert up to and including the first entry of the step
+        bool is_continuation = true;
+        while (cursor > 0 && is_continuation)
+        {
+            cursor--;
+            Entry& entry    = get_entry(cursor);
+            is_continuation = entry.batch_continuation;
+            entry.command->OnRevert();
+        }
     }
 
     void CommandStack::Redo()
     {
-        if (m_redo_buffer.size() == 0)
+        if (cursor == count)
             return;
 
-        // fetch
-        shared_ptr<Command> redo_command = m_redo_buffer.back();
-        m_redo_buffer.pop_back();
+        // apply the step and all the entries that continue it
+        do
+        {
+            get_entry(cursor).command->OnApply();
+            cursor++;
+        } while (cursor < count && get_entry(cursor).batch_continuation);
+    }
+
+    void CommandStack::SetBudget(const uint32_t size_bytes)
+    {
+        Clear();
+        arena.assign(size_bytes, 0);
+        arena.shrink_to_fit();
+    }
+
+    void CommandStack::Clear()
+    {
+        while (count > 0)
+        {
+            evict_oldest();
+        }
+
+        first  = 0;
+        cursor = 0;
+    }
+
+    uint32_t CommandStack::GetBudget()       { return static_cast<uint32_t>(arena.size()); }
+    uint32_t CommandStack::GetUsedBytes()    { return used_bytes; }
+    uint32_t CommandStack::GetCommandCount() { return count; }
+
+    void CommandStack::DiscardRedo()
+    {
+        while (count > cursor)
+        {
+            destroy(get_entry(count - 1));
+            count--;
+        }
+    }
+
+    bool CommandStack::Merge(const Command& command)
+    {
+        // never merge across batches
+        if (cursor == 0 || batch_depth > 0)
+            return false;
+
+        Entry& top = get_entry(cursor - 1);
+        if (top.batch_continuation)
+            return false;
+
+        // only within the interaction in progress
+        if (interaction == 0 || top.interaction != interaction)
+            return false;
+
+        return top.command->Merge(command);
+    }
+
+    void* CommandStack::Allocate(const uint32_t size, const uint32_t alignment)
+    {
+        if (arena.empty())
+        {
+            arena.assign(command_stack_budget, 0);
+        }
 
-        // redo
-        redo_command->OnApply();
+        if (size > arena.size())
+        {
+            SP_LOG_ERROR("The command is larger than the command stack budget of %u bytes", static_cast<uint32_t>(arena.size()));
+            return nullptr;
+        }
 
-        // push it to the top of the undo stack
-        m_undo_buffer.push_back(redo_command);
+        if (count == command_stack_max_commands)
+        {
+            evict_oldest();
+        }
+
+        uint32_t offset     = 0;
+        uint32_t size_total = 0;
+        while (!try_allocate(size, alignment, &offset, &size_total))
+        {
+            evict_oldest();
+        }
+
+        // reserve the entry, the command is constructed by the caller and then pushed
+        Entry& entry  = get_entry(count);
+        entry.offset  = offset;
+        entry.end     = offset + size;
+        entry.size    = size_total;
+        used_bytes   += size_total;
+
+        return &arena[offset];
     }
 
-    vector<shared_ptr<Spartan::Command>> CommandStack::m_undo_buffer;
-    vector<shared_ptr<Spartan::Command>> CommandStack::m_redo_buffer;
+    void CommandStack::Push(Command* command)
+    {
+        Entry& entry             = get_entry(count);
+        entry.command            = command;
+        entry.batch_continuation = batch_depth > 0 && batch_has_first;
+        entry.interaction        = interaction;
+
+        if (batch_depth > 0)
+        {
+            batch_has_first = true;
+        }
+
+        count++;
+        cursor = count;
+    }
 }
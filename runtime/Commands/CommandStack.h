@@ -29,7 +29,8 @@ CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 namespace Spartan
 {
     // @todo make editor setting instead of compile time constant expression
-    constexpr uint64_t max_undo_steps = 128;
+    constexpr uint32_t command_stack_budget       = 1024 * 1024; // bytes, the oldest commands are dropped when exceeded
+    constexpr uint32_t command_stack_max_commands = 1024;
 
     class SP_CLASS CommandStack
     {
@@ -37,21 +38,31 @@ namespace Spartan
         template<typename CommandType, typename... Args>
         static void Add(Args&&... args)
         {
-            // @todo this is garbage for performance, as it has to copy the entire buffer when it's full
-            // could be solved by using linked lists instead of dynamic arrays (vectors)
-            // optimal solution may be to preallocate an array instead, and use a cursor to manage undo/redo <-- probably do this
-            // luckily we only store pointers so should be decent performance for now (as long as max_undo_steps doesn't grow too large)
-            if (m_undo_buffer.size() >= max_undo_steps)
+            static_assert(std::is_base_of_v<Command, CommandType>, "CommandType must derive from Command");
+
+            // make sure to clear the redo buffer if you apply a new command, to preserve the time continuum
+            DiscardRedo();
+
+            // try to fold it into the latest command of the same interaction first
+            CommandType command(std::forward<Args>(args)...);
+            if (Merge(command))
+                return;
+
+            // move it into the arena
+            if (void* memory = Allocate(static_cast<uint32_t>(sizeof(CommandType)), static_cast<uint32_t>(alignof(CommandType))))
             {
-                m_undo_buffer.erase(m_undo_buffer.begin());
+                Push(new (memory) CommandType(std::move(command)));
             }
+        }
 
-            std::shared_ptr<Command> new_command = std::make_shared<CommandType>(std::forward<Args>(args)...);
-            m_undo_buffer.push_back(new_command);
+        // commands added between these two calls are undone/redone as a single step (e.g. multi-entity edits)
+        static void BeginBatch();
+        static void EndBatch();
 
-            // Make sure to clear the redo buffer if you apply a new command, to preserve the time continuum.
-            m_redo_buffer.clear();
-        }
+        // commands added between these two calls fold into each other where they can (e.g. a gizmo being dragged),
+        // commands of separate interactions are never merged
+        static void BeginInteraction();
+        static void EndInteraction();
 
         /** Undoes the latest applied command */
         static void Undo();
@@ -59,8 +70,17 @@ namespace Spartan
         /** Redoes the latest undone command */
         static void Redo();
 
-    protected:
-        static std::vector<std::shared_ptr<Command>> m_undo_buffer;
-        static std::vector<std::shared_ptr<Command>> m_redo_buffer;
+        // memory
+        static void SetBudget(uint32_t size_bytes);
+        static void Clear();
+        static uint32_t GetBudget();
+        static uint32_t GetUsedBytes();
+        static uint32_t GetCommandCount();
+
+    private:
+        static void DiscardRedo();
+        static bool Merge(const Command& command);
+        static void* Allocate(uint32_t size, uint32_t alignment);
+        static void Push(Command* command);
     };
 }
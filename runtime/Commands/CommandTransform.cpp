@@ -32,7 +32,7 @@ using namespace Spartan::Math;
 
 namespace Spartan
 {
-    CommandTransform::CommandTransform(Entity* entity, Vector3 old_position, Quaternion old_rotation, Vector3 old_scale)
+    CommandTransform::CommandTransform(Entity* entity, Vector3 old_position_local, Quaternion old_rotation_local, Vector3 old_scale_local)
     {
         SP_ASSERT(entity);
 
@@ -42,13 +42,13 @@ namespace Spartan
         // Right now this wont work as expected, since the object ids are just incremented on creation
         m_entity_id = entity->GetObjectId();
 
-        m_old_position = old_position;
-        m_old_rotation = old_rotation;
-        m_old_scale    = old_scale;
+        m_old_position = old_position_local;
+        m_old_rotation = old_rotation_local;
+        m_old_scale    = old_scale_local;
 
-        m_new_position = entity->GetPosition();
-        m_new_rotation = entity->GetRotation();
-        m_new_scale    = entity->GetScale();
+        m_new_position = entity->GetPositionLocal();
+        m_new_rotation = entity->GetRotationLocal();
+        m_new_scale    = entity->GetScaleLocal();
     }
 
     void CommandTransform::OnApply()
@@ -57,9 +57,9 @@ namespace Spartan
         if (!entity)
             return;
 
-        entity->SetPosition(m_new_position);
-        entity->SetRotation(m_new_rotation);
-        entity->SetScale(m_new_scale);
+        entity->SetPositionLocal(m_new_position);
+        entity->SetRotationLocal(m_new_rotation);
+        entity->SetScaleLocal(m_new_scale);
     }
 
     void CommandTransform::OnRevert()
@@ -68,8 +68,22 @@ namespace Spartan
         if (!entity)
             return;
 
-        entity->SetPosition(m_old_position);
-        entity->SetRotation(m_old_rotation);
-        entity->SetScale(m_old_scale);
+        entity->SetPositionLocal(m_old_position);
+        entity->SetRotationLocal(m_old_rotation);
+        entity->SetScaleLocal(m_old_scale);
+    }
+
+    bool CommandTransform::Merge(const Command& command)
+    {
+        const CommandTransform* command_transform = dynamic_cast<const CommandTransform*>(&command);
+        if (!command_transform || command_transform->m_entity_id != m_entity_id)
+            return false;
+
+        // keep the old state of this command, take the new state of the newer one
+        m_new_position = command_transform->m_new_position;
+        m_new_rotation = command_transform->m_new_rotation;
+        m_new_scale    = command_transform->m_new_scale;
+
+        return true;
     }
 }
@@ -32,10 +32,12 @@ namespace Spartan
     class SP_CLASS CommandTransform : public Spartan::Command
     {
     public:
-        CommandTransform(Spartan::Entity* entity, Math::Vector3 old_position, Math::Quaternion old_rotation, Math::Vector3 old_scale);
+        // the transforms are local, so that edits of an entity and its descendants can be applied and reverted in any order
+        CommandTransform(Spartan::Entity* entity, Math::Vector3 old_position_local, Math::Quaternion old_rotation_local, Math::Vector3 old_scale_local);
 
         virtual void OnApply() override;
         virtual void OnRevert() override;
+        virtual bool Merge(const Command& command) override;
 
     protected:
 
@@ -25,10 +25,12 @@ CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 #include "ThreadPool.h"
 #include "../Audio/Audio.h"
 #include "../Input/Input.h"
+#include "../IO/VirtualFileSystem.h"
 #include "../World/World.h"
 #include "../Physics/Physics.h"
 #include "../Profiling/Profiler.h"
 #include "../Rendering/Renderer.h"
+#include "../Resource/HotReload.h"
 #include "../Resource/ResourceCache.h"
 #include "../Resource/Import/FontImporter.h"
 #include "../Resource/Import/ModelImporter.h"
@@ -60,6 +62,25 @@ namespace Spartan
                 }
             }
         }
+
+        // the engine data and the project can ship as packs, "-pack" builds them from the loose files first
+        void mount_packs()
+        {
+            for (const string directory : { "data", "project" })
+            {
+                const string pack_path = directory + EXTENSION_PACK;
+
+                if (Engine::HasArgument("-pack"))
+                {
+                    VirtualFileSystem::Pack(directory, pack_path);
+                }
+
+                if (FileSystem::Exists(pack_path))
+                {
+                    VirtualFileSystem::Mount(pack_path);
+                }
+            }
+        }
     }
 
     void Engine::Initialize(const vector<string>& args)
@@ -73,6 +94,7 @@ namespace Spartan
         Stopwatch timer_initialize;
         {
             Log::Initialize();
+            mount_packs();
             FontImporter::Initialize();
             ImageImporterExporter::Initialize();
             ModelImporter::Initialize();
@@ -88,6 +110,7 @@ namespace Spartan
             Renderer::Initialize();
             World::Initialize();
             Settings::Initialize();
+            HotReload::Initialize();
         }
 
         SP_LOG_INFO("Initialization took %.1f ms", timer_initialize.GetElapsedTimeMs());
@@ -98,11 +121,13 @@ namespace Spartan
     {
         SP_FIRE_EVENT(EventType::EngineShutdown);
 
+        HotReload::Shutdown();
+        World::Shutdown(); // before the resources, its entities still reference them
         ResourceCache::Shutdown();
-        World::Shutdown();
         Renderer::Shutdown();
         Physics::Shutdown();
         ThreadPool::Shutdown();
+        VirtualFileSystem::Shutdown(); // after the thread pool, loads in flight could be reading from a pack
         Event::Shutdown();
         Audio::Shutdown();
         Profiler::Shutdown();
@@ -110,6 +135,8 @@ namespace Spartan
         ImageImporterExporter::Shutdown();
         FontImporter::Shutdown();
         Settings::Shutdown();
+
+        MemoryTracker::ReportLeaks();
     }
 
     void Engine::Tick()
@@ -118,6 +145,12 @@ namespace Spartan
         Profiler::PreTick();
         Input::PreTick();
 
+        // events published since the last tick, possibly from other threads
+        Event::Dispatch();
+
+        // files which changed on disk, swapped in before anything uses them this frame
+        HotReload::Tick();
+
         // tick
         Window::Tick();
         Input::Tick();
@@ -125,9 +158,11 @@ namespace Spartan
         Physics::Tick();
         World::Tick();
         Renderer::Tick();
+        ResourceCache::Tick();
 
         // post-tick
         Timer::PostTick();
+        MemoryTracker::Tick();
         Profiler::PostTick();
     }
 
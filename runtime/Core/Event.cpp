@@ -32,27 +32,234 @@ namespace Spartan
 {
     namespace
     {
-        static array<vector<subscriber>, static_cast<uint32_t>(EventType::Max)> event_subscribers;
+        struct Subscriber
+        {
+            EventSubscription subscription = 0;
+            subscriber function;
+        };
+
+        array<vector<Subscriber>, static_cast<uint32_t>(EventType::Max)> event_subscribers;
+        EventSubscription subscription_next = 1;
+        uint32_t fire_depth                 = 0;     // unsubscribing while firing only clears the function
+        bool subscribers_removed            = false; // and the vectors are compacted once firing ends
+
+        // the subscription encodes the event type, so unsubscribing doesn't have to search every event
+        const uint32_t subscription_type_shift = 56;
+
+        // a bounded multiple producer single consumer queue (dmitry vyukov's), each cell has a sequence number
+        // which tells producers and the consumer whose turn it is, so publishing is a single compare exchange
+        namespace queue
+        {
+            const uint64_t capacity = 8192; // power of two
+
+            struct Cell
+            {
+                atomic<uint64_t> sequence = 0;
+                EventType type            = EventType::Max;
+                sp_variant data;
+            };
+
+            array<Cell, capacity> cells;
+            atomic<uint64_t> position_enqueue = 0;
+            uint64_t position_dequeue         = 0;
+            bool initialized                  = false;
+
+            // when the queue is full, which only a burst of events can do, they wait here, and so do the
+            // events after them until the next dispatch, so that they can't overtake the ones that overflowed
+            mutex overflow_mutex;
+            vector<pair<EventType, sp_variant>> overflow;
+            atomic<bool> overflowing = false;
+
+            void initialize()
+            {
+                for (uint64_t i = 0; i < capacity; i++)
+                {
+                    cells[i].sequence.store(i, memory_order_relaxed);
+                }
+                initialized = true;
+            }
+
+            bool enqueue(const EventType type, sp_variant& data)
+            {
+                uint64_t position = position_enqueue.load(memory_order_relaxed);
+                Cell* cell        = nullptr;
+                while (true)
+                {
+                    cell             = &cells[position & (capacity - 1)];
+                    uint64_t sequence = cell->sequence.load(memory_order_acquire);
+                    int64_t difference = static_cast<int64_t>(sequence) - static_cast<int64_t>(position);
+                    if (difference == 0)
+                    {
+                        if (position_enqueue.compare_exchange_weak(position, position + 1, memory_order_relaxed))
+                            break;
+                    }
+                    else if (difference < 0)
+                    {
+                        return false; // full
+                    }
+                    else
+                    {
+                        position = position_enqueue.load(memory_order_relaxed);
+                    }
+                }
+
+                cell->type = type;
+                cell->data = move(data);
+                cell->sequence.store(position + 1, memory_order_release);
+
+                return true;
+            }
+
+            bool dequeue(EventType* type, sp_variant* data)
+            {
+                Cell* cell        = &cells[position_dequeue & (capacity - 1)];
+                uint64_t sequence = cell->sequence.load(memory_order_acquire);
+                if (sequence != position_dequeue + 1)
+                    return false; // empty, or the producer is still writing
+
+                *type      = cell->type;
+                *data      = move(cell->data);
+                cell->data = 0;
+                cell->sequence.store(position_dequeue + capacity, memory_order_release);
+                position_dequeue++;
+
+                return true;
+            }
+        }
+
+        // the cells have to be numbered before any thread publishes
+        struct QueueInitializer
+        {
+            QueueInitializer() { queue::initialize(); }
+        } queue_initializer;
+
+        void compact_subscribers()
+        {
+            for (vector<Subscriber>& subscribers : event_subscribers)
+            {
+                subscribers.erase(remove_if(subscribers.begin(), subscribers.end(), [](const Subscriber& subscriber)
+                {
+                    return !subscriber.function;
+                }), subscribers.end());
+            }
+
+            subscribers_removed = false;
+        }
     }
 
     void Event::Shutdown()
     {
-        for (vector<subscriber>& subscribers : event_subscribers)
+        // drop whatever is still queued, the subscribers are going away
+        EventType type;
+        sp_variant data;
+        while (queue::dequeue(&type, &data)) {}
+        {
+            lock_guard lock(queue::overflow_mutex);
+            queue::overflow.clear();
+            queue::overflow.shrink_to_fit();
+            queue::overflowing = false;
+        }
+
+        for (vector<Subscriber>& subscribers : event_subscribers)
         {
             subscribers.clear();
+            subscribers.shrink_to_fit();
         }
     }
 
-    void Event::Subscribe(const EventType event_type, subscriber&& function)
+    EventSubscription Event::Subscribe(const EventType event_type, subscriber&& function)
+    {
+        EventSubscription subscription = (static_cast<uint64_t>(event_type) << subscription_type_shift) | subscription_next++;
+        event_subscribers[static_cast<uint32_t>(event_type)].push_back({ subscription, std::forward<subscriber>(function) });
+
+        return subscription;
+    }
+
+    void Event::Unsubscribe(const EventSubscription subscription)
     {
-        event_subscribers[static_cast<uint32_t>(event_type)].push_back(std::forward<subscriber>(function));
+        uint32_t event_index = static_cast<uint32_t>(subscription >> subscription_type_shift);
+        if (subscription == 0 || event_index >= static_cast<uint32_t>(EventType::Max))
+            return;
+
+        for (Subscriber& subscriber : event_subscribers[event_index])
+        {
+            if (subscriber.subscription == subscription)
+            {
+                subscriber.function = nullptr;
+                subscribers_removed = true;
+                break;
+            }
+        }
+
+        if (fire_depth == 0)
+        {
+            compact_subscribers();
+        }
     }
 
     void Event::Fire(const EventType event_type, sp_variant data /*= 0*/)
     {
-        for (const auto& subscriber : event_subscribers[static_cast<uint32_t>(event_type)])
+        // by index, a subscriber can subscribe others, which can grow the vector
+        vector<Subscriber>& subscribers = event_subscribers[static_cast<uint32_t>(event_type)];
+        fire_depth++;
+        for (size_t i = 0; i < subscribers.size(); i++)
+        {
+            if (subscribers[i].function)
+            {
+                subscriber function = subscribers[i].function;
+                function(data);
+            }
+        }
+        fire_depth--;
+
+        if (fire_depth == 0 && subscribers_removed)
+        {
+            compact_subscribers();
+        }
+    }
+
+    void Event::Publish(const EventType event_type, sp_variant data /*= 0*/)
+    {
+        if (queue::overflowing.load(memory_order_acquire) || !queue::enqueue(event_type, data))
+        {
+            lock_guard lock(queue::overflow_mutex);
+            queue::overflow.emplace_back(event_type, move(data));
+            queue::overflowing.store(true, memory_order_release);
+        }
+    }
+
+    void Event::Dispatch()
+    {
+        SP_ASSERT(queue::initialized);
+
+        // only what was published before this call, so that subscribers which publish can't keep this going forever,
+        // the overflow and the end of the queue are taken together, everything that overflowed comes after that end
+        vector<pair<EventType, sp_variant>> overflow;
+        uint64_t position_end = 0;
+        {
+            lock_guard lock(queue::overflow_mutex);
+            overflow.swap(queue::overflow);
+            position_end = queue::position_enqueue.load(memory_order_acquire);
+            queue::overflowing.store(false, memory_order_release);
+        }
+
+        EventType type;
+        sp_variant data;
+        while (queue::position_dequeue < position_end)
+        {
+            // the cell is claimed, but its producer can still be writing it
+            if (!queue::dequeue(&type, &data))
+            {
+                this_thread::yield();
+                continue;
+            }
+
+            Fire(type, move(data));
+        }
+
+        for (auto& [type_overflow, data_overflow] : overflow)
         {
-            subscriber(data);
+            Fire(type_overflow, move(data_overflow));
         }
     }
 }
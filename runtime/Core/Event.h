@@ -30,28 +30,43 @@ CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 HOW TO USE
 ================================================================================
 To subscribe a function to an event -> SP_SUBSCRIBE_TO_EVENT(EVENT_ID, Handler);
+To subscribe to typed event data    -> SP_SUBSCRIBE_TO_EVENT_DATA(EVENT_ID, Function);
 To fire an event                    -> SP_FIRE_EVENT(EVENT_ID);
-To fire an event with data          -> SP_FIRE_EVENT_DATA(EVENT_ID, Variant);
+To fire an event with data          -> SP_FIRE_EVENT_DATA(EVENT_ID, Data);
+To publish an event                 -> SP_PUBLISH_EVENT(EVENT_ID);
+To publish an event with data       -> SP_PUBLISH_EVENT_DATA(EVENT_ID, Data);
+To unsubscribe                      -> Event::Unsubscribe(subscription);
 
-Note: This is a blocking event system
+Note: Firing is blocking, the subscribers run on the firing thread before Fire() returns.
+Publishing is not, the event is queued (from any thread, without locking) and the
+subscribers run on the main thread when Event::Dispatch() is called, at the start
+of every engine tick. Publish events which can originate from worker threads, and
+give them data that is still valid when they are dispatched, like an object id.
+
+The data of every event has a type, see EventData below, the _DATA macros check
+it at compile time and SP_SUBSCRIBE_TO_EVENT_DATA hands it to the function as is.
 ================================================================================
 */
 
-//= MACROS ===============================================================================================
-#define SP_EVENT_HANDLER_EXPRESSION(expression)        [this](Spartan::sp_variant var)  { expression }
-#define SP_EVENT_HANDLER_EXPRESSION_STATIC(expression) [](Spartan::sp_variant var)      { expression }
-
-#define SP_EVENT_HANDLER(function)                     [this](Spartan::sp_variant var)  { function(); }
-#define SP_EVENT_HANDLER_STATIC(function)              [](Spartan::sp_variant var)      { function(); }
-                                                                                     
-#define SP_EVENT_HANDLER_VARIANT(function)             [this](Spartan::sp_variant var)  { function(var); }
-#define SP_EVENT_HANDLER_VARIANT_STATIC(function)      [](Spartan::sp_variant var)      { function(var); }
-                                                       
-#define SP_FIRE_EVENT(event_enum)                      Spartan::Event::Fire(event_enum)
-#define SP_FIRE_EVENT_DATA(event_enum, data)           Spartan::Event::Fire(event_enum, data)
-                                                       
-#define SP_SUBSCRIBE_TO_EVENT(event_enum, function)    Spartan::Event::Subscribe(event_enum, function);
-//========================================================================================================
+//= MACROS =================================================================================================
+#define SP_EVENT_HANDLER_EXPRESSION(expression)          [this](Spartan::sp_variant var)  { expression }
+#define SP_EVENT_HANDLER_EXPRESSION_STATIC(expression)   [](Spartan::sp_variant var)      { expression }
+
+#define SP_EVENT_HANDLER(function)                       [this](Spartan::sp_variant var)  { function(); }
+#define SP_EVENT_HANDLER_STATIC(function)                [](Spartan::sp_variant var)      { function(); }
+
+#define SP_EVENT_HANDLER_VARIANT(function)               [this](Spartan::sp_variant var)  { function(var); }
+#define SP_EVENT_HANDLER_VARIANT_STATIC(function)        [](Spartan::sp_variant var)      { function(var); }
+
+#define SP_FIRE_EVENT(event_enum)                        Spartan::Event::Fire(event_enum)
+#define SP_FIRE_EVENT_DATA(event_enum, data)             Spartan::Event::Fire<event_enum>(data)
+
+#define SP_PUBLISH_EVENT(event_enum)                     Spartan::Event::Publish(event_enum)
+#define SP_PUBLISH_EVENT_DATA(event_enum, data)          Spartan::Event::Publish<event_enum>(data)
+
+#define SP_SUBSCRIBE_TO_EVENT(event_enum, function)      Spartan::Event::Subscribe(event_enum, function);
+#define SP_SUBSCRIBE_TO_EVENT_DATA(event_enum, function) Spartan::Event::Subscribe<event_enum>(function);
+//==========================================================================================================
 
 namespace Spartan
 {
@@ -85,16 +100,59 @@ namespace Spartan
 
     using sp_variant = std::variant<
         int,
+        uint64_t,
         void*,
         std::vector<std::shared_ptr<Entity>>
     >;
+
+    // the data each event carries, events which aren't listed carry an int which nobody reads
+    template<EventType event_type> struct EventData           { using type = int; };
+    template<> struct EventData<EventType::Sdl>               { using type = void*; };    // the SDL_Event
+    template<> struct EventData<EventType::MaterialOnChanged> { using type = uint64_t; }; // the object id of the material
+
     using subscriber = std::function<void(const sp_variant&)>;
 
+    // identifies a subscriber so that it can unsubscribe, 0 is never a valid subscription
+    using EventSubscription = uint64_t;
+
     class SP_CLASS Event
     {
     public:
         static void Shutdown();
-        static void Subscribe(const EventType event_type, subscriber&& function);
+
+        // subscriptions are expected to change on the main thread
+        static EventSubscription Subscribe(const EventType event_type, subscriber&& function);
+        static void Unsubscribe(const EventSubscription subscription);
+
+        // blocking, runs the subscribers on the calling thread
         static void Fire(const EventType event_type, sp_variant data = 0);
+
+        // deferred, safe to call from any thread
+        static void Publish(const EventType event_type, sp_variant data = 0);
+
+        // typed, the data has to be what EventData says the event carries
+        template<EventType event_type>
+        static void Fire(const typename EventData<event_type>::type& data)
+        {
+            Fire(event_type, sp_variant(std::in_place_type<typename EventData<event_type>::type>, data));
+        }
+
+        template<EventType event_type>
+        static void Publish(const typename EventData<event_type>::type& data)
+        {
+            Publish(event_type, sp_variant(std::in_place_type<typename EventData<event_type>::type>, data));
+        }
+
+        template<EventType event_type, typename Function>
+        static EventSubscription Subscribe(Function&& function)
+        {
+            return Subscribe(event_type, [function = std::forward<Function>(function)](const sp_variant& data)
+            {
+                function(std::get<typename EventData<event_type>::type>(data));
+            });
+        }
+
+        // runs the subscribers of everything published so far, called on the main thread
+        static void Dispatch();
     };
 }
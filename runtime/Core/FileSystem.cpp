@@ -19,10 +19,11 @@ IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
 CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 */
 
-//= INCLUDES ============
+//= INCLUDES =======================
 #include "pch.h"
 #include <SDL_misc.h>
-//=======================
+#include "../IO/VirtualFileSystem.h"
+//==================================
 
 //= NAMESPACES =====
 using namespace std;
@@ -162,7 +163,8 @@ namespace Spartan
             SP_LOG_WARNING("%s, %s", e.what(), path.c_str());
         }
 
-        return false;
+        // or in a mounted pack
+        return VirtualFileSystem::Exists(path);
     }
 
     bool FileSystem::IsDirectoryEmpty(const string& path)
@@ -215,7 +217,8 @@ namespace Spartan
             SP_LOG_WARNING("%s, %s", e.what(), path.c_str());
         }
 
-        return false;
+        // packs only contain files
+        return VirtualFileSystem::Exists(path);
     }
 
     string FileSystem::GetFileNameFromFilePath(const string& path)
@@ -100,6 +100,7 @@ namespace Spartan
     static const char* EXTENSION_TEXTURE  = ".texture";
     static const char* EXTENSION_MESH     = ".mesh";
     static const char* EXTENSION_AUDIO    = ".audio";
+    static const char* EXTENSION_PACK     = ".pak";
 
     static const std::vector<std::string> supported_formats_image
     {
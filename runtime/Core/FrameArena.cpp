@@ -0,0 +1,164 @@
+/*
+Copyright(c) 2016-2024 Panos Karabelas
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+copies of the Software, and to permit persons to whom the Software is furnished
+to do so, subject to the following conditions :
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE AUTHORS OR
+COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+//= INCLUDES ==========================
+#include "pch.h"
+#include "FrameArena.h"
+#include "../Profiling/MemoryTracker.h"
+//=====================================
+
+//= NAMESPACES =====
+using namespace std;
+//==================
+
+namespace Spartan
+{
+    namespace
+    {
+        const size_t block_size = 1024 * 1024;
+
+        atomic<uint64_t> frame                 = 0;
+        array<atomic<uint64_t>, 2> bytes_used  = {};
+        atomic<uint64_t> bytes_used_last_frame = 0;
+        atomic<uint64_t> bytes_capacity        = 0;
+        atomic<uint64_t> block_allocations     = 0;
+
+        struct Block
+        {
+            uint8_t* data = nullptr;
+            size_t size   = 0;
+        };
+
+        struct Arena
+        {
+            vector<Block> blocks;
+            size_t block_index = 0;
+            size_t offset      = 0;
+
+            ~Arena()
+            {
+                for (Block& block : blocks)
+                {
+                    bytes_capacity -= block.size;
+                    delete[] block.data;
+                }
+            }
+
+            void reset()
+            {
+                block_index = 0;
+                offset      = 0;
+            }
+
+            void* allocate(const size_t size, const size_t alignment)
+            {
+                while (true)
+                {
+                    // the blocks of earlier frames are reused in order, one is only added when none is left or it's too small
+                    if (block_index == blocks.size() || blocks[block_index].size < size + alignment)
+                    {
+                        if (block_index < blocks.size() && offset == 0)
+                        {
+                            // too small for this allocation, keep it for the next ones
+                            block_index++;
+                            continue;
+                        }
+
+                        if (block_index == blocks.size())
+                        {
+                            // the blocks are reused until the thread exits
+                            SP_MEMORY_TAG(MemoryTag::Persistent);
+
+                            Block block;
+                            block.size = max(block_size, size + alignment);
+                            block.data = new uint8_t[block.size];
+                            blocks.emplace_back(block);
+
+                            bytes_capacity += block.size;
+                            block_allocations++;
+                        }
+                    }
+
+                    Block& block     = blocks[block_index];
+                    uintptr_t start  = reinterpret_cast<uintptr_t>(block.data) + offset;
+                    uintptr_t padded = (start + alignment - 1) & ~(static_cast<uintptr_t>(alignment) - 1);
+                    size_t end       = offset + (padded - start) + size;
+                    if (end <= block.size)
+                    {
+                        offset = end;
+                        return reinterpret_cast<void*>(padded);
+                    }
+
+                    // full, move on to the next block
+                    block_index++;
+                    offset = 0;
+                }
+            }
+        };
+
+        struct ThreadArenas
+        {
+            array<Arena, 2> arenas;
+            uint64_t frame = numeric_limits<uint64_t>::max();
+        };
+        thread_local ThreadArenas thread_arenas;
+    }
+
+    void FrameArena::Tick()
+    {
+        uint64_t frame_next = frame + 1;
+
+        bytes_used_last_frame      = bytes_used[frame % 2].load();
+        bytes_used[frame_next % 2] = 0;
+        frame                      = frame_next;
+    }
+
+    void* FrameArena::Allocate(const size_t size, const size_t alignment)
+    {
+        SP_ASSERT_MSG((alignment & (alignment - 1)) == 0, "The alignment has to be a power of two");
+
+        // the first allocation of this thread in a new frame, the other arena holds the previous frame
+        uint64_t frame_current = frame.load(memory_order_relaxed);
+        if (thread_arenas.frame != frame_current)
+        {
+            thread_arenas.frame = frame_current;
+            thread_arenas.arenas[frame_current % 2].reset();
+        }
+
+        bytes_used[frame_current % 2].fetch_add(size, memory_order_relaxed);
+        return thread_arenas.arenas[frame_current % 2].allocate(max(size, static_cast<size_t>(1)), alignment);
+    }
+
+    uint64_t FrameArena::GetBytesUsed()
+    {
+        return bytes_used_last_frame;
+    }
+
+    uint64_t FrameArena::GetBytesCapacity()
+    {
+        return bytes_capacity;
+    }
+
+    uint64_t FrameArena::GetBlockAllocations()
+    {
+        return block_allocations;
+    }
+}
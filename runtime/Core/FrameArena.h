@@ -0,0 +1,76 @@
+/*
+Copyright(c) 2016-2024 Panos Karabelas
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+copies of the Software, and to permit persons to whom the Software is furnished
+to do so, subject to the following conditions :
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE AUTHORS OR
+COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#pragma once
+
+//= INCLUDES =============
+#include "Definitions.h"
+#include <vector>
+#include <unordered_map>
+#include <unordered_set>
+//========================
+
+namespace Spartan
+{
+    // a linear allocator per thread for data which doesn't outlive the frame after the one it was allocated in,
+    // every thread owns two arenas and switches to the other one (resetting it) when it first allocates in a new
+    // frame, so steady state frames reuse the same blocks and never touch the general purpose heap
+    class SP_CLASS FrameArena
+    {
+    public:
+        // called once per frame, by Renderer::Tick()
+        static void Tick();
+
+        static void* Allocate(const size_t size, const size_t alignment);
+
+        // stats
+        static uint64_t GetBytesUsed();        // by all threads during the last complete frame
+        static uint64_t GetBytesCapacity();    // the blocks held by all threads
+        static uint64_t GetBlockAllocations(); // heap allocations made by the arenas since startup, flat once they are warm
+    };
+
+    // memory is released when the arena resets, so deallocation does nothing, containers using this must
+    // be local to a frame, a container kept across frames would reference memory that has been reused
+    template<typename T>
+    class FrameAllocator
+    {
+    public:
+        using value_type = T;
+
+        FrameAllocator() = default;
+        template<typename U> FrameAllocator(const FrameAllocator<U>&) {}
+
+        T* allocate(const size_t count)   { return static_cast<T*>(FrameArena::Allocate(count * sizeof(T), alignof(T))); }
+        void deallocate(T*, const size_t) {}
+
+        template<typename U> bool operator==(const FrameAllocator<U>&) const { return true; }
+        template<typename U> bool operator!=(const FrameAllocator<U>&) const { return false; }
+    };
+
+    template<typename T>
+    using frame_vector = std::vector<T, FrameAllocator<T>>;
+
+    template<typename T>
+    using frame_unordered_set = std::unordered_set<T, std::hash<T>, std::equal_to<T>, FrameAllocator<T>>;
+
+    template<typename K, typename V>
+    using frame_unordered_map = std::unordered_map<K, V, std::hash<K>, std::equal_to<K>, FrameAllocator<std::pair<const K, V>>>;
+}
@@ -81,6 +81,8 @@ namespace Spartan
                 case Renderer_Option::ResolutionScale:               return "ResolutionScale";
                 case Renderer_Option::DynamicResolution:             return "DynamicResolution";
                 case Renderer_Option::OcclusionCulling:              return "OcclusionCulling";
+                case Renderer_Option::GpuCulling:                    return "GpuCulling";
+                case Renderer_Option::AutoInstancing:                return "AutoInstancing";
                 default:
                 {
                     SP_ASSERT_MSG(false, "Renderer_Option not handled");
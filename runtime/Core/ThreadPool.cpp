@@ -19,10 +19,11 @@ IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
 CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 */
 
-//= INCLUDES =========
+//= INCLUDES ==========================
 #include "pch.h"
 #include "ThreadPool.h"
-//====================
+#include "../Profiling/MemoryTracker.h"
+//=====================================
 
 //= NAMESPACES =====
 using namespace std;
@@ -118,6 +119,7 @@ namespace Spartan
 
         // Empty worker threads.
         threads.clear();
+        thread_count = 0; // parallel loops run inline again
     }
 
     void ThreadPool::AddTask(Task&& task)
@@ -125,8 +127,12 @@ namespace Spartan
         // Lock tasks mutex
         unique_lock<mutex> lock(mutex_tasks);
 
-        // Save the task
-        tasks.emplace_back(bind(std::forward<Task>(task)));
+        // Save the task, it runs with the memory tag of the thread that added it
+        tasks.emplace_back([tag = MemoryTracker::GetTag(), task = std::forward<Task>(task)]()
+        {
+            SP_MEMORY_TAG(tag);
+            task();
+        });
 
         // Unlock the mutex
         lock.unlock();
@@ -139,7 +145,7 @@ namespace Spartan
     {
         SP_ASSERT_MSG(work_total > 1, "A parallel loop can't have a range of 1 or smaller");
 
-        uint32_t available_threads = GetIdleThreadCount();
+        uint32_t available_threads = max(GetIdleThreadCount(), 1u); // workers which just finished can still be counted as busy
         uint32_t work_per_thread   = work_total / available_threads;
         uint32_t work_remainder    = work_total % available_threads;
         uint32_t work_index        = 0;
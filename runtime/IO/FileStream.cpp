@@ -22,6 +22,7 @@ CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 //= INCLUDES =================
 #include "pch.h"
 #include "FileStream.h"
+#include "VirtualFileSystem.h"
 #include "../RHI/RHI_Vertex.h"
 //============================
 
@@ -31,6 +32,20 @@ using namespace std;
 
 namespace Spartan
 {
+    namespace
+    {
+        // reads straight from memory, which is either the pack mapping or the decompressed bytes
+        class MemoryBuffer : public streambuf
+        {
+        public:
+            MemoryBuffer(const byte* data, const uint64_t size)
+            {
+                char* begin = const_cast<char*>(reinterpret_cast<const char*>(data));
+                setg(begin, begin, begin + size);
+            }
+        };
+    }
+
     FileStream::FileStream(const string& path, uint32_t flags)
     {
         m_is_open = false;
@@ -52,12 +67,33 @@ namespace Spartan
         }
         else if (m_flags & FileStream_Read)
         {
-            in.open(path, ios_flags);
-            if(in.fail())
+            // mounted packs take precedence over the disk, uncompressed files are read in place
+            const byte* data = nullptr;
+            uint64_t size    = 0;
+            if (VirtualFileSystem::Map(path, &data, &size))
             {
-                SP_LOG_ERROR("Failed to open \"%s\" for reading", path.c_str());
-                return;
+                in_buffer = make_unique<MemoryBuffer>(data, size);
+            }
+            else if (VirtualFileSystem::Exists(path))
+            {
+                if (!VirtualFileSystem::Read(path, in_bytes))
+                {
+                    SP_LOG_ERROR("Failed to open \"%s\" for reading", path.c_str());
+                    return;
+                }
+                in_buffer = make_unique<MemoryBuffer>(in_bytes.data(), in_bytes.size());
             }
+            else
+            {
+                in_file.open(path, ios_flags);
+                if (in_file.fail())
+                {
+                    SP_LOG_ERROR("Failed to open \"%s\" for reading", path.c_str());
+                    return;
+                }
+            }
+
+            in.rdbuf(in_buffer ? in_buffer.get() : in_file.rdbuf());
         }
 
         m_is_open = true;
@@ -77,8 +113,11 @@ namespace Spartan
         }
         else if (m_flags & FileStream_Read)
         {
-            in.clear();
-            in.close();
+            in.rdbuf(nullptr);
+            in_file.clear();
+            in_file.close();
+            in_buffer.reset();
+            in_bytes.clear();
         }
     }
 
@@ -23,6 +23,7 @@ CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 
 //= INCLUDES ===================
 #include <vector>
+#include <memory>
 #include <fstream>
 #include "../Math/Vector2.h"
 #include "../Math/Vector3.h"
@@ -156,7 +157,10 @@ namespace Spartan
 
     private:
         std::ofstream out;
-        std::ifstream in;
+        std::ifstream in_file;
+        std::unique_ptr<std::streambuf> in_buffer; // when reading from a pack
+        std::vector<std::byte> in_bytes;           // the decompressed file, if it was compressed in the pack
+        std::istream in{ nullptr };                // reads from either of the above
         uint32_t m_flags;
         bool m_is_open;
     };
@@ -0,0 +1,368 @@
+/*
+Copyright(c) 2016-2024 Panos Karabelas
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+copies of the Software, and to permit persons to whom the Software is furnished
+to do so, subject to the following conditions :
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE AUTHORS OR
+COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+//= INCLUDES =================
+#include "pch.h"
+#include "FileWatcher.h"
+#ifdef _MSC_VER
+#include <Windows.h>
+#else
+#include <sys/inotify.h>
+#include <unistd.h>
+#endif
+//============================
+
+//= NAMESPACES =====
+using namespace std;
+//==================
+
+namespace Spartan
+{
+    namespace
+    {
+        mutex mutex_watcher;
+        unordered_map<string, chrono::steady_clock::time_point> changes_pending; // file path -> last change
+        float coalesce_time_ms = 150.0f;
+        vector<string> directories; // as added
+
+        // when the os drops changes, the files written since the previous poll are found by scanning instead,
+        // with some slack, as file times can be coarse
+        filesystem::file_time_type time_poll_previous;
+        const chrono::seconds rescan_slack = chrono::seconds(2);
+
+        string to_generic(string path)
+        {
+            replace(path.begin(), path.end(), '\\', '/');
+            while (path.size() > 1 && path.back() == '/')
+            {
+                path.pop_back();
+            }
+
+            return path;
+        }
+
+        void on_change(const string& file_path)
+        {
+            changes_pending[file_path] = chrono::steady_clock::now();
+        }
+
+        void rescan(const string& directory)
+        {
+            SP_LOG_WARNING("Changes in \"%s\" were dropped, rescanning it", directory.c_str());
+
+            const filesystem::file_time_type time_min = time_poll_previous - rescan_slack;
+
+            error_code error;
+            for (const filesystem::directory_entry& entry : filesystem::recursive_directory_iterator(directory, error))
+            {
+                if (entry.is_regular_file(error) && entry.last_write_time(error) >= time_min)
+                {
+                    on_change(to_generic(entry.path().string()));
+                }
+            }
+        }
+
+    #ifdef _MSC_VER
+        struct Watch
+        {
+            string directory;
+            HANDLE handle         = INVALID_HANDLE_VALUE;
+            OVERLAPPED overlapped = {};
+            alignas(DWORD) array<uint8_t, 64 * 1024> buffer;
+        };
+        vector<unique_ptr<Watch>> watches;
+
+        bool issue_read(Watch& watch)
+        {
+            const DWORD filter = FILE_NOTIFY_CHANGE_LAST_WRITE | FILE_NOTIFY_CHANGE_FILE_NAME | FILE_NOTIFY_CHANGE_SIZE;
+            return ReadDirectoryChangesW(watch.handle, watch.buffer.data(), static_cast<DWORD>(watch.buffer.size()), TRUE, filter, nullptr, &watch.overlapped, nullptr) != 0;
+        }
+
+        bool initialize_os()
+        {
+            return true;
+        }
+
+        void add_watch(const string& directory)
+        {
+            // the watch is recursive, so a directory within one which is already watched would report everything twice
+            for (const unique_ptr<Watch>& watch : watches)
+            {
+                if (directory == watch->directory || directory.rfind(watch->directory + "/", 0) == 0)
+                    return;
+            }
+
+            unique_ptr<Watch> watch = make_unique<Watch>();
+            watch->directory        = directory;
+            watch->handle           = CreateFileW(
+                FileSystem::StringToWstring(directory).c_str(),
+                FILE_LIST_DIRECTORY,
+                FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE,
+                nullptr,
+                OPEN_EXISTING,
+                FILE_FLAG_BACKUP_SEMANTICS | FILE_FLAG_OVERLAPPED,
+                nullptr
+            );
+
+            if (watch->handle == INVALID_HANDLE_VALUE)
+            {
+                SP_LOG_ERROR("Failed to watch \"%s\"", directory.c_str());
+                return;
+            }
+
+            watch->overlapped.hEvent = CreateEventW(nullptr, TRUE, FALSE, nullptr);
+            if (!issue_read(*watch))
+            {
+                SP_LOG_ERROR("Failed to watch \"%s\"", directory.c_str());
+                CloseHandle(watch->overlapped.hEvent);
+                CloseHandle(watch->handle);
+                return;
+            }
+
+            watches.emplace_back(move(watch));
+        }
+
+        void read_changes()
+        {
+            for (unique_ptr<Watch>& watch : watches)
+            {
+                // still pending
+                DWORD bytes = 0;
+                if (!GetOverlappedResult(watch->handle, &watch->overlapped, &bytes, FALSE))
+                    continue;
+
+                // zero bytes means that the buffer overflowed and the changes were dropped
+                if (bytes == 0)
+                {
+                    rescan(watch->directory);
+                }
+
+                uint8_t* entry = watch->buffer.data();
+                while (bytes != 0)
+                {
+                    const FILE_NOTIFY_INFORMATION* info = reinterpret_cast<const FILE_NOTIFY_INFORMATION*>(entry);
+                    if (info->Action != FILE_ACTION_REMOVED && info->Action != FILE_ACTION_RENAMED_OLD_NAME)
+                    {
+                        const int name_length = static_cast<int>(info->FileNameLength / sizeof(WCHAR));
+                        const int size        = WideCharToMultiByte(CP_UTF8, 0, info->FileName, name_length, nullptr, 0, nullptr, nullptr);
+                        string name(size, '\0');
+                        WideCharToMultiByte(CP_UTF8, 0, info->FileName, name_length, name.data(), size, nullptr, nullptr);
+
+                        on_change(to_generic(watch->directory + "/" + name));
+                    }
+
+                    if (info->NextEntryOffset == 0)
+                        break;
+
+                    entry += info->NextEntryOffset;
+                }
+
+                ResetEvent(watch->overlapped.hEvent);
+                issue_read(*watch);
+            }
+        }
+
+        void shutdown_os()
+        {
+            for (unique_ptr<Watch>& watch : watches)
+            {
+                CancelIo(watch->handle);
+                CloseHandle(watch->handle);
+                CloseHandle(watch->overlapped.hEvent);
+            }
+            watches.clear();
+        }
+    #else
+        int inotify_fd = -1;
+        unordered_map<int, string> watches; // watch descriptor -> directory
+
+        bool initialize_os()
+        {
+            inotify_fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+            return inotify_fd >= 0;
+        }
+
+        void add_watch(const string& directory, const bool report_files = false)
+        {
+            // a watch isn't recursive, so every subdirectory needs its own
+            const uint32_t mask = IN_CLOSE_WRITE | IN_MODIFY | IN_MOVED_TO | IN_CREATE;
+            const int watch     = inotify_add_watch(inotify_fd, directory.c_str(), mask);
+            if (watch < 0)
+            {
+                SP_LOG_ERROR("Failed to watch \"%s\"", directory.c_str());
+                return;
+            }
+            watches[watch] = directory;
+
+            error_code error;
+            for (const filesystem::directory_entry& entry : filesystem::directory_iterator(directory, error))
+            {
+                if (entry.is_directory(error))
+                {
+                    add_watch(to_generic(entry.path().string()), report_files);
+                }
+                else if (report_files)
+                {
+                    on_change(to_generic(entry.path().string()));
+                }
+            }
+        }
+
+        void read_changes()
+        {
+            alignas(inotify_event) char buffer[16 * 1024];
+            bool overflowed = false;
+            while (true)
+            {
+                // non-blocking, fails with EAGAIN once everything has been read
+                const ssize_t length = read(inotify_fd, buffer, sizeof(buffer));
+                if (length <= 0)
+                    break;
+
+                for (char* position = buffer; position < buffer + length;)
+                {
+                    const inotify_event* event = reinterpret_cast<const inotify_event*>(position);
+                    position                  += sizeof(inotify_event) + event->len;
+
+                    // the kernel's queue was full and events were dropped
+                    if (event->mask & IN_Q_OVERFLOW)
+                    {
+                        overflowed = true;
+                        continue;
+                    }
+
+                    // the directory was deleted or moved away, the watch is gone
+                    if (event->mask & IN_IGNORED)
+                    {
+                        watches.erase(event->wd);
+                        continue;
+                    }
+
+                    auto it = watches.find(event->wd);
+                    if (it == watches.end() || event->len == 0)
+                        continue;
+
+                    const string path = it->second + "/" + event->name;
+                    if (event->mask & IN_ISDIR)
+                    {
+                        // new directories are watched as well, what was written into them before the watch existed is reported
+                        if (event->mask & (IN_CREATE | IN_MOVED_TO))
+                        {
+                            add_watch(path, true);
+                        }
+                    }
+                    else
+                    {
+                        on_change(path);
+                    }
+                }
+            }
+
+            // dropped events can include new directories, so the watches are renewed too
+            if (overflowed)
+            {
+                for (const string& directory : directories)
+                {
+                    add_watch(directory);
+                    rescan(directory);
+                }
+            }
+        }
+
+        void shutdown_os()
+        {
+            if (inotify_fd >= 0)
+            {
+                close(inotify_fd); // removes the watches as well
+                inotify_fd = -1;
+            }
+            watches.clear();
+        }
+    #endif
+    }
+
+    void FileWatcher::Initialize()
+    {
+        lock_guard lock(mutex_watcher);
+
+        time_poll_previous = filesystem::file_time_type::clock::now();
+        if (!initialize_os())
+        {
+            SP_LOG_ERROR("Failed to initialize, files won't be watched");
+        }
+    }
+
+    void FileWatcher::Shutdown()
+    {
+        lock_guard lock(mutex_watcher);
+
+        shutdown_os();
+        changes_pending.clear();
+        directories.clear();
+    }
+
+    void FileWatcher::AddDirectory(const string& directory)
+    {
+        const string directory_generic = to_generic(directory);
+        if (!FileSystem::IsDirectory(directory_generic))
+        {
+            SP_LOG_ERROR("\"%s\" is not a directory", directory_generic.c_str());
+            return;
+        }
+
+        lock_guard lock(mutex_watcher);
+        add_watch(directory_generic);
+        directories.emplace_back(directory_generic);
+    }
+
+    void FileWatcher::Poll(vector<string>& file_paths)
+    {
+        lock_guard lock(mutex_watcher);
+
+        const filesystem::file_time_type time_poll = filesystem::file_time_type::clock::now();
+        read_changes();
+        time_poll_previous = time_poll;
+
+        // report what has been quiet long enough
+        const chrono::steady_clock::time_point now = chrono::steady_clock::now();
+        for (auto it = changes_pending.begin(); it != changes_pending.end();)
+        {
+            if (chrono::duration<float, milli>(now - it->second).count() >= coalesce_time_ms)
+            {
+                // temporary files which were renamed or deleted in the meantime are of no interest
+                if (FileSystem::IsFile(it->first))
+                {
+                    file_paths.emplace_back(it->first);
+                }
+                it = changes_pending.erase(it);
+            }
+            else
+            {
+                ++it;
+            }
+        }
+    }
+
+    void FileWatcher::SetCoalesceTimeMs(const float time_ms)
+    {
+        coalesce_time_ms = time_ms;
+    }
+}
@@ -0,0 +1,49 @@
+/*
+Copyright(c) 2016-2024 Panos Karabelas
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+copies of the Software, and to permit persons to whom the Software is furnished
+to do so, subject to the following conditions :
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE AUTHORS OR
+COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#pragma once
+
+//= INCLUDES ===================
+#include <string>
+#include <vector>
+#include "../Core/Definitions.h"
+//==============================
+
+namespace Spartan
+{
+    // watches directories (and their subdirectories) for files which are written, created or renamed into
+    // them, a burst of changes to the same file (editors tend to write in several steps) is reported once,
+    // after the file has been quiet for a short while, backed by inotify on linux and ReadDirectoryChangesW on windows
+    class SP_CLASS FileWatcher
+    {
+    public:
+        static void Initialize();
+        static void Shutdown();
+
+        static void AddDirectory(const std::string& directory);
+
+        // non-blocking, appends the files which changed and have settled since the last call
+        static void Poll(std::vector<std::string>& file_paths);
+
+        // how long a file has to be quiet before it's reported
+        static void SetCoalesceTimeMs(const float time_ms);
+    };
+}
@@ -0,0 +1,624 @@
+/*
+Copyright(c) 2016-2024 Panos Karabelas
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+copies of the Software, and to permit persons to whom the Software is furnished
+to do so, subject to the following conditions :
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE AUTHORS OR
+COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+//= INCLUDES ======================
+#include "pch.h"
+#include "VirtualFileSystem.h"
+#include "../Core/Stopwatch.h"
+#include <shared_mutex>
+#ifdef _MSC_VER
+#include <Windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+//=================================
+
+//= NAMESPACES =====
+using namespace std;
+//==================
+
+namespace Spartan
+{
+    namespace
+    {
+        // bump when the layout changes
+        const uint32_t pack_magic   = 0x4B415053; // "SPAK"
+        const uint32_t pack_version = 1;
+
+        enum class Compression : uint32_t
+        {
+            None,
+            Lz4
+        };
+
+        struct PackHeader
+        {
+            uint32_t magic        = pack_magic;
+            uint32_t version      = pack_version;
+            uint32_t entry_count  = 0;
+            uint32_t alignment    = 0;
+            uint64_t entry_offset = 0; // the table of contents, sorted by hash
+            uint64_t path_offset  = 0; // the paths the entries point into, to tell hash collisions apart
+        };
+
+        struct PackEntry
+        {
+            uint64_t hash            = 0;
+            uint64_t offset          = 0;
+            uint64_t size_stored     = 0;
+            uint64_t size            = 0;
+            uint32_t path_offset     = 0;
+            uint32_t path_length     = 0;
+            Compression compression  = Compression::None;
+            uint32_t padding         = 0;
+        };
+
+        struct MountedPack
+        {
+            string path;
+            const uint8_t* data      = nullptr;
+            uint64_t size            = 0;
+            const PackEntry* entries = nullptr;
+            uint32_t entry_count     = 0;
+            const char* paths        = nullptr;
+        #ifdef _MSC_VER
+            HANDLE file              = INVALID_HANDLE_VALUE;
+            HANDLE mapping           = nullptr;
+        #endif
+        };
+
+        shared_mutex mutex_packs;
+        vector<MountedPack> packs;
+
+        // fnv-1a, stable across runs and platforms which matters for an on-disk key
+        uint64_t hash_fnv1a(const string& value)
+        {
+            uint64_t hash = 0xcbf29ce484222325;
+            for (const char c : value)
+            {
+                hash ^= static_cast<uint8_t>(c);
+                hash *= 0x100000001b3;
+            }
+
+            return hash;
+        }
+
+        // the key a file is stored under, relative to the working directory with generic separators
+        string to_key(const string& file_path)
+        {
+            string path_generic = file_path;
+            replace(path_generic.begin(), path_generic.end(), '\\', '/');
+
+            filesystem::path path(path_generic);
+            if (path.is_absolute())
+            {
+                error_code error;
+                path = path.lexically_relative(filesystem::current_path(error));
+            }
+
+            string key = path.lexically_normal().generic_string();
+            transform(key.begin(), key.end(), key.begin(), [](const char c) { return static_cast<char>(tolower(static_cast<unsigned char>(c))); });
+
+            return key;
+        }
+
+        // expects the lock to be held, the most recently mounted pack wins
+        const PackEntry* find(const string& file_path, const MountedPack** pack_out)
+        {
+            if (packs.empty())
+                return nullptr;
+
+            const string key   = to_key(file_path);
+            const uint64_t hash = hash_fnv1a(key);
+            for (auto pack = packs.rbegin(); pack != packs.rend(); ++pack)
+            {
+                const PackEntry* end   = pack->entries + pack->entry_count;
+                const PackEntry* entry = lower_bound(pack->entries, end, hash, [](const PackEntry& entry, const uint64_t hash) { return entry.hash < hash; });
+                for (; entry != end && entry->hash == hash; entry++)
+                {
+                    if (string_view(pack->paths + entry->path_offset, entry->path_length) == key)
+                    {
+                        *pack_out = &(*pack);
+                        return entry;
+                    }
+                }
+            }
+
+            return nullptr;
+        }
+
+        // the lz4 block format, implemented here as there is no compression library among the dependencies
+        namespace lz4
+        {
+            const size_t min_match        = 4;
+            const size_t last_literals    = 5;  // the last bytes are always literals
+            const size_t match_find_limit = 12; // and no match starts within this many bytes of the end
+            const uint32_t hash_bits      = 16;
+
+            uint32_t read_u32(const uint8_t* data)
+            {
+                uint32_t value;
+                memcpy(&value, data, sizeof(value));
+                return value;
+            }
+
+            void write_length(vector<uint8_t>& output, size_t length)
+            {
+                while (length >= 255)
+                {
+                    output.push_back(255);
+                    length -= 255;
+                }
+                output.push_back(static_cast<uint8_t>(length));
+            }
+
+            void write_sequence(vector<uint8_t>& output, const uint8_t* literals, const size_t literal_count, const size_t offset, const size_t match_length)
+            {
+                const size_t match_code = match_length ? match_length - min_match : 0;
+                output.push_back(static_cast<uint8_t>((min(literal_count, size_t(15)) << 4) | min(match_code, size_t(15))));
+                if (literal_count >= 15)
+                {
+                    write_length(output, literal_count - 15);
+                }
+                output.insert(output.end(), literals, literals + literal_count);
+
+                // the last sequence has no match
+                if (match_length == 0)
+                    return;
+
+                output.push_back(static_cast<uint8_t>(offset & 0xFF));
+                output.push_back(static_cast<uint8_t>(offset >> 8));
+                if (match_code >= 15)
+                {
+                    write_length(output, match_code - 15);
+                }
+            }
+
+            // greedy, a single hash table of the most recent position of every 4 byte sequence
+            void compress(const uint8_t* input, const size_t size, vector<uint8_t>& output)
+            {
+                output.clear();
+                output.reserve(size + size / 255 + 16);
+
+                size_t anchor = 0;
+                if (size > match_find_limit)
+                {
+                    vector<uint32_t> table(size_t(1) << hash_bits, numeric_limits<uint32_t>::max());
+                    const size_t match_start_end = size - match_find_limit;
+                    const size_t match_end       = size - last_literals;
+
+                    size_t position = 0;
+                    while (position < match_start_end)
+                    {
+                        const uint32_t sequence  = read_u32(input + position);
+                        const uint32_t hash      = (sequence * 2654435761u) >> (32 - hash_bits);
+                        const uint32_t candidate = table[hash];
+                        table[hash]              = static_cast<uint32_t>(position);
+
+                        if (candidate == numeric_limits<uint32_t>::max() || position - candidate > 0xFFFF || read_u32(input + candidate) != sequence)
+                        {
+                            position++;
+                            continue;
+                        }
+
+                        size_t match_length = min_match;
+                        while (position + match_length < match_end && input[candidate + match_length] == input[position + match_length])
+                        {
+                            match_length++;
+                        }
+
+                        write_sequence(output, input + anchor, position - anchor, position - candidate, match_length);
+                        position += match_length;
+                        anchor    = position;
+                    }
+                }
+
+                write_sequence(output, input + anchor, size - anchor, 0, 0);
+            }
+
+            bool decompress(const uint8_t* input, const size_t input_size, uint8_t* output, const size_t output_size)
+            {
+                size_t position_in  = 0;
+                size_t position_out = 0;
+
+                auto read_length = [&](size_t& length)
+                {
+                    uint8_t value = 255;
+                    while (value == 255)
+                    {
+                        if (position_in >= input_size)
+                            return false;
+
+                        value   = input[position_in++];
+                        length += value;
+                    }
+
+                    return true;
+                };
+
+                while (position_in < input_size)
+                {
+                    const uint8_t token = input[position_in++];
+
+                    // literals
+                    size_t literal_count = token >> 4;
+                    if (literal_count == 15 && !read_length(literal_count))
+                        return false;
+
+                    if (position_in + literal_count > input_size || position_out + literal_count > output_size)
+                        return false;
+
+                    memcpy(output + position_out, input + position_in, literal_count);
+                    position_in  += literal_count;
+                    position_out += literal_count;
+
+                    // the last sequence ends after its literals
+                    if (position_in == input_size)
+                        break;
+
+                    // match
+                    if (position_in + 2 > input_size)
+                        return false;
+
+                    const size_t offset = input[position_in] | (input[position_in + 1] << 8);
+                    position_in        += 2;
+                    if (offset == 0 || offset > position_out)
+                        return false;
+
+                    size_t match_length = token & 15;
+                    if (match_length == 15 && !read_length(match_length))
+                        return false;
+                    match_length += min_match;
+
+                    if (position_out + match_length > output_size)
+                        return false;
+
+                    // byte by byte, a match can overlap the bytes it's producing
+                    for (size_t i = 0; i < match_length; i++, position_out++)
+                    {
+                        output[position_out] = output[position_out - offset];
+                    }
+                }
+
+                return position_out == output_size;
+            }
+        }
+
+        bool map_file(MountedPack& pack)
+        {
+        #ifdef _MSC_VER
+            pack.file = CreateFileW(FileSystem::StringToWstring(pack.path).c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_FLAG_RANDOM_ACCESS, nullptr);
+            if (pack.file == INVALID_HANDLE_VALUE)
+                return false;
+
+            LARGE_INTEGER size = {};
+            GetFileSizeEx(pack.file, &size);
+            pack.size    = static_cast<uint64_t>(size.QuadPart);
+            pack.mapping = CreateFileMappingW(pack.file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+            if (!pack.mapping)
+            {
+                CloseHandle(pack.file);
+                return false;
+            }
+
+            pack.data = static_cast<const uint8_t*>(MapViewOfFile(pack.mapping, FILE_MAP_READ, 0, 0, 0));
+            if (!pack.data)
+            {
+                CloseHandle(pack.mapping);
+                CloseHandle(pack.file);
+                return false;
+            }
+        #else
+            const int file = open(pack.path.c_str(), O_RDONLY | O_CLOEXEC);
+            if (file < 0)
+                return false;
+
+            struct stat file_stat = {};
+            if (fstat(file, &file_stat) != 0 || file_stat.st_size == 0)
+            {
+                close(file);
+                return false;
+            }
+
+            // the mapping keeps the file alive, so the descriptor can go
+            pack.size    = static_cast<uint64_t>(file_stat.st_size);
+            void* memory = mmap(nullptr, pack.size, PROT_READ, MAP_PRIVATE, file, 0);
+            close(file);
+            if (memory == MAP_FAILED)
+                return false;
+
+            pack.data = static_cast<const uint8_t*>(memory);
+        #endif
+
+            return true;
+        }
+
+        void unmap_file(MountedPack& pack)
+        {
+        #ifdef _MSC_VER
+            UnmapViewOfFile(pack.data);
+            CloseHandle(pack.mapping);
+            CloseHandle(pack.file);
+        #else
+            munmap(const_cast<uint8_t*>(pack.data), pack.size);
+        #endif
+            pack.data = nullptr;
+        }
+    }
+
+    bool VirtualFileSystem::Mount(const string& pack_path)
+    {
+        MountedPack pack;
+        pack.path = pack_path;
+        if (!map_file(pack))
+        {
+            SP_LOG_ERROR("Failed to map \"%s\"", pack_path.c_str());
+            return false;
+        }
+
+        // validate
+        PackHeader header;
+        bool is_valid = pack.size >= sizeof(PackHeader);
+        if (is_valid)
+        {
+            memcpy(&header, pack.data, sizeof(PackHeader));
+            is_valid = header.magic == pack_magic && header.version == pack_version &&
+                       header.entry_offset % alignof(PackEntry) == 0 && header.entry_offset <= pack.size &&
+                       header.entry_count <= (pack.size - header.entry_offset) / sizeof(PackEntry) &&
+                       header.path_offset <= pack.size;
+        }
+
+        // every entry has to stay within the pack, lookups and reads trust them from here on
+        if (is_valid)
+        {
+            const PackEntry* entries = reinterpret_cast<const PackEntry*>(pack.data + header.entry_offset);
+            const uint64_t path_size = pack.size - header.path_offset;
+            for (uint32_t i = 0; i < header.entry_count && is_valid; i++)
+            {
+                const PackEntry& entry = entries[i];
+                is_valid = entry.offset <= pack.size && entry.size_stored <= pack.size - entry.offset &&
+                           entry.path_offset <= path_size && entry.path_length <= path_size - entry.path_offset;
+
+                // uncompressed entries are copied and mapped as they are, lz4 can't expand a byte into more than 255
+                if (entry.compression == Compression::None)
+                {
+                    is_valid = is_valid && entry.size == entry.size_stored;
+                }
+                else
+                {
+                    is_valid = is_valid && entry.compression == Compression::Lz4 && entry.size <= entry.size_stored * 255;
+                }
+            }
+        }
+
+        if (!is_valid)
+        {
+            SP_LOG_ERROR("\"%s\" is not a valid pack", pack_path.c_str());
+            unmap_file(pack);
+            return false;
+        }
+
+        pack.entries     = reinterpret_cast<const PackEntry*>(pack.data + header.entry_offset);
+        pack.entry_count = header.entry_count;
+        pack.paths       = reinterpret_cast<const char*>(pack.data + header.path_offset);
+
+        unique_lock lock(mutex_packs);
+        packs.emplace_back(pack);
+
+        SP_LOG_INFO("Mounted \"%s\" with %d files", pack_path.c_str(), header.entry_count);
+        return true;
+    }
+
+    void VirtualFileSystem::Shutdown()
+    {
+        unique_lock lock(mutex_packs);
+
+        for (MountedPack& pack : packs)
+        {
+            unmap_file(pack);
+        }
+        packs.clear();
+    }
+
+    bool VirtualFileSystem::Exists(const string& file_path)
+    {
+        shared_lock lock(mutex_packs);
+
+        const MountedPack* pack = nullptr;
+        return find(file_path, &pack) != nullptr;
+    }
+
+    bool VirtualFileSystem::Read(const string& file_path, vector<byte>& bytes)
+    {
+        {
+            shared_lock lock(mutex_packs);
+
+            const MountedPack* pack = nullptr;
+            if (const PackEntry* entry = find(file_path, &pack))
+            {
+                const uint8_t* data = pack->data + entry->offset;
+                bytes.resize(entry->size);
+
+                if (entry->compression == Compression::None)
+                {
+                    memcpy(bytes.data(), data, entry->size);
+                    return true;
+                }
+
+                if (lz4::decompress(data, entry->size_stored, reinterpret_cast<uint8_t*>(bytes.data()), entry->size))
+                    return true;
+
+                SP_LOG_ERROR("\"%s\" is corrupted in \"%s\"", file_path.c_str(), pack->path.c_str());
+                return false;
+            }
+        }
+
+        // loose file
+        ifstream file(file_path, ios::binary | ios::ate);
+        if (!file)
+            return false;
+
+        bytes.resize(static_cast<size_t>(file.tellg()));
+        file.seekg(0);
+        file.read(reinterpret_cast<char*>(bytes.data()), bytes.size());
+
+        return static_cast<bool>(file);
+    }
+
+    bool VirtualFileSystem::Map(const string& file_path, const byte** data, uint64_t* size)
+    {
+        shared_lock lock(mutex_packs);
+
+        const MountedPack* pack = nullptr;
+        const PackEntry* entry = find(file_path, &pack);
+        if (!entry || entry->compression != Compression::None)
+            return false;
+
+        *data = reinterpret_cast<const byte*>(pack->data + entry->offset);
+        *size = entry->size;
+
+        return true;
+    }
+
+    bool VirtualFileSystem::Pack(const string& directory, const string& pack_path, const bool compress, const uint32_t alignment)
+    {
+        SP_ASSERT(alignment != 0 && (alignment & (alignment - 1)) == 0);
+
+        if (!FileSystem::IsDirectory(directory))
+        {
+            SP_LOG_ERROR("\"%s\" is not a directory", directory.c_str());
+            return false;
+        }
+
+        const Stopwatch timer;
+
+        vector<string> file_paths;
+        {
+            error_code error;
+            for (const filesystem::directory_entry& entry : filesystem::recursive_directory_iterator(directory, error))
+            {
+                if (entry.is_regular_file(error) && !filesystem::equivalent(entry.path(), pack_path, error))
+                {
+                    file_paths.emplace_back(entry.path().generic_string());
+                }
+            }
+        }
+
+        ofstream file(pack_path, ios::binary | ios::trunc);
+        if (!file)
+        {
+            SP_LOG_ERROR("Failed to create \"%s\"", pack_path.c_str());
+            return false;
+        }
+
+        // the header is written again once the offsets are known
+        PackHeader header;
+        header.alignment = alignment;
+        file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+
+        auto align = [&file, alignment]()
+        {
+            const uint64_t position = static_cast<uint64_t>(file.tellp());
+            const uint64_t padding  = (alignment - (position % alignment)) % alignment;
+            for (uint64_t i = 0; i < padding; i++)
+            {
+                file.put(0);
+            }
+        };
+
+        // one file at a time, so that packing doesn't need memory for all of them
+        vector<PackEntry> entries;
+        string paths;
+        vector<uint8_t> bytes;
+        vector<uint8_t> bytes_compressed;
+        uint64_t size_total        = 0;
+        uint64_t size_total_stored = 0;
+        for (const string& file_path : file_paths)
+        {
+            ifstream input(file_path, ios::binary | ios::ate);
+            if (!input)
+            {
+                SP_LOG_WARNING("Skipping \"%s\", it can't be read", file_path.c_str());
+                continue;
+            }
+
+            bytes.resize(static_cast<size_t>(input.tellg()));
+            input.seekg(0);
+            input.read(reinterpret_cast<char*>(bytes.data()), bytes.size());
+
+            const string key = to_key(file_path);
+
+            PackEntry entry;
+            entry.hash        = hash_fnv1a(key);
+            entry.size        = bytes.size();
+            entry.path_offset = static_cast<uint32_t>(paths.size());
+            entry.path_length = static_cast<uint32_t>(key.size());
+            paths            += key;
+
+            // already compressed formats (most images) don't shrink, they stay uncompressed so that they can be mapped
+            const uint8_t* data = bytes.data();
+            entry.size_stored   = bytes.size();
+            if (compress && !bytes.empty())
+            {
+                lz4::compress(bytes.data(), bytes.size(), bytes_compressed);
+                if (bytes_compressed.size() < bytes.size() - bytes.size() / 8)
+                {
+                    data              = bytes_compressed.data();
+                    entry.size_stored = bytes_compressed.size();
+                    entry.compression = Compression::Lz4;
+                }
+            }
+
+            align();
+            entry.offset = static_cast<uint64_t>(file.tellp());
+            file.write(reinterpret_cast<const char*>(data), entry.size_stored);
+            entries.emplace_back(entry);
+
+            size_total        += entry.size;
+            size_total_stored += entry.size_stored;
+        }
+
+        // table of contents
+        sort(entries.begin(), entries.end(), [](const PackEntry& a, const PackEntry& b) { return a.hash < b.hash; });
+        align();
+        header.entry_count  = static_cast<uint32_t>(entries.size());
+        header.entry_offset = static_cast<uint64_t>(file.tellp());
+        file.write(reinterpret_cast<const char*>(entries.data()), entries.size() * sizeof(PackEntry));
+        header.path_offset  = static_cast<uint64_t>(file.tellp());
+        file.write(paths.data(), paths.size());
+
+        file.seekp(0);
+        file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        if (!file)
+        {
+            SP_LOG_ERROR("Failed to write \"%s\"", pack_path.c_str());
+            return false;
+        }
+
+        SP_LOG_INFO("Packed %d files (%.1f MB into %.1f MB) into \"%s\" in %.1f ms",
+            header.entry_count, size_total / (1024.0 * 1024.0), size_total_stored / (1024.0 * 1024.0), pack_path.c_str(), timer.GetElapsedTimeMs());
+
+        return true;
+    }
+}
@@ -0,0 +1,54 @@
+/*
+Copyright(c) 2016-2024 Panos Karabelas
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+copies of the Software, and to permit persons to whom the Software is furnished
+to do so, subject to the following conditions :
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE AUTHORS OR
+COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#pragma once
+
+//= INCLUDES ===================
+#include <string>
+#include <vector>
+#include "../Core/Definitions.h"
+//==============================
+
+namespace Spartan
+{
+    // files can be read from pack files (archives) as well as from disk, a pack is memory mapped and its table
+    // of contents is sorted by path hash, entries are aligned so that uncompressed ones can be used in place,
+    // the rest are lz4 compressed, paths are looked up relative to the working directory and case insensitively,
+    // packs which are mounted later take precedence and anything which isn't in a pack is read from disk
+    class SP_CLASS VirtualFileSystem
+    {
+    public:
+        static bool Mount(const std::string& pack_path);
+        static void Shutdown();
+
+        // true if a mounted pack has the file
+        static bool Exists(const std::string& file_path);
+
+        // reads a file from the packs, or from disk
+        static bool Read(const std::string& file_path, std::vector<std::byte>& bytes);
+
+        // the file in place, only for uncompressed files in a pack, the memory lives as long as the pack is mounted
+        static bool Map(const std::string& file_path, const std::byte** data, uint64_t* size);
+
+        // the packer, every file in the directory (and its subdirectories) goes into the pack
+        static bool Pack(const std::string& directory, const std::string& pack_path, const bool compress = true, const uint32_t alignment = 64);
+    };
+}
@@ -142,6 +142,7 @@ namespace Spartan
     void Physics::Tick()
     {
         SP_PROFILE_CPU();
+        SP_MEMORY_TAG(MemoryTag::Physics);
 
         bool is_in_editor_mode = !Engine::IsFlagSet(EngineMode::Game);
         bool physics_enabled   = Engine::IsFlagSet(EngineMode::Physics);
@@ -0,0 +1,411 @@
+﻿/*
+Copyright(c) 2016-2024 Panos Karabelas
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+copies of the Software, and to permit persons to whom the Software is furnished
+to do so, subject to the following conditions :
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE AUTHORS OR
+COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+//= INCLUDES ===============
+#include "pch.h"
+#include "MemoryTracker.h"
+#include <new>
+#include <cstdlib>
+#ifdef _MSC_VER
+#include <intrin.h>
+#include <Windows.h>
+#include <DbgHelp.h>
+#pragma intrinsic(_ReturnAddress)
+#pragma comment(lib, "dbghelp.lib")
+#define SP_RETURN_ADDRESS() _ReturnAddress()
+#else
+#include <execinfo.h>
+#define SP_RETURN_ADDRESS() __builtin_return_address(0)
+#endif
+//==========================
+
+//= NAMESPACES =====
+using namespace std;
+//==================
+
+namespace Spartan
+{
+    namespace
+    {
+        // everything here is used by operator new, so it can't allocate and it has to be
+        // usable before any constructor runs, hence the zero initialized atomics and plain arrays
+
+        const uint32_t tag_count       = static_cast<uint32_t>(MemoryTag::Max);
+        const uint32_t call_site_count = 4096; // power of two
+        const uint32_t call_site_probe = 16;
+        const uint16_t call_site_other = 0;    // allocations whose call site didn't fit in the table
+        const size_t header_size       = 16;
+        const uint64_t key_tag_shift   = 56;   // user space addresses don't reach these bits
+
+        // precedes every allocation
+        struct Header
+        {
+            uint64_t size      = 0;
+            uint32_t offset    = 0; // from the start of the block malloc returned
+            uint16_t call_site = 0;
+            uint8_t tag        = 0;
+            uint8_t padding    = 0;
+        };
+        static_assert(sizeof(Header) == header_size, "the header has to keep the default new alignment");
+
+        struct TagCounters
+        {
+            atomic<uint64_t> bytes_live;
+            atomic<uint64_t> bytes_peak;
+            atomic<uint64_t> bytes_total;
+            atomic<uint64_t> allocations_live;
+            atomic<uint64_t> allocations_total;
+        };
+        TagCounters tag_counters[tag_count];
+
+        // open addressing, keyed by return address and tag
+        struct CallSiteCounters
+        {
+            atomic<uint64_t> key;
+            atomic<uint64_t> allocations;
+            atomic<uint64_t> bytes_live;
+        };
+        CallSiteCounters call_sites[call_site_count];
+
+        thread_local MemoryTag tag_current = MemoryTag::Untagged;
+
+        // only touched by Tick()
+        array<uint64_t, tag_count> allocations_total_previous = {};
+        array<uint64_t, tag_count> bytes_total_previous       = {};
+        array<uint64_t, tag_count> allocations_per_frame      = {};
+        array<uint64_t, tag_count> bytes_per_frame            = {};
+        array<uint64_t, tag_count> budgets                    = {};
+        array<bool, tag_count> over_budget                    = {};
+
+        const char* tag_names[] = { "Untagged", "Persistent", "World", "Resources", "Physics", "Renderer", "Importers" };
+        static_assert(size(tag_names) == tag_count, "every tag needs a name");
+
+        bool is_leak_checked(const MemoryTag tag)
+        {
+            return tag != MemoryTag::Untagged && tag != MemoryTag::Persistent;
+        }
+
+        uint16_t acquire_call_site(void* address, const MemoryTag tag)
+        {
+            uint64_t key  = reinterpret_cast<uint64_t>(address) | (static_cast<uint64_t>(tag) << key_tag_shift);
+            uint32_t hash = static_cast<uint32_t>(((key >> 4) * 0x9E3779B97F4A7C15ull) >> 32);
+
+            for (uint32_t probe = 0; probe < call_site_probe; probe++)
+            {
+                uint32_t slot = (hash + probe) & (call_site_count - 1);
+                if (slot == call_site_other)
+                    continue;
+
+                uint64_t existing = call_sites[slot].key.load(memory_order_relaxed);
+                if (existing == key)
+                    return static_cast<uint16_t>(slot);
+
+                if (existing == 0)
+                {
+                    if (call_sites[slot].key.compare_exchange_strong(existing, key, memory_order_relaxed) || existing == key)
+                        return static_cast<uint16_t>(slot);
+                }
+            }
+
+            return call_site_other;
+        }
+
+        void* allocate(const size_t size, size_t alignment, void* return_address)
+        {
+            // malloc is 16 byte aligned on x64, so the header plus any extra alignment fits in this many bytes
+            alignment = max(alignment, header_size);
+
+            // the padded size would wrap and return a tiny block, the throwing overloads turn this into bad_alloc
+            if (size > SIZE_MAX - alignment)
+                return nullptr;
+
+            uint8_t* block = static_cast<uint8_t*>(malloc(size + alignment));
+            if (!block)
+                return nullptr;
+
+            uintptr_t start = reinterpret_cast<uintptr_t>(block) + header_size;
+            uint8_t* data   = reinterpret_cast<uint8_t*>((start + alignment - 1) & ~(static_cast<uintptr_t>(alignment) - 1));
+
+            MemoryTag tag     = tag_current;
+            Header* header    = reinterpret_cast<Header*>(data) - 1;
+            header->size      = size;
+            header->offset    = static_cast<uint32_t>(data - block);
+            header->call_site = acquire_call_site(return_address, tag);
+            header->tag       = static_cast<uint8_t>(tag);
+
+            TagCounters& counters = tag_counters[header->tag];
+            uint64_t bytes_live   = counters.bytes_live.fetch_add(size, memory_order_relaxed) + size;
+            counters.bytes_total.fetch_add(size, memory_order_relaxed);
+            counters.allocations_live.fetch_add(1, memory_order_relaxed);
+            counters.allocations_total.fetch_add(1, memory_order_relaxed);
+
+            uint64_t bytes_peak = counters.bytes_peak.load(memory_order_relaxed);
+            while (bytes_live > bytes_peak && !counters.bytes_peak.compare_exchange_weak(bytes_peak, bytes_live, memory_order_relaxed)) {}
+
+            CallSiteCounters& call_site = call_sites[header->call_site];
+            call_site.allocations.fetch_add(1, memory_order_relaxed);
+            call_site.bytes_live.fetch_add(size, memory_order_relaxed);
+
+            return data;
+        }
+
+        void deallocate(void* data)
+        {
+            if (!data)
+                return;
+
+            Header* header = static_cast<Header*>(data) - 1;
+
+            TagCounters& counters = tag_counters[header->tag];
+            counters.bytes_live.fetch_sub(header->size, memory_order_relaxed);
+            counters.allocations_live.fetch_sub(1, memory_order_relaxed);
+            call_sites[header->call_site].bytes_live.fetch_sub(header->size, memory_order_relaxed);
+
+            free(static_cast<uint8_t*>(data) - header->offset);
+        }
+
+        string get_symbol_name(void* address)
+        {
+            char buffer[32];
+            snprintf(buffer, sizeof(buffer), "0x%llx", static_cast<unsigned long long>(reinterpret_cast<uintptr_t>(address)));
+            string name = buffer;
+
+#ifdef _MSC_VER
+            static bool initialized = false;
+            HANDLE process          = GetCurrentProcess();
+            if (!initialized)
+            {
+                SymSetOptions(SYMOPT_UNDNAME | SYMOPT_DEFERRED_LOADS);
+                SymInitialize(process, NULL, TRUE);
+                initialized = true;
+            }
+
+            char symbol_buffer[sizeof(SYMBOL_INFO) + MAX_SYM_NAME * sizeof(TCHAR)];
+            PSYMBOL_INFO symbol  = reinterpret_cast<PSYMBOL_INFO>(symbol_buffer);
+            symbol->SizeOfStruct = sizeof(SYMBOL_INFO);
+            symbol->MaxNameLen   = MAX_SYM_NAME;
+            DWORD64 displacement = 0;
+            if (SymFromAddr(process, reinterpret_cast<DWORD64>(address), &displacement, symbol))
+            {
+                name += string(" ") + symbol->Name;
+            }
+#else
+            if (char** symbols = backtrace_symbols(&address, 1))
+            {
+                name += string(" ") + symbols[0];
+                free(symbols);
+            }
+#endif
+
+            return name;
+        }
+    }
+
+    void MemoryTracker::Tick()
+    {
+        for (uint32_t i = 0; i < tag_count; i++)
+        {
+            TagCounters& counters = tag_counters[i];
+
+            uint64_t allocations_total    = counters.allocations_total.load(memory_order_relaxed);
+            uint64_t bytes_total          = counters.bytes_total.load(memory_order_relaxed);
+            allocations_per_frame[i]      = allocations_total - allocations_total_previous[i];
+            bytes_per_frame[i]            = bytes_total - bytes_total_previous[i];
+            allocations_total_previous[i] = allocations_total;
+            bytes_total_previous[i]       = bytes_total;
+
+            // warn once per crossing, not every frame
+            uint64_t bytes_live = counters.bytes_live.load(memory_order_relaxed);
+            bool is_over        = budgets[i] != 0 && bytes_live > budgets[i];
+            if (is_over && !over_budget[i])
+            {
+                SP_LOG_WARNING("%s is over its memory budget, %.2f/%.2f MB", tag_names[i], bytes_live / (1024.0 * 1024.0), budgets[i] / (1024.0 * 1024.0));
+            }
+            over_budget[i] = is_over;
+        }
+    }
+
+    void MemoryTracker::ReportLeaks()
+    {
+        // untagged and persistent memory is owned by statics and thread locals which are destroyed after this, so it's not a leak
+        bool leaked = false;
+        for (uint32_t i = 0; i < tag_count; i++)
+        {
+            if (!is_leak_checked(static_cast<MemoryTag>(i)))
+                continue;
+
+            MemoryTagStats stats = GetStats(static_cast<MemoryTag>(i));
+            if (stats.allocations_live != 0)
+            {
+                SP_LOG_WARNING("%s leaked %llu allocations, %.2f KB", tag_names[i], static_cast<unsigned long long>(stats.allocations_live), stats.bytes_live / 1024.0);
+                leaked = true;
+            }
+        }
+
+        if (!leaked)
+            return;
+
+        for (const MemoryCallSite& call_site : GetCallSites(16, true))
+        {
+            if (!is_leak_checked(call_site.tag))
+                continue;
+
+            SP_LOG_WARNING("%s: %.2f KB still alive, allocated at %s", tag_names[static_cast<uint32_t>(call_site.tag)], call_site.bytes_live / 1024.0, call_site.name.c_str());
+        }
+    }
+
+    MemoryTag MemoryTracker::GetTag()
+    {
+        return tag_current;
+    }
+
+    void MemoryTracker::SetTag(const MemoryTag tag)
+    {
+        tag_current = tag;
+    }
+
+    const char* MemoryTracker::GetTagName(const MemoryTag tag)
+    {
+        return tag_names[static_cast<uint32_t>(tag)];
+    }
+
+    void MemoryTracker::SetBudget(const MemoryTag tag, const uint64_t bytes)
+    {
+        budgets[static_cast<uint32_t>(tag)] = bytes;
+    }
+
+    bool MemoryTracker::IsWithinBudgets()
+    {
+        for (uint32_t i = 0; i < tag_count; i++)
+        {
+            if (budgets[i] != 0 && tag_counters[i].bytes_live.load(memory_order_relaxed) > budgets[i])
+                return false;
+        }
+
+        return true;
+    }
+
+    MemoryTagStats MemoryTracker::GetStats(const MemoryTag tag)
+    {
+        uint32_t index        = static_cast<uint32_t>(tag);
+        TagCounters& counters = tag_counters[index];
+
+        MemoryTagStats stats;
+        stats.bytes_live            = counters.bytes_live.load(memory_order_relaxed);
+        stats.bytes_peak            = counters.bytes_peak.load(memory_order_relaxed);
+        stats.allocations_live      = counters.allocations_live.load(memory_order_relaxed);
+        stats.allocations_per_frame = allocations_per_frame[index];
+        stats.bytes_per_frame       = bytes_per_frame[index];
+        stats.budget                = budgets[index];
+
+        return stats;
+    }
+
+    vector<MemoryCallSite> MemoryTracker::GetCallSites(const uint32_t count_max, const bool live_only)
+    {
+        vector<MemoryCallSite> result;
+        for (uint32_t slot = 0; slot < call_site_count; slot++)
+        {
+            CallSiteCounters& counters = call_sites[slot];
+
+            MemoryCallSite call_site;
+            uint64_t key          = counters.key.load(memory_order_relaxed);
+            call_site.address     = reinterpret_cast<void*>(key & ((uint64_t(1) << key_tag_shift) - 1));
+            call_site.tag         = static_cast<MemoryTag>(key >> key_tag_shift);
+            call_site.allocations = counters.allocations.load(memory_order_relaxed);
+            call_site.bytes_live  = counters.bytes_live.load(memory_order_relaxed);
+            if (call_site.allocations == 0 || (live_only && call_site.bytes_live == 0))
+                continue;
+
+            result.emplace_back(call_site);
+        }
+
+        sort(result.begin(), result.end(), [](const MemoryCallSite& a, const MemoryCallSite& b)
+        {
+            return a.bytes_live != b.bytes_live ? a.bytes_live > b.bytes_live : a.allocations > b.allocations;
+        });
+
+        if (result.size() > count_max)
+        {
+            result.resize(count_max);
+        }
+
+        // symbols are only resolved for what is returned, it's slow
+        for (MemoryCallSite& call_site : result)
+        {
+            call_site.name = call_site.address ? get_symbol_name(call_site.address) : "unknown (the call site table is full)";
+        }
+
+        return result;
+    }
+}
+
+//= GLOBAL ALLOCATION FUNCTIONS ==========================================================================================
+void* operator new(size_t size)
+{
+    if (void* data = Spartan::allocate(size, __STDCPP_DEFAULT_NEW_ALIGNMENT__, SP_RETURN_ADDRESS()))
+        return data;
+
+    throw bad_alloc();
+}
+
+void* operator new[](size_t size)
+{
+    if (void* data = Spartan::allocate(size, __STDCPP_DEFAULT_NEW_ALIGNMENT__, SP_RETURN_ADDRESS()))
+        return data;
+
+    throw bad_alloc();
+}
+
+void* operator new(size_t size, align_val_t alignment)
+{
+    if (void* data = Spartan::allocate(size, static_cast<size_t>(alignment), SP_RETURN_ADDRESS()))
+        return data;
+
+    throw bad_alloc();
+}
+
+void* operator new[](size_t size, align_val_t alignment)
+{
+    if (void* data = Spartan::allocate(size, static_cast<size_t>(alignment), SP_RETURN_ADDRESS()))
+        return data;
+
+    throw bad_alloc();
+}
+
+void* operator new(size_t size, const nothrow_t&) noexcept                             { return Spartan::allocate(size, __STDCPP_DEFAULT_NEW_ALIGNMENT__, SP_RETURN_ADDRESS()); }
+void* operator new[](size_t size, const nothrow_t&) noexcept                           { return Spartan::allocate(size, __STDCPP_DEFAULT_NEW_ALIGNMENT__, SP_RETURN_ADDRESS()); }
+void* operator new(size_t size, align_val_t alignment, const nothrow_t&) noexcept      { return Spartan::allocate(size, static_cast<size_t>(alignment), SP_RETURN_ADDRESS()); }
+void* operator new[](size_t size, align_val_t alignment, const nothrow_t&) noexcept    { return Spartan::allocate(size, static_cast<size_t>(alignment), SP_RETURN_ADDRESS()); }
+
+void operator delete(void* data) noexcept                                              { Spartan::deallocate(data); }
+void operator delete[](void* data) noexcept                                            { Spartan::deallocate(data); }
+void operator delete(void* data, size_t) noexcept                                      { Spartan::deallocate(data); }
+void operator delete[](void* data, size_t) noexcept                                    { Spartan::deallocate(data); }
+void operator delete(void* data, align_val_t) noexcept                                 { Spartan::deallocate(data); }
+void operator delete[](void* data, align_val_t) noexcept                               { Spartan::deallocate(data); }
+void operator delete(void* data, size_t, align_val_t) noexcept                         { Spartan::deallocate(data); }
+void operator delete[](void* data, size_t, align_val_t) noexcept                       { Spartan::deallocate(data); }
+void operator delete(void* data, const nothrow_t&) noexcept                            { Spartan::deallocate(data); }
+void operator delete[](void* data, const nothrow_t&) noexcept                          { Spartan::deallocate(data); }
+void operator delete(void* data, align_val_t, const nothrow_t&) noexcept               { Spartan::deallocate(data); }
+void operator delete[](void* data, align_val_t, const nothrow_t&) noexcept             { Spartan::deallocate(data); }
+//========================================================================================================================
@@ -0,0 +1,100 @@
+/*
+Copyright(c) 2016-2024 Panos Karabelas
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+copies of the Software, and to permit persons to whom the Software is furnished
+to do so, subject to the following conditions :
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE AUTHORS OR
+COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#pragma once
+
+//= INCLUDES ===================
+#include "../Core/Definitions.h"
+#include <string>
+#include <vector>
+//==============================
+
+// attributes every allocation made on this thread until the end of the scope to a subsystem
+#define SP_MEMORY_TAG(tag) Spartan::MemoryTagScope memory_tag_scope = Spartan::MemoryTagScope(tag);
+
+namespace Spartan
+{
+    enum class MemoryTag : uint8_t
+    {
+        Untagged,
+        Persistent, // kept for the lifetime of the process on purpose, like the frame arenas and scratch reused every frame
+        World,
+        Resources,
+        Physics,
+        Renderer,
+        Importers,
+        Max
+    };
+
+    struct MemoryTagStats
+    {
+        uint64_t bytes_live            = 0;
+        uint64_t bytes_peak            = 0;
+        uint64_t allocations_live      = 0;
+        uint64_t allocations_per_frame = 0; // the rate, over the last frame
+        uint64_t bytes_per_frame       = 0;
+        uint64_t budget                = 0; // 0 means no budget
+    };
+
+    struct MemoryCallSite
+    {
+        void* address         = nullptr;
+        MemoryTag tag         = MemoryTag::Untagged;
+        uint64_t allocations  = 0; // since startup
+        uint64_t bytes_live   = 0;
+        std::string name;
+    };
+
+    // the global operator new/delete are replaced, so every cpu allocation is counted, each one carries a small
+    // header with its size, tag and call site, which makes frees exact no matter which thread or tag frees it
+    class SP_CLASS MemoryTracker
+    {
+    public:
+        // called once per frame, computes the rates and checks the budgets
+        static void Tick();
+
+        // logs what is still alive, called at the very end of Engine::Shutdown(), untagged and persistent memory is not checked
+        static void ReportLeaks();
+
+        // tags, they are per thread and tasks added to the thread pool inherit the tag of the thread that added them
+        static MemoryTag GetTag();
+        static void SetTag(const MemoryTag tag);
+        static const char* GetTagName(const MemoryTag tag);
+
+        // a warning is logged when a tag exceeds its budget, returns false when any tag is over
+        static void SetBudget(const MemoryTag tag, const uint64_t bytes);
+        static bool IsWithinBudgets();
+
+        // stats
+        static MemoryTagStats GetStats(const MemoryTag tag);
+        static std::vector<MemoryCallSite> GetCallSites(const uint32_t count_max, const bool live_only); // sorted by live bytes
+    };
+
+    class MemoryTagScope
+    {
+    public:
+        MemoryTagScope(const MemoryTag tag) : m_tag_previous(MemoryTracker::GetTag()) { MemoryTracker::SetTag(tag); }
+        ~MemoryTagScope() { MemoryTracker::SetTag(m_tag_previous); }
+
+    private:
+        MemoryTag m_tag_previous;
+    };
+}
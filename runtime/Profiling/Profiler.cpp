@@ -27,7 +27,9 @@ CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 #include "../RHI/RHI_Implementation.h"
 #include "../RHI/RHI_SwapChain.h"
 #include "../Core/ThreadPool.h"
+#include "../Core/FrameArena.h"
 #include "../Rendering/Renderer.h"
+#include "../Resource/HotReload.h"
 #include "../Resource/ResourceCache.h"
 #include "../Display/Display.h"
 //====================================
@@ -41,22 +43,55 @@ namespace Spartan
     ProfilerGranularity granularity = ProfilerGranularity::Light;
 
     // metrics - rhi
-    uint32_t Profiler::m_rhi_draw                       = 0;
-    uint32_t Profiler::m_rhi_bindings_buffer_index      = 0;
-    uint32_t Profiler::m_rhi_bindings_buffer_vertex     = 0;
-    uint32_t Profiler::m_rhi_bindings_buffer_constant   = 0;
-    uint32_t Profiler::m_rhi_bindings_buffer_structured = 0;
-    uint32_t Profiler::m_rhi_bindings_sampler           = 0;
-    uint32_t Profiler::m_rhi_bindings_texture_sampled   = 0;
-    uint32_t Profiler::m_rhi_bindings_shader_vertex     = 0;
-    uint32_t Profiler::m_rhi_bindings_shader_pixel      = 0;
-    uint32_t Profiler::m_rhi_bindings_shader_compute    = 0;
-    uint32_t Profiler::m_rhi_bindings_render_target     = 0;
-    uint32_t Profiler::m_rhi_bindings_texture_storage   = 0;
-    uint32_t Profiler::m_rhi_bindings_descriptor_set    = 0;
-    uint32_t Profiler::m_rhi_bindings_pipeline          = 0;
-    uint32_t Profiler::m_rhi_pipeline_barriers          = 0;
-    uint32_t Profiler::m_rhi_timeblock_count            = 0;
+    atomic<uint32_t> Profiler::m_rhi_draw                       = 0;
+    atomic<uint32_t> Profiler::m_rhi_bindings_buffer_index      = 0;
+    atomic<uint32_t> Profiler::m_rhi_bindings_buffer_vertex     = 0;
+    atomic<uint32_t> Profiler::m_rhi_bindings_buffer_constant   = 0;
+    atomic<uint32_t> Profiler::m_rhi_bindings_buffer_structured = 0;
+    atomic<uint32_t> Profiler::m_rhi_bindings_sampler           = 0;
+    atomic<uint32_t> Profiler::m_rhi_bindings_texture_sampled   = 0;
+    atomic<uint32_t> Profiler::m_rhi_bindings_shader_vertex     = 0;
+    atomic<uint32_t> Profiler::m_rhi_bindings_shader_pixel      = 0;
+    atomic<uint32_t> Profiler::m_rhi_bindings_shader_compute    = 0;
+    atomic<uint32_t> Profiler::m_rhi_bindings_render_target     = 0;
+    atomic<uint32_t> Profiler::m_rhi_bindings_texture_storage   = 0;
+    atomic<uint32_t> Profiler::m_rhi_bindings_descriptor_set    = 0;
+    atomic<uint32_t> Profiler::m_rhi_bindings_pipeline          = 0;
+    atomic<uint32_t> Profiler::m_rhi_pipeline_barriers          = 0;
+    atomic<uint32_t> Profiler::m_rhi_timeblock_count            = 0;
+    atomic<uint32_t> Profiler::m_rhi_bindings_push_constant     = 0;
+    atomic<uint32_t> Profiler::m_rhi_skipped_pipeline           = 0;
+    atomic<uint32_t> Profiler::m_rhi_skipped_buffer_vertex      = 0;
+    atomic<uint32_t> Profiler::m_rhi_skipped_buffer_index       = 0;
+    atomic<uint32_t> Profiler::m_rhi_skipped_push_constant      = 0;
+
+    // metrics - renderer
+    uint32_t Profiler::m_renderer_draw_packets            = 0;
+    atomic<uint32_t> Profiler::m_renderer_triangles       = 0;
+    uint32_t Profiler::m_renderer_draws_unbatched         = 0;
+    uint32_t Profiler::m_renderer_draws_batched           = 0;
+    float Profiler::m_renderer_time_draw_list_build_ms    = 0.0f;
+    float Profiler::m_renderer_time_draw_list_record_ms   = 0.0f;
+    uint32_t Profiler::m_renderer_shadow_views_rendered   = 0;
+    uint32_t Profiler::m_renderer_shadow_views_composited = 0;
+    uint32_t Profiler::m_renderer_shadow_views_skipped    = 0;
+    uint32_t Profiler::m_renderer_occluders               = 0;
+    uint32_t Profiler::m_renderer_occluder_triangles      = 0;
+    uint32_t Profiler::m_renderer_occluded                = 0;
+    float Profiler::m_renderer_time_occlusion_ms          = 0.0f;
+    uint32_t Profiler::m_renderer_lights_clustered        = 0;
+    uint32_t Profiler::m_renderer_lights_culled           = 0;
+    uint32_t Profiler::m_renderer_light_cluster_indices   = 0;
+    float Profiler::m_renderer_time_light_clusters_ms     = 0.0f;
+
+    // metrics - bindless materials
+    uint32_t Profiler::m_renderer_material_blocks_used     = 0;
+    uint32_t Profiler::m_renderer_material_blocks_capacity = 0;
+    uint32_t Profiler::m_renderer_material_upload_bytes    = 0;
+
+    // metrics - terrain
+    uint32_t Profiler::m_terrain_vertices  = 0;
+    uint32_t Profiler::m_terrain_triangles = 0;
 
     // metrics - time
     float Profiler::m_time_frame_avg  = 0.0f;
@@ -512,12 +547,91 @@ namespace Spartan
             << "Vertex buffer bindings:\t\t"   << m_rhi_bindings_buffer_vertex  << endl
             << "Descriptor set bindings:\t\t"  << m_rhi_bindings_descriptor_set << endl
             << "Pipeline bindings:\t\t\t\t\t"  << m_rhi_bindings_pipeline       << endl
+            << "Push constants:\t\t\t\t\t\t" << m_rhi_bindings_push_constant  << endl
             << "Pipeline barriers:\t\t\t\t\t"  << m_rhi_pipeline_barriers       << endl;
 
+        // redundant api calls which were filtered out by the command list
+        oss_metrics << "\nAPI calls skipped" << endl
+            << "Index buffer bindings:\t\t\t"  << m_rhi_skipped_buffer_index   << endl
+            << "Vertex buffer bindings:\t\t"   << m_rhi_skipped_buffer_vertex  << endl
+            << "Pipeline bindings:\t\t\t\t\t"  << m_rhi_skipped_pipeline       << endl
+            << "Push constants:\t\t\t\t\t\t" << m_rhi_skipped_push_constant  << endl;
+
+        // draw lists
+        {
+            float draws_per_ms = m_renderer_time_draw_list_record_ms > 0.0f ? static_cast<float>(m_renderer_draw_packets) / m_renderer_time_draw_list_record_ms : 0.0f;
+            oss_metrics << "\nDraw lists" << endl
+                << "Packets:\t\t\t\t\t\t\t\t" << m_renderer_draw_packets             << endl
+                << "Triangles:\t\t\t\t\t\t\t" << m_renderer_triangles                << endl
+                << "Batching:\t\t\t\t\t\t\t"  << m_renderer_draws_unbatched << " -> " << m_renderer_draws_batched << " draws" << endl
+                << "Build:\t\t\t\t\t\t\t\t\t"  << m_renderer_time_draw_list_build_ms  << " ms" << endl
+                << "Record:\t\t\t\t\t\t\t\t\t" << m_renderer_time_draw_list_record_ms << " ms" << endl
+                << "Throughput:\t\t\t\t\t\t" << static_cast<uint32_t>(draws_per_ms)      << " draws/ms" << endl;
+        }
+
+        // shadow views (a view is a cascade or a paraboloid face)
+        oss_metrics << "\nShadow views" << endl
+            << "Rendered:\t\t\t\t\t\t\t"   << m_renderer_shadow_views_rendered   << endl
+            << "Composited:\t\t\t\t\t\t" << m_renderer_shadow_views_composited << endl
+            << "Skipped:\t\t\t\t\t\t\t\t"  << m_renderer_shadow_views_skipped    << endl;
+
+        // occlusion culling (rasterized on the cpu)
+        if (m_renderer_occluders != 0)
+        {
+            oss_metrics << "\nOcclusion culling" << endl
+                << "Occluders:\t\t\t\t\t\t\t" << m_renderer_occluders          << endl
+                << "Triangles:\t\t\t\t\t\t\t" << m_renderer_occluder_triangles << endl
+                << "Occluded:\t\t\t\t\t\t\t"  << m_renderer_occluded           << endl
+                << "Time:\t\t\t\t\t\t\t\t\t"   << m_renderer_time_occlusion_ms   << " ms" << endl;
+        }
+
+        // light clusters (point and spot lights)
+        if (m_renderer_lights_clustered != 0)
+        {
+            oss_metrics << "\nLight clusters" << endl
+                << "Lights:\t\t\t\t\t\t\t\t"  << m_renderer_lights_clustered       << endl
+                << "Culled:\t\t\t\t\t\t\t\t"  << m_renderer_lights_culled          << endl
+                << "Indices:\t\t\t\t\t\t\t\t" << m_renderer_light_cluster_indices  << endl
+                << "Time:\t\t\t\t\t\t\t\t\t"   << m_renderer_time_light_clusters_ms << " ms" << endl;
+        }
+
+        // bindless materials
+        oss_metrics << "\nBindless materials" << endl
+            << "Occupancy:\t\t\t\t\t\t" << m_renderer_material_blocks_used << "/" << m_renderer_material_blocks_capacity << endl
+            << "Upload:\t\t\t\t\t\t\t\t" << m_renderer_material_upload_bytes << " bytes" << endl;
+
+        // terrain
+        if (m_terrain_triangles != 0)
+        {
+            oss_metrics << "\nTerrain" << endl
+                << "Vertices:\t\t\t\t\t\t\t\t"  << m_terrain_vertices  << endl
+                << "Triangles:\t\t\t\t\t\t\t" << m_terrain_triangles << endl;
+        }
+
+        // frame arena (transient allocations of all threads)
+        oss_metrics << "\nFrame arena" << endl
+            << "Used:\t\t\t\t\t\t\t\t\t"  << FrameArena::GetBytesUsed() / 1024     << " KB" << endl
+            << "Capacity:\t\t\t\t\t\t\t" << FrameArena::GetBytesCapacity() / 1024 << " KB" << endl
+            << "Blocks allocated:\t\t\t" << FrameArena::GetBlockAllocations()       << endl;
+
+        // cpu memory, per subsystem
+        oss_metrics << "\nMemory (CPU)" << endl;
+        for (uint32_t i = 0; i < static_cast<uint32_t>(MemoryTag::Max); i++)
+        {
+            MemoryTag tag        = static_cast<MemoryTag>(i);
+            MemoryTagStats stats = MemoryTracker::GetStats(tag);
+            oss_metrics << MemoryTracker::GetTagName(tag) << ":\t\t\t\t\t"
+                << stats.bytes_live / (1024.0f * 1024.0f) << "/" << stats.bytes_peak / (1024.0f * 1024.0f) << " MB (live/peak), "
+                << stats.allocations_per_frame << " allocations/frame" << endl;
+        }
+
         // resources
         oss_metrics << "\nResources\n"
             << "Textures:\t\t\t\t\t\t\t\t"  << texture_count          << endl
             << "Materials:\t\t\t\t\t\t\t"   << material_count         << endl
+            << "Memory (CPU/GPU):\t\t\t"   << ResourceCache::GetMemoryUsageCpu() / (1024 * 1024) << "/" << ResourceCache::GetMemoryUsageGpu() / (1024 * 1024) << " MB" << endl
+            << "Evicted:\t\t\t\t\t\t\t\t"  << ResourceCache::GetEvictionCount() << endl
+            << "Hot reloaded:\t\t\t\t\t\t"  << HotReload::GetReloadCount()       << endl
             << "Pipelines:\t\t\t\t\t\t\t\t" << pipeline_count         << endl
             << "Descriptor set capacity:\t" << m_descriptor_set_count << "/" << rhi_max_descriptor_set_count;
 
@@ -22,9 +22,11 @@ CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 #pragma once
 
 //= INCLUDES ===================
+#include <atomic>
 #include <string>
 #include <vector>
 #include "TimeBlock.h"
+#include "MemoryTracker.h"
 #include "../Core/Definitions.h"
 //==============================
 
@@ -66,23 +68,56 @@ namespace Spartan
         static bool IsCpuStuttering();
         static bool IsGpuStuttering();
         
-        // metrics - rhi
-        static uint32_t m_rhi_draw;
-        static uint32_t m_rhi_bindings_buffer_index;
-        static uint32_t m_rhi_bindings_buffer_vertex;
-        static uint32_t m_rhi_bindings_buffer_constant;
-        static uint32_t m_rhi_bindings_buffer_structured;
-        static uint32_t m_rhi_bindings_sampler;
-        static uint32_t m_rhi_bindings_texture_sampled;
-        static uint32_t m_rhi_bindings_shader_vertex;
-        static uint32_t m_rhi_bindings_shader_pixel;
-        static uint32_t m_rhi_bindings_shader_compute;
-        static uint32_t m_rhi_bindings_render_target;
-        static uint32_t m_rhi_bindings_texture_storage;
-        static uint32_t m_rhi_bindings_descriptor_set;
-        static uint32_t m_rhi_bindings_pipeline;
-        static uint32_t m_rhi_pipeline_barriers;
-        static uint32_t m_rhi_timeblock_count;
+        // metrics - rhi (atomic, secondary command lists are recorded concurrently)
+        static std::atomic<uint32_t> m_rhi_draw;
+        static std::atomic<uint32_t> m_rhi_bindings_buffer_index;
+        static std::atomic<uint32_t> m_rhi_bindings_buffer_vertex;
+        static std::atomic<uint32_t> m_rhi_bindings_buffer_constant;
+        static std::atomic<uint32_t> m_rhi_bindings_buffer_structured;
+        static std::atomic<uint32_t> m_rhi_bindings_sampler;
+        static std::atomic<uint32_t> m_rhi_bindings_texture_sampled;
+        static std::atomic<uint32_t> m_rhi_bindings_shader_vertex;
+        static std::atomic<uint32_t> m_rhi_bindings_shader_pixel;
+        static std::atomic<uint32_t> m_rhi_bindings_shader_compute;
+        static std::atomic<uint32_t> m_rhi_bindings_render_target;
+        static std::atomic<uint32_t> m_rhi_bindings_texture_storage;
+        static std::atomic<uint32_t> m_rhi_bindings_descriptor_set;
+        static std::atomic<uint32_t> m_rhi_bindings_pipeline;
+        static std::atomic<uint32_t> m_rhi_pipeline_barriers;
+        static std::atomic<uint32_t> m_rhi_timeblock_count;
+        static std::atomic<uint32_t> m_rhi_bindings_push_constant;
+        static std::atomic<uint32_t> m_rhi_skipped_pipeline;
+        static std::atomic<uint32_t> m_rhi_skipped_buffer_vertex;
+        static std::atomic<uint32_t> m_rhi_skipped_buffer_index;
+        static std::atomic<uint32_t> m_rhi_skipped_push_constant;
+
+        // metrics - renderer
+        static uint32_t m_renderer_draw_packets;
+        static std::atomic<uint32_t> m_renderer_triangles; // counted while recording, which can be parallel
+        static uint32_t m_renderer_draws_unbatched;
+        static uint32_t m_renderer_draws_batched;
+        static float m_renderer_time_draw_list_build_ms;
+        static float m_renderer_time_draw_list_record_ms;
+        static uint32_t m_renderer_shadow_views_rendered;
+        static uint32_t m_renderer_shadow_views_composited;
+        static uint32_t m_renderer_shadow_views_skipped;
+        static uint32_t m_renderer_occluders;
+        static uint32_t m_renderer_occluder_triangles;
+        static uint32_t m_renderer_occluded;
+        static float m_renderer_time_occlusion_ms;
+        static uint32_t m_renderer_lights_clustered;
+        static uint32_t m_renderer_lights_culled;
+        static uint32_t m_renderer_light_cluster_indices;
+        static float m_renderer_time_light_clusters_ms;
+
+        // metrics - bindless materials (a block is the slots owned by one material)
+        static uint32_t m_renderer_material_blocks_used;
+        static uint32_t m_renderer_material_blocks_capacity;
+        static uint32_t m_renderer_material_upload_bytes;
+
+        // metrics - terrain (of the lods selected for the visible tiles)
+        static uint32_t m_terrain_vertices;
+        static uint32_t m_terrain_triangles;
 
         // metrics - time
         static float m_time_frame_avg ;
@@ -130,6 +165,30 @@ namespace Spartan
             m_rhi_bindings_pipeline          = 0;
             m_rhi_pipeline_barriers          = 0;
             m_rhi_timeblock_count            = 0;
+            m_rhi_bindings_push_constant     = 0;
+            m_rhi_skipped_pipeline           = 0;
+            m_rhi_skipped_buffer_vertex      = 0;
+            m_rhi_skipped_buffer_index       = 0;
+            m_rhi_skipped_push_constant      = 0;
+
+            m_renderer_draw_packets             = 0;
+            m_renderer_triangles                = 0;
+            m_renderer_draws_unbatched          = 0;
+            m_renderer_draws_batched            = 0;
+            m_renderer_time_draw_list_build_ms  = 0.0f;
+            m_renderer_time_draw_list_record_ms = 0.0f;
+            m_renderer_shadow_views_rendered    = 0;
+            m_renderer_shadow_views_composited  = 0;
+            m_renderer_shadow_views_skipped     = 0;
+            m_renderer_occluders                = 0;
+            m_renderer_occluder_triangles       = 0;
+            m_renderer_occluded                 = 0;
+            m_renderer_time_occlusion_ms        = 0.0f;
+            m_renderer_lights_clustered         = 0;
+            m_renderer_lights_culled            = 0;
+            m_renderer_light_cluster_indices    = 0;
+            m_renderer_time_light_clusters_ms   = 0.0f;
+            m_renderer_material_upload_bytes    = 0;
         }
 
         static TimeBlock* GetNewTimeBlock();
@@ -48,7 +48,7 @@ using namespace Spartan::Math;
 
 namespace Spartan
 {
-    RHI_CommandList::RHI_CommandList(void* cmd_pool, const char* name)
+    RHI_CommandList::RHI_CommandList(void* cmd_pool, const char* name, const bool is_secondary)
     {
         SP_ASSERT(cmd_pool != nullptr);
 
@@ -113,7 +113,7 @@ namespace Spartan
         SP_ASSERT_MSG(false, "Function is not implemented");
     }
 
-    void RHI_CommandList::RenderPassBegin()
+    void RHI_CommandList::RenderPassBegin(const bool secondary_contents)
     {
         SP_ASSERT_MSG(false, "Function is not implemented");
     }
@@ -123,6 +123,22 @@ namespace Spartan
         SP_ASSERT_MSG(false, "Function is not implemented");
     }
 
+    RHI_CommandList* RHI_CommandList::AcquireSecondary()
+    {
+        SP_ASSERT_MSG(false, "Function is not implemented");
+        return nullptr;
+    }
+
+    void RHI_CommandList::BeginSecondary(RHI_CommandList* primary)
+    {
+        SP_ASSERT_MSG(false, "Function is not implemented");
+    }
+
+    void RHI_CommandList::ExecuteSecondaries(RHI_CommandList* const* secondaries, const uint32_t count)
+    {
+        SP_ASSERT_MSG(false, "Function is not implemented");
+    }
+
     void RHI_CommandList::ClearPipelineStateRenderTargets(RHI_PipelineState& pipeline_state)
     {
         SP_ASSERT_MSG(false, "Function is not implemented");
@@ -166,6 +182,11 @@ namespace Spartan
         Profiler::m_rhi_draw++;
     }
   
+    void RHI_CommandList::DrawIndexedIndirect(RHI_StructuredBuffer* arguments, const uint32_t offset)
+    {
+        SP_ASSERT_MSG(false, "Function is not implemented");
+    }
+
     void RHI_CommandList::Dispatch(uint32_t x, uint32_t y, uint32_t z)
     {
         SP_ASSERT(m_state == RHI_CommandListState::Recording);
@@ -236,8 +257,11 @@ namespace Spartan
     {
         SP_ASSERT(m_state == RHI_CommandListState::Recording);
 
-        if (m_buffer_id_vertex == buffer->GetObjectId())
+        if (m_buffer_id_vertex[binding] == buffer->GetObjectId())
+        {
+            Profiler::m_rhi_skipped_buffer_vertex++;
             return;
+        }
 
         D3D12_VERTEX_BUFFER_VIEW vertex_buffer_view = {};
         vertex_buffer_view.BufferLocation           = 0;
@@ -245,22 +269,30 @@ namespace Spartan
         vertex_buffer_view.SizeInBytes              = static_cast<UINT>(buffer->GetObjectSize());
 
         static_cast<ID3D12GraphicsCommandList*>(m_rhi_resource)->IASetVertexBuffers(
-            0,                  // StartSlot
+            binding,            // StartSlot
             1,                  // NumViews
             &vertex_buffer_view // pViews
         );
 
-        m_buffer_id_vertex = buffer->GetObjectId();
+        m_buffer_id_vertex[binding] = buffer->GetObjectId();
 
         Profiler::m_rhi_bindings_buffer_vertex++;
     }
+
+    void RHI_CommandList::SetBufferVertex(const RHI_StructuredBuffer* buffer, const uint32_t binding /*= 0*/)
+    {
+        SP_ASSERT_MSG(false, "Function is not implemented");
+    }
     
     void RHI_CommandList::SetBufferIndex(const RHI_IndexBuffer* buffer)
     {
         SP_ASSERT(m_state == RHI_CommandListState::Recording);
 
         if (m_buffer_id_index == buffer->GetObjectId())
+        {
+            Profiler::m_rhi_skipped_buffer_index++;
             return;
+        }
 
         D3D12_INDEX_BUFFER_VIEW index_buffer_view = {};
         index_buffer_view.BufferLocation          = 0;
@@ -374,4 +406,9 @@ namespace Spartan
     {
 
     }
+
+    void RHI_CommandList::InsertBarrierBufferReadWrite()
+    {
+        SP_ASSERT_MSG(false, "Function is not implemented");
+    }
 }
@@ -261,7 +261,7 @@ namespace Spartan
         return false;
     }
 
-    void RHI_Device::UpdateBindlessResources(const array<shared_ptr<RHI_Sampler>, static_cast<uint32_t>(Renderer_Sampler::Max)>* samplers, array<RHI_Texture*, rhi_max_array_size>* textures)
+    void RHI_Device::UpdateBindlessResources(const array<shared_ptr<RHI_Sampler>, static_cast<uint32_t>(Renderer_Sampler::Max)>* samplers, array<RHI_Texture*, rhi_max_array_size>* textures, const uint32_t texture_start, const uint32_t texture_count)
     {
 
     }
@@ -280,4 +280,34 @@ namespace Spartan
     {
         return 0;
     }
+
+    void RHI_Device::DeletePipelines(const RHI_Shader* shader)
+    {
+
+    }
+
+    void RHI_Device::PrewarmPipelines()
+    {
+
+    }
+
+    void RHI_Device::PipelineCacheSave()
+    {
+
+    }
+
+    bool RHI_Device::PipelineCacheLoad()
+    {
+        return false;
+    }
+
+    uint64_t RHI_Device::PipelineCacheGetSize()
+    {
+        return 0;
+    }
+
+    uint32_t RHI_Device::PipelineCacheGetRecordCount()
+    {
+        return 0;
+    }
 }
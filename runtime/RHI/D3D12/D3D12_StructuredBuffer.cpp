@@ -45,4 +45,9 @@ namespace Spartan
     {
         SP_ASSERT_MSG(false, "Not implemented");
     }
+
+    void RHI_StructuredBuffer::UpdateRange(const void* data_cpu, const uint32_t offset, const uint32_t size)
+    {
+        SP_ASSERT_MSG(false, "Not implemented");
+    }
 }
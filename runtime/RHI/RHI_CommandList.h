@@ -57,7 +57,7 @@ namespace Spartan
     class SP_CLASS RHI_CommandList
     {
     public:
-        RHI_CommandList(void* cmd_pool, const char* name);
+        RHI_CommandList(void* cmd_pool, const char* name, const bool is_secondary = false);
         ~RHI_CommandList();
 
         void Begin(const RHI_Queue* queue);
@@ -77,6 +77,7 @@ namespace Spartan
         // draw
         void Draw(const uint32_t vertex_count, const uint32_t vertex_start_index = 0);
         void DrawIndexed(const uint32_t index_count, const uint32_t index_offset = 0, const uint32_t vertex_offset = 0, const uint32_t instance_start_index = 0, const uint32_t instance_count = 1);
+        void DrawIndexedIndirect(RHI_StructuredBuffer* arguments, const uint32_t offset = 0);
 
         // dispatch
         void Dispatch(uint32_t x, uint32_t y, uint32_t z = 1);
@@ -101,6 +102,7 @@ namespace Spartan
         
         // vertex buffer
         void SetBufferVertex(const RHI_VertexBuffer* buffer, const uint32_t binding = 0);
+        void SetBufferVertex(const RHI_StructuredBuffer* buffer, const uint32_t binding = 0); // for vertex data written by compute shaders
         
         // index buffer
         void SetBufferIndex(const RHI_IndexBuffer* buffer);
@@ -161,8 +163,14 @@ namespace Spartan
         );
         void InsertBarrierTexture(RHI_Texture* texture, const uint32_t mip_start, const uint32_t mip_range, const uint32_t array_length, const RHI_Image_Layout layout_old, const RHI_Image_Layout layout_new);
         void InsertBarrierTextureReadWrite(RHI_Texture* texture);
+        void InsertBarrierBufferReadWrite();
         void InsertPendingBarrierGroup();
 
+        // secondary command lists, recorded in parallel and executed within the render pass of this (primary) list
+        RHI_CommandList* AcquireSecondary();
+        void BeginSecondary(RHI_CommandList* primary);
+        void ExecuteSecondaries(RHI_CommandList* const* secondaries, const uint32_t count);
+
         // misc
         void SetIgnoreClearValues(const bool ignore_clear_values) { m_ignore_clear_values = ignore_clear_values; }
         RHI_Semaphore* GetRenderingCompleteSemaphore()            { return m_rendering_complete_semaphore.get(); }
@@ -172,7 +180,7 @@ namespace Spartan
 
     private:
         void PreDraw();
-        void RenderPassBegin();
+        void RenderPassBegin(const bool secondary_contents = false);
         void RenderPassEnd();
 
         // sync
@@ -180,7 +188,7 @@ namespace Spartan
         std::shared_ptr<RHI_Semaphore> m_rendering_complete_semaphore_timeline;
 
         // misc
-        uint64_t m_buffer_id_vertex                          = 0;
+        std::array<uint64_t, 2> m_buffer_id_vertex           = {}; // per binding, 0 is geometry and 1 is instances
         uint64_t m_buffer_id_index                           = 0;
         bool m_ignore_clear_values                           = false;
         uint64_t m_swapchain_id                              = 0;
@@ -196,6 +204,16 @@ namespace Spartan
         RHI_PipelineState m_pso;
         std::vector<ImageBarrierInfo> m_image_barriers;
 
+        // last pushed constants, redundant pushes are skipped (a size of 0 means nothing is cached)
+        std::array<uint8_t, 256> m_push_constant_data = {};
+        uint32_t m_push_constant_offset               = 0;
+        uint32_t m_push_constant_size                 = 0;
+
+        // secondary command lists, owned by the primary which executes them, each one has its own pool
+        std::vector<std::shared_ptr<RHI_CommandList>> m_secondaries;
+        uint32_t m_secondary_count = 0;
+        bool m_is_secondary        = false;
+
         // rhi resources
         void* m_rhi_resource              = nullptr;
         void* m_rhi_cmd_pool_resource     = nullptr;
@@ -51,11 +51,19 @@ namespace Spartan
         static std::unordered_map<uint64_t, RHI_DescriptorSet>& GetDescriptorSets();
         static void* GetDescriptorSet(const RHI_Device_Resource resource_type);
         static void* GetDescriptorSetLayout(const RHI_Device_Resource resource_type);
-        static void UpdateBindlessResources(const std::array<std::shared_ptr<RHI_Sampler>, static_cast<uint32_t>(Renderer_Sampler::Max)>* samplers, std::array<RHI_Texture*, rhi_max_array_size>* textures);
+        static void UpdateBindlessResources(const std::array<std::shared_ptr<RHI_Sampler>, static_cast<uint32_t>(Renderer_Sampler::Max)>* samplers, std::array<RHI_Texture*, rhi_max_array_size>* textures, const uint32_t texture_start = 0, const uint32_t texture_count = rhi_max_array_size);
 
         // pipelines
         static void GetOrCreatePipeline(RHI_PipelineState& pso, RHI_Pipeline*& pipeline, RHI_DescriptorSetLayout*& descriptor_set_layout);
         static uint32_t GetPipelineCount();
+        static void DeletePipelines(const RHI_Shader* shader); // the ones created with this shader, call once the gpu is done with them
+        static void PrewarmPipelines(); // creates the pipelines previous sessions used, call from a worker thread
+
+        // pipeline cache, saved on shutdown and loaded on startup, call these while no pipelines are being created
+        static void PipelineCacheSave();
+        static bool PipelineCacheLoad(); // replaces the cache with the saved one, returns false if the driver data was rejected
+        static uint64_t PipelineCacheGetSize();
+        static uint32_t PipelineCacheGetRecordCount(); // the pipelines a save would record
 
         // deletion queue
         static void DeletionQueueAdd(const RHI_Resource_Type resource_type, void* resource);
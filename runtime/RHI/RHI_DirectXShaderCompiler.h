@@ -266,34 +266,7 @@ namespace Spartan
     public:
         static IDxcResult* Compile(const std::string& source, std::vector<std::string>& arguments)
         {
-            // initialize (only happens once)
-            static IDxcUtils* m_utils        = nullptr;
-            static IDxcCompiler3* m_compiler = nullptr;
-            if (!m_compiler)
-            {
-                DxcCreateInstance(CLSID_DxcCompiler, IID_PPV_ARGS(&m_compiler));
-                DxcCreateInstance(CLSID_DxcUtils, IID_PPV_ARGS(&m_utils));
-
-                // Try to get the version information
-                IDxcVersionInfo* version_info = nullptr;
-                HRESULT hr = m_compiler->QueryInterface(&version_info);
-                if (SUCCEEDED(hr) && version_info)
-                {
-                    UINT32 major, minor;
-                    version_info->GetVersion(&major, &minor);
-
-                    // format the version string
-                    std::ostringstream stream;
-                    stream << major << "." << minor;
-
-                    Settings::RegisterThirdPartyLib("DirectXShaderCompiler", stream.str(), "https://github.com/microsoft/DirectXShaderCompiler");
-                    version_info->Release();
-                }
-                else
-                {
-                    SP_LOG_ERROR("Failed to get library version");
-                }
-            }
+            Initialize();
 
             // Get shader source
             DxcBuffer dxc_buffer = {};
@@ -357,5 +330,63 @@ namespace Spartan
 
             return dxc_result;
         }
+
+        // part of the shader cache key, so that a compiler update invalidates the cache
+        static const std::string& GetVersion()
+        {
+            Initialize();
+            return m_version;
+        }
+
+    private:
+        static void Initialize()
+        {
+            // only happens once, shaders are compiled from multiple threads
+            static std::once_flag initialized;
+            std::call_once(initialized, []()
+            {
+                DxcCreateInstance(CLSID_DxcCompiler, IID_PPV_ARGS(&m_compiler));
+                DxcCreateInstance(CLSID_DxcUtils, IID_PPV_ARGS(&m_utils));
+
+                // Try to get the version information
+                IDxcVersionInfo* version_info = nullptr;
+                HRESULT hr = m_compiler->QueryInterface(&version_info);
+                if (SUCCEEDED(hr) && version_info)
+                {
+                    UINT32 major, minor;
+                    version_info->GetVersion(&major, &minor);
+
+                    // format the version string
+                    std::ostringstream stream;
+                    stream << major << "." << minor;
+                    m_version = stream.str();
+
+                    // the commit hash distinguishes builds with the same version number
+                    IDxcVersionInfo2* version_info_2 = nullptr;
+                    if (SUCCEEDED(m_compiler->QueryInterface(&version_info_2)) && version_info_2)
+                    {
+                        UINT32 commit_count = 0;
+                        char* commit_hash   = nullptr;
+                        if (SUCCEEDED(version_info_2->GetCommitInfo(&commit_count, &commit_hash)) && commit_hash)
+                        {
+                            m_version += std::string("-") + commit_hash;
+                            CoTaskMemFree(commit_hash);
+                        }
+                        version_info_2->Release();
+                    }
+
+                    Settings::RegisterThirdPartyLib("DirectXShaderCompiler", stream.str(), "https://github.com/microsoft/DirectXShaderCompiler");
+                    version_info->Release();
+                }
+                else
+                {
+                    SP_LOG_ERROR("Failed to get library version");
+                }
+            });
+        }
+
+        static inline IDxcUtils* m_utils        = nullptr;
+        static inline IDxcCompiler3* m_compiler = nullptr;
+        static inline std::string m_version     = "unknown";
     };
 }
@@ -41,6 +41,7 @@ namespace Spartan
     VkInstance       RHI_Context::instance        = nullptr;
     VkPhysicalDevice RHI_Context::device_physical = nullptr;
     VkDevice         RHI_Context::device          = nullptr;
+    VkPipelineCache  RHI_Context::pipeline_cache  = nullptr;
 #endif
 
     // api agnostic
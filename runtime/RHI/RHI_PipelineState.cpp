@@ -59,69 +59,70 @@ namespace Spartan
             }
         }
 
-        uint64_t compute_hash(RHI_PipelineState& pso)
+        // everything that identifies a pipeline, gathered into a flat array so that it can be compared
+        // cheaply against the previous call, null members contribute a zero
+        void gather_hash_inputs(const RHI_PipelineState& pso, array<uint64_t, RHI_PipelineState::hash_input_count>& inputs)
         {
-            uint64_t hash = 0;
+            uint32_t i = 0;
 
-            hash = rhi_hash_combine(hash, static_cast<uint64_t>(pso.instancing));
-            hash = rhi_hash_combine(hash, static_cast<uint64_t>(pso.primitive_toplogy));
+            inputs[i++] = static_cast<uint64_t>(pso.instancing);
+            inputs[i++] = static_cast<uint64_t>(pso.primitive_toplogy);
+            inputs[i++] = pso.render_target_swapchain ? static_cast<uint64_t>(pso.render_target_swapchain->GetFormat()) : 0;
+            inputs[i++] = pso.rasterizer_state        ? pso.rasterizer_state->GetHash()                                 : 0;
+            inputs[i++] = pso.blend_state             ? pso.blend_state->GetHash()                                      : 0;
+            inputs[i++] = pso.depth_stencil_state     ? pso.depth_stencil_state->GetHash()                              : 0;
 
-            if (pso.render_target_swapchain)
+            // shaders
+            for (RHI_Shader* shader : pso.shaders)
             {
-                hash = rhi_hash_combine(hash, static_cast<uint64_t>(pso.render_target_swapchain->GetFormat()));
+                inputs[i++] = shader ? shader->GetHash() : 0;
             }
 
-            if (pso.rasterizer_state)
+            // rt
+            for (RHI_Texture* texture : pso.render_target_color_textures)
             {
-                hash = rhi_hash_combine(hash, pso.rasterizer_state->GetHash());
+                inputs[i++] = texture ? texture->GetObjectId() : 0;
             }
+            inputs[i++] = pso.render_target_depth_texture ? pso.render_target_depth_texture->GetObjectId() : 0;
+            inputs[i++] = pso.vrs_input_texture           ? pso.vrs_input_texture->GetObjectId()           : 0;
+            inputs[i++] = pso.render_target_array_index;
 
-            if (pso.blend_state)
-            {
-                hash = rhi_hash_combine(hash, pso.blend_state->GetHash());
-            }
+            SP_ASSERT(i == RHI_PipelineState::hash_input_count);
+        }
 
-            if (pso.depth_stencil_state)
+        uint64_t compute_hash(const array<uint64_t, RHI_PipelineState::hash_input_count>& inputs)
+        {
+            uint64_t hash = 0;
+
+            for (uint64_t input : inputs)
             {
-                hash = rhi_hash_combine(hash, pso.depth_stencil_state->GetHash());
+                hash = rhi_hash_combine(hash, input);
             }
 
-            // shaders
-            for (RHI_Shader* shader : pso.shaders)
-            {
-                if (!shader)
-                    continue;
+            return hash;
+        }
 
-                hash = rhi_hash_combine(hash, shader->GetHash());
-            }
+        void get_formats(RHI_PipelineState& pso)
+        {
+            pso.render_target_color_formats.fill(RHI_Format::Max);
 
-            // rt
+            if (pso.render_target_swapchain)
+            {
+                pso.render_target_color_formats[0] = pso.render_target_swapchain->GetFormat();
+            }
+            else
             {
-                // color
                 for (uint32_t i = 0; i < rhi_max_render_target_count; i++)
                 {
-                    if (RHI_Texture* texture = pso.render_target_color_textures[i])
-                    {
-                        hash = rhi_hash_combine(hash, texture->GetObjectId());
-                    }
-                }
+                    RHI_Texture* texture = pso.render_target_color_textures[i];
+                    if (!texture)
+                        break;
 
-                // depth
-                if (pso.render_target_depth_texture)
-                {
-                    hash = rhi_hash_combine(hash, pso.render_target_depth_texture->GetObjectId());
+                    pso.render_target_color_formats[i] = texture->GetFormat();
                 }
-
-                // variable rate shading
-                if (pso.vrs_input_texture)
-                {
-                    hash = rhi_hash_combine(hash, pso.vrs_input_texture->GetObjectId());
-                }
-
-                hash = rhi_hash_combine(hash, pso.render_target_array_index);
             }
 
-            return hash;
+            pso.render_target_depth_format = pso.render_target_depth_texture ? pso.render_target_depth_texture->GetFormat() : RHI_Format::Max;
         }
 
         void get_dimensions(RHI_PipelineState& pso, uint32_t* width, uint32_t* height)
@@ -160,6 +161,7 @@ namespace Spartan
     {
         clear_color.fill(rhi_color_load);
         render_target_color_textures.fill(nullptr);
+        render_target_color_formats.fill(RHI_Format::Max);
     }
 
     RHI_PipelineState::~RHI_PipelineState()
@@ -169,8 +171,17 @@ namespace Spartan
 
     void RHI_PipelineState::Prepare()
     {
-        m_hash = compute_hash(*this);
         get_dimensions(*this, &m_width, &m_height);
+        get_formats(*this);
+
+        // passes mutate a static pso and prepare it per draw, only re-hash and re-validate when something changed
+        array<uint64_t, hash_input_count> hash_inputs;
+        gather_hash_inputs(*this, hash_inputs);
+        if (m_hash != 0 && hash_inputs == m_hash_inputs)
+            return;
+
+        m_hash_inputs = hash_inputs;
+        m_hash        = compute_hash(m_hash_inputs);
         validate(*this);
     }
 
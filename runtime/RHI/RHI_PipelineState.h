@@ -59,6 +59,11 @@ namespace Spartan
         uint32_t render_target_array_index       = 0;
         //=================================================================================
 
+        // render target formats, this is all that a pipeline needs to know about the render targets
+        // Prepare() derives them from the render targets above (the swapchain goes in the first slot)
+        std::array<RHI_Format, rhi_max_render_target_count> render_target_color_formats;
+        RHI_Format render_target_depth_format = RHI_Format::Max;
+
         // dynamic properties, changing these will not create a new PSO
         bool resolution_scale  = false;
         float clear_depth      = rhi_depth_load;
@@ -66,11 +71,15 @@ namespace Spartan
         std::array<Color, rhi_max_render_target_count> clear_color;
         std::string name; // used by the validation layer
 
+        // state members which contribute to the hash (see STATE above)
+        static const uint32_t hash_input_count = 6 + static_cast<uint32_t>(RHI_Shader_Type::Max) + rhi_max_render_target_count + 3;
+
     private:
         bool HasShader(const RHI_Shader_Type shader_stage) const;
 
         uint32_t m_width  = 0;
         uint32_t m_height = 0;
         uint64_t m_hash   = 0;
+        std::array<uint64_t, hash_input_count> m_hash_inputs = {};
     };
 }
@@ -19,12 +19,15 @@ IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
 CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 */
 
-//= INCLUDES ==================
+//= INCLUDES ===========================
 #include "pch.h"
 #include "RHI_Shader.h"
 #include "RHI_InputLayout.h"
 #include "../Core/ThreadPool.h"
-//=============================
+#include "../IO/FileStream.h"
+#include "../IO/VirtualFileSystem.h"
+#include "../Resource/ResourceCache.h"
+//======================================
 
 //= NAMESPACES =====
 using namespace std;
@@ -32,6 +35,183 @@ using namespace std;
 
 namespace Spartan
 {
+    namespace
+    {
+        // bump when the cache file layout changes
+        const uint32_t cache_magic   = 0x53484443; // "SHDC"
+        const uint32_t cache_version = 1;
+
+        // fnv-1a, stable across runs and platforms (unlike std::hash) which matters for an on-disk key
+        uint64_t hash_fnv1a(const void* data, const size_t size, uint64_t hash = 0xcbf29ce484222325)
+        {
+            const uint8_t* bytes = static_cast<const uint8_t*>(data);
+            for (size_t i = 0; i < size; i++)
+            {
+                hash ^= bytes[i];
+                hash *= 0x100000001b3;
+            }
+
+            return hash;
+        }
+
+        uint64_t hash_fnv1a(const string& value, const uint64_t hash)
+        {
+            // include the size so that adjacent strings can't alias
+            uint64_t size = value.size();
+            return hash_fnv1a(value.data(), value.size(), hash_fnv1a(&size, sizeof(size), hash));
+        }
+
+        string get_cache_file_path(const string& shader_name, const uint64_t key)
+        {
+            ostringstream stream;
+            stream << ResourceCache::GetResourceDirectory(ResourceDirectory::Cache) << "\\shaders\\" << shader_name << "_" << hex << key << ".spv";
+            return stream.str();
+        }
+
+        // bounded, prioritized compile queue which sits on top of the thread pool
+        namespace compile_queue
+        {
+            const uint32_t priority_count = static_cast<uint32_t>(RHI_ShaderCompilationPriority::Max);
+
+            struct Job
+            {
+                RHI_Shader* shader = nullptr;
+                function<void()> compile;
+                uint32_t priority  = 0;
+            };
+
+            struct Stats
+            {
+                uint32_t compiled   = 0;
+                uint32_t cache_hits = 0;
+                float time_ms       = 0.0f;
+                float slowest_ms    = 0.0f;
+                string slowest_name;
+            };
+
+            mutex mutex_jobs;
+            condition_variable condition_var;
+            array<deque<Job>, priority_count> jobs;
+            array<uint32_t, priority_count> pending = {}; // queued or running
+            uint32_t worker_count                   = 0;
+            Stats stats;
+
+            // leave the other half of the pool to asset loading and the rest of the engine
+            uint32_t get_worker_limit()
+            {
+                return max(ThreadPool::GetThreadCount() / 2, 1u);
+            }
+
+            // expects the lock to be held
+            bool pop(Job& job, const uint32_t priority_max)
+            {
+                for (uint32_t i = 0; i <= priority_max; i++)
+                {
+                    if (!jobs[i].empty())
+                    {
+                        job = move(jobs[i].front());
+                        jobs[i].pop_front();
+                        return true;
+                    }
+                }
+
+                return false;
+            }
+
+            // expects the lock to be held, releases it while compiling
+            void execute(Job& job, unique_lock<mutex>& lock)
+            {
+                lock.unlock();
+                job.compile();
+                lock.lock();
+
+                stats.compiled++;
+                stats.cache_hits += job.shader->IsFromCache() ? 1 : 0;
+                stats.time_ms    += job.shader->GetCompilationTimeMs();
+                if (job.shader->GetCompilationTimeMs() > stats.slowest_ms)
+                {
+                    stats.slowest_ms   = job.shader->GetCompilationTimeMs();
+                    stats.slowest_name = job.shader->GetObjectName();
+                }
+
+                pending[job.priority]--;
+                condition_var.notify_all();
+            }
+
+            void worker()
+            {
+                unique_lock<mutex> lock(mutex_jobs);
+
+                Job job;
+                while (pop(job, priority_count - 1))
+                {
+                    execute(job, lock);
+                }
+
+                worker_count--;
+            }
+
+            void push(RHI_Shader* shader, function<void()>&& compile, const uint32_t priority)
+            {
+                unique_lock<mutex> lock(mutex_jobs);
+
+                // a shader which is still waiting in the queue only has to compile once
+                for (uint32_t i = 0; i < priority_count; i++)
+                {
+                    auto it = find_if(jobs[i].begin(), jobs[i].end(), [shader](const Job& job) { return job.shader == shader; });
+                    if (it != jobs[i].end())
+                    {
+                        jobs[i].erase(it);
+                        pending[i]--;
+                        break;
+                    }
+                }
+
+                jobs[priority].push_back({ shader, move(compile), priority });
+                pending[priority]++;
+
+                // only spin up a worker if we are below the cap, running workers drain the queue
+                if (worker_count < get_worker_limit())
+                {
+                    worker_count++;
+                    lock.unlock();
+                    ThreadPool::AddTask(worker);
+                }
+            }
+
+            void wait(const uint32_t priority_max)
+            {
+                unique_lock<mutex> lock(mutex_jobs);
+
+                auto is_done = [priority_max]()
+                {
+                    for (uint32_t i = 0; i <= priority_max; i++)
+                    {
+                        if (pending[i] != 0)
+                            return false;
+                    }
+
+                    return true;
+                };
+
+                while (!is_done())
+                {
+                    // help out instead of just blocking, this also means that a
+                    // caller which is itself a pool thread can't starve the workers
+                    Job job;
+                    if (pop(job, priority_max))
+                    {
+                        execute(job, lock);
+                    }
+                    else
+                    {
+                        condition_var.wait(lock);
+                    }
+                }
+            }
+        }
+    }
+
     RHI_Shader::RHI_Shader() : SpartanObject()
     {
 
@@ -63,15 +243,18 @@ namespace Spartan
         {
             m_compilation_state = RHI_ShaderCompilationState::Idle;
 
-            auto compile = [this, shader_type, async]()
+            const Stopwatch timer_queue;
+            auto compile = [this, timer_queue]()
             {
                 // time compilation
                 const Stopwatch timer;
+                m_queue_time_ms = timer_queue.GetElapsedTimeMs();
 
                 // compile
-                m_compilation_state = RHI_ShaderCompilationState::Compiling;
-                m_rhi_resource      = RHI_Compile();
-                m_compilation_state = m_rhi_resource ? RHI_ShaderCompilationState::Succeeded : RHI_ShaderCompilationState::Failed;
+                m_compilation_state   = RHI_ShaderCompilationState::Compiling;
+                m_rhi_resource        = RHI_Compile();
+                m_compilation_time_ms = timer.GetElapsedTimeMs();
+                m_compilation_state   = m_rhi_resource ? RHI_ShaderCompilationState::Succeeded : RHI_ShaderCompilationState::Failed;
 
                 // log failure
                 if (m_compilation_state != RHI_ShaderCompilationState::Succeeded)
@@ -98,7 +281,7 @@ namespace Spartan
 
             if (async)
             {
-                ThreadPool::AddTask(compile);
+                compile_queue::push(this, compile, static_cast<uint32_t>(m_compilation_priority));
             }
             else
             {
@@ -107,6 +290,45 @@ namespace Spartan
         }
     }
 
+    void RHI_Shader::WaitForCompilation(const RHI_ShaderCompilationPriority priority)
+    {
+        const Stopwatch timer;
+        compile_queue::wait(static_cast<uint32_t>(priority));
+
+        lock_guard<mutex> lock(compile_queue::mutex_jobs);
+        const compile_queue::Stats& stats = compile_queue::stats;
+        if (stats.compiled != 0)
+        {
+            SP_LOG_INFO("Waited %.2f ms for shaders, %d compiled so far (%d from cache, %.2f ms of compile time), slowest is \"%s\" at %.2f ms",
+                timer.GetElapsedTimeMs(), stats.compiled, stats.cache_hits, stats.time_ms, stats.slowest_name.c_str(), stats.slowest_ms);
+        }
+    }
+
+    uint32_t RHI_Shader::GetPendingCompilationCount()
+    {
+        lock_guard<mutex> lock(compile_queue::mutex_jobs);
+
+        uint32_t count = 0;
+        for (uint32_t pending : compile_queue::pending)
+        {
+            count += pending;
+        }
+
+        return count;
+    }
+
+    RHI_ShaderCompilationStats RHI_Shader::GetCompilationStats()
+    {
+        lock_guard<mutex> lock(compile_queue::mutex_jobs);
+
+        RHI_ShaderCompilationStats stats;
+        stats.compiled   = compile_queue::stats.compiled;
+        stats.cache_hits = compile_queue::stats.cache_hits;
+        stats.time_ms    = compile_queue::stats.time_ms;
+
+        return stats;
+    }
+
     void RHI_Shader::PreprocessIncludeDirectives(const string& file_path)
     {
         static string include_directive_prefix = "#include \"";
@@ -121,11 +343,11 @@ namespace Spartan
             return;
         }
 
-        // load source
-        ifstream in(file_path);
-        stringstream buffer;
-        buffer << in.rdbuf();
-        string source = buffer.str();
+        // load source, from a pack or from disk
+        vector<byte> bytes;
+        VirtualFileSystem::Read(file_path, bytes);
+        string source(reinterpret_cast<const char*>(bytes.data()), bytes.size());
+        source.erase(remove(source.begin(), source.end(), '\r'), source.end()); // binary reads keep windows line endings
         
         // go through every line
         istringstream stream(source);
@@ -204,6 +426,133 @@ namespace Spartan
         m_sources[index] = source;
     }
 
+    uint64_t RHI_Shader::ComputeCacheKey(const vector<string>& arguments, const string& compiler_version) const
+    {
+        uint64_t key = hash_fnv1a(&cache_version, sizeof(cache_version));
+        key          = hash_fnv1a(compiler_version, key);
+        key          = hash_fnv1a(m_preprocessed_source, key);
+
+        // the arguments include the defines, entry point, target profile and optimization level
+        for (const string& argument : arguments)
+        {
+            key = hash_fnv1a(argument, key);
+        }
+
+        return key;
+    }
+
+    bool RHI_Shader::LoadFromCache(const uint64_t key, vector<uint32_t>& bytecode)
+    {
+        const string file_path = get_cache_file_path(m_object_name, key);
+        if (!FileSystem::IsFile(file_path))
+            return false;
+
+        uint64_t file_size = static_cast<uint64_t>(filesystem::file_size(file_path));
+        FileStream stream(file_path, FileStream_Read);
+        if (!stream.IsOpen())
+            return false;
+
+        // header
+        uint32_t magic      = stream.ReadAs<uint32_t>();
+        uint32_t version    = stream.ReadAs<uint32_t>();
+        uint64_t file_key   = stream.ReadAs<uint64_t>();
+        uint32_t stage      = stream.ReadAs<uint32_t>();
+        uint32_t word_count = stream.ReadAs<uint32_t>();
+        uint64_t checksum   = stream.ReadAs<uint64_t>();
+        bool header_valid   =
+            magic      == cache_magic   &&
+            version    == cache_version &&
+            file_key   == key           &&
+            stage      == static_cast<uint32_t>(m_shader_type) &&
+            word_count != 0             &&
+            static_cast<uint64_t>(word_count) * sizeof(uint32_t) < file_size;
+        if (!header_valid)
+            return false;
+
+        // bytecode
+        stream.Read(&bytecode);
+        const uint32_t spirv_magic = 0x07230203;
+        if (bytecode.size() != word_count || bytecode[0] != spirv_magic || hash_fnv1a(bytecode.data(), bytecode.size() * sizeof(uint32_t)) != checksum)
+        {
+            SP_LOG_WARNING("Shader cache entry \"%s\" is corrupt, recompiling", file_path.c_str());
+            bytecode.clear();
+            return false;
+        }
+
+        // reflected descriptors
+        uint32_t descriptor_count = stream.ReadAs<uint32_t>();
+        if (descriptor_count > 256)
+        {
+            bytecode.clear();
+            return false;
+        }
+
+        m_descriptors.clear();
+        m_descriptors.reserve(descriptor_count);
+        for (uint32_t i = 0; i < descriptor_count; i++)
+        {
+            string name               = stream.ReadAs<string>();
+            RHI_Descriptor_Type type  = static_cast<RHI_Descriptor_Type>(stream.ReadAs<uint32_t>());
+            RHI_Image_Layout layout   = static_cast<RHI_Image_Layout>(stream.ReadAs<uint32_t>());
+            uint32_t slot             = stream.ReadAs<uint32_t>();
+            uint32_t descriptor_stage = stream.ReadAs<uint32_t>();
+            uint32_t struct_size      = stream.ReadAs<uint32_t>();
+            bool as_array             = stream.ReadAs<bool>();
+            uint32_t array_length     = stream.ReadAs<uint32_t>();
+
+            m_descriptors.emplace_back(name, type, layout, slot, descriptor_stage, struct_size, as_array, array_length);
+        }
+
+        return true;
+    }
+
+    void RHI_Shader::SaveToCache(const uint64_t key, const uint32_t* bytecode, const uint32_t word_count) const
+    {
+        const string directory = ResourceCache::GetResourceDirectory(ResourceDirectory::Cache) + "\\shaders\\";
+        if (!FileSystem::Exists(directory))
+        {
+            FileSystem::CreateDirectory(directory);
+        }
+
+        // write to a temporary file and then rename it, so that a crash can't leave a truncated entry behind
+        const string file_path      = get_cache_file_path(m_object_name, key);
+        const string file_path_temp = file_path + ".tmp";
+        {
+            FileStream stream(file_path_temp, FileStream_Write);
+            if (!stream.IsOpen())
+                return;
+
+            stream.Write(cache_magic);
+            stream.Write(cache_version);
+            stream.Write(key);
+            stream.Write(static_cast<uint32_t>(m_shader_type));
+            stream.Write(word_count);
+            stream.Write(hash_fnv1a(bytecode, word_count * sizeof(uint32_t)));
+            stream.Write(vector<uint32_t>(bytecode, bytecode + word_count));
+
+            stream.Write(static_cast<uint32_t>(m_descriptors.size()));
+            for (const RHI_Descriptor& descriptor : m_descriptors)
+            {
+                stream.Write(descriptor.name);
+                stream.Write(static_cast<uint32_t>(descriptor.type));
+                stream.Write(static_cast<uint32_t>(descriptor.layout));
+                stream.Write(descriptor.slot);
+                stream.Write(descriptor.stage);
+                stream.Write(descriptor.struct_size);
+                stream.Write(descriptor.as_array);
+                stream.Write(descriptor.array_length);
+            }
+        }
+
+        error_code error;
+        filesystem::rename(file_path_temp, file_path, error);
+        if (error)
+        {
+            SP_LOG_WARNING("Failed to write shader cache entry \"%s\": %s", file_path.c_str(), error.message().c_str());
+            filesystem::remove(file_path_temp, error);
+        }
+    }
+
     uint32_t RHI_Shader::GetVertexSize() const
     {
         return m_input_layout->GetVertexSize();
@@ -41,6 +41,20 @@ namespace Spartan
         Failed
     };
 
+    enum class RHI_ShaderCompilationPriority
+    {
+        Essential, // needed to render the first frame
+        Normal,
+        Max
+    };
+
+    struct RHI_ShaderCompilationStats
+    {
+        uint32_t compiled   = 0;
+        uint32_t cache_hits = 0;
+        float time_ms       = 0.0f; // summed across threads
+    };
+
     class SP_CLASS RHI_Shader : public SpartanObject
     {
     public:
@@ -49,8 +63,14 @@ namespace Spartan
 
         // compilation
         void Compile(const RHI_Shader_Type type, const std::string& file_path, bool async, const RHI_Vertex_Type vertex_type = RHI_Vertex_Type::Max);
-        RHI_ShaderCompilationState GetCompilationState() const { return m_compilation_state; }
-        bool IsCompiled() const                                { return m_compilation_state == RHI_ShaderCompilationState::Succeeded; }
+        RHI_ShaderCompilationState GetCompilationState() const                    { return m_compilation_state; }
+        bool IsCompiled() const                                                   { return m_compilation_state == RHI_ShaderCompilationState::Succeeded; }
+        void SetCompilationPriority(const RHI_ShaderCompilationPriority priority) { m_compilation_priority = priority; }
+
+        // async compilation queue
+        static void WaitForCompilation(const RHI_ShaderCompilationPriority priority = RHI_ShaderCompilationPriority::Essential);
+        static uint32_t GetPendingCompilationCount();
+        static RHI_ShaderCompilationStats GetCompilationStats(); // since startup
 
         // source
         void LoadFromDrive(const std::string& file_path);
@@ -69,16 +89,27 @@ namespace Spartan
         const std::shared_ptr<RHI_InputLayout>& GetInputLayout() const { return m_input_layout; } // only valid for a vertex shader
         const auto& GetFilePath()                                const { return m_file_path; }
         RHI_Shader_Type GetShaderStage()                         const { return m_shader_type; }
+        RHI_Vertex_Type GetVertexType()                          const { return m_vertex_type; }
         uint64_t GetHash()                                       const { return m_hash; }
         const char* GetEntryPoint()                              const;
         const char* GetTargetProfile()                           const;
         void* GetRhiResource()                                   const { return m_rhi_resource; }
 
+        // profiling
+        float GetCompilationTimeMs() const { return m_compilation_time_ms; }
+        float GetQueueTimeMs() const       { return m_queue_time_ms; }
+        bool IsFromCache() const           { return m_from_cache; }
+
     private:
         void PreprocessIncludeDirectives(const std::string& file_path);
         void* RHI_Compile();
         void Reflect(const RHI_Shader_Type shader_type, const uint32_t* ptr, uint32_t size);
 
+        // on-disk bytecode cache, keyed by everything that affects the compiler output
+        uint64_t ComputeCacheKey(const std::vector<std::string>& arguments, const std::string& compiler_version) const;
+        bool LoadFromCache(const uint64_t key, std::vector<uint32_t>& bytecode);
+        void SaveToCache(const uint64_t key, const uint32_t* bytecode, const uint32_t word_count) const;
+
         std::string m_file_path;
         std::string m_preprocessed_source;
         std::vector<std::string> m_names;               // The names of the files from the include directives in the shader
@@ -92,6 +123,10 @@ namespace Spartan
         RHI_Shader_Type m_shader_type                              = RHI_Shader_Type::Max;
         RHI_Vertex_Type m_vertex_type                               = RHI_Vertex_Type::Max;
         uint64_t m_hash                                             = 0;
+        RHI_ShaderCompilationPriority m_compilation_priority        = RHI_ShaderCompilationPriority::Normal;
+        float m_compilation_time_ms                                 = 0.0f;
+        float m_queue_time_ms                                       = 0.0f;
+        bool m_from_cache                                           = false;
 
         void* m_rhi_resource = nullptr;
     };
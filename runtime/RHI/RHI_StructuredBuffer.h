@@ -34,6 +34,7 @@ namespace Spartan
         ~RHI_StructuredBuffer();
 
         void Update(void* data, const uint32_t update_size = 0);
+        void UpdateRange(const void* data, const uint32_t offset, const uint32_t size); // in place, doesn't advance the offset
         void ResetOffset()           { m_offset = 0; first_update = true; }
         uint32_t GetStride()   const { return m_stride; }
         uint32_t GetOffset()   const { return m_offset; }
@@ -387,6 +387,21 @@ namespace Spartan
         }
     }
 
+    uint64_t RHI_Texture::GetMemoryUsageCpu() const
+    {
+        // only textures which keep their data (or haven't uploaded it yet) have any
+        uint64_t size = 0;
+        for (const RHI_Texture_Slice& slice : m_slices)
+        {
+            for (const RHI_Texture_Mip& mip : slice.mips)
+            {
+                size += mip.bytes.size();
+            }
+        }
+
+        return size;
+    }
+
     void RHI_Texture::SetLayout(const RHI_Image_Layout new_layout, RHI_CommandList* cmd_list, uint32_t mip_index /*= all_mips*/, uint32_t mip_range /*= 0*/)
     {
         const bool mip_specified = mip_index != rhi_all_mips;
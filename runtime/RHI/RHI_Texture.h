@@ -68,6 +68,7 @@ namespace Spartan
         //= IResource ===========================================
         bool SaveToFile(const std::string& file_path) override;
         bool LoadFromFile(const std::string& file_path) override;
+        uint64_t GetMemoryUsageCpu() const override;
         //=======================================================
 
         uint32_t GetWidth()                                const { return m_width; }
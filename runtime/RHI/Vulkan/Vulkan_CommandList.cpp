@@ -374,7 +374,11 @@ namespace Spartan
 
     namespace descriptor_sets
     {
-        bool bind_dynamic = false;
+        // per thread, as secondary command lists are recorded concurrently
+        thread_local bool bind_dynamic = false;
+
+        // the descriptor set layouts and the descriptor sets are shared, secondaries bind them under this lock
+        mutex mutex_secondary;
 
         void set_dynamic(const RHI_PipelineState pso, void* resource, void* pipeline_layout, RHI_DescriptorSetLayout* layout)
         {
@@ -530,15 +534,18 @@ namespace Spartan
         }
     }
 
-    RHI_CommandList::RHI_CommandList(void* cmd_pool, const char* name)
+    RHI_CommandList::RHI_CommandList(void* cmd_pool, const char* name, const bool is_secondary)
     {
+        m_is_secondary          = is_secondary;
+        m_rhi_cmd_pool_resource = cmd_pool;
+
         // command buffer
         {
             // define
             VkCommandBufferAllocateInfo allocate_info = {};
             allocate_info.sType                       = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
             allocate_info.commandPool                 = static_cast<VkCommandPool>(cmd_pool);
-            allocate_info.level                       = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+            allocate_info.level                       = is_secondary ? VK_COMMAND_BUFFER_LEVEL_SECONDARY : VK_COMMAND_BUFFER_LEVEL_PRIMARY;
             allocate_info.commandBufferCount          = 1;
 
             // allocate
@@ -549,6 +556,10 @@ namespace Spartan
             RHI_Device::SetResourceName(static_cast<void*>(m_rhi_resource), RHI_Resource_Type::CommandList, name);
         }
 
+        // secondaries are submitted as part of a primary, which does the synchronization and the queries
+        if (is_secondary)
+            return;
+
         // semaphores
         m_rendering_complete_semaphore          = make_shared<RHI_Semaphore>(false, name);
         m_rendering_complete_semaphore_timeline = make_shared<RHI_Semaphore>(true, name);
@@ -558,6 +569,13 @@ namespace Spartan
 
     RHI_CommandList::~RHI_CommandList()
     {
+        // a secondary owns its pool, destroying the pool frees the command buffer as well
+        if (m_is_secondary)
+        {
+            RHI_Device::DeletionQueueAdd(RHI_Resource_Type::CommandPool, m_rhi_cmd_pool_resource);
+            return;
+        }
+
         queries::shutdown(m_rhi_query_pool_timestamps, m_rhi_query_pool_occlusion);
     }
 
@@ -580,8 +598,14 @@ namespace Spartan
 
         // set states
         m_state        = RHI_CommandListState::Recording;
-        m_pso          = RHI_PipelineState();
-        m_cull_mode    = RHI_CullMode::Max;
+        m_pso                = RHI_PipelineState();
+        m_cull_mode          = RHI_CullMode::Max;
+        m_buffer_id_index    = 0;
+        m_push_constant_size = 0;
+        m_buffer_id_vertex.fill(0);
+
+        // the secondaries executed by the previous recording have completed along with it
+        m_secondary_count = 0;
 
         // set dynamic states
         if (queue->GetType() == RHI_Queue_Type::Graphics)
@@ -642,7 +666,13 @@ namespace Spartan
         // early exit if the pipeline state hasn't changed
         pso.Prepare();
         if (m_pso.GetHash() == pso.GetHash())
+        {
+            Profiler::m_rhi_skipped_pipeline++;
             return;
+        }
+
+        // secondaries are recorded concurrently, and the descriptor state which is bound below is shared
+        unique_lock<mutex> lock_secondary = m_is_secondary ? unique_lock<mutex>(descriptor_sets::mutex_secondary) : unique_lock<mutex>();
 
         // get (or create) a pipeline which matches the requested pipeline state
         m_pso = pso;
@@ -662,6 +692,9 @@ namespace Spartan
             // profile
             Profiler::m_rhi_bindings_pipeline++;
 
+            // the layout might have changed
+            m_push_constant_size = 0;
+
             // set some dynamic states
             if (m_pso.IsGraphics())
             {
@@ -680,8 +713,8 @@ namespace Spartan
                 SetScissorRectangle(scissor_rect);
 
                 // vertex and index buffer state
-                m_buffer_id_index  = 0;
-                m_buffer_id_vertex = 0;
+                m_buffer_id_index = 0;
+                m_buffer_id_vertex.fill(0);
             }
         }
 
@@ -698,9 +731,18 @@ namespace Spartan
         RenderPassBegin();
     }
 
-    void RHI_CommandList::RenderPassBegin()
+    void RHI_CommandList::RenderPassBegin(const bool secondary_contents)
     {
         SP_ASSERT(m_state == RHI_CommandListState::Recording);
+
+        // a secondary continues the render pass of its primary, only the dynamic states have to be set as they are not inherited
+        if (m_is_secondary)
+        {
+            RHI_Device::SetVariableRateShading(this, m_pso.vrs_input_texture != nullptr);
+            SetViewport(RHI_Viewport(0.0f, 0.0f, static_cast<float>(m_pso.GetWidth()), static_cast<float>(m_pso.GetHeight())));
+            return;
+        }
+
         RenderPassEnd();
 
         if (!m_pso.IsGraphics())
@@ -708,6 +750,7 @@ namespace Spartan
 
         VkRenderingInfo rendering_info      = {};
         rendering_info.sType                = VK_STRUCTURE_TYPE_RENDERING_INFO_KHR;
+        rendering_info.flags                = secondary_contents ? VK_RENDERING_CONTENTS_SECONDARY_COMMAND_BUFFERS_BIT : 0;
         rendering_info.renderArea           = { 0, 0, m_pso.GetWidth(), m_pso.GetHeight() };
         rendering_info.layerCount           = 1;
         rendering_info.colorAttachmentCount = 0;
@@ -818,7 +861,8 @@ namespace Spartan
         InsertPendingBarrierGroup();
         vkCmdBeginRendering(static_cast<VkCommandBuffer>(m_rhi_resource), &rendering_info);
 
-        // set dynamic states
+        // set dynamic states, when the contents are secondaries, these are set by them
+        if (!secondary_contents)
         {
             // variable rate shading
             RHI_Device::SetVariableRateShading(this, m_pso.vrs_input_texture != nullptr);
@@ -838,7 +882,7 @@ namespace Spartan
 
     void RHI_CommandList::RenderPassEnd()
     {
-        if (!m_render_pass_active)
+        if (!m_render_pass_active || m_is_secondary)
             return;
 
         vkCmdEndRendering(static_cast<VkCommandBuffer>(m_rhi_resource));
@@ -850,6 +894,120 @@ namespace Spartan
         }
     }
 
+    RHI_CommandList* RHI_CommandList::AcquireSecondary()
+    {
+        SP_ASSERT(m_state == RHI_CommandListState::Recording);
+        SP_ASSERT(!m_is_secondary);
+
+        if (m_secondary_count == m_secondaries.size())
+        {
+            // each secondary gets its own pool, command pools can't be used by multiple threads at once
+            VkCommandPoolCreateInfo cmd_pool_info = {};
+            cmd_pool_info.sType                   = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+            cmd_pool_info.queueFamilyIndex        = RHI_Device::QueueGetIndex(RHI_Queue_Type::Graphics);
+            cmd_pool_info.flags                   = VK_COMMAND_POOL_CREATE_TRANSIENT_BIT;
+
+            VkCommandPool cmd_pool = nullptr;
+            SP_ASSERT_VK_MSG(vkCreateCommandPool(RHI_Context::device, &cmd_pool_info, nullptr, &cmd_pool), "Failed to create command pool");
+
+            string name = "cmd_list_secondary_" + to_string(m_secondary_count);
+            RHI_Device::SetResourceName(cmd_pool, RHI_Resource_Type::CommandPool, name);
+            m_secondaries.emplace_back(make_shared<RHI_CommandList>(static_cast<void*>(cmd_pool), name.c_str(), true));
+        }
+
+        return m_secondaries[m_secondary_count++].get();
+    }
+
+    void RHI_CommandList::BeginSecondary(RHI_CommandList* primary)
+    {
+        SP_ASSERT(m_is_secondary);
+        SP_ASSERT(primary->m_render_pass_active);
+
+        // the primary which executed the previous recording has completed, so the pool can be reset
+        SP_ASSERT_VK_MSG(vkResetCommandPool(RHI_Context::device, static_cast<VkCommandPool>(m_rhi_cmd_pool_resource), 0), "Failed to reset command pool");
+
+        // inherit the render targets of the primary's render pass
+        const RHI_PipelineState& pso = primary->m_pso;
+        array<VkFormat, rhi_max_render_target_count> formats_color;
+        uint32_t format_color_count = 0;
+        for (RHI_Format format : pso.render_target_color_formats)
+        {
+            if (format == RHI_Format::Max)
+                break;
+
+            formats_color[format_color_count++] = vulkan_format[rhi_format_to_index(format)];
+        }
+
+        VkFormat format_depth   = VK_FORMAT_UNDEFINED;
+        VkFormat format_stencil = VK_FORMAT_UNDEFINED;
+        if (pso.render_target_depth_format != RHI_Format::Max)
+        {
+            format_depth   = vulkan_format[rhi_format_to_index(pso.render_target_depth_format)];
+            format_stencil = pso.render_target_depth_format == RHI_Format::D32_Float_S8X24_Uint ? format_depth : VK_FORMAT_UNDEFINED;
+        }
+
+        VkCommandBufferInheritanceRenderingInfo inheritance_rendering_info = {};
+        inheritance_rendering_info.sType                                   = VK_STRUCTURE_TYPE_COMMAND_BUFFER_INHERITANCE_RENDERING_INFO;
+        inheritance_rendering_info.colorAttachmentCount                    = format_color_count;
+        inheritance_rendering_info.pColorAttachmentFormats                 = formats_color.data();
+        inheritance_rendering_info.depthAttachmentFormat                   = format_depth;
+        inheritance_rendering_info.stencilAttachmentFormat                 = format_stencil;
+        inheritance_rendering_info.rasterizationSamples                    = VK_SAMPLE_COUNT_1_BIT;
+
+        VkCommandBufferInheritanceInfo inheritance_info = {};
+        inheritance_info.sType                          = VK_STRUCTURE_TYPE_COMMAND_BUFFER_INHERITANCE_INFO;
+        inheritance_info.pNext                          = &inheritance_rendering_info;
+
+        VkCommandBufferBeginInfo begin_info = {};
+        begin_info.sType                    = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+        begin_info.flags                    = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT | VK_COMMAND_BUFFER_USAGE_RENDER_PASS_CONTINUE_BIT;
+        begin_info.pInheritanceInfo         = &inheritance_info;
+        SP_ASSERT_VK_MSG(vkBeginCommandBuffer(static_cast<VkCommandBuffer>(m_rhi_resource), &begin_info), "Failed to begin command buffer");
+
+        // nothing besides the render targets is inherited, the first SetPipelineState() binds everything
+        m_state                     = RHI_CommandListState::Recording;
+        m_pso                       = RHI_PipelineState();
+        m_pipeline                  = nullptr;
+        m_descriptor_layout_current = nullptr;
+        m_cull_mode                 = RHI_CullMode::Max;
+        m_buffer_id_index           = 0;
+        m_push_constant_size        = 0;
+        m_render_pass_active        = true;
+        m_buffer_id_vertex.fill(0);
+    }
+
+    void RHI_CommandList::ExecuteSecondaries(RHI_CommandList* const* secondaries, const uint32_t count)
+    {
+        SP_ASSERT(m_state == RHI_CommandListState::Recording);
+        SP_ASSERT(!m_is_secondary);
+        SP_ASSERT(m_pso.IsGraphics());
+
+        array<VkCommandBuffer, rhi_max_secondary_cmd_lists> cmd_buffers;
+        SP_ASSERT(count <= cmd_buffers.size());
+        for (uint32_t i = 0; i < count; i++)
+        {
+            RHI_CommandList* secondary = secondaries[i];
+            SP_ASSERT(secondary->m_state == RHI_CommandListState::Recording);
+
+            SP_ASSERT_VK_MSG(vkEndCommandBuffer(static_cast<VkCommandBuffer>(secondary->m_rhi_resource)), "Failed to end command buffer");
+            secondary->m_state = RHI_CommandListState::Idle;
+            cmd_buffers[i]     = static_cast<VkCommandBuffer>(secondary->m_rhi_resource);
+        }
+
+        // secondaries can only be executed in a render pass which was begun for them, it loads what the current one stored
+        RenderPassEnd();
+        RenderPassBegin(true);
+        vkCmdExecuteCommands(static_cast<VkCommandBuffer>(m_rhi_resource), count, cmd_buffers.data());
+        RenderPassEnd();
+
+        // the state which the secondaries bound is undefined in the primary, so everything has to be bound again
+        m_pso                = RHI_PipelineState();
+        m_cull_mode          = RHI_CullMode::Max;
+        m_buffer_id_index    = 0;
+        m_push_constant_size = 0;
+        m_buffer_id_vertex.fill(0);
+    }
+
     void RHI_CommandList::ClearPipelineStateRenderTargets(RHI_PipelineState& pipeline_state)
     {
         SP_ASSERT(m_state == RHI_CommandListState::Recording);
@@ -992,6 +1150,23 @@ namespace Spartan
         Profiler::m_rhi_draw++;
     }
 
+    void RHI_CommandList::DrawIndexedIndirect(RHI_StructuredBuffer* arguments, const uint32_t offset /*= 0*/)
+    {
+        SP_ASSERT(m_state == RHI_CommandListState::Recording);
+        SP_ASSERT(arguments != nullptr);
+
+        PreDraw();
+
+        vkCmdDrawIndexedIndirect(
+            static_cast<VkCommandBuffer>(m_rhi_resource),       // commandBuffer
+            static_cast<VkBuffer>(arguments->GetRhiResource()), // buffer
+            arguments->GetOffset() + offset,                    // offset
+            1,                                                  // drawCount
+            sizeof(VkDrawIndexedIndirectCommand)                // stride
+        );
+        Profiler::m_rhi_draw++;
+    }
+
     void RHI_CommandList::Dispatch(uint32_t x, uint32_t y, uint32_t z /*= 1*/)
     {
         SP_ASSERT(m_state == RHI_CommandListState::Recording);
@@ -1145,17 +1320,23 @@ namespace Spartan
                 "If the mips are blitted, then the mip count between the source and the destination textures must match");
         }
 
+        SP_ASSERT(source->GetArrayLength() == destination->GetArrayLength());
+
+        // copy all array slices, with the aspect matching the format (depth textures can be copied too)
+        VkImageAspectFlags aspect_mask = source->IsDepthFormat() ? VK_IMAGE_ASPECT_DEPTH_BIT : VK_IMAGE_ASPECT_COLOR_BIT;
+        uint32_t layer_count           = source->GetArrayLength();
+
         array<VkImageCopy, rhi_max_mip_count> copy_regions = {};
         uint32_t copy_region_count                         = blit_mips ? source->GetMipCount() : 1;
         for (uint32_t mip_index = 0; mip_index < copy_region_count; mip_index++)
         {
             VkImageCopy& copy_region              = copy_regions[mip_index];
-            copy_region.srcSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+            copy_region.srcSubresource.aspectMask = aspect_mask;
             copy_region.srcSubresource.mipLevel   = mip_index;
-            copy_region.srcSubresource.layerCount = 1;
-            copy_region.dstSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+            copy_region.srcSubresource.layerCount = layer_count;
+            copy_region.dstSubresource.aspectMask = aspect_mask;
             copy_region.dstSubresource.mipLevel   = mip_index;
-            copy_region.dstSubresource.layerCount = 1;
+            copy_region.dstSubresource.layerCount = layer_count;
             copy_region.extent.width              = source->GetWidth()  >> mip_index;
             copy_region.extent.height             = source->GetHeight() >> mip_index;
             copy_region.extent.depth              = 1;
@@ -1286,9 +1467,13 @@ namespace Spartan
         SP_ASSERT(m_state == RHI_CommandListState::Recording);
         SP_ASSERT(buffer != nullptr);
         SP_ASSERT(buffer->GetRhiResource() != nullptr);
+        SP_ASSERT(binding < m_buffer_id_vertex.size());
 
-        if (m_buffer_id_vertex == buffer->GetObjectId())
+        if (m_buffer_id_vertex[binding] == buffer->GetObjectId())
+        {
+            Profiler::m_rhi_skipped_buffer_vertex++;
             return;
+        }
 
         VkBuffer vertex_buffers[] = { static_cast<VkBuffer>(buffer->GetRhiResource()) };
         VkDeviceSize offsets[]    = { 0 };
@@ -1301,7 +1486,35 @@ namespace Spartan
             offsets                                       // pOffsets
         );
 
-        m_buffer_id_vertex = buffer->GetObjectId();
+        m_buffer_id_vertex[binding] = buffer->GetObjectId();
+        Profiler::m_rhi_bindings_buffer_vertex++;
+    }
+
+    void RHI_CommandList::SetBufferVertex(const RHI_StructuredBuffer* buffer, const uint32_t binding /*= 0*/)
+    {
+        SP_ASSERT(m_state == RHI_CommandListState::Recording);
+        SP_ASSERT(buffer != nullptr);
+        SP_ASSERT(buffer->GetRhiResource() != nullptr);
+        SP_ASSERT(binding < m_buffer_id_vertex.size());
+
+        if (m_buffer_id_vertex[binding] == buffer->GetObjectId())
+        {
+            Profiler::m_rhi_skipped_buffer_vertex++;
+            return;
+        }
+
+        VkBuffer vertex_buffers[] = { static_cast<VkBuffer>(buffer->GetRhiResource()) };
+        VkDeviceSize offsets[]    = { buffer->GetOffset() };
+
+        vkCmdBindVertexBuffers(
+            static_cast<VkCommandBuffer>(m_rhi_resource), // commandBuffer
+            binding,                                      // firstBinding
+            1,                                            // bindingCount
+            vertex_buffers,                               // pBuffers
+            offsets                                       // pOffsets
+        );
+
+        m_buffer_id_vertex[binding] = buffer->GetObjectId();
         Profiler::m_rhi_bindings_buffer_vertex++;
     }
 
@@ -1312,7 +1525,10 @@ namespace Spartan
         SP_ASSERT(buffer->GetRhiResource() != nullptr);
 
         if (m_buffer_id_index == buffer->GetObjectId())
+        {
+            Profiler::m_rhi_skipped_buffer_index++;
             return;
+        }
 
         vkCmdBindIndexBuffer(
             static_cast<VkCommandBuffer>(m_rhi_resource),                   // commandBuffer
@@ -1330,6 +1546,14 @@ namespace Spartan
         SP_ASSERT(m_state == RHI_CommandListState::Recording);
         SP_ASSERT(size <= RHI_Device::PropertyGetMaxPushConstantSize());
 
+        // skip if the exact same range and data is what was last pushed for this pipeline
+        bool cacheable = offset + size <= static_cast<uint32_t>(m_push_constant_data.size());
+        if (cacheable && m_push_constant_size == size && m_push_constant_offset == offset && memcmp(m_push_constant_data.data() + offset, data, size) == 0)
+        {
+            Profiler::m_rhi_skipped_push_constant++;
+            return;
+        }
+
         uint32_t stages = 0;
 
         if (m_pso.shaders[RHI_Shader_Type::Compute])
@@ -1365,6 +1589,15 @@ namespace Spartan
             size,
             data
         );
+
+        m_push_constant_offset = offset;
+        m_push_constant_size   = cacheable ? size : 0;
+        if (cacheable)
+        {
+            memcpy(m_push_constant_data.data() + offset, data, size);
+        }
+
+        Profiler::m_rhi_bindings_push_constant++;
     }
 
     void RHI_CommandList::SetConstantBuffer(const uint32_t slot, RHI_ConstantBuffer* constant_buffer) const
@@ -1667,6 +1900,7 @@ namespace Spartan
     )
     {
         SP_ASSERT(m_state == RHI_CommandListState::Recording);
+        SP_ASSERT_MSG(!m_is_secondary, "A secondary command list is recorded within a render pass, it can't have barriers");
 
         if (!m_render_pass_active)
         {
@@ -1706,6 +1940,31 @@ namespace Spartan
         InsertBarrierTexture(texture->GetRhiResource(), get_aspect_mask(texture), 0, 1, 1, texture->GetLayout(0), texture->GetLayout(0), texture->IsDsv());
     }
 
+    void RHI_CommandList::InsertBarrierBufferReadWrite()
+    {
+        SP_ASSERT(m_state == RHI_CommandListState::Recording);
+        SP_ASSERT_MSG(!m_is_secondary, "A secondary command list is recorded within a render pass, it can't have barriers");
+
+        // a global barrier, it orders buffer writes by compute shaders against any later access (indirect arguments,
+        // vertex input, shaders) and previous reads against later compute writes, structured buffers don't track state
+        VkMemoryBarrier2 barrier = {};
+        barrier.sType            = VK_STRUCTURE_TYPE_MEMORY_BARRIER_2;
+        barrier.srcStageMask     = VK_PIPELINE_STAGE_2_ALL_COMMANDS_BIT;
+        barrier.srcAccessMask    = VK_ACCESS_2_SHADER_WRITE_BIT;
+        barrier.dstStageMask     = VK_PIPELINE_STAGE_2_ALL_COMMANDS_BIT;
+        barrier.dstAccessMask    = VK_ACCESS_2_INDIRECT_COMMAND_READ_BIT | VK_ACCESS_2_VERTEX_ATTRIBUTE_READ_BIT | VK_ACCESS_2_SHADER_READ_BIT | VK_ACCESS_2_SHADER_WRITE_BIT;
+
+        VkDependencyInfo dependency_info   = {};
+        dependency_info.sType              = VK_STRUCTURE_TYPE_DEPENDENCY_INFO_KHR;
+        dependency_info.memoryBarrierCount = 1;
+        dependency_info.pMemoryBarriers    = &barrier;
+
+        RenderPassEnd();
+        vkCmdPipelineBarrier2(static_cast<VkCommandBuffer>(m_rhi_resource), &dependency_info);
+
+        Profiler::m_rhi_pipeline_barriers++;
+    }
+
     void RHI_CommandList::InsertPendingBarrierGroup()
     {
         if (!m_image_barriers.empty())
@@ -19,7 +19,7 @@ IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
 CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 */
 
-//= INCLUDES ==========================
+//= INCLUDES ==============================
 #include "pch.h"
 #include "../Rendering/Renderer.h"
 #include "../../Profiling/Profiler.h"
@@ -31,11 +31,16 @@ CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 #include "../RHI_Shader.h"
 #include "../RHI_DescriptorSetLayout.h"
 #include "../RHI_Pipeline.h"
+#include "../RHI_BlendState.h"
+#include "../RHI_RasterizerState.h"
+#include "../RHI_DepthStencilState.h"
+#include "../../IO/FileStream.h"
+#include "../../Resource/ResourceCache.h"
 SP_WARNINGS_OFF
 #define VMA_IMPLEMENTATION
 #include "vk_mem_alloc.h"
 SP_WARNINGS_ON
-//=====================================
+//=========================================
 
 //= NAMESPACES ===============
 using namespace std;
@@ -820,15 +825,37 @@ namespace Spartan
             }
         }
 
-        void get_descriptors_from_pipeline_state(RHI_PipelineState& pipeline_state, vector<RHI_Descriptor>& descriptors)
+        // the descriptors only depend on the shaders, so they are the key for the cache
+        uint64_t get_shaders_hash(const RHI_PipelineState& pipeline_state)
+        {
+            uint64_t shaders_hash = 0;
+            for (RHI_Shader* shader : pipeline_state.shaders)
+            {
+                shaders_hash = rhi_hash_combine(shaders_hash, shader ? shader->GetObjectId() : 0);
+                shaders_hash = rhi_hash_combine(shaders_hash, shader ? shader->GetHash()     : 0);
+            }
+
+            return shaders_hash;
+        }
+
+        uint64_t get_layout_hash(const vector<RHI_Descriptor>& descriptors)
         {
-            pipeline_state.Prepare();
+            uint64_t hash = 0;
+            for (const RHI_Descriptor& descriptor : descriptors)
+            {
+                hash = rhi_hash_combine(hash, static_cast<uint64_t>(descriptor.slot));
+                hash = rhi_hash_combine(hash, static_cast<uint64_t>(descriptor.stage));
+            }
 
-            // use the hash of the pipeline state as the key for the cache
-            uint64_t pipeline_state_hash = pipeline_state.GetHash();
+            return hash;
+        }
+
+        void get_descriptors_from_pipeline_state(RHI_PipelineState& pipeline_state, vector<RHI_Descriptor>& descriptors)
+        {
+            uint64_t shaders_hash = get_shaders_hash(pipeline_state);
 
-            // check if descriptors for this pipeline state are already cached
-            auto cached_descriptors = descriptor_cache.find(pipeline_state_hash);
+            // check if descriptors for these shaders are already cached
+            auto cached_descriptors = descriptor_cache.find(shaders_hash);
             if (cached_descriptors != descriptor_cache.end())
             {
                 // fetch from cache
@@ -877,25 +904,18 @@ namespace Spartan
             });
 
             // cache the newly created descriptors
-            descriptor_cache[pipeline_state_hash] = descriptors;
+            descriptor_cache[shaders_hash] = descriptors;
         }
 
-        shared_ptr<RHI_DescriptorSetLayout> get_or_create_descriptor_set_layout(RHI_PipelineState& pipeline_state)
+        shared_ptr<RHI_DescriptorSetLayout> get_or_create_descriptor_set_layout(RHI_PipelineState& pipeline_state, const bool clear_descriptor_data = true)
         {
             // get descriptors from pipeline state
             vector<RHI_Descriptor> descriptors;
             get_descriptors_from_pipeline_state(pipeline_state, descriptors);
 
-            // compute a hash for the descriptors
-            uint64_t hash = 0;
-            for (RHI_Descriptor& descriptor : descriptors)
-            {
-                hash = rhi_hash_combine(hash, static_cast<uint64_t>(descriptor.slot));
-                hash = rhi_hash_combine(hash, static_cast<uint64_t>(descriptor.stage));
-            }
-
-            // search for a descriptor set layout which matches this hash
-            auto it     = layouts.find(hash);
+            // search for a descriptor set layout which matches these descriptors
+            uint64_t hash = get_layout_hash(descriptors);
+            auto it       = layouts.find(hash);
             bool cached = it != layouts.end();
 
             // if there is no descriptor set layout for this particular hash, create one
@@ -906,7 +926,7 @@ namespace Spartan
             }
             shared_ptr<RHI_DescriptorSetLayout> descriptor_set_layout = it->second;
 
-            if (cached)
+            if (cached && clear_descriptor_data)
             {
                 descriptor_set_layout->ClearDescriptorData();
             }
@@ -1006,7 +1026,7 @@ namespace Spartan
                 }
             }
 
-            void update_textures(const array<RHI_Texture*, rhi_max_array_size>* textures, const uint32_t binding_slot)
+            void update_textures(const array<RHI_Texture*, rhi_max_array_size>* textures, const uint32_t binding_slot, const uint32_t start = 0, uint32_t count = rhi_max_array_size)
             {
                 uint32_t texture_count = static_cast<uint32_t>(textures->size());
                 uint32_t binding       = rhi_shader_shift_register_t + binding_slot;
@@ -1020,12 +1040,14 @@ namespace Spartan
                     create_set(RHI_Device_Resource::textures_material, texture_count, debug_name);
                 }
 
-                // update
+                // update, only the requested range is written
+                SP_ASSERT(start < texture_count);
+                count = min(count, texture_count - start);
                 {
-                    vector<VkDescriptorImageInfo> image_infos(texture_count);
-                    for (uint32_t i = 0; i < texture_count; ++i)
+                    vector<VkDescriptorImageInfo> image_infos(count);
+                    for (uint32_t i = 0; i < count; ++i)
                     {
-                        RHI_Texture* texture = (*textures)[i];
+                        RHI_Texture* texture = (*textures)[start + i];
                         if (!texture)
                             continue;
 
@@ -1042,9 +1064,9 @@ namespace Spartan
                     descriptor_write.sType                = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
                     descriptor_write.dstSet               = sets[static_cast<uint32_t>(RHI_Device_Resource::textures_material)];
                     descriptor_write.dstBinding           = binding;
-                    descriptor_write.dstArrayElement      = 0; // starting element in the array
+                    descriptor_write.dstArrayElement      = start; // starting element in the array
                     descriptor_write.descriptorType       = VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE;
-                    descriptor_write.descriptorCount      = texture_count;
+                    descriptor_write.descriptorCount      = count;
                     descriptor_write.pImageInfo           = image_infos.data();
 
                     vkUpdateDescriptorSets(RHI_Context::device, 1, &descriptor_write, 0, nullptr);
@@ -1066,6 +1088,375 @@ namespace Spartan
         }
     }
 
+    namespace pipeline_cache
+    {
+        // bump when the record layout changes
+        const uint32_t record_magic   = 0x50534F52; // "PSOR"
+        const uint32_t record_version = 1;
+        const uint8_t unused          = 0xFF;
+
+        // a pipeline description which outlives the session, renderer owned resources are referred to by their enum
+        struct Record
+        {
+            string name;
+            array<uint8_t, static_cast<uint32_t>(RHI_Shader_Type::Max)> shaders;         // Renderer_Shader
+            array<RHI_Format, rhi_max_render_target_count> color_formats;
+            RHI_Format depth_format     = RHI_Format::Max;
+            uint8_t rasterizer_state    = unused; // Renderer_RasterizerState
+            uint8_t blend_state         = unused; // Renderer_BlendState
+            uint8_t depth_stencil_state = unused; // Renderer_DepthStencilState
+            uint8_t primitive_topology  = 0;
+            bool instancing             = false;
+            bool vrs                    = false;
+        };
+
+        mutex mutex_records;
+        unordered_map<uint64_t, Record> records; // pipelines seen this session, keyed by their pipeline key
+        vector<Record> records_previous;         // pipelines seen in previous sessions, consumed by the pre-warm
+
+        string get_file_path(const string& file_name)
+        {
+            return ResourceCache::GetResourceDirectory(ResourceDirectory::Cache) + "\\" + file_name;
+        }
+
+        // everything that ends up in a vulkan pipeline, unlike the pso hash this doesn't care
+        // about which textures are bound, only their formats, so pipelines are shared across render targets
+        uint64_t get_key(const RHI_PipelineState& pso)
+        {
+            uint64_t key = static_cast<uint64_t>(pso.instancing);
+            key          = rhi_hash_combine(key, static_cast<uint64_t>(pso.primitive_toplogy));
+            key          = rhi_hash_combine(key, static_cast<uint64_t>(pso.vrs_input_texture != nullptr));
+            key          = rhi_hash_combine(key, pso.rasterizer_state    ? pso.rasterizer_state->GetHash()    : 0);
+            key          = rhi_hash_combine(key, pso.blend_state         ? pso.blend_state->GetHash()         : 0);
+            key          = rhi_hash_combine(key, pso.depth_stencil_state ? pso.depth_stencil_state->GetHash() : 0);
+
+            for (RHI_Shader* shader : pso.shaders)
+            {
+                key = rhi_hash_combine(key, shader ? shader->GetObjectId() : 0);
+                key = rhi_hash_combine(key, shader ? shader->GetHash()     : 0);
+            }
+
+            for (RHI_Format format : pso.render_target_color_formats)
+            {
+                key = rhi_hash_combine(key, static_cast<uint64_t>(format));
+            }
+            key = rhi_hash_combine(key, static_cast<uint64_t>(pso.render_target_depth_format));
+
+            return key;
+        }
+
+        template<typename T, typename TEnum>
+        bool find_index(const T* resource, const uint32_t count, function<T*(TEnum)> get, uint8_t& index)
+        {
+            index = unused;
+            if (!resource)
+                return true;
+
+            for (uint32_t i = 0; i < count; i++)
+            {
+                if (get(static_cast<TEnum>(i)) == resource)
+                {
+                    index = static_cast<uint8_t>(i);
+                    return true;
+                }
+            }
+
+            // not owned by the renderer (e.g. the editor's), so it can't be found again next session
+            return false;
+        }
+
+        bool to_record(const RHI_PipelineState& pso, Record& record)
+        {
+            record.name               = pso.name;
+            record.color_formats      = pso.render_target_color_formats;
+            record.depth_format       = pso.render_target_depth_format;
+            record.primitive_topology = static_cast<uint8_t>(pso.primitive_toplogy);
+            record.instancing         = pso.instancing;
+            record.vrs                = pso.vrs_input_texture != nullptr;
+
+            auto get_shader = [](Renderer_Shader type) { return Renderer::GetShader(type).get(); };
+            for (uint32_t stage = 0; stage < static_cast<uint32_t>(RHI_Shader_Type::Max); stage++)
+            {
+                if (!find_index<RHI_Shader, Renderer_Shader>(pso.shaders[stage], static_cast<uint32_t>(Renderer_Shader::max), get_shader, record.shaders[stage]))
+                    return false;
+            }
+
+            auto get_rasterizer    = [](Renderer_RasterizerState type)   { return Renderer::GetRasterizerState(type).get(); };
+            auto get_blend         = [](Renderer_BlendState type)        { return Renderer::GetBlendState(type).get(); };
+            auto get_depth_stencil = [](Renderer_DepthStencilState type) { return Renderer::GetDepthStencilState(type).get(); };
+
+            return
+                find_index<RHI_RasterizerState, Renderer_RasterizerState>(pso.rasterizer_state, static_cast<uint32_t>(Renderer_RasterizerState::Max), get_rasterizer, record.rasterizer_state) &&
+                find_index<RHI_BlendState, Renderer_BlendState>(pso.blend_state, static_cast<uint32_t>(Renderer_BlendState::Max), get_blend, record.blend_state) &&
+                find_index<RHI_DepthStencilState, Renderer_DepthStencilState>(pso.depth_stencil_state, static_cast<uint32_t>(Renderer_DepthStencilState::Max), get_depth_stencil, record.depth_stencil_state);
+        }
+
+        bool from_record(const Record& record, RHI_PipelineState& pso)
+        {
+            for (uint32_t stage = 0; stage < static_cast<uint32_t>(RHI_Shader_Type::Max); stage++)
+            {
+                if (record.shaders[stage] == unused)
+                    continue;
+
+                RHI_Shader* shader = Renderer::GetShader(static_cast<Renderer_Shader>(record.shaders[stage])).get();
+                if (!shader || !shader->IsCompiled())
+                    return false;
+
+                pso.shaders[stage] = shader;
+            }
+
+            if (record.rasterizer_state != unused)
+            {
+                pso.rasterizer_state = Renderer::GetRasterizerState(static_cast<Renderer_RasterizerState>(record.rasterizer_state)).get();
+            }
+
+            if (record.blend_state != unused)
+            {
+                pso.blend_state = Renderer::GetBlendState(static_cast<Renderer_BlendState>(record.blend_state)).get();
+            }
+
+            if (record.depth_stencil_state != unused)
+            {
+                pso.depth_stencil_state = Renderer::GetDepthStencilState(static_cast<Renderer_DepthStencilState>(record.depth_stencil_state)).get();
+            }
+
+            if (record.vrs)
+            {
+                pso.vrs_input_texture = Renderer::GetRenderTarget(Renderer_RenderTarget::shading_rate).get();
+                if (!pso.vrs_input_texture)
+                    return false;
+            }
+
+            pso.name                        = record.name;
+            pso.render_target_color_formats = record.color_formats;
+            pso.render_target_depth_format  = record.depth_format;
+            pso.primitive_toplogy           = static_cast<RHI_PrimitiveTopology>(record.primitive_topology);
+            pso.instancing                  = record.instancing;
+
+            return pso.IsGraphics() || pso.IsCompute();
+        }
+
+        void add_record(const RHI_PipelineState& pso, const uint64_t key)
+        {
+            Record record;
+            if (!to_record(pso, record))
+                return;
+
+            lock_guard<mutex> lock(mutex_records);
+            records[key] = record;
+        }
+
+        void load_records()
+        {
+            const string file_path = get_file_path("pipelines.rec");
+            if (!FileSystem::IsFile(file_path))
+                return;
+
+            FileStream stream(file_path, FileStream_Read);
+            if (!stream.IsOpen())
+                return;
+
+            // the renderer's enums are part of the format, so discard the records when they change
+            bool valid =
+                stream.ReadAs<uint32_t>() == record_magic   &&
+                stream.ReadAs<uint32_t>() == record_version &&
+                stream.ReadAs<uint32_t>() == static_cast<uint32_t>(Renderer_Shader::max);
+            if (!valid)
+                return;
+
+            uint32_t count = stream.ReadAs<uint32_t>();
+            vector<Record> records_loaded;
+            records_loaded.reserve(count);
+            for (uint32_t i = 0; i < count; i++)
+            {
+                Record record;
+                record.name = stream.ReadAs<string>();
+                for (uint8_t& shader : record.shaders)
+                {
+                    stream.Read(&shader);
+                }
+                for (RHI_Format& format : record.color_formats)
+                {
+                    format = static_cast<RHI_Format>(stream.ReadAs<uint32_t>());
+                }
+                record.depth_format = static_cast<RHI_Format>(stream.ReadAs<uint32_t>());
+                stream.Read(&record.rasterizer_state);
+                stream.Read(&record.blend_state);
+                stream.Read(&record.depth_stencil_state);
+                stream.Read(&record.primitive_topology);
+                stream.Read(&record.instancing);
+                stream.Read(&record.vrs);
+
+                records_loaded.emplace_back(record);
+            }
+
+            lock_guard<mutex> lock(mutex_records);
+            records_previous = move(records_loaded);
+        }
+
+        void save_records()
+        {
+            const string file_path      = get_file_path("pipelines.rec");
+            const string file_path_temp = file_path + ".tmp";
+            {
+                FileStream stream(file_path_temp, FileStream_Write);
+                if (!stream.IsOpen())
+                    return;
+
+                stream.Write(record_magic);
+                stream.Write(record_version);
+                stream.Write(static_cast<uint32_t>(Renderer_Shader::max));
+                auto write = [&stream](const Record& record)
+                {
+                    stream.Write(record.name);
+                    for (uint8_t shader : record.shaders)
+                    {
+                        stream.Write(shader);
+                    }
+                    for (RHI_Format format : record.color_formats)
+                    {
+                        stream.Write(static_cast<uint32_t>(format));
+                    }
+                    stream.Write(static_cast<uint32_t>(record.depth_format));
+                    stream.Write(record.rasterizer_state);
+                    stream.Write(record.blend_state);
+                    stream.Write(record.depth_stencil_state);
+                    stream.Write(record.primitive_topology);
+                    stream.Write(record.instancing);
+                    stream.Write(record.vrs);
+                };
+
+                // also keep what previous sessions saw but this one didn't get around to re-creating
+                stream.Write(static_cast<uint32_t>(records.size() + records_previous.size()));
+                for (const auto& it : records)
+                {
+                    write(it.second);
+                }
+                for (const Record& record : records_previous)
+                {
+                    write(record);
+                }
+            }
+
+            error_code error;
+            filesystem::rename(file_path_temp, file_path, error);
+        }
+
+        // creates the driver's pipeline cache, returns whether the one saved by the previous session could be used
+        bool create()
+        {
+            vector<unsigned char> data;
+            const string file_path = get_file_path("pipelines.cache");
+            if (FileSystem::IsFile(file_path))
+            {
+                FileStream stream(file_path, FileStream_Read);
+                if (stream.IsOpen())
+                {
+                    stream.Read(&data);
+                }
+            }
+
+            // drivers are supposed to reject data from other devices or driver versions, not all of them do, so check ourselves
+            if (!data.empty())
+            {
+                VkPhysicalDeviceProperties properties = {};
+                vkGetPhysicalDeviceProperties(RHI_Context::device_physical, &properties);
+
+                VkPipelineCacheHeaderVersionOne header = {};
+                bool valid = data.size() >= sizeof(header);
+                if (valid)
+                {
+                    memcpy(&header, data.data(), sizeof(header));
+                    valid =
+                        header.headerVersion == VK_PIPELINE_CACHE_HEADER_VERSION_ONE &&
+                        header.vendorID      == properties.vendorID                  &&
+                        header.deviceID      == properties.deviceID                  &&
+                        memcmp(header.pipelineCacheUUID, properties.pipelineCacheUUID, VK_UUID_SIZE) == 0;
+                }
+
+                if (!valid)
+                {
+                    SP_LOG_INFO("Pipeline cache is from a different device or driver, starting with an empty one");
+                    data.clear();
+                }
+            }
+
+            VkPipelineCacheCreateInfo create_info = {};
+            create_info.sType                     = VK_STRUCTURE_TYPE_PIPELINE_CACHE_CREATE_INFO;
+            create_info.initialDataSize           = data.size();
+            create_info.pInitialData              = data.empty() ? nullptr : data.data();
+            if (vkCreatePipelineCache(RHI_Context::device, &create_info, nullptr, &RHI_Context::pipeline_cache) != VK_SUCCESS)
+            {
+                create_info.initialDataSize = 0;
+                create_info.pInitialData    = nullptr;
+                SP_ASSERT_VK_MSG(vkCreatePipelineCache(RHI_Context::device, &create_info, nullptr, &RHI_Context::pipeline_cache), "Failed to create pipeline cache");
+                return false;
+            }
+
+            return !data.empty();
+        }
+
+        void save()
+        {
+            const string directory = ResourceCache::GetResourceDirectory(ResourceDirectory::Cache);
+            if (!FileSystem::Exists(directory))
+            {
+                FileSystem::CreateDirectory(directory);
+            }
+
+            // save the driver's pipeline cache
+            size_t size = 0;
+            if (vkGetPipelineCacheData(RHI_Context::device, RHI_Context::pipeline_cache, &size, nullptr) == VK_SUCCESS && size != 0)
+            {
+                vector<unsigned char> data(size);
+                if (vkGetPipelineCacheData(RHI_Context::device, RHI_Context::pipeline_cache, &size, data.data()) == VK_SUCCESS)
+                {
+                    data.resize(size);
+
+                    // write to a temporary file and then rename it, so that a crash can't leave a truncated cache behind
+                    const string file_path      = get_file_path("pipelines.cache");
+                    const string file_path_temp = file_path + ".tmp";
+                    {
+                        FileStream stream(file_path_temp, FileStream_Write);
+                        if (stream.IsOpen())
+                        {
+                            stream.Write(data);
+                        }
+                    }
+
+                    error_code error;
+                    filesystem::rename(file_path_temp, file_path, error);
+                }
+            }
+
+            save_records();
+        }
+
+        void initialize()
+        {
+            create();
+            load_records();
+        }
+
+        void shutdown()
+        {
+            if (!RHI_Context::pipeline_cache)
+                return;
+
+            save();
+
+            // only needed until they are saved, release them so that they don't show up as leaks
+            {
+                lock_guard<mutex> lock(mutex_records);
+                records          = unordered_map<uint64_t, Record>();
+                records_previous = vector<Record>();
+            }
+
+            vkDestroyPipelineCache(RHI_Context::device, RHI_Context::pipeline_cache, nullptr);
+            RHI_Context::pipeline_cache = nullptr;
+        }
+    }
+
     namespace device_features
     {
         VkPhysicalDeviceFeatures2 features                          = {};
@@ -1362,6 +1753,7 @@ namespace Spartan
 
         vulkan_memory_allocator::initialize();
         CreateDescriptorPool();
+        pipeline_cache::initialize();
 
         // register the vulkan sdk version, which can be higher than the version we are using which is driver dependent
         string version_Sdlk = to_string(VK_VERSION_MAJOR(VK_HEADER_VERSION_COMPLETE)) + "." + to_string(VK_VERSION_MINOR(VK_HEADER_VERSION_COMPLETE)) + "." + to_string(VK_VERSION_PATCH(VK_HEADER_VERSION_COMPLETE));
@@ -1403,6 +1795,9 @@ namespace Spartan
         // descriptors
         descriptors::release();
 
+        // persist the pipeline cache and the pipelines this session used
+        pipeline_cache::shutdown();
+
         // the destructor of all the resources enqueues it's vk buffer memory for de-allocation
         // this is where we actually go through them and de-allocate them
         RHI_Device::DeletionQueueParse();
@@ -1562,6 +1957,7 @@ namespace Spartan
                     case RHI_Resource_Type::QueryPool:           vkDestroyQueryPool(RHI_Context::device, static_cast<VkQueryPool>(resource), nullptr);                     break;
                     case RHI_Resource_Type::Pipeline:            vkDestroyPipeline(RHI_Context::device, static_cast<VkPipeline>(resource), nullptr);                       break;
                     case RHI_Resource_Type::PipelineLayout:      vkDestroyPipelineLayout(RHI_Context::device, static_cast<VkPipelineLayout>(resource), nullptr);           break;
+                    case RHI_Resource_Type::CommandPool:         vkDestroyCommandPool(RHI_Context::device, static_cast<VkCommandPool>(resource), nullptr);                 break;
                     default:                                     SP_ASSERT_MSG(false, "Unknown resource");                                                                 break;
                 }
 
@@ -1716,7 +2112,7 @@ namespace Spartan
         return VkDescriptorType::VK_DESCRIPTOR_TYPE_MAX_ENUM;
     }
 
-    void RHI_Device::UpdateBindlessResources(const array<shared_ptr<RHI_Sampler>, static_cast<uint32_t>(Renderer_Sampler::Max)>* samplers, array<RHI_Texture*, rhi_max_array_size>* textures)
+    void RHI_Device::UpdateBindlessResources(const array<shared_ptr<RHI_Sampler>, static_cast<uint32_t>(Renderer_Sampler::Max)>* samplers, array<RHI_Texture*, rhi_max_array_size>* textures, const uint32_t texture_start, const uint32_t texture_count)
     {
         if (samplers)
         {
@@ -1765,9 +2161,9 @@ namespace Spartan
                 }
             }
 
-            if (textures)
+            if (textures && texture_count != 0)
             {
-                descriptors::bindless::update_textures(textures, binding_slot);
+                descriptors::bindless::update_textures(textures, binding_slot, texture_start, texture_count);
             }
         }
     }
@@ -1783,17 +2179,173 @@ namespace Spartan
         descriptor_set_layout = descriptors::get_or_create_descriptor_set_layout(pso).get();
 
         // if no pipeline exists, create one
-        uint64_t hash = pso.GetHash();
-        auto it = descriptors::pipelines.find(hash);
+        uint64_t key = pipeline_cache::get_key(pso);
+        auto it      = descriptors::pipelines.find(key);
         if (it == descriptors::pipelines.end())
         {
             // create a new pipeline
-            it = descriptors::pipelines.emplace(make_pair(hash, make_shared<RHI_Pipeline>(pso, descriptor_set_layout))).first;
+            it = descriptors::pipelines.emplace(make_pair(key, make_shared<RHI_Pipeline>(pso, descriptor_set_layout))).first;
+
+            // remember it, so that the next session can create it ahead of time
+            pipeline_cache::add_record(pso, key);
         }
 
         pipeline = it->second.get();
     }
 
+    void RHI_Device::DeletePipelines(const RHI_Shader* shader)
+    {
+        lock_guard<mutex> lock(descriptors::descriptor_pipeline_mutex);
+
+        // the pipeline destructor hands the api objects to the deletion queue
+        uint32_t deleted = 0;
+        for (auto it = descriptors::pipelines.begin(); it != descriptors::pipelines.end();)
+        {
+            RHI_PipelineState* pso = it->second->GetPipelineState();
+            if (find(pso->shaders.begin(), pso->shaders.end(), shader) != pso->shaders.end())
+            {
+                descriptors::descriptor_cache.erase(descriptors::get_shaders_hash(*pso));
+                it = descriptors::pipelines.erase(it);
+                deleted++;
+            }
+            else
+            {
+                ++it;
+            }
+        }
+
+        if (deleted == 0)
+            return;
+
+        // layouts are shared by descriptors, so only the ones which no pipeline resolves to anymore can go
+        unordered_set<uint64_t> layouts_used;
+        vector<RHI_Descriptor> descriptors;
+        for (const auto& [key, pipeline] : descriptors::pipelines)
+        {
+            descriptors::get_descriptors_from_pipeline_state(*pipeline->GetPipelineState(), descriptors);
+            layouts_used.insert(descriptors::get_layout_hash(descriptors));
+        }
+
+        for (auto it = descriptors::layouts.begin(); it != descriptors::layouts.end();)
+        {
+            if (layouts_used.find(it->first) == layouts_used.end())
+            {
+                it = descriptors::layouts.erase(it);
+            }
+            else
+            {
+                ++it;
+            }
+        }
+    }
+
+    void RHI_Device::PrewarmPipelines()
+    {
+        // take the records whose shaders are ready, the rest stay for a later call
+        vector<pipeline_cache::Record> records;
+        {
+            lock_guard<mutex> lock(pipeline_cache::mutex_records);
+
+            auto& records_previous = pipeline_cache::records_previous;
+            for (auto it = records_previous.begin(); it != records_previous.end();)
+            {
+                bool shaders_ready = true;
+                for (uint8_t shader : it->shaders)
+                {
+                    if (shader != pipeline_cache::unused)
+                    {
+                        RHI_Shader* rhi_shader = Renderer::GetShader(static_cast<Renderer_Shader>(shader)).get();
+                        shaders_ready         &= rhi_shader && rhi_shader->GetCompilationState() != RHI_ShaderCompilationState::Idle && rhi_shader->GetCompilationState() != RHI_ShaderCompilationState::Compiling;
+                    }
+                }
+
+                if (shaders_ready)
+                {
+                    records.emplace_back(move(*it));
+                    it = records_previous.erase(it);
+                }
+                else
+                {
+                    ++it;
+                }
+            }
+        }
+
+        const Stopwatch timer;
+        uint32_t created = 0;
+        for (const pipeline_cache::Record& record : records)
+        {
+            // records with shaders that failed to compile or resources that no longer exist are dropped
+            RHI_PipelineState pso;
+            if (!pipeline_cache::from_record(record, pso))
+                continue;
+
+            uint64_t key = pipeline_cache::get_key(pso);
+            RHI_DescriptorSetLayout* descriptor_set_layout = nullptr;
+            {
+                lock_guard<mutex> lock(descriptors::descriptor_pipeline_mutex);
+                if (descriptors::pipelines.find(key) != descriptors::pipelines.end())
+                    continue;
+
+                // don't clear the descriptor data, the render thread might be in the middle of using this layout
+                descriptor_set_layout = descriptors::get_or_create_descriptor_set_layout(pso, false).get();
+            }
+
+            // create outside of the lock, so the render thread doesn't have to wait for us
+            shared_ptr<RHI_Pipeline> rhi_pipeline = make_shared<RHI_Pipeline>(pso, descriptor_set_layout);
+            {
+                lock_guard<mutex> lock(descriptors::descriptor_pipeline_mutex);
+                if (descriptors::pipelines.emplace(make_pair(key, rhi_pipeline)).second)
+                {
+                    created++;
+                }
+            }
+
+            lock_guard<mutex> lock(pipeline_cache::mutex_records);
+            pipeline_cache::records[key] = record;
+        }
+
+        if (created != 0)
+        {
+            SP_LOG_INFO("Pre-warmed %d pipelines in %.2f ms", created, timer.GetElapsedTimeMs());
+        }
+    }
+
+    void RHI_Device::PipelineCacheSave()
+    {
+        pipeline_cache::save();
+    }
+
+    bool RHI_Device::PipelineCacheLoad()
+    {
+        // start over from what was saved, the records of this session are part of it if it was saved
+        vkDestroyPipelineCache(RHI_Context::device, RHI_Context::pipeline_cache, nullptr);
+        RHI_Context::pipeline_cache = nullptr;
+        {
+            lock_guard<mutex> lock(pipeline_cache::mutex_records);
+            pipeline_cache::records.clear();
+            pipeline_cache::records_previous.clear();
+        }
+
+        const bool is_from_disk = pipeline_cache::create();
+        pipeline_cache::load_records();
+
+        return is_from_disk;
+    }
+
+    uint64_t RHI_Device::PipelineCacheGetSize()
+    {
+        size_t size = 0;
+        vkGetPipelineCacheData(RHI_Context::device, RHI_Context::pipeline_cache, &size, nullptr);
+        return static_cast<uint64_t>(size);
+    }
+
+    uint32_t RHI_Device::PipelineCacheGetRecordCount()
+    {
+        lock_guard<mutex> lock(pipeline_cache::mutex_records);
+        return static_cast<uint32_t>(pipeline_cache::records.size() + pipeline_cache::records_previous.size());
+    }
+
     uint32_t RHI_Device::GetPipelineCount()
     {
         return static_cast<uint32_t>(descriptors::pipelines.size());
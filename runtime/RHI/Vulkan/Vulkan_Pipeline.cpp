@@ -313,19 +313,13 @@ namespace Spartan
                 blend_state_attachment.dstAlphaBlendFactor                 = vulkan_blend_factor[static_cast<uint32_t>(m_state.blend_state->GetDestBlendAlpha())];
                 blend_state_attachment.alphaBlendOp                        = vulkan_blend_operation[static_cast<uint32_t>(m_state.blend_state->GetBlendOpAlpha())];
 
-                // swapchain
-                if (m_state.render_target_swapchain)
+                // swapchain or render target(s)
+                for (RHI_Format format : m_state.render_target_color_formats)
                 {
-                    blend_state_attachments.push_back(blend_state_attachment);
-                }
+                    if (format == RHI_Format::Max)
+                        break;
 
-                // render target(s)
-                for (uint8_t i = 0; i < rhi_max_render_target_count; i++)
-                {
-                    if (m_state.render_target_color_textures[i] != nullptr)
-                    {
-                        blend_state_attachments.push_back(blend_state_attachment);
-                    }
+                    blend_state_attachments.push_back(blend_state_attachment);
                 }
             }
             
@@ -375,29 +369,20 @@ namespace Spartan
                 VkFormat attachment_format_depth   = VK_FORMAT_UNDEFINED;
                 VkFormat attachment_format_stencil = VK_FORMAT_UNDEFINED;
                 {
-                    // swapchain buffer as a render target
-                    if (m_state.render_target_swapchain)
-                    {
-                        attachment_formats_color.push_back(vulkan_format[rhi_format_to_index(m_state.render_target_swapchain->GetFormat())]);
-                    }
-                    else // regular render target(s)
+                    // swapchain buffer or regular render target(s)
+                    for (RHI_Format format : m_state.render_target_color_formats)
                     {
-                        for (uint32_t i = 0; i < rhi_max_render_target_count; i++)
-                        {
-                            RHI_Texture* texture = m_state.render_target_color_textures[i];
-                            if (texture == nullptr)
-                                break;
-
-                            attachment_formats_color.push_back(vulkan_format[rhi_format_to_index(texture->GetFormat())]);
-                        }
+                        if (format == RHI_Format::Max)
+                            break;
+
+                        attachment_formats_color.push_back(vulkan_format[rhi_format_to_index(format)]);
                     }
 
                     // depth
-                    if (m_state.render_target_depth_texture)
+                    if (m_state.render_target_depth_format != RHI_Format::Max)
                     {
-                        RHI_Texture* tex_depth    = m_state.render_target_depth_texture;
-                        attachment_format_depth   = vulkan_format[rhi_format_to_index(tex_depth->GetFormat())];
-                        attachment_format_stencil = tex_depth->IsStencilFormat() ? attachment_format_depth : VK_FORMAT_UNDEFINED;
+                        attachment_format_depth   = vulkan_format[rhi_format_to_index(m_state.render_target_depth_format)];
+                        attachment_format_stencil = m_state.render_target_depth_format == RHI_Format::D32_Float_S8X24_Uint ? attachment_format_depth : VK_FORMAT_UNDEFINED;
                     }
 
                     // variable rate shading
@@ -438,7 +423,7 @@ namespace Spartan
                     pipeline_info.layout                       = static_cast<VkPipelineLayout>(m_resource_pipeline_layout);
                     pipeline_info.flags                        = m_state.vrs_input_texture ? VK_PIPELINE_CREATE_RENDERING_FRAGMENT_SHADING_RATE_ATTACHMENT_BIT_KHR : 0;
 
-                    SP_ASSERT_VK_MSG(vkCreateGraphicsPipelines(RHI_Context::device, nullptr, 1, &pipeline_info, nullptr, pipeline), "Failed to create graphics pipeline");
+                    SP_ASSERT_VK_MSG(vkCreateGraphicsPipelines(RHI_Context::device, RHI_Context::pipeline_cache, 1, &pipeline_info, nullptr, pipeline), "Failed to create graphics pipeline");
                     RHI_Device::SetResourceName(static_cast<void*>(*pipeline), RHI_Resource_Type::Pipeline, pipeline_state.name);
                 }
             }
@@ -449,7 +434,7 @@ namespace Spartan
                 pipeline_info.layout                      = static_cast<VkPipelineLayout>(m_resource_pipeline_layout);
                 pipeline_info.stage                       = shader_stages[0];
 
-                SP_ASSERT_VK_MSG(vkCreateComputePipelines(RHI_Context::device, nullptr, 1, &pipeline_info, nullptr, pipeline),"Failed to create compute pipeline");
+                SP_ASSERT_VK_MSG(vkCreateComputePipelines(RHI_Context::device, RHI_Context::pipeline_cache, 1, &pipeline_info, nullptr, pipeline),"Failed to create compute pipeline");
                 RHI_Device::SetResourceName(static_cast<void*>(*pipeline), RHI_Resource_Type::Pipeline, pipeline_state.name);
             }
         }
@@ -151,46 +151,50 @@ namespace Spartan
             arguments.emplace_back("-D"); arguments.emplace_back(define.first + "=" + define.second);
         }
 
-        // compile
-        if (IDxcResult* dxc_result = DirecXShaderCompiler::Compile(m_preprocessed_source, arguments))
+        // load from the cache, or compile, reflect and cache
+        vector<uint32_t> bytecode;
+        uint64_t cache_key = ComputeCacheKey(arguments, DirecXShaderCompiler::GetVersion());
+        m_from_cache       = LoadFromCache(cache_key, bytecode);
+        if (!m_from_cache)
         {
+            IDxcResult* dxc_result = DirecXShaderCompiler::Compile(m_preprocessed_source, arguments);
+            if (!dxc_result)
+                return nullptr;
+
             // get compiled shader buffer
             IDxcBlob* shader_buffer = nullptr;
             dxc_result->GetResult(&shader_buffer);
+            const uint32_t* words = reinterpret_cast<const uint32_t*>(shader_buffer->GetBufferPointer());
+            bytecode.assign(words, words + shader_buffer->GetBufferSize() / 4);
 
-            // create shader module
-            VkShaderModule shader_module         = nullptr;
-            VkShaderModuleCreateInfo create_info = {};
-            create_info.sType                    = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO;
-            create_info.codeSize                 = static_cast<size_t>(shader_buffer->GetBufferSize());
-            create_info.pCode                    = reinterpret_cast<const uint32_t*>(shader_buffer->GetBufferPointer());
+            // release
+            dxc_result->Release();
 
-            SP_ASSERT_VK_MSG(vkCreateShaderModule(RHI_Context::device, &create_info, nullptr, &shader_module), "Failed to create shader module");
+            // reflect shader resources (so that descriptor sets can be created later)
+            Reflect(m_shader_type, bytecode.data(), static_cast<uint32_t>(bytecode.size()));
 
-            // name the shader module (useful for gpu-based validation)
-            RHI_Device::SetResourceName(static_cast<void*>(shader_module), RHI_Resource_Type::Shader, m_object_name.c_str());
+            SaveToCache(cache_key, bytecode.data(), static_cast<uint32_t>(bytecode.size()));
+        }
 
-            // reflect shader resources (so that descriptor sets can be created later)
-            Reflect
-            (
-                m_shader_type,
-                reinterpret_cast<uint32_t*>(shader_buffer->GetBufferPointer()),
-                static_cast<uint32_t>(shader_buffer->GetBufferSize() / 4)
-            );
-            
-            // create input layout
-            if (m_input_layout)
-            {
-                m_input_layout->Create(m_vertex_type, nullptr);
-            }
+        // create shader module
+        VkShaderModule shader_module         = nullptr;
+        VkShaderModuleCreateInfo create_info = {};
+        create_info.sType                    = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO;
+        create_info.codeSize                 = bytecode.size() * sizeof(uint32_t);
+        create_info.pCode                    = bytecode.data();
 
-            // release
-            dxc_result->Release();
+        SP_ASSERT_VK_MSG(vkCreateShaderModule(RHI_Context::device, &create_info, nullptr, &shader_module), "Failed to create shader module");
+
+        // name the shader module (useful for gpu-based validation)
+        RHI_Device::SetResourceName(static_cast<void*>(shader_module), RHI_Resource_Type::Shader, m_object_name.c_str());
 
-            return static_cast<void*>(shader_module);
+        // create input layout
+        if (m_input_layout)
+        {
+            m_input_layout->Create(m_vertex_type, nullptr);
         }
 
-        return nullptr;
+        return static_cast<void*>(shader_module);
     }
 
     void RHI_Shader::Reflect(const RHI_Shader_Type shader_stage, const uint32_t* ptr, const uint32_t size)
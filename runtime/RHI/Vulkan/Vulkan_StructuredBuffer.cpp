@@ -47,9 +47,10 @@ namespace Spartan
         }
         m_object_size = m_stride * m_element_count;
 
-        // create buffer
+        // create buffer, compute shaders can also write draw arguments and vertex data into it
         VkMemoryPropertyFlags flags = VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT; // mappable
-        RHI_Device::MemoryBufferCreate(m_rhi_resource, m_object_size, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, flags, nullptr, name);
+        VkBufferUsageFlags usage    = VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT | VK_BUFFER_USAGE_VERTEX_BUFFER_BIT;
+        RHI_Device::MemoryBufferCreate(m_rhi_resource, m_object_size, usage, flags, nullptr, name);
         RHI_Device::SetResourceName(m_rhi_resource, RHI_Resource_Type::Buffer, name); // name the resource
 
         // get mapped data pointer
@@ -83,4 +84,13 @@ namespace Spartan
         // we are using persistent mapping, so we only copy (no need for map/unmap)
         memcpy(reinterpret_cast<std::byte*>(m_mapped_data) + m_offset, reinterpret_cast<std::byte*>(data_cpu), size);
     }
+
+    void RHI_StructuredBuffer::UpdateRange(const void* data_cpu, const uint32_t offset, const uint32_t size)
+    {
+        SP_ASSERT_MSG(data_cpu != nullptr,            "Invalid update data");
+        SP_ASSERT_MSG(m_mapped_data != nullptr,       "Invalid mapped data");
+        SP_ASSERT_MSG(offset + size <= m_object_size, "Out of memory");
+
+        memcpy(reinterpret_cast<std::byte*>(m_mapped_data) + offset, data_cpu, size);
+    }
 }
@@ -209,11 +209,14 @@ namespace Spartan
         Create();
         AcquireNextImage();
 
-        SP_SUBSCRIBE_TO_EVENT(EventType::WindowResized, SP_EVENT_HANDLER(ResizeToWindowSize));
+        m_event_subscription = SP_SUBSCRIBE_TO_EVENT(EventType::WindowResized, SP_EVENT_HANDLER(ResizeToWindowSize));
     }
 
     RHI_SwapChain::~RHI_SwapChain()
     {
+        // the handler captures this swapchain
+        Event::Unsubscribe(m_event_subscription);
+
         Destroy();
     }
 
@@ -19,17 +19,209 @@ IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
 CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 */
 
-//= INCLUDES =========
+//= INCLUDES ==========================
 #include "pch.h"
 #include "Animation.h"
-//====================
+#include "../Core/ThreadPool.h"
+#include "../Profiling/MemoryTracker.h"
+#include <emmintrin.h>
+//=====================================
 
-//= NAMESPACES =====
+//= NAMESPACES ===============
 using namespace std;
-//==================
+using namespace Spartan::Math;
+//============================
 
 namespace Spartan
 {
+    namespace
+    {
+        const uint32_t stream_count = static_cast<uint32_t>(AnimationStream::Max);
+        const uint32_t simd_width   = 4; // sse, the streams are padded so that every loop runs on whole registers
+
+        uint32_t get_lane_count(const uint32_t joint_count)
+        {
+            return (joint_count + simd_width - 1) & ~(simd_width - 1);
+        }
+
+        template<typename T>
+        uint32_t find_key(const vector<T>& keys, const double time)
+        {
+            // index of the last key which is at or before the given time
+            auto it = upper_bound(keys.begin(), keys.end(), time, [](const double t, const T& key) { return t < key.time; });
+            return it == keys.begin() ? 0 : static_cast<uint32_t>(distance(keys.begin(), it) - 1);
+        }
+
+        Vector3 sample_keys(const vector<KeyVector>& keys, const double time, const Vector3& fallback)
+        {
+            if (keys.empty())
+                return fallback;
+
+            const uint32_t i0 = find_key(keys, time);
+            const uint32_t i1 = min(i0 + 1, static_cast<uint32_t>(keys.size() - 1));
+            if (i0 == i1)
+                return keys[i0].value;
+
+            const double span = keys[i1].time - keys[i0].time;
+            const float t     = span > 0.0 ? static_cast<float>(Helper::Clamp((time - keys[i0].time) / span, 0.0, 1.0)) : 0.0f;
+            return keys[i0].value + (keys[i1].value - keys[i0].value) * t;
+        }
+
+        Quaternion sample_keys(const vector<KeyQuaternion>& keys, const double time, const Quaternion& fallback)
+        {
+            if (keys.empty())
+                return fallback;
+
+            const uint32_t i0 = find_key(keys, time);
+            const uint32_t i1 = min(i0 + 1, static_cast<uint32_t>(keys.size() - 1));
+            if (i0 == i1)
+                return keys[i0].value;
+
+            const double span = keys[i1].time - keys[i0].time;
+            const float t     = span > 0.0 ? static_cast<float>(Helper::Clamp((time - keys[i0].time) / span, 0.0, 1.0)) : 0.0f;
+            return Quaternion::Lerp(keys[i0].value, keys[i1].value, t);
+        }
+
+        void normalize_rotations(AnimationPose& pose)
+        {
+            float* x = pose.GetStream(AnimationStream::RotationX);
+            float* y = pose.GetStream(AnimationStream::RotationY);
+            float* z = pose.GetStream(AnimationStream::RotationZ);
+            float* w = pose.GetStream(AnimationStream::RotationW);
+
+            const __m128 zero = _mm_setzero_ps();
+            const __m128 one  = _mm_set1_ps(1.0f);
+            for (uint32_t i = 0; i < pose.lane_count; i += simd_width)
+            {
+                __m128 qx = _mm_loadu_ps(x + i);
+                __m128 qy = _mm_loadu_ps(y + i);
+                __m128 qz = _mm_loadu_ps(z + i);
+                __m128 qw = _mm_loadu_ps(w + i);
+
+                __m128 length_squared = _mm_add_ps(_mm_add_ps(_mm_mul_ps(qx, qx), _mm_mul_ps(qy, qy)), _mm_add_ps(_mm_mul_ps(qz, qz), _mm_mul_ps(qw, qw)));
+                __m128 is_valid       = _mm_cmpgt_ps(length_squared, zero);
+                __m128 length_inv     = _mm_and_ps(_mm_div_ps(one, _mm_sqrt_ps(length_squared)), is_valid);
+
+                _mm_storeu_ps(x + i, _mm_mul_ps(qx, length_inv));
+                _mm_storeu_ps(y + i, _mm_mul_ps(qy, length_inv));
+                _mm_storeu_ps(z + i, _mm_mul_ps(qz, length_inv));
+                _mm_storeu_ps(w + i, _mm_mul_ps(qw, length_inv));
+            }
+        }
+    }
+
+    void AnimationPose::Resize(const uint32_t joint_count)
+    {
+        if (this->joint_count == joint_count && !data.empty())
+            return;
+
+        this->joint_count = joint_count;
+        lane_count        = get_lane_count(joint_count);
+        data.assign(stream_count * lane_count, 0.0f);
+
+        // identity transforms
+        fill_n(GetStream(AnimationStream::RotationW), lane_count, 1.0f);
+        fill_n(GetStream(AnimationStream::ScaleX),    lane_count, 1.0f);
+        fill_n(GetStream(AnimationStream::ScaleY),    lane_count, 1.0f);
+        fill_n(GetStream(AnimationStream::ScaleZ),    lane_count, 1.0f);
+    }
+
+    Matrix AnimationPose::GetLocalMatrix(const uint32_t joint_index) const
+    {
+        const uint32_t i = joint_index;
+
+        return Matrix
+        (
+            Vector3(GetStream(AnimationStream::TranslationX)[i], GetStream(AnimationStream::TranslationY)[i], GetStream(AnimationStream::TranslationZ)[i]),
+            Quaternion(GetStream(AnimationStream::RotationX)[i], GetStream(AnimationStream::RotationY)[i], GetStream(AnimationStream::RotationZ)[i], GetStream(AnimationStream::RotationW)[i]),
+            Vector3(GetStream(AnimationStream::ScaleX)[i], GetStream(AnimationStream::ScaleY)[i], GetStream(AnimationStream::ScaleZ)[i])
+        );
+    }
+
+    void AnimationPose::Blend(const AnimationPose& a, const AnimationPose& b, const float weight, AnimationPose& out)
+    {
+        SP_ASSERT(a.lane_count == b.lane_count);
+        out.Resize(a.joint_count);
+
+        const uint32_t lanes = a.lane_count;
+
+        // translation and scale, a plain lerp
+        for (AnimationStream stream : { AnimationStream::TranslationX, AnimationStream::TranslationY, AnimationStream::TranslationZ, AnimationStream::ScaleX, AnimationStream::ScaleY, AnimationStream::ScaleZ })
+        {
+            const float* va = a.GetStream(stream);
+            const float* vb = b.GetStream(stream);
+            float* vo       = out.GetStream(stream);
+
+            for (uint32_t i = 0; i < lanes; i++)
+            {
+                vo[i] = va[i] + (vb[i] - va[i]) * weight;
+            }
+        }
+
+        // rotation, a normalized lerp along the shortest path
+        {
+            const float* ax = a.GetStream(AnimationStream::RotationX);
+            const float* ay = a.GetStream(AnimationStream::RotationY);
+            const float* az = a.GetStream(AnimationStream::RotationZ);
+            const float* aw = a.GetStream(AnimationStream::RotationW);
+            const float* bx = b.GetStream(AnimationStream::RotationX);
+            const float* by = b.GetStream(AnimationStream::RotationY);
+            const float* bz = b.GetStream(AnimationStream::RotationZ);
+            const float* bw = b.GetStream(AnimationStream::RotationW);
+            float* ox       = out.GetStream(AnimationStream::RotationX);
+            float* oy       = out.GetStream(AnimationStream::RotationY);
+            float* oz       = out.GetStream(AnimationStream::RotationZ);
+            float* ow       = out.GetStream(AnimationStream::RotationW);
+
+            for (uint32_t i = 0; i < lanes; i++)
+            {
+                const float dot = ax[i] * bx[i] + ay[i] * by[i] + az[i] * bz[i] + aw[i] * bw[i];
+                const float wb  = dot < 0.0f ? -weight : weight;
+                const float wa  = 1.0f - weight;
+
+                ox[i] = ax[i] * wa + bx[i] * wb;
+                oy[i] = ay[i] * wa + by[i] * wb;
+                oz[i] = az[i] * wa + bz[i] * wb;
+                ow[i] = aw[i] * wa + bw[i] * wb;
+            }
+        }
+
+        normalize_rotations(out);
+    }
+
+    int32_t AnimationSkeleton::GetJointIndex(const string& name) const
+    {
+        for (uint32_t i = 0; i < static_cast<uint32_t>(joint_names.size()); i++)
+        {
+            if (joint_names[i] == name)
+                return static_cast<int32_t>(i);
+        }
+
+        return -1;
+    }
+
+    void AnimationSkeleton::ComputePalette(const AnimationPose& pose, vector<Matrix>& palette) const
+    {
+        const uint32_t joint_count = GetJointCount();
+        SP_ASSERT(pose.joint_count == joint_count);
+
+        // model space transforms, kept per thread to avoid allocating every frame
+        static thread_local vector<Matrix> model;
+        {
+            SP_MEMORY_TAG(MemoryTag::Persistent);
+            model.resize(joint_count);
+        }
+        palette.resize(joint_count);
+
+        for (uint32_t i = 0; i < joint_count; i++)
+        {
+            const Matrix local = pose.GetLocalMatrix(i);
+            const int32_t parent = joint_parents[i];
+            model[i]   = parent < 0 ? local : local * model[parent];
+            palette[i] = joint_offsets[i] * model[i];
+        }
+    }
+
     Animation::Animation(): IResource(ResourceType::Animation)
     {
 
@@ -44,4 +236,258 @@ namespace Spartan
     {
         return true;
     }
+
+    void Animation::Compress(const shared_ptr<AnimationSkeleton>& skeleton, const float frame_rate)
+    {
+        SP_ASSERT(skeleton != nullptr);
+        SP_ASSERT(frame_rate > 0.0f);
+
+        const uint32_t joint_count = skeleton->GetJointCount();
+        const uint32_t lanes       = get_lane_count(joint_count);
+        const float duration       = GetDurationSeconds();
+        const uint32_t frame_count = max(2u, static_cast<uint32_t>(ceilf(duration * frame_rate)) + 1);
+
+        // map joints to channels
+        vector<const AnimationNode*> joint_channels(joint_count, nullptr);
+        for (const AnimationNode& channel : m_channels)
+        {
+            int32_t joint_index = skeleton->GetJointIndex(channel.name);
+            if (joint_index != -1)
+            {
+                joint_channels[joint_index] = &channel;
+            }
+        }
+
+        // resample into a [frame][stream][lane] float buffer
+        vector<float> values(static_cast<size_t>(frame_count) * stream_count * lanes, 0.0f);
+        auto value = [&values, lanes](uint32_t frame, AnimationStream stream, uint32_t lane) -> float&
+        {
+            return values[(static_cast<size_t>(frame) * stream_count + static_cast<uint32_t>(stream)) * lanes + lane];
+        };
+
+        for (uint32_t joint = 0; joint < lanes; joint++)
+        {
+            // joints without a channel hold their bind pose, padding lanes hold identity
+            Vector3 bind_translation = Vector3::Zero;
+            Quaternion bind_rotation = Quaternion::Identity;
+            Vector3 bind_scale       = Vector3::One;
+            if (joint < joint_count)
+            {
+                skeleton->joint_bind_local[joint].Decompose(bind_scale, bind_rotation, bind_translation);
+            }
+
+            const AnimationNode* channel = joint < joint_count ? joint_channels[joint] : nullptr;
+            Quaternion rotation_previous = bind_rotation;
+            for (uint32_t frame = 0; frame < frame_count; frame++)
+            {
+                const double time = min(static_cast<double>(frame) / frame_rate, static_cast<double>(duration)) * m_ticksPerSec;
+
+                Vector3 translation = bind_translation;
+                Quaternion rotation = bind_rotation;
+                Vector3 scale       = bind_scale;
+                if (channel)
+                {
+                    translation = sample_keys(channel->positionFrames, time, bind_translation);
+                    rotation    = sample_keys(channel->rotationFrames, time, bind_rotation);
+                    scale       = sample_keys(channel->scaleFrames,    time, bind_scale);
+                }
+
+                // keep consecutive rotations in the same hemisphere so that a component-wise lerp takes the shortest path
+                if (frame > 0 && rotation.Dot(rotation_previous) < 0.0f)
+                {
+                    rotation = Quaternion(-rotation.x, -rotation.y, -rotation.z, -rotation.w);
+                }
+                rotation_previous = rotation;
+
+                value(frame, AnimationStream::TranslationX, joint) = translation.x;
+                value(frame, AnimationStream::TranslationY, joint) = translation.y;
+                value(frame, AnimationStream::TranslationZ, joint) = translation.z;
+                value(frame, AnimationStream::RotationX,    joint) = rotation.x;
+                value(frame, AnimationStream::RotationY,    joint) = rotation.y;
+                value(frame, AnimationStream::RotationZ,    joint) = rotation.z;
+                value(frame, AnimationStream::RotationW,    joint) = rotation.w;
+                value(frame, AnimationStream::ScaleX,       joint) = scale.x;
+                value(frame, AnimationStream::ScaleY,       joint) = scale.y;
+                value(frame, AnimationStream::ScaleZ,       joint) = scale.z;
+            }
+        }
+
+        // quantize every stream and lane against its own range
+        m_range_min.assign(stream_count * lanes, 0.0f);
+        m_range_scale.assign(stream_count * lanes, 0.0f);
+        m_samples.assign(values.size(), 0);
+        for (uint32_t stream = 0; stream < stream_count; stream++)
+        {
+            for (uint32_t lane = 0; lane < lanes; lane++)
+            {
+                float range_min = numeric_limits<float>::max();
+                float range_max = numeric_limits<float>::lowest();
+                for (uint32_t frame = 0; frame < frame_count; frame++)
+                {
+                    const float v = value(frame, static_cast<AnimationStream>(stream), lane);
+                    range_min = min(range_min, v);
+                    range_max = max(range_max, v);
+                }
+
+                const float extent = range_max - range_min;
+                m_range_min[stream * lanes + lane]   = range_min;
+                m_range_scale[stream * lanes + lane] = extent / 65535.0f;
+
+                for (uint32_t frame = 0; frame < frame_count; frame++)
+                {
+                    const size_t index  = (static_cast<size_t>(frame) * stream_count + stream) * lanes + lane;
+                    const float normalized = extent > 0.0f ? (values[index] - range_min) / extent : 0.0f;
+                    m_samples[index]    = static_cast<uint16_t>(Helper::Clamp(normalized, 0.0f, 1.0f) * 65535.0f + 0.5f);
+                }
+            }
+        }
+
+        m_skeleton    = skeleton;
+        m_frame_count = frame_count;
+        m_lane_count  = lanes;
+        m_frame_rate  = frame_rate;
+
+        // the source keyframes are no longer needed
+        m_channels.clear();
+        m_channels.shrink_to_fit();
+    }
+
+    void Animation::Sample(float time, AnimationPose& pose) const
+    {
+        SP_ASSERT_MSG(IsCompressed(), "The animation has to be compressed before it can be sampled");
+
+        pose.Resize(m_skeleton->GetJointCount());
+
+        // loop over the clip's own duration, the frame count is rounded up so the last frame can be closer than a frame interval
+        const float duration = GetDurationSeconds();
+        time = duration > 0.0f ? fmodf(time, duration) : 0.0f;
+        if (time < 0.0f)
+        {
+            time += duration;
+        }
+
+        const uint32_t f0    = min(static_cast<uint32_t>(time * m_frame_rate), m_frame_count - 1);
+        const uint32_t f1    = min(f0 + 1, m_frame_count - 1);
+        const float time_0   = static_cast<float>(f0) / m_frame_rate;
+        const float time_1   = min(static_cast<float>(f1) / m_frame_rate, duration);
+        const float fraction = time_1 > time_0 ? Helper::Clamp((time - time_0) / (time_1 - time_0), 0.0f, 1.0f) : 0.0f;
+        const uint32_t lanes = m_lane_count;
+        const __m128i zero   = _mm_setzero_si128();
+        const __m128 t       = _mm_set1_ps(fraction);
+
+        for (uint32_t stream = 0; stream < stream_count; stream++)
+        {
+            const uint16_t* q0          = &m_samples[(static_cast<size_t>(f0) * stream_count + stream) * lanes];
+            const uint16_t* q1          = &m_samples[(static_cast<size_t>(f1) * stream_count + stream) * lanes];
+            const float* range_min      = &m_range_min[stream * lanes];
+            const float* range_scale    = &m_range_scale[stream * lanes];
+            float* out                  = pose.GetStream(static_cast<AnimationStream>(stream));
+
+            // four joints at a time, the 16 bit samples are widened to 32 bit integers and then converted to floats
+            for (uint32_t i = 0; i < lanes; i += simd_width)
+            {
+                const __m128 sample_0 = _mm_cvtepi32_ps(_mm_unpacklo_epi16(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(q0 + i)), zero));
+                const __m128 sample_1 = _mm_cvtepi32_ps(_mm_unpacklo_epi16(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(q1 + i)), zero));
+                const __m128 minimum  = _mm_loadu_ps(range_min + i);
+                const __m128 scale    = _mm_loadu_ps(range_scale + i);
+                const __m128 v0       = _mm_add_ps(minimum, _mm_mul_ps(sample_0, scale));
+                const __m128 v1       = _mm_add_ps(minimum, _mm_mul_ps(sample_1, scale));
+                _mm_storeu_ps(out + i, _mm_add_ps(v0, _mm_mul_ps(_mm_sub_ps(v1, v0), t)));
+            }
+        }
+
+        normalize_rotations(pose);
+    }
+
+    void Animation::Evaluate(vector<AnimationJob>& jobs)
+    {
+        auto evaluate = [&jobs](uint32_t start, uint32_t end)
+        {
+            static thread_local AnimationPose pose_b;
+
+            for (uint32_t i = start; i < end; i++)
+            {
+                AnimationJob& job = jobs[i];
+                if (!job.clip_a || !job.pose)
+                    continue;
+
+                job.clip_a->Sample(job.time_a, *job.pose);
+
+                if (job.clip_b && job.blend_weight > 0.0f)
+                {
+                    job.clip_b->Sample(job.time_b, pose_b);
+                    AnimationPose::Blend(*job.pose, pose_b, job.blend_weight, *job.pose);
+                }
+
+                if (job.palette)
+                {
+                    job.clip_a->GetSkeleton()->ComputePalette(*job.pose, *job.palette);
+                }
+            }
+        };
+
+        const uint32_t job_count = static_cast<uint32_t>(jobs.size());
+        if (job_count > 1)
+        {
+            ThreadPool::ParallelLoop(evaluate, job_count);
+        }
+        else
+        {
+            evaluate(0, job_count);
+        }
+    }
+
+    void Animation::Skin(
+        const vector<Matrix>& palette,
+        const RHI_Vertex_PosTexNorTan* vertices_in,
+        const AnimationVertexInfluence* influences,
+        const uint32_t vertex_count,
+        RHI_Vertex_PosTexNorTan* vertices_out
+    )
+    {
+        for (uint32_t v = 0; v < vertex_count; v++)
+        {
+            const RHI_Vertex_PosTexNorTan& in        = vertices_in[v];
+            const AnimationVertexInfluence& influence = influences[v];
+            RHI_Vertex_PosTexNorTan& out             = vertices_out[v];
+
+            // blend the affine part of the influencing matrices
+            float m[12] = {};
+            for (uint32_t k = 0; k < 4; k++)
+            {
+                const float w = influence.weights[k];
+                if (w == 0.0f)
+                    continue;
+
+                const Matrix& j = palette[influence.joints[k]];
+                m[0] += j.m00 * w; m[1]  += j.m01 * w; m[2]  += j.m02 * w;
+                m[3] += j.m10 * w; m[4]  += j.m11 * w; m[5]  += j.m12 * w;
+                m[6] += j.m20 * w; m[7]  += j.m21 * w; m[8]  += j.m22 * w;
+                m[9] += j.m30 * w; m[10] += j.m31 * w; m[11] += j.m32 * w;
+            }
+
+            auto transform = [&m](const float* in, float* out, const float w)
+            {
+                const float x = in[0] * m[0] + in[1] * m[3] + in[2] * m[6] + w * m[9];
+                const float y = in[0] * m[1] + in[1] * m[4] + in[2] * m[7] + w * m[10];
+                const float z = in[0] * m[2] + in[1] * m[5] + in[2] * m[8] + w * m[11];
+                out[0] = x; out[1] = y; out[2] = z;
+            };
+
+            auto normalize = [](float* v)
+            {
+                const float length_squared = v[0] * v[0] + v[1] * v[1] + v[2] * v[2];
+                const float length_inv     = length_squared > 0.0f ? 1.0f / sqrtf(length_squared) : 0.0f;
+                v[0] *= length_inv; v[1] *= length_inv; v[2] *= length_inv;
+            };
+
+            transform(in.pos, out.pos, 1.0f);
+            transform(in.nor, out.nor, 0.0f);
+            transform(in.tan, out.tan, 0.0f);
+            normalize(out.nor);
+            normalize(out.tan);
+            out.tex[0] = in.tex[0];
+            out.tex[1] = in.tex[1];
+        }
+    }
 }
@@ -24,6 +24,7 @@ CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 //= INCLUDES =====================
 #include "../Resource/IResource.h"
 #include "../Math/Matrix.h"
+#include "../RHI/RHI_Vertex.h"
 //================================
 
 namespace Spartan
@@ -61,6 +62,74 @@ namespace Spartan
         std::vector<KeyVector> scaleFrames;
     };
 
+    // a pose is made of ten scalar streams (translation xyz, rotation xyzw, scale xyz)
+    enum class AnimationStream : uint32_t
+    {
+        TranslationX,
+        TranslationY,
+        TranslationZ,
+        RotationX,
+        RotationY,
+        RotationZ,
+        RotationW,
+        ScaleX,
+        ScaleY,
+        ScaleZ,
+        Max
+    };
+
+    // local space pose, stored as structure of arrays so that sampling and blending process many joints per instruction
+    struct AnimationPose
+    {
+        void Resize(uint32_t joint_count);
+        float* GetStream(AnimationStream stream)             { return &data[static_cast<uint32_t>(stream) * lane_count]; }
+        const float* GetStream(AnimationStream stream) const { return &data[static_cast<uint32_t>(stream) * lane_count]; }
+        Math::Matrix GetLocalMatrix(uint32_t joint_index) const;
+
+        // blends two poses of the same skeleton, weight 0 returns a and weight 1 returns b
+        static void Blend(const AnimationPose& a, const AnimationPose& b, float weight, AnimationPose& out);
+
+        uint32_t joint_count = 0;
+        uint32_t lane_count  = 0; // joint count rounded up to a multiple of the simd width
+        std::vector<float> data;
+    };
+
+    // joints are sorted parents first, so model space transforms can be resolved in a single forward pass
+    struct AnimationSkeleton
+    {
+        uint32_t GetJointCount() const { return static_cast<uint32_t>(joint_names.size()); }
+        int32_t GetJointIndex(const std::string& name) const;
+
+        // converts a local pose into skinning matrices (offset * model space), ready to be uploaded to the gpu as is
+        void ComputePalette(const AnimationPose& pose, std::vector<Math::Matrix>& palette) const;
+
+        std::vector<std::string> joint_names;
+        std::vector<int32_t> joint_parents;        // -1 for root joints
+        std::vector<Math::Matrix> joint_offsets;   // mesh space to joint space (inverse bind)
+        std::vector<Math::Matrix> joint_bind_local; // local bind transform, used for joints that have no animation channel
+    };
+
+    // per vertex skinning influences, up to four joints
+    struct AnimationVertexInfluence
+    {
+        uint16_t joints[4]  = { 0, 0, 0, 0 };
+        float weights[4]    = { 0.0f, 0.0f, 0.0f, 0.0f };
+    };
+
+    class Animation;
+
+    // one animated character for a given frame, clip_b is optional and is blended over clip_a by blend_weight
+    struct AnimationJob
+    {
+        const Animation* clip_a          = nullptr;
+        const Animation* clip_b          = nullptr;
+        float time_a                     = 0.0f;
+        float time_b                     = 0.0f;
+        float blend_weight               = 0.0f;
+        AnimationPose* pose              = nullptr;
+        std::vector<Math::Matrix>* palette = nullptr; // optional
+    };
+
     class SP_CLASS Animation : public IResource
     {
     public:
@@ -75,6 +144,32 @@ namespace Spartan
         void SetObjectName(const std::string& name)   { m_object_name = name; }
         void SetDuration(double duration)       { m_duration = duration; }
         void SetTicksPerSec(double ticksPerSec) { m_ticksPerSec = ticksPerSec; }
+        float GetDurationSeconds() const        { return m_ticksPerSec != 0.0 ? static_cast<float>(m_duration / m_ticksPerSec) : 0.0f; }
+
+        // channels
+        void AddChannel(AnimationNode&& channel) { m_channels.emplace_back(std::move(channel)); }
+        const std::vector<AnimationNode>& GetChannels() const { return m_channels; }
+
+        // resamples the channels at a fixed rate and quantizes them to 16 bits per component, laid out per frame as
+        // structure of arrays in skeleton joint order, the source keyframes are released afterwards
+        void Compress(const std::shared_ptr<AnimationSkeleton>& skeleton, float frame_rate = 30.0f);
+        bool IsCompressed() const { return m_frame_count != 0; }
+        const std::shared_ptr<AnimationSkeleton>& GetSkeleton() const { return m_skeleton; }
+
+        // samples the compressed clip at a given time (in seconds, looping) into a local pose
+        void Sample(float time, AnimationPose& pose) const;
+
+        // samples, blends and computes palettes for many characters in parallel
+        static void Evaluate(std::vector<AnimationJob>& jobs);
+
+        // transforms vertices on the cpu using a palette produced by AnimationSkeleton::ComputePalette()
+        static void Skin(
+            const std::vector<Math::Matrix>& palette,
+            const RHI_Vertex_PosTexNorTan* vertices_in,
+            const AnimationVertexInfluence* influences,
+            uint32_t vertex_count,
+            RHI_Vertex_PosTexNorTan* vertices_out
+        );
 
     private:
         std::string m_object_name;
@@ -83,5 +178,14 @@ namespace Spartan
 
         // Each channel controls a single node
         std::vector<AnimationNode> m_channels;
+
+        // compressed representation
+        std::shared_ptr<AnimationSkeleton> m_skeleton;
+        uint32_t m_frame_count = 0;
+        uint32_t m_lane_count  = 0;
+        float m_frame_rate     = 0.0f;
+        std::vector<float> m_range_min;     // per stream and lane
+        std::vector<float> m_range_scale;   // per stream and lane, extent / 65535
+        std::vector<uint16_t> m_samples;    // [frame][stream][lane]
     };
 }
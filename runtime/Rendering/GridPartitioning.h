@@ -22,7 +22,8 @@ CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 #pragma once
 
 //= INCLUDES ===============
-#include <unordered_map>
+#include <algorithm>
+#include <vector>
 #include "../Math/Vector3.h"
 #include "../Math/Matrix.h"
 //==========================
@@ -64,36 +65,46 @@ namespace grid_partitioning
 
         static GridKey get_key(const Spartan::Math::Vector3& position)
         {
+            // cast through a signed integer, negative cells simply wrap around
             return
             {
-                static_cast<uint32_t>(std::floor(position.x / static_cast<float>(physical_cell_size))),
-                static_cast<uint32_t>(std::floor(position.y / static_cast<float>(physical_cell_size))),
-                static_cast<uint32_t>(std::floor(position.z / static_cast<float>(physical_cell_size)))
+                static_cast<uint32_t>(static_cast<int32_t>(std::floor(position.x / static_cast<float>(physical_cell_size)))),
+                static_cast<uint32_t>(static_cast<int32_t>(std::floor(position.y / static_cast<float>(physical_cell_size)))),
+                static_cast<uint32_t>(static_cast<int32_t>(std::floor(position.z / static_cast<float>(physical_cell_size))))
             };
         }
+
+        static bool is_less(const GridKey& a, const GridKey& b)
+        {
+            if (a.x != b.x) return a.x < b.x;
+            if (a.y != b.y) return a.y < b.y;
+            return a.z < b.z;
+        }
     };
 
-    void reorder_instances_into_cell_chunks(std::vector<Spartan::Math::Matrix>& instance_transforms, std::vector<uint32_t>& cell_end_indices)
+    // sorts instances by grid cell, deterministically (instances within a cell keep their relative order)
+    inline void sort_instances_by_cell(std::vector<Spartan::Math::Matrix>& instance_transforms)
     {
-        // populate the grid map
-        std::unordered_map<GridKey, std::vector<Spartan::Math::Matrix>, GridKeyHash> grid_map;
-        for (const auto& instance : instance_transforms)
+        std::stable_sort(instance_transforms.begin(), instance_transforms.end(), [](const Spartan::Math::Matrix& a, const Spartan::Math::Matrix& b)
         {
-            Spartan::Math::Vector3 position = instance.GetTranslation();
+            return GridKeyHash::is_less(GridKeyHash::get_key(a.GetTranslation()), GridKeyHash::get_key(b.GetTranslation()));
+        });
+    }
 
-            GridKey key = GridKeyHash::get_key(position);
-            grid_map[key].push_back(instance);
-        }
+    inline void reorder_instances_into_cell_chunks(std::vector<Spartan::Math::Matrix>& instance_transforms, std::vector<uint32_t>& cell_end_indices)
+    {
+        // sort by cell, this is a no-op for instances which were already emitted sorted (e.g. terrain scattering)
+        sort_instances_by_cell(instance_transforms);
 
-        // reorder instances based on grid map
-        instance_transforms.clear();
+        // every change of cell ends a chunk
         cell_end_indices.clear();
-        uint32_t index = 0;
-        for (const auto& [key, transforms] : grid_map)
+        for (uint32_t index = 0; index < static_cast<uint32_t>(instance_transforms.size()); index++)
         {
-            instance_transforms.insert(instance_transforms.end(), transforms.begin(), transforms.end());
-            index += static_cast<uint32_t>(transforms.size());
-            cell_end_indices.push_back(index);
+            const bool is_last = index + 1 == static_cast<uint32_t>(instance_transforms.size());
+            if (is_last || !(GridKeyHash::get_key(instance_transforms[index].GetTranslation()) == GridKeyHash::get_key(instance_transforms[index + 1].GetTranslation())))
+            {
+                cell_end_indices.push_back(index + 1);
+            }
         }
     }
 }
@@ -0,0 +1,252 @@
+/*
+Copyright(c) 2016-2024 Panos Karabelas
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+copies of the Software, and to permit persons to whom the Software is furnished
+to do so, subject to the following conditions :
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE AUTHORS OR
+COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#pragma once
+
+//= INCLUDES ===============
+#include <algorithm>
+#include <cmath>
+#include <vector>
+#include "../Math/Vector3.h"
+#include "../Math/Vector4.h"
+#include "../Math/Matrix.h"
+//==========================
+
+namespace instance_culling
+{
+    // this namespace is the cpu reference of culling.hlsl, it tests per-instance bounds against the
+    // view frustum and a reverse-z depth pyramid (hi-z) and produces indirect draw arguments and a
+    // compacted list of the surviving instances, any change here has to be mirrored in the shader
+
+    // these two reach the shader as defines, see Renderer::CreateShaders()
+    const uint32_t thread_group_size = 64;
+    const uint32_t instance_offset   = 1; // the first instance slot, the vertex shaders treat an instance id of 0 as non-instanced
+
+    // matches VkDrawIndexedIndirectCommand and D3D12_DRAW_INDEXED_ARGUMENTS
+    struct DrawIndexedArguments
+    {
+        uint32_t index_count    = 0;
+        uint32_t instance_count = 0;
+        uint32_t index_offset   = 0;
+        int32_t vertex_offset   = 0;
+        uint32_t instance_start = 0;
+    };
+
+    // world space bounds of an instance, w is padding so that the layout matches the gpu side
+    struct Bounds
+    {
+        Spartan::Math::Vector4 min;
+        Spartan::Math::Vector4 max;
+    };
+
+    // the largest power of two which is less than or equal to the value, the pyramid uses such
+    // dimensions so that every mip is an exact 2x2 reduction of the previous one
+    inline uint32_t get_pyramid_dimension(uint32_t value)
+    {
+        uint32_t dimension = 1;
+        while ((dimension << 1) <= value)
+        {
+            dimension <<= 1;
+        }
+
+        return dimension;
+    }
+
+    inline uint32_t get_pyramid_mip_count(uint32_t width, uint32_t height)
+    {
+        uint32_t mip_count = 1;
+        while (width > 1 && height > 1)
+        {
+            width  /= 2;
+            height /= 2;
+            mip_count++;
+        }
+
+        return mip_count;
+    }
+
+    struct DepthPyramid
+    {
+        std::vector<std::vector<float>> mips;
+        std::vector<uint32_t> widths;
+        std::vector<uint32_t> heights;
+
+        // each texel keeps the farthest (smallest, reverse-z) depth of the texels it covers, which makes the test conservative
+        void build(const float* depth, const uint32_t depth_width, const uint32_t depth_height)
+        {
+            uint32_t width     = get_pyramid_dimension(depth_width);
+            uint32_t height    = get_pyramid_dimension(depth_height);
+            uint32_t mip_count = get_pyramid_mip_count(width, height);
+
+            mips.assign(mip_count, {});
+            widths.assign(mip_count, 0);
+            heights.assign(mip_count, 0);
+
+            // mip 0, reduce the depth buffer to the pyramid dimensions
+            {
+                float scale_x = static_cast<float>(depth_width)  / static_cast<float>(width);
+                float scale_y = static_cast<float>(depth_height) / static_cast<float>(height);
+
+                mips[0].resize(width * height);
+                widths[0]  = width;
+                heights[0] = height;
+                for (uint32_t y = 0; y < height; y++)
+                {
+                    uint32_t y_start = static_cast<uint32_t>(std::floor(y * scale_y));
+                    uint32_t y_end   = std::min(static_cast<uint32_t>(std::ceil((y + 1) * scale_y)), depth_height);
+                    for (uint32_t x = 0; x < width; x++)
+                    {
+                        uint32_t x_start = static_cast<uint32_t>(std::floor(x * scale_x));
+                        uint32_t x_end   = std::min(static_cast<uint32_t>(std::ceil((x + 1) * scale_x)), depth_width);
+
+                        float farthest = 1.0f;
+                        for (uint32_t j = y_start; j < y_end; j++)
+                        {
+                            for (uint32_t i = x_start; i < x_end; i++)
+                            {
+                                farthest = std::min(farthest, depth[j * depth_width + i]);
+                            }
+                        }
+                        mips[0][y * width + x] = farthest;
+                    }
+                }
+            }
+
+            // the rest of the chain, 2x2 reductions
+            for (uint32_t mip = 1; mip < mip_count; mip++)
+            {
+                widths[mip]  = std::max(widths[mip - 1] >> 1, 1u);
+                heights[mip] = std::max(heights[mip - 1] >> 1, 1u);
+                mips[mip].resize(widths[mip] * heights[mip]);
+
+                for (uint32_t y = 0; y < heights[mip]; y++)
+                {
+                    for (uint32_t x = 0; x < widths[mip]; x++)
+                    {
+                        float farthest = std::min(
+                            std::min(load(mip - 1, x * 2, y * 2),     load(mip - 1, x * 2 + 1, y * 2)),
+                            std::min(load(mip - 1, x * 2, y * 2 + 1), load(mip - 1, x * 2 + 1, y * 2 + 1))
+                        );
+                        mips[mip][y * widths[mip] + x] = farthest;
+                    }
+                }
+            }
+        }
+
+        float load(const uint32_t mip, const uint32_t x, const uint32_t y) const
+        {
+            return mips[mip][std::min(y, heights[mip] - 1) * widths[mip] + std::min(x, widths[mip] - 1)];
+        }
+    };
+
+    inline bool is_visible(const Bounds& bounds, const Spartan::Math::Matrix& view_projection, const DepthPyramid* pyramid)
+    {
+        using namespace Spartan::Math;
+
+        // project the corners, an instance is outside if all of them are beyond the same clip plane
+        uint32_t outcode_all = 0x3F;
+        bool behind_camera   = false;
+        Vector3 ndc_min      = Vector3::Infinity;
+        Vector3 ndc_max      = Vector3::InfinityNeg;
+        for (uint32_t i = 0; i < 8; i++)
+        {
+            Vector4 corner = Vector4(
+                (i & 1) ? bounds.max.x : bounds.min.x,
+                (i & 2) ? bounds.max.y : bounds.min.y,
+                (i & 4) ? bounds.max.z : bounds.min.z,
+                1.0f
+            );
+            Vector4 clip = corner * view_projection;
+
+            uint32_t outcode  = 0;
+            outcode          |= clip.x < -clip.w ? 1  : 0;
+            outcode          |= clip.x >  clip.w ? 2  : 0;
+            outcode          |= clip.y < -clip.w ? 4  : 0;
+            outcode          |= clip.y >  clip.w ? 8  : 0;
+            outcode          |= clip.z <  0.0f   ? 16 : 0; // beyond the far plane (reverse-z)
+            outcode          |= clip.z >  clip.w ? 32 : 0; // before the near plane (reverse-z)
+            outcode_all      &= outcode;
+
+            behind_camera = behind_camera || clip.w <= 0.0f;
+            Vector3 ndc   = Vector3(clip.x, clip.y, clip.z) / clip.w;
+            ndc_min       = Vector3(std::min(ndc_min.x, ndc.x), std::min(ndc_min.y, ndc.y), std::min(ndc_min.z, ndc.z));
+            ndc_max       = Vector3(std::max(ndc_max.x, ndc.x), std::max(ndc_max.y, ndc.y), std::max(ndc_max.z, ndc.z));
+        }
+
+        if (outcode_all != 0)
+            return false;
+
+        // the projected rectangle is meaningless if the bounds cross the camera plane
+        if (!pyramid || behind_camera)
+            return true;
+
+        // screen space rectangle
+        float uv_min_x = std::clamp(ndc_min.x *  0.5f + 0.5f, 0.0f, 1.0f);
+        float uv_max_x = std::clamp(ndc_max.x *  0.5f + 0.5f, 0.0f, 1.0f);
+        float uv_min_y = std::clamp(ndc_max.y * -0.5f + 0.5f, 0.0f, 1.0f);
+        float uv_max_y = std::clamp(ndc_min.y * -0.5f + 0.5f, 0.0f, 1.0f);
+
+        // pick the mip where the rectangle spans at most 2x2 texels
+        float width  = (uv_max_x - uv_min_x) * static_cast<float>(pyramid->widths[0]);
+        float height = (uv_max_y - uv_min_y) * static_cast<float>(pyramid->heights[0]);
+        float mip_f  = std::ceil(std::log2(std::max(std::max(width, height), 1.0f)));
+        uint32_t mip = std::min(static_cast<uint32_t>(mip_f), static_cast<uint32_t>(pyramid->mips.size()) - 1);
+
+        uint32_t mip_width  = pyramid->widths[mip];
+        uint32_t mip_height = pyramid->heights[mip];
+        uint32_t x0         = std::min(static_cast<uint32_t>(uv_min_x * mip_width),  mip_width  - 1);
+        uint32_t x1         = std::min(static_cast<uint32_t>(uv_max_x * mip_width),  mip_width  - 1);
+        uint32_t y0         = std::min(static_cast<uint32_t>(uv_min_y * mip_height), mip_height - 1);
+        uint32_t y1         = std::min(static_cast<uint32_t>(uv_max_y * mip_height), mip_height - 1);
+        if (x1 - x0 > 1 || y1 - y0 > 1)
+            return true;
+
+        float depth_farthest = std::min(
+            std::min(pyramid->load(mip, x0, y0), pyramid->load(mip, x1, y0)),
+            std::min(pyramid->load(mip, x0, y1), pyramid->load(mip, x1, y1))
+        );
+
+        // occluded if the nearest point of the bounds is behind everything it covers
+        return ndc_max.z >= depth_farthest;
+    }
+
+    // the gpu appends survivors with an atomic, so its order is not deterministic, the set is identical
+    inline void cull(
+        const std::vector<Bounds>& bounds,
+        const Spartan::Math::Matrix& view_projection,
+        const DepthPyramid* pyramid,
+        DrawIndexedArguments& arguments,
+        std::vector<uint32_t>& instances_visible
+    )
+    {
+        instances_visible.clear();
+        for (uint32_t i = 0; i < static_cast<uint32_t>(bounds.size()); i++)
+        {
+            if (is_visible(bounds[i], view_projection, pyramid))
+            {
+                instances_visible.push_back(i);
+            }
+        }
+
+        arguments.instance_count = static_cast<uint32_t>(instances_visible.size());
+        arguments.instance_start = instance_offset;
+    }
+}
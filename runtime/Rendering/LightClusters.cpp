@@ -0,0 +1,365 @@
+/*
+Copyright(c) 2016-2024 Panos Karabelas
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+copies of the Software, and to permit persons to whom the Software is furnished
+to do so, subject to the following conditions :
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE AUTHORS OR
+COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+//= INCLUDES =================
+#include "pch.h"
+#include "LightClusters.h"
+#include "../Core/ThreadPool.h"
+#include "../Core/FrameArena.h"
+#include <xmmintrin.h>
+//============================
+
+//= NAMESPACES ===============
+using namespace std;
+using namespace Spartan::Math;
+//============================
+
+namespace Spartan
+{
+    namespace
+    {
+        const uint32_t grid_x        = LightClusters::grid_x;
+        const uint32_t grid_y        = LightClusters::grid_y;
+        const uint32_t grid_z        = LightClusters::grid_z;
+        const uint32_t cluster_count = LightClusters::cluster_count;
+
+        // view space bounds of every cluster, they only change with the projection
+        struct ClusterBounds
+        {
+            Vector3 min;
+            Vector3 max;
+            Vector3 center;
+            float radius = 0.0f;
+        };
+        array<ClusterBounds, cluster_count> cluster_bounds;
+        Matrix cluster_bounds_projection = Matrix::Identity;
+        float cluster_bounds_near        = 0.0f;
+        float cluster_bounds_far         = 0.0f;
+
+        // the lights which overlap each depth slice, in structure of arrays form and padded to groups of
+        // four, so that a cluster tests four lights at once, padding lights have a negative squared range
+        struct SliceLights
+        {
+            vector<float> x, y, z, range_squared;
+            vector<float> direction_x, direction_y, direction_z, cos_angle, sin_angle;
+            vector<uint32_t> is_point; // all bits set for point lights, they skip the cone test
+            vector<uint32_t> index;
+
+            void clear()
+            {
+                x.clear(); y.clear(); z.clear(); range_squared.clear();
+                direction_x.clear(); direction_y.clear(); direction_z.clear(); cos_angle.clear(); sin_angle.clear();
+                is_point.clear();
+                index.clear();
+            }
+
+            uint32_t size() const { return static_cast<uint32_t>(index.size()); }
+        };
+        array<SliceLights, grid_z> slice_lights;
+
+        // outputs
+        vector<vector<uint32_t>> cluster_lists(cluster_count);
+        vector<LightClusters::Cluster> clusters(cluster_count);
+        vector<uint32_t> indices;
+        vector<uint8_t> light_visible; // by light index
+
+        // runs a function over [0, work_total) on the thread pool, or inline if there is too little work to split
+        void parallel_for(const uint32_t work_total, function<void(uint32_t start, uint32_t end)>&& function)
+        {
+            if (work_total > 1 && ThreadPool::GetIdleThreadCount() > 0)
+            {
+                ThreadPool::ParallelLoop(move(function), work_total);
+            }
+            else
+            {
+                function(0, work_total);
+            }
+        }
+
+        // exponential slicing, so that clusters keep a similar shape at any distance
+        float get_slice_depth(const uint32_t slice, const float near_plane, const float far_plane)
+        {
+            return near_plane * pow(far_plane / near_plane, static_cast<float>(slice) / static_cast<float>(grid_z));
+        }
+
+        uint32_t get_slice(const float depth, const float near_plane, const float far_plane)
+        {
+            if (depth <= near_plane)
+                return 0;
+
+            float slice = floor(log(depth / near_plane) / log(far_plane / near_plane) * static_cast<float>(grid_z));
+            return min(static_cast<uint32_t>(max(slice, 0.0f)), grid_z - 1);
+        }
+
+        void update_cluster_bounds(const Matrix& projection, const float near_plane, const float far_plane)
+        {
+            if (projection == cluster_bounds_projection && near_plane == cluster_bounds_near && far_plane == cluster_bounds_far)
+                return;
+
+            cluster_bounds_projection = projection;
+            cluster_bounds_near       = near_plane;
+            cluster_bounds_far        = far_plane;
+
+            // view space rays through the tile corners, scaled so that their z is 1
+            Matrix projection_inverted = projection.Inverted();
+            array<Vector3, (grid_x + 1) * (grid_y + 1)> rays;
+            for (uint32_t y = 0; y <= grid_y; y++)
+            {
+                for (uint32_t x = 0; x <= grid_x; x++)
+                {
+                    // tile rows go from the top of the screen down, like the uvs
+                    float ndc_x = static_cast<float>(x) / static_cast<float>(grid_x) *  2.0f - 1.0f;
+                    float ndc_y = static_cast<float>(y) / static_cast<float>(grid_y) * -2.0f + 1.0f;
+                    Vector3 point = Vector3(ndc_x, ndc_y, 0.5f) * projection_inverted;
+                    rays[y * (grid_x + 1) + x] = point / point.z;
+                }
+            }
+
+            for (uint32_t z = 0; z < grid_z; z++)
+            {
+                float depth_near = get_slice_depth(z, near_plane, far_plane);
+                float depth_far  = get_slice_depth(z + 1, near_plane, far_plane);
+
+                for (uint32_t y = 0; y < grid_y; y++)
+                {
+                    for (uint32_t x = 0; x < grid_x; x++)
+                    {
+                        Vector3 bounds_min = Vector3::Infinity;
+                        Vector3 bounds_max = Vector3::InfinityNeg;
+                        for (uint32_t corner = 0; corner < 4; corner++)
+                        {
+                            const Vector3& ray = rays[(y + (corner >> 1)) * (grid_x + 1) + x + (corner & 1)];
+                            for (float depth : { depth_near, depth_far })
+                            {
+                                Vector3 point = ray * depth;
+                                bounds_min    = Vector3(min(bounds_min.x, point.x), min(bounds_min.y, point.y), min(bounds_min.z, point.z));
+                                bounds_max    = Vector3(max(bounds_max.x, point.x), max(bounds_max.y, point.y), max(bounds_max.z, point.z));
+                            }
+                        }
+
+                        ClusterBounds& bounds = cluster_bounds[(z * grid_y + y) * grid_x + x];
+                        bounds.min            = bounds_min;
+                        bounds.max            = bounds_max;
+                        bounds.center         = (bounds_min + bounds_max) * 0.5f;
+                        bounds.radius         = (bounds_max - bounds_min).Length() * 0.5f;
+                    }
+                }
+            }
+        }
+
+        void bin_lights(const Matrix& view, const float near_plane, const float far_plane, const vector<LightClusters::LightVolume>& lights)
+        {
+            for (SliceLights& slice : slice_lights)
+            {
+                slice.clear();
+            }
+
+            // the lists have to come out sorted, the light pass searches them
+            frame_vector<const LightClusters::LightVolume*> lights_sorted(lights.size());
+            for (size_t i = 0; i < lights.size(); i++)
+            {
+                lights_sorted[i] = &lights[i];
+            }
+            sort(lights_sorted.begin(), lights_sorted.end(), [](const LightClusters::LightVolume* a, const LightClusters::LightVolume* b)
+            {
+                return a->index < b->index;
+            });
+
+            for (const LightClusters::LightVolume* light : lights_sorted)
+            {
+                Vector3 position  = light->position * view;
+                Vector4 direction = Vector4(light->direction, 0.0f) * view;
+
+                // whole lights behind the camera or beyond the far plane
+                if (position.z + light->range < near_plane || position.z - light->range > far_plane)
+                    continue;
+
+                bool is_point    = light->angle <= 0.0f;
+                uint32_t slice_0 = get_slice(position.z - light->range, near_plane, far_plane);
+                uint32_t slice_1 = get_slice(position.z + light->range, near_plane, far_plane);
+                for (uint32_t z = slice_0; z <= slice_1; z++)
+                {
+                    SliceLights& slice = slice_lights[z];
+                    slice.x.emplace_back(position.x);
+                    slice.y.emplace_back(position.y);
+                    slice.z.emplace_back(position.z);
+                    slice.range_squared.emplace_back(light->range * light->range);
+                    slice.direction_x.emplace_back(direction.x);
+                    slice.direction_y.emplace_back(direction.y);
+                    slice.direction_z.emplace_back(direction.z);
+                    slice.cos_angle.emplace_back(cos(light->angle));
+                    slice.sin_angle.emplace_back(sin(light->angle));
+                    slice.is_point.emplace_back(is_point ? 0xFFFFFFFF : 0);
+                    slice.index.emplace_back(light->index);
+                }
+            }
+
+            // pad
+            for (SliceLights& slice : slice_lights)
+            {
+                while (slice.size() % 4 != 0)
+                {
+                    slice.x.emplace_back(0.0f);
+                    slice.y.emplace_back(0.0f);
+                    slice.z.emplace_back(0.0f);
+                    slice.range_squared.emplace_back(-1.0f);
+                    slice.direction_x.emplace_back(0.0f);
+                    slice.direction_y.emplace_back(0.0f);
+                    slice.direction_z.emplace_back(0.0f);
+                    slice.cos_angle.emplace_back(1.0f);
+                    slice.sin_angle.emplace_back(0.0f);
+                    slice.is_point.emplace_back(0xFFFFFFFF);
+                    slice.index.emplace_back(0);
+                }
+            }
+        }
+
+        // appends the indices of the lights which can reach the cluster, four at a time
+        void test_cluster(const uint32_t cluster_index)
+        {
+            const ClusterBounds& bounds = cluster_bounds[cluster_index];
+            const SliceLights& slice    = slice_lights[cluster_index / (grid_x * grid_y)];
+            vector<uint32_t>& list      = cluster_lists[cluster_index];
+            list.clear();
+
+            const __m128 zero       = _mm_setzero_ps();
+            const __m128 min_x      = _mm_set1_ps(bounds.min.x);
+            const __m128 min_y      = _mm_set1_ps(bounds.min.y);
+            const __m128 min_z      = _mm_set1_ps(bounds.min.z);
+            const __m128 max_x      = _mm_set1_ps(bounds.max.x);
+            const __m128 max_y      = _mm_set1_ps(bounds.max.y);
+            const __m128 max_z      = _mm_set1_ps(bounds.max.z);
+            const __m128 center_x   = _mm_set1_ps(bounds.center.x);
+            const __m128 center_y   = _mm_set1_ps(bounds.center.y);
+            const __m128 center_z   = _mm_set1_ps(bounds.center.z);
+            const __m128 radius     = _mm_set1_ps(bounds.radius);
+            const __m128 radius_neg = _mm_set1_ps(-bounds.radius);
+
+            for (uint32_t i = 0; i < slice.size(); i += 4)
+            {
+                __m128 x = _mm_loadu_ps(&slice.x[i]);
+                __m128 y = _mm_loadu_ps(&slice.y[i]);
+                __m128 z = _mm_loadu_ps(&slice.z[i]);
+
+                // sphere, the squared distance from the light to the box
+                __m128 dx       = _mm_add_ps(_mm_max_ps(_mm_sub_ps(min_x, x), zero), _mm_max_ps(_mm_sub_ps(x, max_x), zero));
+                __m128 dy       = _mm_add_ps(_mm_max_ps(_mm_sub_ps(min_y, y), zero), _mm_max_ps(_mm_sub_ps(y, max_y), zero));
+                __m128 dz       = _mm_add_ps(_mm_max_ps(_mm_sub_ps(min_z, z), zero), _mm_max_ps(_mm_sub_ps(z, max_z), zero));
+                __m128 distance = _mm_add_ps(_mm_add_ps(_mm_mul_ps(dx, dx), _mm_mul_ps(dy, dy)), _mm_mul_ps(dz, dz));
+                __m128 inside   = _mm_cmple_ps(distance, _mm_loadu_ps(&slice.range_squared[i]));
+                if (_mm_movemask_ps(inside) == 0)
+                    continue;
+
+                // cone, against the bounding sphere of the box
+                __m128 vx            = _mm_sub_ps(center_x, x);
+                __m128 vy            = _mm_sub_ps(center_y, y);
+                __m128 vz            = _mm_sub_ps(center_z, z);
+                __m128 length_sq     = _mm_add_ps(_mm_add_ps(_mm_mul_ps(vx, vx), _mm_mul_ps(vy, vy)), _mm_mul_ps(vz, vz));
+                __m128 along         = _mm_add_ps(_mm_add_ps(
+                    _mm_mul_ps(vx, _mm_loadu_ps(&slice.direction_x[i])),
+                    _mm_mul_ps(vy, _mm_loadu_ps(&slice.direction_y[i]))),
+                    _mm_mul_ps(vz, _mm_loadu_ps(&slice.direction_z[i])));
+                __m128 across        = _mm_sqrt_ps(_mm_max_ps(_mm_sub_ps(length_sq, _mm_mul_ps(along, along)), zero));
+                __m128 distance_cone = _mm_sub_ps(_mm_mul_ps(_mm_loadu_ps(&slice.cos_angle[i]), across), _mm_mul_ps(along, _mm_loadu_ps(&slice.sin_angle[i])));
+                __m128 inside_cone   = _mm_and_ps(_mm_cmple_ps(distance_cone, radius), _mm_cmpge_ps(along, radius_neg));
+                inside_cone          = _mm_or_ps(inside_cone, _mm_loadu_ps(reinterpret_cast<const float*>(&slice.is_point[i])));
+                inside               = _mm_and_ps(inside, inside_cone);
+
+                int mask = _mm_movemask_ps(inside);
+                for (uint32_t lane = 0; lane < 4; lane++)
+                {
+                    if (mask & (1 << lane))
+                    {
+                        list.emplace_back(slice.index[i + lane]);
+                    }
+                }
+            }
+        }
+    }
+
+    void LightClusters::Build(const Matrix& view, const Matrix& projection, const float near_plane, const float far_plane, const vector<LightVolume>& lights)
+    {
+        SP_ASSERT(near_plane > 0.0f && far_plane > near_plane);
+
+        update_cluster_bounds(projection, near_plane, far_plane);
+        bin_lights(view, near_plane, far_plane, lights);
+
+        parallel_for(cluster_count, [](uint32_t start, uint32_t end)
+        {
+            for (uint32_t i = start; i < end; i++)
+            {
+                test_cluster(i);
+            }
+        });
+
+        // compact, in cluster order
+        uint32_t index_max = 0;
+        for (const LightVolume& light : lights)
+        {
+            index_max = max(index_max, light.index + 1);
+        }
+        light_visible.assign(index_max, 0);
+
+        indices.clear();
+        for (uint32_t i = 0; i < cluster_count; i++)
+        {
+            clusters[i].offset = static_cast<uint32_t>(indices.size());
+            clusters[i].count  = static_cast<uint32_t>(cluster_lists[i].size());
+            indices.insert(indices.end(), cluster_lists[i].begin(), cluster_lists[i].end());
+
+            for (uint32_t index : cluster_lists[i])
+            {
+                light_visible[index] = 1;
+            }
+        }
+    }
+
+    void LightClusters::Shutdown()
+    {
+        for (SliceLights& slice : slice_lights)
+        {
+            slice = SliceLights();
+        }
+
+        for (vector<uint32_t>& list : cluster_lists)
+        {
+            vector<uint32_t>().swap(list);
+        }
+
+        vector<uint32_t>().swap(indices);
+        vector<uint8_t>().swap(light_visible);
+    }
+
+    const vector<LightClusters::Cluster>& LightClusters::GetClusters()
+    {
+        return clusters;
+    }
+
+    const vector<uint32_t>& LightClusters::GetIndices()
+    {
+        return indices;
+    }
+
+    bool LightClusters::IsLightVisible(const uint32_t index)
+    {
+        return index < light_visible.size() && light_visible[index] != 0;
+    }
+}
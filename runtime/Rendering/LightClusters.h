@@ -0,0 +1,78 @@
+/*
+Copyright(c) 2016-2024 Panos Karabelas
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+copies of the Software, and to permit persons to whom the Software is furnished
+to do so, subject to the following conditions :
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE AUTHORS OR
+COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#pragma once
+
+//= INCLUDES ===================
+#include "../Core/Definitions.h"
+#include <vector>
+#include "../Math/Matrix.h"
+//==============================
+
+namespace Spartan
+{
+    // the view frustum is split into a grid of clusters, screen tiles which are sliced exponentially in depth,
+    // and every cluster gets a compact list of the lights that can reach it, the light pass uses the lists
+    // to skip pixels (and whole dispatches) that a light doesn't touch, light.hlsl mirrors the grid layout
+    class SP_CLASS LightClusters
+    {
+    public:
+        static const uint32_t grid_x        = 16;
+        static const uint32_t grid_y        = 9;
+        static const uint32_t grid_z        = 24;
+        static const uint32_t cluster_count = grid_x * grid_y * grid_z;
+
+        // matches the uint2 of light.hlsl, a range of the index list
+        struct Cluster
+        {
+            uint32_t offset = 0;
+            uint32_t count  = 0;
+        };
+
+        // point lights are spheres, spot lights are cones with their apex at the position
+        struct LightVolume
+        {
+            Math::Vector3 position;
+            Math::Vector3 direction;
+            float range     = 0.0f;
+            float angle     = 0.0f; // half angle in radians, 0 for point lights
+            uint32_t index  = 0;    // the light's index in the bindless light buffer
+        };
+
+        // the tests run on the thread pool, the lists don't depend on the thread count and are sorted by light index
+        static void Build(
+            const Math::Matrix& view,
+            const Math::Matrix& projection,
+            const float near_plane,
+            const float far_plane,
+            const std::vector<LightVolume>& lights
+        );
+
+        static const std::vector<Cluster>& GetClusters();
+        static const std::vector<uint32_t>& GetIndices();
+
+        // false if no cluster references the light, so it can't affect anything in view
+        static bool IsLightVisible(const uint32_t index);
+
+        // frees the lists, they otherwise keep their capacity from frame to frame
+        static void Shutdown();
+    };
+}
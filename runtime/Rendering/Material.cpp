@@ -26,6 +26,7 @@ CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 #include "../Resource/ResourceCache.h"
 #include "../RHI/RHI_Texture2D.h"
 #include "../RHI/RHI_TextureCube.h"
+#include "../IO/VirtualFileSystem.h"
 #include "../World/World.h"
 SP_WARNINGS_OFF
 #include "../IO/pugixml.hpp"
@@ -103,8 +104,10 @@ namespace Spartan
 
     bool Material::LoadFromFile(const std::string& file_path)
     {
+        // through the virtual file system, so that materials can come from a pack
+        vector<byte> bytes;
         pugi::xml_document doc;
-        if (!doc.load_file(file_path.c_str()))
+        if (!VirtualFileSystem::Read(file_path, bytes) || !doc.load_buffer(bytes.data(), bytes.size()))
         {
             SP_LOG_ERROR("Failed to load XML file");
             return false;
@@ -212,7 +215,7 @@ namespace Spartan
             SetProperty(MaterialProperty::Height, multiplier);
         }
 
-        SP_FIRE_EVENT(EventType::MaterialOnChanged);
+        SP_PUBLISH_EVENT_DATA(EventType::MaterialOnChanged, GetObjectId());
     }
 
     void Material::SetTexture(const MaterialTexture texture_type, shared_ptr<RHI_Texture> texture)
@@ -339,7 +342,7 @@ namespace Spartan
         // also the renderer will check all the materials after loading anyway
         if (!ProgressTracker::GetProgress(ProgressType::World).IsProgressing())
         {
-            SP_FIRE_EVENT(EventType::MaterialOnChanged);
+            SP_PUBLISH_EVENT_DATA(EventType::MaterialOnChanged, GetObjectId());
         }
     }
 
@@ -61,6 +61,9 @@ namespace Spartan
 
         m_vertices.clear();
         m_vertices.shrink_to_fit();
+
+        m_influences.clear();
+        m_influences.shrink_to_fit();
     }
 
     bool Mesh::LoadFromFile(const string& file_path)
@@ -133,6 +136,7 @@ namespace Spartan
         uint32_t size = 0;
         size += uint32_t(m_indices.size()  * sizeof(uint32_t));
         size += uint32_t(m_vertices.size() * sizeof(RHI_Vertex_PosTexNorTan));
+        size += uint32_t(m_influences.size() * sizeof(AnimationVertexInfluence));
 
         return size;
     }
@@ -184,6 +188,19 @@ namespace Spartan
         m_indices.insert(m_indices.end(), indices.begin(), indices.end());
     }
 
+    void Mesh::AddInfluences(const vector<AnimationVertexInfluence>& influences, const uint32_t vertex_offset)
+    {
+        lock_guard lock(m_mutex_vertices);
+
+        // unskinned sub-meshes in between are left with default influences (zero weights)
+        if (m_influences.size() < vertex_offset + influences.size())
+        {
+            m_influences.resize(vertex_offset + influences.size());
+        }
+
+        copy(influences.begin(), influences.end(), m_influences.begin() + vertex_offset);
+    }
+
     uint32_t Mesh::GetVertexCount() const
     {
         return static_cast<uint32_t>(m_vertices.size());
@@ -205,7 +222,8 @@ namespace Spartan
     {
         return
             static_cast<uint32_t>(MeshFlags::ImportRemoveRedundantData) |
-            static_cast<uint32_t>(MeshFlags::ImportNormalizeScale);
+            static_cast<uint32_t>(MeshFlags::ImportNormalizeScale) |
+            static_cast<uint32_t>(MeshFlags::GenerateLods);
             //static_cast<uint32_t>(MeshFlags::OptimizeVertexCache) |
             //static_cast<uint32_t>(MeshFlags::OptimizeOverdraw) |
             //static_cast<uint32_t>(MeshFlags::OptimizeVertexFetch);
@@ -248,13 +266,79 @@ namespace Spartan
         // reorders vertices and changes indices to improve vertex fetch cache performance, reducing the bandwidth needed to fetch vertices
         if (m_flags & static_cast<uint32_t>(MeshFlags::OptimizeVertexFetch))
         {
-            meshopt_optimizeVertexFetch(&m_vertices[0], &indices[0], index_count, &vertices[0], vertex_count, vertex_size);
+            // through a remap table, so that the skinning influences can follow their vertices
+            vector<uint32_t> remap(vertex_count);
+            meshopt_optimizeVertexFetchRemap(&remap[0], &indices[0], index_count, vertex_count);
+            meshopt_remapIndexBuffer(&indices[0], &indices[0], index_count, &remap[0]);
+            meshopt_remapVertexBuffer(&m_vertices[0], &vertices[0], vertex_count, vertex_size, &remap[0]);
+
+            if (!m_influences.empty())
+            {
+                m_influences.resize(vertex_count);
+                vector<AnimationVertexInfluence> influences = m_influences;
+                meshopt_remapVertexBuffer(&m_influences[0], &influences[0], vertex_count, sizeof(AnimationVertexInfluence), &remap[0]);
+            }
         }
 
         // store the updated indices back to m_indices
         m_indices = indices;
     }
 
+    void Mesh::GenerateLods(const vector<uint32_t>& indices, const vector<RHI_Vertex_PosTexNorTan>& vertices, vector<vector<uint32_t>>& lods)
+    {
+        const uint32_t lod_count_max       = 4;      // including the full resolution one
+        const uint32_t lod_index_count_min = 3 * 64; // below this, a lod saves less than it costs to switch to it
+        const float lod_reduction_min      = 0.8f;   // a lod has to have at most this fraction of the previous one's indices
+        const float lod_error_base         = 0.01f;  // relative to the mesh extents, doubles with every lod
+
+        lods.clear();
+
+        // every lod halves the triangles of the previous one, each is simplified from the full resolution
+        // indices (rather than the previous lod) since that keeps the error of distant lods lower
+        size_t index_count_previous = indices.size();
+        for (uint32_t lod = 1; lod < lod_count_max; lod++)
+        {
+            size_t index_count_target = (indices.size() >> lod) / 3 * 3;
+            if (index_count_target < lod_index_count_min)
+                break;
+
+            vector<uint32_t> lod_indices(indices.size());
+            size_t index_count = meshopt_simplify(
+                lod_indices.data(),
+                indices.data(),
+                indices.size(),
+                &vertices[0].pos[0],
+                vertices.size(),
+                sizeof(RHI_Vertex_PosTexNorTan),
+                index_count_target,
+                lod_error_base * static_cast<float>(1 << (lod - 1))
+            );
+
+            // the error limit was reached before the target, further lods would look the same
+            if (index_count == 0 || static_cast<float>(index_count) > static_cast<float>(index_count_previous) * lod_reduction_min)
+                break;
+
+            lod_indices.resize(index_count);
+            meshopt_optimizeVertexCache(lod_indices.data(), lod_indices.data(), index_count, vertices.size());
+            lods.emplace_back(move(lod_indices));
+            index_count_previous = index_count;
+        }
+    }
+
+    vector<MeshLod> Mesh::AppendLods(vector<uint32_t>& indices, const vector<vector<uint32_t>>& lods)
+    {
+        // the lods go right after the full resolution indices so that they share a single index buffer add
+        vector<MeshLod> ranges;
+        ranges.reserve(lods.size());
+        for (const vector<uint32_t>& lod : lods)
+        {
+            ranges.push_back({ static_cast<uint32_t>(indices.size()), static_cast<uint32_t>(lod.size()) });
+            indices.insert(indices.end(), lod.begin(), lod.end());
+        }
+
+        return ranges;
+    }
+
     void Mesh::CreateGpuBuffers()
     {
         SP_ASSERT_MSG(!m_indices.empty(), "There are no indices");
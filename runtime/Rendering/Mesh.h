@@ -24,6 +24,7 @@ CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 //= INCLUDES =====================
 #include <vector>
 #include "Material.h"
+#include "Animation.h"
 #include "../Resource/IResource.h"
 #include "../Math/BoundingBox.h"
 #include "../RHI/RHI_Vertex.h"
@@ -40,6 +41,7 @@ namespace Spartan
         OptimizeVertexCache       = 1 << 4,
         OptimizeVertexFetch       = 1 << 5,
         OptimizeOverdraw          = 1 << 6,
+        GenerateLods              = 1 << 7,
     };
 
     enum class MeshType
@@ -54,6 +56,13 @@ namespace Spartan
         Max
     };
 
+    // a range of the index buffer, the lods of a sub-mesh are such ranges and share its vertices
+    struct MeshLod
+    {
+        uint32_t index_offset = 0;
+        uint32_t index_count  = 0;
+    };
+
     class Mesh : public IResource
     {
     public:
@@ -63,6 +72,7 @@ namespace Spartan
         // iresource
         bool LoadFromFile(const std::string& file_path) override;
         bool SaveToFile(const std::string& file_path) override;
+        uint64_t GetMemoryUsageCpu() const override { return GetMemoryUsage(); }
 
         // geometry
         void Clear();
@@ -79,10 +89,12 @@ namespace Spartan
         // add geometry
         void AddVertices(const std::vector<RHI_Vertex_PosTexNorTan>& vertices, uint32_t* vertex_offset_out = nullptr);
         void AddIndices(const std::vector<uint32_t>& indices, uint32_t* index_offset_out = nullptr);
+        void AddInfluences(const std::vector<AnimationVertexInfluence>& influences, uint32_t vertex_offset);
 
         // get geometry
         std::vector<RHI_Vertex_PosTexNorTan>& GetVertices() { return m_vertices; }
         std::vector<uint32_t>& GetIndices()                 { return m_indices; }
+        const std::vector<AnimationVertexInfluence>& GetInfluences() const { return m_influences; } // parallel to the vertices, empty if nothing is skinned
 
         // get counts
         uint32_t GetVertexCount() const;
@@ -101,6 +113,10 @@ namespace Spartan
         std::weak_ptr<Entity> GetRootEntity() { return m_root_entity; }
         void SetRootEntity(std::shared_ptr<Entity>& entity) { m_root_entity = entity; }
 
+        // animations
+        void AddAnimation(const std::shared_ptr<Animation>& animation) { m_animations.emplace_back(animation); }
+        const std::vector<std::shared_ptr<Animation>>& GetAnimations() const { return m_animations; }
+
         // mesh type
         MeshType GetType() const          { return m_type; }
         void SetType(const MeshType type) { m_type = type; }
@@ -110,6 +126,8 @@ namespace Spartan
         static uint32_t GetDefaultFlags();
         float ComputeNormalizedScale();
         void Optimize();
+        static void GenerateLods(const std::vector<uint32_t>& indices, const std::vector<RHI_Vertex_PosTexNorTan>& vertices, std::vector<std::vector<uint32_t>>& lods);
+        static std::vector<MeshLod> AppendLods(std::vector<uint32_t>& indices, const std::vector<std::vector<uint32_t>>& lods); // ranges are relative to the first index
         void SetMaterial(std::shared_ptr<Material>& material, Entity* entity) const;
         void AddTexture(std::shared_ptr<Material>& material, MaterialTexture texture_type, const std::string& file_path, bool is_gltf);
 
@@ -117,6 +135,7 @@ namespace Spartan
         // geometry
         std::vector<RHI_Vertex_PosTexNorTan> m_vertices;
         std::vector<uint32_t> m_indices;
+        std::vector<AnimationVertexInfluence> m_influences;
 
         // gpu buffers
         std::shared_ptr<RHI_VertexBuffer> m_vertex_buffer;
@@ -125,6 +144,9 @@ namespace Spartan
         // aabb
         Math::BoundingBox m_aabb;
 
+        // animations
+        std::vector<std::shared_ptr<Animation>> m_animations;
+
         // sync primitives
         std::mutex m_mutex_indices;
         std::mutex m_mutex_vertices;
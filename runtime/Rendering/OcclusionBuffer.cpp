@@ -0,0 +1,458 @@
+/*
+Copyright(c) 2016-2024 Panos Karabelas
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+copies of the Software, and to permit persons to whom the Software is furnished
+to do so, subject to the following conditions :
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE AUTHORS OR
+COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+//= INCLUDES ==================================
+#include "pch.h"
+#include "OcclusionBuffer.h"
+#include "../Core/ThreadPool.h"
+#include "../World/Entity.h"
+#include "../World/Components/Renderable.h"
+#include "../RHI/RHI_VertexBuffer.h"
+#include "../Profiling/MemoryTracker.h"
+#include <xmmintrin.h>
+//=============================================
+
+//= NAMESPACES ===============
+using namespace std;
+using namespace Spartan::Math;
+//============================
+
+namespace Spartan
+{
+    namespace
+    {
+        const uint32_t width        = OcclusionBuffer::width;
+        const uint32_t height       = OcclusionBuffer::height;
+        const uint32_t tile_size    = OcclusionBuffer::tile_size;
+        const uint32_t tile_count_x = width  / tile_size;
+        const uint32_t tile_count_y = height / tile_size;
+        const float w_min           = 1e-5f; // anything closer to the camera plane can't be projected reliably
+
+        static_assert(width % tile_size == 0 && height % tile_size == 0, "the buffer has to be made of whole tiles");
+        static_assert(tile_size % 4 == 0, "the rasterizer works on rows of 4 pixels");
+
+        // reverse-z, 0 is the far plane and nothing has been rasterized there
+        alignas(16) array<float, width * height> depth;
+        array<float, tile_count_x * tile_count_y> depth_tiles; // the farthest depth of each tile
+        Matrix view_projection;
+        uint32_t triangle_count = 0;
+
+        // a triangle in pixel space, ready for rasterization
+        struct Triangle
+        {
+            // edge functions, a pixel is inside when all three are positive
+            array<float, 3> edge_a;
+            array<float, 3> edge_b;
+            array<float, 3> edge_c;
+
+            // depth plane, depth = a * x + b * y + c
+            float depth_a = 0.0f;
+            float depth_b = 0.0f;
+            float depth_c = 0.0f;
+
+            // pixel bounds, inclusive
+            int32_t x_min = 0;
+            int32_t x_max = 0;
+            int32_t y_min = 0;
+            int32_t y_max = 0;
+        };
+        vector<vector<Triangle>> triangles; // per occluder
+        vector<OcclusionBuffer::Occluder> renderable_occluders;
+
+        // runs a function over [0, work_total) on the thread pool, or inline if there is too little work to split
+        void parallel_for(const uint32_t work_total, function<void(uint32_t start, uint32_t end)>&& function)
+        {
+            if (work_total > 1 && ThreadPool::GetIdleThreadCount() > 0)
+            {
+                ThreadPool::ParallelLoop(move(function), work_total);
+            }
+            else
+            {
+                function(0, work_total);
+            }
+        }
+
+        namespace occluder_cache
+        {
+            struct Geometry
+            {
+                vector<Vector3> positions;
+                vector<uint32_t> indices;
+            };
+
+            unordered_map<uint64_t, Geometry> geometries;
+            mutex mutex_geometries;
+
+            const Geometry& get(Renderable* renderable)
+            {
+                // a renderable is a range of a mesh, so the vertex buffer and the index offset identify it
+                uint64_t key = rhi_hash_combine(renderable->GetVertexBuffer()->GetObjectId(), renderable->GetIndexOffset());
+
+                auto it = geometries.find(key);
+                if (it != geometries.end())
+                    return it->second;
+
+                Geometry& geometry = geometries[key];
+
+                vector<uint32_t> indices;
+                vector<RHI_Vertex_PosTexNorTan> vertices;
+                renderable->GetGeometry(&indices, &vertices);
+
+                geometry.positions.reserve(vertices.size());
+                for (const RHI_Vertex_PosTexNorTan& vertex : vertices)
+                {
+                    geometry.positions.emplace_back(vertex.pos[0], vertex.pos[1], vertex.pos[2]);
+                }
+
+                // the geometry is used as is, simplification can move the silhouette outwards and hide what is right behind it
+                geometry.indices = move(indices);
+
+                return geometry;
+            }
+        }
+
+        void setup_triangles(const vector<Vector3>& positions, const vector<uint32_t>& indices, const Matrix& transform, vector<Triangle>& output)
+        {
+            output.clear();
+
+            // transform the vertices once, triangles share most of them, kept per thread to avoid allocating every frame
+            static thread_local vector<Vector4> clip;
+            {
+                SP_MEMORY_TAG(MemoryTag::Persistent);
+                clip.resize(positions.size());
+            }
+            for (uint32_t i = 0; i < static_cast<uint32_t>(positions.size()); i++)
+            {
+                clip[i] = Vector4(positions[i], 1.0f) * transform;
+            }
+
+            for (uint32_t i = 0; i + 2 < static_cast<uint32_t>(indices.size()); i += 3)
+            {
+                const Vector4& c0 = clip[indices[i + 0]];
+                const Vector4& c1 = clip[indices[i + 1]];
+                const Vector4& c2 = clip[indices[i + 2]];
+
+                // triangles crossing the camera or the near plane are dropped instead of clipped, the gpu wouldn't
+                // rasterize those parts and dropping an occluder triangle can only make the result more conservative
+                if (c0.w <= w_min || c1.w <= w_min || c2.w <= w_min)
+                    continue;
+
+                if (c0.z > c0.w || c1.z > c1.w || c2.z > c2.w)
+                    continue;
+
+                // trivially outside
+                if ((c0.x < -c0.w && c1.x < -c1.w && c2.x < -c2.w) || (c0.x > c0.w && c1.x > c1.w && c2.x > c2.w) ||
+                    (c0.y < -c0.w && c1.y < -c1.w && c2.y < -c2.w) || (c0.y > c0.w && c1.y > c1.w && c2.y > c2.w) ||
+                    (c0.z < 0.0f  && c1.z < 0.0f  && c2.z < 0.0f))
+                    continue;
+
+                // to pixel space, y goes down
+                array<Vector3, 3> v;
+                const Vector4* c[3] = { &c0, &c1, &c2 };
+                for (uint32_t j = 0; j < 3; j++)
+                {
+                    float w_rcp = 1.0f / c[j]->w;
+                    v[j].x      = (c[j]->x * w_rcp *  0.5f + 0.5f) * static_cast<float>(width);
+                    v[j].y      = (c[j]->y * w_rcp * -0.5f + 0.5f) * static_cast<float>(height);
+                    v[j].z      = clamp(c[j]->z * w_rcp, 0.0f, 1.0f);
+                }
+
+                // occluders are treated as two sided, so just flip the winding
+                float area = (v[1].x - v[0].x) * (v[2].y - v[0].y) - (v[1].y - v[0].y) * (v[2].x - v[0].x);
+                if (area < 0.0f)
+                {
+                    swap(v[1], v[2]);
+                    area = -area;
+                }
+
+                if (area < 1e-4f)
+                    continue;
+
+                Triangle triangle;
+
+                // bounds of the pixels whose centers may be inside, clamped before the conversion since vertices near the camera plane project far away
+                float x_min    = clamp(min({ v[0].x, v[1].x, v[2].x }), -1.0f, static_cast<float>(width));
+                float x_max    = clamp(max({ v[0].x, v[1].x, v[2].x }), -1.0f, static_cast<float>(width));
+                float y_min    = clamp(min({ v[0].y, v[1].y, v[2].y }), -1.0f, static_cast<float>(height));
+                float y_max    = clamp(max({ v[0].y, v[1].y, v[2].y }), -1.0f, static_cast<float>(height));
+                triangle.x_min = max(static_cast<int32_t>(ceil(x_min - 0.5f)), 0);
+                triangle.x_max = min(static_cast<int32_t>(floor(x_max - 0.5f)), static_cast<int32_t>(width) - 1);
+                triangle.y_min = max(static_cast<int32_t>(ceil(y_min - 0.5f)), 0);
+                triangle.y_max = min(static_cast<int32_t>(floor(y_max - 0.5f)), static_cast<int32_t>(height) - 1);
+                if (triangle.x_min > triangle.x_max || triangle.y_min > triangle.y_max)
+                    continue;
+
+                // edge i goes from vertex i to the next one and is positive on the side of the remaining vertex
+                for (uint32_t j = 0; j < 3; j++)
+                {
+                    const Vector3& a = v[j];
+                    const Vector3& b = v[(j + 1) % 3];
+
+                    triangle.edge_a[j] = a.y - b.y;
+                    triangle.edge_b[j] = b.x - a.x;
+                    triangle.edge_c[j] = -(triangle.edge_a[j] * a.x + triangle.edge_b[j] * a.y);
+                }
+
+                // the barycentric weight of a vertex is the edge opposite of it over the area, and depth is linear in screen space
+                float area_rcp    = 1.0f / area;
+                triangle.depth_a  = (triangle.edge_a[1] * v[0].z + triangle.edge_a[2] * v[1].z + triangle.edge_a[0] * v[2].z) * area_rcp;
+                triangle.depth_b  = (triangle.edge_b[1] * v[0].z + triangle.edge_b[2] * v[1].z + triangle.edge_b[0] * v[2].z) * area_rcp;
+                triangle.depth_c  = (triangle.edge_c[1] * v[0].z + triangle.edge_c[2] * v[1].z + triangle.edge_c[0] * v[2].z) * area_rcp;
+
+                // evaluated at pixel centers, so move the plane back to the farthest depth it reaches within a pixel
+                triangle.depth_c -= 0.5f * (fabs(triangle.depth_a) + fabs(triangle.depth_b));
+
+                output.push_back(triangle);
+            }
+        }
+
+        // rasterizes the part of the triangle which falls in a row of tiles, 4 pixels at a time
+        void rasterize_triangle(const Triangle& triangle, const int32_t band_y_min, const int32_t band_y_max)
+        {
+            int32_t y_min = max(triangle.y_min, band_y_min);
+            int32_t y_max = min(triangle.y_max, band_y_max);
+            if (y_min > y_max)
+                return;
+
+            const __m128 lane_offsets = _mm_setr_ps(0.5f, 1.5f, 2.5f, 3.5f);
+            const __m128 zero         = _mm_setzero_ps();
+            const __m128 edge_a0      = _mm_set1_ps(triangle.edge_a[0]);
+            const __m128 edge_a1      = _mm_set1_ps(triangle.edge_a[1]);
+            const __m128 edge_a2      = _mm_set1_ps(triangle.edge_a[2]);
+            const __m128 depth_a      = _mm_set1_ps(triangle.depth_a);
+            const int32_t x_start     = triangle.x_min & ~3; // the width is a multiple of 4, so rows never overrun
+
+            for (int32_t y = y_min; y <= y_max; y++)
+            {
+                float pixel_y = static_cast<float>(y) + 0.5f;
+                __m128 row_0  = _mm_set1_ps(triangle.edge_b[0] * pixel_y + triangle.edge_c[0]);
+                __m128 row_1  = _mm_set1_ps(triangle.edge_b[1] * pixel_y + triangle.edge_c[1]);
+                __m128 row_2  = _mm_set1_ps(triangle.edge_b[2] * pixel_y + triangle.edge_c[2]);
+                __m128 row_z  = _mm_set1_ps(triangle.depth_b * pixel_y + triangle.depth_c);
+                float* row    = &depth[y * width];
+
+                for (int32_t x = x_start; x <= triangle.x_max; x += 4)
+                {
+                    __m128 pixel_x = _mm_add_ps(_mm_set1_ps(static_cast<float>(x)), lane_offsets);
+                    __m128 e0      = _mm_add_ps(_mm_mul_ps(edge_a0, pixel_x), row_0);
+                    __m128 e1      = _mm_add_ps(_mm_mul_ps(edge_a1, pixel_x), row_1);
+                    __m128 e2      = _mm_add_ps(_mm_mul_ps(edge_a2, pixel_x), row_2);
+                    __m128 inside  = _mm_and_ps(_mm_and_ps(_mm_cmpge_ps(e0, zero), _mm_cmpge_ps(e1, zero)), _mm_cmpge_ps(e2, zero));
+                    if (_mm_movemask_ps(inside) == 0)
+                        continue;
+
+                    // keep the nearest depth, max is order independent which is what makes the result deterministic
+                    __m128 z        = _mm_add_ps(_mm_mul_ps(depth_a, pixel_x), row_z);
+                    __m128 existing = _mm_load_ps(row + x);
+                    __m128 nearest  = _mm_max_ps(existing, z);
+                    _mm_store_ps(row + x, _mm_or_ps(_mm_and_ps(inside, nearest), _mm_andnot_ps(inside, existing)));
+                }
+            }
+        }
+
+        void update_tiles(const uint32_t tile_y)
+        {
+            for (uint32_t tile_x = 0; tile_x < tile_count_x; tile_x++)
+            {
+                __m128 farthest = _mm_set1_ps(1.0f);
+                for (uint32_t y = tile_y * tile_size; y < (tile_y + 1) * tile_size; y++)
+                {
+                    const float* row = &depth[y * width + tile_x * tile_size];
+                    for (uint32_t x = 0; x < tile_size; x += 4)
+                    {
+                        farthest = _mm_min_ps(farthest, _mm_load_ps(row + x));
+                    }
+                }
+
+                alignas(16) array<float, 4> lanes;
+                _mm_store_ps(lanes.data(), farthest);
+                depth_tiles[tile_y * tile_count_x + tile_x] = min(min(lanes[0], lanes[1]), min(lanes[2], lanes[3]));
+            }
+        }
+    }
+
+    void OcclusionBuffer::Rasterize(const Matrix& _view_projection, const vector<Renderable*>& renderables)
+    {
+        // fetch the occluder geometry, reading it back the first time a mesh is seen
+        renderable_occluders.clear();
+        {
+            lock_guard lock(occluder_cache::mutex_geometries);
+            for (Renderable* renderable : renderables)
+            {
+                const occluder_cache::Geometry& geometry = occluder_cache::get(renderable);
+                renderable_occluders.push_back({ &geometry.positions, &geometry.indices, renderable->GetEntity()->GetMatrix() });
+            }
+        }
+
+        Rasterize(_view_projection, renderable_occluders);
+    }
+
+    void OcclusionBuffer::Rasterize(const Matrix& _view_projection, const vector<Occluder>& occluders)
+    {
+        view_projection = _view_projection;
+        depth.fill(0.0f);
+        depth_tiles.fill(0.0f);
+        triangle_count  = 0;
+
+        if (occluders.empty())
+            return;
+
+        // set up the triangles of each occluder
+        uint32_t occluder_count = static_cast<uint32_t>(occluders.size());
+        triangles.resize(occluder_count);
+        parallel_for(occluder_count, [&occluders](uint32_t start, uint32_t end)
+        {
+            for (uint32_t i = start; i < end; i++)
+            {
+                setup_triangles(*occluders[i].positions, *occluders[i].indices, occluders[i].transform * view_projection, triangles[i]);
+            }
+        });
+
+        for (uint32_t i = 0; i < occluder_count; i++)
+        {
+            triangle_count += static_cast<uint32_t>(triangles[i].size());
+        }
+
+        // rasterize, each thread owns whole rows of tiles so no two threads ever write the same pixel
+        parallel_for(tile_count_y, [occluder_count](uint32_t start, uint32_t end)
+        {
+            for (uint32_t tile_y = start; tile_y < end; tile_y++)
+            {
+                int32_t band_y_min = static_cast<int32_t>(tile_y * tile_size);
+                int32_t band_y_max = band_y_min + static_cast<int32_t>(tile_size) - 1;
+                for (uint32_t i = 0; i < occluder_count; i++)
+                {
+                    for (const Triangle& triangle : triangles[i])
+                    {
+                        rasterize_triangle(triangle, band_y_min, band_y_max);
+                    }
+                }
+
+                update_tiles(tile_y);
+            }
+        });
+    }
+
+    bool OcclusionBuffer::IsVisible(const BoundingBox& box)
+    {
+        // project the corners
+        uint32_t outcode_all = 0x3F;
+        float x_min          = numeric_limits<float>::max();
+        float x_max          = numeric_limits<float>::lowest();
+        float y_min          = numeric_limits<float>::max();
+        float y_max          = numeric_limits<float>::lowest();
+        float z_nearest      = 0.0f;
+        for (uint32_t i = 0; i < 8; i++)
+        {
+            Vector4 corner = Vector4(
+                (i & 1) ? box.GetMax().x : box.GetMin().x,
+                (i & 2) ? box.GetMax().y : box.GetMin().y,
+                (i & 4) ? box.GetMax().z : box.GetMin().z,
+                1.0f
+            );
+            Vector4 clip = corner * view_projection;
+
+            // the projected rectangle is meaningless if the box crosses the camera plane
+            if (clip.w <= w_min)
+                return true;
+
+            uint32_t outcode  = 0;
+            outcode          |= clip.x < -clip.w ? 1  : 0;
+            outcode          |= clip.x >  clip.w ? 2  : 0;
+            outcode          |= clip.y < -clip.w ? 4  : 0;
+            outcode          |= clip.y >  clip.w ? 8  : 0;
+            outcode          |= clip.z <  0.0f   ? 16 : 0;
+            outcode          |= clip.z >  clip.w ? 32 : 0;
+            outcode_all      &= outcode;
+
+            float w_rcp = 1.0f / clip.w;
+            float x     = (clip.x * w_rcp *  0.5f + 0.5f) * static_cast<float>(width);
+            float y     = (clip.y * w_rcp * -0.5f + 0.5f) * static_cast<float>(height);
+            x_min       = min(x_min, x);
+            x_max       = max(x_max, x);
+            y_min       = min(y_min, y);
+            y_max       = max(y_max, y);
+            z_nearest   = max(z_nearest, clip.z * w_rcp);
+        }
+
+        if (outcode_all != 0)
+            return false;
+
+        // every pixel the rectangle touches, even partially
+        int32_t pixel_x_min = static_cast<int32_t>(floor(clamp(x_min, 0.0f, static_cast<float>(width  - 1))));
+        int32_t pixel_x_max = static_cast<int32_t>(floor(clamp(x_max, 0.0f, static_cast<float>(width  - 1))));
+        int32_t pixel_y_min = static_cast<int32_t>(floor(clamp(y_min, 0.0f, static_cast<float>(height - 1))));
+        int32_t pixel_y_max = static_cast<int32_t>(floor(clamp(y_max, 0.0f, static_cast<float>(height - 1))));
+
+        const int32_t tile = static_cast<int32_t>(tile_size);
+        for (int32_t tile_y = pixel_y_min / tile; tile_y <= pixel_y_max / tile; tile_y++)
+        {
+            for (int32_t tile_x = pixel_x_min / tile; tile_x <= pixel_x_max / tile; tile_x++)
+            {
+                // the whole tile is in front of the box
+                if (depth_tiles[tile_y * tile_count_x + tile_x] > z_nearest)
+                    continue;
+
+                int32_t y_start = max(pixel_y_min, tile_y * tile);
+                int32_t y_end   = min(pixel_y_max, (tile_y + 1) * tile - 1);
+                int32_t x_start = max(pixel_x_min, tile_x * tile);
+                int32_t x_end   = min(pixel_x_max, (tile_x + 1) * tile - 1);
+                for (int32_t y = y_start; y <= y_end; y++)
+                {
+                    for (int32_t x = x_start; x <= x_end; x++)
+                    {
+                        if (depth[y * width + x] <= z_nearest)
+                            return true;
+                    }
+                }
+            }
+        }
+
+        return false;
+    }
+
+    void OcclusionBuffer::ClearCache()
+    {
+        lock_guard lock(occluder_cache::mutex_geometries);
+        occluder_cache::geometries.clear();
+    }
+
+    void OcclusionBuffer::Shutdown()
+    {
+        {
+            lock_guard lock(occluder_cache::mutex_geometries);
+            unordered_map<uint64_t, occluder_cache::Geometry>().swap(occluder_cache::geometries);
+        }
+
+        vector<vector<Triangle>>().swap(triangles);
+        vector<Occluder>().swap(renderable_occluders);
+    }
+
+    uint32_t OcclusionBuffer::GetTriangleCount()
+    {
+        return triangle_count;
+    }
+
+    float OcclusionBuffer::GetDepth(const uint32_t x, const uint32_t y)
+    {
+        return depth[min(y, height - 1) * width + min(x, width - 1)];
+    }
+}
@@ -0,0 +1,69 @@
+/*
+Copyright(c) 2016-2024 Panos Karabelas
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+copies of the Software, and to permit persons to whom the Software is furnished
+to do so, subject to the following conditions :
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE AUTHORS OR
+COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#pragma once
+
+//= INCLUDES ===================
+#include "../Core/Definitions.h"
+#include <vector>
+#include "../Math/Matrix.h"
+#include "../Math/BoundingBox.h"
+//==============================
+
+namespace Spartan
+{
+    class Renderable;
+
+    // a small reverse-z depth buffer which the cpu rasterizes a few large occluders into, bounding boxes
+    // are then tested against it before any draw is recorded, the buffer is split into tiles which also
+    // keep their farthest depth so that most tests never touch individual pixels
+    class SP_CLASS OcclusionBuffer
+    {
+    public:
+        static const uint32_t width                    = 320;
+        static const uint32_t height                   = 192;
+        static const uint32_t tile_size                = 8;
+        static const uint32_t occluder_index_count_max = 3 * 4096; // occluders are rasterized at full detail, so larger meshes are not worth it
+
+        // geometry in object space, the buffer only reads it during rasterization
+        struct Occluder
+        {
+            const std::vector<Math::Vector3>* positions = nullptr;
+            const std::vector<uint32_t>* indices        = nullptr;
+            Math::Matrix transform                      = Math::Matrix::Identity;
+        };
+
+        // rasterizes the occluders on the thread pool, the result doesn't depend on the thread count
+        static void Rasterize(const Math::Matrix& view_projection, const std::vector<Renderable*>& occluders);
+        static void Rasterize(const Math::Matrix& view_projection, const std::vector<Occluder>& occluders);
+
+        // false only if every pixel the box covers is in front of it, coverage is sampled at pixel centers like the gpu does
+        static bool IsVisible(const Math::BoundingBox& box);
+
+        // the occluder geometry is cached per mesh, it has to go when the meshes do
+        static void ClearCache();
+        static void Shutdown(); // also frees the triangles, which otherwise keep their capacity from frame to frame
+
+        // stats of the last rasterization
+        static uint32_t GetTriangleCount();
+        static float GetDepth(const uint32_t x, const uint32_t y);
+    };
+}
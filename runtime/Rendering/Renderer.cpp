@@ -24,6 +24,7 @@ CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 #include "Renderer.h"
 #include "ThreadPool.h"
 #include "ProgressTracker.h"
+#include "OcclusionBuffer.h"
 #include "../Profiling/Profiler.h"
 #include "../Core/Window.h"
 #include "../Input/Input.h"
@@ -31,6 +32,7 @@ CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 #include "../RHI/RHI_Device.h"
 #include "../RHI/RHI_SwapChain.h"
 #include "../RHI/RHI_Queue.h"
+#include "../RHI/RHI_Shader.h"
 #include "../RHI/RHI_ConstantBuffer.h"
 #include "../RHI/RHI_Implementation.h"
 #include "../RHI/RHI_StructuredBuffer.h"
@@ -80,7 +82,14 @@ namespace Spartan
 
         // bindless
         static array<RHI_Texture*, rhi_max_array_size> bindless_textures;
-        bool bindless_materials_dirty = true;
+
+        // what the renderer knows about each registered entity, lets entity changes be applied without walking the world
+        struct EntityRecord
+        {
+            uint32_t buckets     = 0; // mask of Renderer_Entity bits
+            uint64_t material_id = 0; // the bindless material the entity holds a reference to, when in the mesh bucket
+        };
+        unordered_map<uint64_t, EntityRecord> entity_records;
 
         // misc
         unordered_map<Renderer_Option, float> m_options;
@@ -91,6 +100,236 @@ namespace Spartan
         float far_plane                      = 1.0f;
         bool dirty_orthographic_projection   = true;
 
+        // the renderer buckets an entity belongs to, as a mask of Renderer_Entity bits
+        const uint32_t renderer_entity_bucket_count = static_cast<uint32_t>(Renderer_Entity::AudioSource) + 1;
+        uint32_t get_entity_buckets(Entity* entity)
+        {
+            uint32_t buckets = 0;
+
+            if (!entity->IsActive())
+                return buckets;
+
+            if (shared_ptr<Renderable> renderable = entity->GetComponent<Renderable>())
+            {
+                if (Material* material = renderable->GetMaterial())
+                {
+                    if (material->IsVisible())
+                    {
+                        // a mesh can be uninitialized if it's currently loading in a different thread
+                        // but we don't keep anything uninitialized in what the renderer is processing
+                        if (renderable->GetVertexBuffer() && renderable->GetIndexBuffer())
+                        { 
+                            buckets |= 1u << static_cast<uint32_t>(Renderer_Entity::Mesh);
+                        }
+                    }
+                }
+            }
+
+            if (entity->GetComponent<Light>())
+            {
+                buckets |= 1u << static_cast<uint32_t>(Renderer_Entity::Light);
+            }
+
+            if (entity->GetComponent<Camera>())
+            {
+                buckets |= 1u << static_cast<uint32_t>(Renderer_Entity::Camera);
+            }
+
+            if (entity->GetComponent<AudioSource>())
+            {
+                buckets |= 1u << static_cast<uint32_t>(Renderer_Entity::AudioSource);
+            }
+
+            return buckets;
+        }
+
+        // bindless materials, each material owns a block of MaterialTexture::Max slots, its properties live in the first
+        // slot of the block and its textures span the whole block, blocks are reference counted by the renderables that
+        // use them and are recycled through a free list once no renderable does
+        namespace bindless_materials
+        {
+            const uint32_t block_size = static_cast<uint32_t>(MaterialTexture::Max);
+
+            struct Block
+            {
+                Material* material = nullptr; // alive for as long as a renderable uses it, which is what the block counts
+                uint32_t index     = 0;
+                uint32_t ref_count = 0;
+            };
+
+            array<Sb_Material, rhi_max_array_size> properties; // mapped to the gpu as a structured properties buffer
+            unordered_map<uint64_t, Block> blocks;            // material id -> block
+            vector<uint32_t> blocks_free;
+            uint32_t block_end = 0;                           // one past the last slot that was ever handed out
+
+            // slot ranges which changed since they were last uploaded, as [begin, end)
+            uint32_t dirty_properties_begin = numeric_limits<uint32_t>::max();
+            uint32_t dirty_properties_end   = 0;
+            uint32_t dirty_textures_begin   = numeric_limits<uint32_t>::max();
+            uint32_t dirty_textures_end     = 0;
+
+            void mark_dirty(const uint32_t index)
+            {
+                dirty_properties_begin = min(dirty_properties_begin, index);
+                dirty_properties_end   = max(dirty_properties_end,   index + 1);
+                dirty_textures_begin   = min(dirty_textures_begin,   index);
+                dirty_textures_end     = max(dirty_textures_end,     index + block_size);
+            }
+
+            void write(Material* material, const uint32_t index)
+            {
+                // properties
+                {
+                    properties[index] = Sb_Material{};
+
+                    properties[index].world_space_height     = material->GetProperty(MaterialProperty::WorldSpaceHeight);
+                    properties[index].color.x                = material->GetProperty(MaterialProperty::ColorR);
+                    properties[index].color.y                = material->GetProperty(MaterialProperty::ColorG);
+                    properties[index].color.z                = material->GetProperty(MaterialProperty::ColorB);
+                    properties[index].color.w                = material->GetProperty(MaterialProperty::ColorA);
+                    properties[index].tiling_uv.x            = material->GetProperty(MaterialProperty::TextureTilingX);
+                    properties[index].tiling_uv.y            = material->GetProperty(MaterialProperty::TextureTilingY);
+                    properties[index].offset_uv.x            = material->GetProperty(MaterialProperty::TextureOffsetX);
+                    properties[index].offset_uv.y            = material->GetProperty(MaterialProperty::TextureOffsetY);
+                    properties[index].roughness_mul          = material->GetProperty(MaterialProperty::Roughness);
+                    properties[index].metallic_mul           = material->GetProperty(MaterialProperty::Metalness);
+                    properties[index].normal_mul             = material->GetProperty(MaterialProperty::Normal);
+                    properties[index].height_mul             = material->GetProperty(MaterialProperty::Height);
+                    properties[index].anisotropic            = material->GetProperty(MaterialProperty::Anisotropic);
+                    properties[index].anisotropic_rotation   = material->GetProperty(MaterialProperty::AnisotropicRotation);
+                    properties[index].clearcoat              = material->GetProperty(MaterialProperty::Clearcoat);
+                    properties[index].clearcoat_roughness    = material->GetProperty(MaterialProperty::Clearcoat_Roughness);
+                    properties[index].sheen                  = material->GetProperty(MaterialProperty::Sheen);
+                    properties[index].sheen_tint             = material->GetProperty(MaterialProperty::SheenTint);
+                    properties[index].subsurface_scattering  = material->GetProperty(MaterialProperty::SubsurfaceScattering);
+                    properties[index].ior                    = material->GetProperty(MaterialProperty::Ior);
+                    properties[index].flags                 |= material->GetProperty(MaterialProperty::SingleTextureRoughnessMetalness) ? (1U << 0) : 0;
+                    properties[index].flags                 |= material->HasTexture(MaterialTexture::Height)               ? (1U << 1)  : 0;
+                    properties[index].flags                 |= material->HasTexture(MaterialTexture::Normal)               ? (1U << 2)  : 0;
+                    properties[index].flags                 |= material->HasTexture(MaterialTexture::Color)                ? (1U << 3)  : 0;
+                    properties[index].flags                 |= material->HasTexture(MaterialTexture::Roughness)            ? (1U << 4)  : 0;
+                    properties[index].flags                 |= material->HasTexture(MaterialTexture::Metalness)            ? (1U << 5)  : 0;
+                    properties[index].flags                 |= material->HasTexture(MaterialTexture::AlphaMask)            ? (1U << 6)  : 0;
+                    properties[index].flags                 |= material->HasTexture(MaterialTexture::Emission)             ? (1U << 7)  : 0;
+                    properties[index].flags                 |= material->HasTexture(MaterialTexture::Occlusion)            ? (1U << 8)  : 0;
+                    properties[index].flags                 |= material->GetProperty(MaterialProperty::TextureSlopeBased)  ? (1U << 9)  : 0;
+                    properties[index].flags                 |= material->GetProperty(MaterialProperty::VertexAnimateWind)  ? (1U << 10) : 0;
+                    properties[index].flags                 |= material->GetProperty(MaterialProperty::VertexAnimateWater) ? (1U << 11) : 0;
+                    properties[index].flags                 |= material->IsTessellated()                                   ? (1U << 12) : 0;
+                    // when changing the bit flags, ensure that you also update the Surface struct in common_structs.hlsl, so that it reads those flags as expected
+                }
+
+                // textures
+                for (uint32_t texture_index = 0; texture_index < block_size; texture_index++)
+                {
+                    bindless_textures[index + texture_index] = material->GetTexture(static_cast<MaterialTexture>(texture_index));
+                }
+
+                material->SetIndex(index);
+                mark_dirty(index);
+            }
+
+            void acquire(Material* material)
+            {
+                auto it = blocks.find(material->GetObjectId());
+                if (it != blocks.end())
+                {
+                    it->second.ref_count++;
+                    return;
+                }
+
+                // recycle a released block or grow into unused slots
+                Block block;
+                block.material  = material;
+                block.ref_count = 1;
+                if (!blocks_free.empty())
+                {
+                    block.index = blocks_free.back();
+                    blocks_free.pop_back();
+                }
+                else
+                {
+                    SP_ASSERT_MSG(block_end + block_size <= rhi_max_array_size, "Out of bindless material slots");
+                    block.index = block_end;
+                    block_end  += block_size;
+                }
+
+                blocks[material->GetObjectId()] = block;
+                write(material, block.index);
+            }
+
+            void release(const uint64_t material_id)
+            {
+                auto it = blocks.find(material_id);
+                if (it == blocks.end())
+                    return;
+
+                if (--it->second.ref_count != 0)
+                    return;
+
+                // clear the block so nothing can sample stale textures from it
+                uint32_t index    = it->second.index;
+                properties[index] = Sb_Material{};
+                fill(bindless_textures.begin() + index, bindless_textures.begin() + index + block_size, nullptr);
+                mark_dirty(index);
+
+                blocks_free.emplace_back(index);
+                blocks.erase(it);
+            }
+
+            void reset()
+            {
+                if (block_end != 0)
+                {
+                    fill(properties.begin(), properties.begin() + block_end, Sb_Material{});
+                    fill(bindless_textures.begin(), bindless_textures.begin() + block_end, nullptr);
+                    mark_dirty(0);
+                    mark_dirty(block_end - block_size);
+                }
+
+                blocks.clear();
+                blocks_free.clear();
+                block_end = 0;
+            }
+
+            void shutdown()
+            {
+                reset();
+                unordered_map<uint64_t, Block>().swap(blocks);
+                vector<uint32_t>().swap(blocks_free);
+            }
+
+            void upload_properties()
+            {
+                if (dirty_properties_begin < dirty_properties_end)
+                {
+                    uint32_t stride = static_cast<uint32_t>(sizeof(Sb_Material));
+                    uint32_t size   = (dirty_properties_end - dirty_properties_begin) * stride;
+                    Renderer::GetStructuredBuffer(Renderer_StructuredBuffer::Materials)->UpdateRange(&properties[dirty_properties_begin], dirty_properties_begin * stride, size);
+
+                    Profiler::m_renderer_material_upload_bytes += size;
+                }
+
+                dirty_properties_begin = numeric_limits<uint32_t>::max();
+                dirty_properties_end   = 0;
+
+                Profiler::m_renderer_material_blocks_used     = static_cast<uint32_t>(blocks.size());
+                Profiler::m_renderer_material_blocks_capacity = rhi_max_array_size / block_size;
+            }
+
+            void upload_textures()
+            {
+                if (dirty_textures_begin >= dirty_textures_end)
+                    return;
+
+                uint32_t count = dirty_textures_end - dirty_textures_begin;
+                RHI_Device::UpdateBindlessResources(nullptr, &bindless_textures, dirty_textures_begin, count);
+
+                dirty_textures_begin = numeric_limits<uint32_t>::max();
+                dirty_textures_end   = 0;
+            }
+        }
+
         float get_directional_light_intensity_lumens(const vector<shared_ptr<Entity>>& lights)
         {
             float intensity = 0.0f;
@@ -161,7 +400,16 @@ namespace Spartan
                 CreateStandardMaterials();
                 CreateFonts();
                 CreateShaders();
+
+                // the first frame can't render without these, the rest compile in the background
+                RHI_Shader::WaitForCompilation(RHI_ShaderCompilationPriority::Essential);
+                RHI_Device::PrewarmPipelines();
+
                 m_resources_created = true;
+
+                // once everything has compiled, create the remaining pipelines that previous sessions used
+                RHI_Shader::WaitForCompilation(RHI_ShaderCompilationPriority::Normal);
+                RHI_Device::PrewarmPipelines();
             });
 
             CreateBuffers();
@@ -177,7 +425,7 @@ namespace Spartan
             // subscribe
             SP_SUBSCRIBE_TO_EVENT(EventType::WorldClear,              SP_EVENT_HANDLER_STATIC(OnClear));
             SP_SUBSCRIBE_TO_EVENT(EventType::WindowFullScreenToggled, SP_EVENT_HANDLER_STATIC(OnFullScreenToggled));
-            SP_SUBSCRIBE_TO_EVENT(EventType::MaterialOnChanged,       SP_EVENT_HANDLER_STATIC(BindlessUpdateMaterials));
+            SP_SUBSCRIBE_TO_EVENT_DATA(EventType::MaterialOnChanged, OnMaterialChanged);
             SP_SUBSCRIBE_TO_EVENT(EventType::LightOnChanged,          SP_EVENT_HANDLER_STATIC(BindlessUpdateLights));
 
             // fire
@@ -211,7 +459,9 @@ namespace Spartan
         SetOption(Renderer_Option::Lights,                        1.0f);
         SetOption(Renderer_Option::Physics,                       0.0f);
         SetOption(Renderer_Option::PerformanceMetrics,            1.0f);
-        SetOption(Renderer_Option::OcclusionCulling,              0.0f); // disabled by default as it's a WIP (you can see the query delays)
+        SetOption(Renderer_Option::OcclusionCulling,              0.0f); // disabled by default, the buffer is low resolution so sub-pixel gaps between occluders can be missed
+        SetOption(Renderer_Option::GpuCulling,                    0.0f); // disabled by default as it's a WIP (the culling buffers live in host visible memory)
+        SetOption(Renderer_Option::AutoInstancing,                1.0f);
     }
 
     void Renderer::Shutdown()
@@ -222,8 +472,11 @@ namespace Spartan
         // releases their rhi resources before device destruction
         {
             DestroyResources();
+            DestroyPassResources();
 
-            m_renderables.clear();
+            unordered_map<Renderer_Entity, vector<shared_ptr<Entity>>>().swap(m_renderables);
+            unordered_map<uint64_t, EntityRecord>().swap(entity_records);
+            bindless_materials::shutdown();
             swap_chain            = nullptr;
             m_vertex_buffer_lines = nullptr;
         }
@@ -235,6 +488,11 @@ namespace Spartan
 
     void Renderer::Tick()
     {
+        SP_MEMORY_TAG(MemoryTag::Renderer);
+
+        // transient allocations of the previous frame are kept alive for one more frame
+        FrameArena::Tick();
+
         // don't waste cpu/gpu time if nothing can be seen
         if (Window::IsMinimized() || !m_resources_created)
             return;
@@ -432,55 +690,154 @@ namespace Spartan
 
     void Renderer::SetEntities(unordered_map<uint64_t, shared_ptr<Entity>>& entities)
     {
+        // the buckets and the entity records are the renderer's mirror of the world, they are released on shutdown
+        SP_MEMORY_TAG(MemoryTag::Renderer);
+
         m_mutex_renderables.lock();
 
         // clear previous state
         m_renderables.clear();
+        entity_records.clear();
+        OcclusionBuffer::ClearCache();
 
         for (auto it : entities)
         {
             shared_ptr<Entity>& entity = it.second;
 
-            if (!entity->IsActive())
+            uint32_t buckets = get_entity_buckets(entity.get());
+            if (buckets == 0)
                 continue;
 
-            if (shared_ptr<Renderable> renderable = entity->GetComponent<Renderable>())
+            for (uint32_t i = 0; i < renderer_entity_bucket_count; i++)
             {
-                if (Material* material = renderable->GetMaterial())
+                if (buckets & (1u << i))
                 {
-                    if (material->IsVisible())
-                    {
-                        // a mesh can be uninitialized if it's currently loading in a different thread
-                        // but we don't keep anything uninitialized in what the renderer is processing
-                        if (renderable->GetVertexBuffer() && renderable->GetIndexBuffer())
-                        { 
-                            m_renderables[Renderer_Entity::Mesh].emplace_back(entity);
-                        }
-                    }
+                    m_renderables[static_cast<Renderer_Entity>(i)].emplace_back(entity);
                 }
             }
 
-            if (shared_ptr<Light> light = entity->GetComponent<Light>())
+            entity_records[entity->GetObjectId()].buckets = buckets;
+        }
+
+        m_mutex_renderables.unlock();
+
+        // update bindless resources
+        BindlessUpdateMaterials();
+        BindlessUpdateLights();
+    }
+
+    void Renderer::UpdateEntities(const frame_vector<shared_ptr<Entity>>& changed, const frame_vector<uint64_t>& removed)
+    {
+        SP_MEMORY_TAG(MemoryTag::Renderer);
+
+        const uint32_t bucket_mesh  = 1u << static_cast<uint32_t>(Renderer_Entity::Mesh);
+        const uint32_t bucket_light = 1u << static_cast<uint32_t>(Renderer_Entity::Light);
+
+        bool lights_changed = false;
+
+        m_mutex_renderables.lock();
+
+        // ids to drop from each bucket
+        array<frame_unordered_set<uint64_t>, renderer_entity_bucket_count> to_remove;
+        auto unregister = [&to_remove, &lights_changed, bucket_mesh, bucket_light](uint64_t id, const EntityRecord& record, uint32_t buckets)
+        {
+            for (uint32_t i = 0; i < renderer_entity_bucket_count; i++)
             {
-                m_renderables[Renderer_Entity::Light].emplace_back(entity);
+                if (buckets & (1u << i))
+                {
+                    to_remove[i].insert(id);
+                }
+            }
+
+            if (buckets & bucket_mesh)
+            {
+                bindless_materials::release(record.material_id);
             }
 
-            if (shared_ptr<Camera> camera = entity->GetComponent<Camera>())
+            lights_changed |= (buckets & bucket_light) != 0;
+        };
+
+        for (uint64_t id : removed)
+        {
+            auto it = entity_records.find(id);
+            if (it == entity_records.end())
+                continue;
+
+            unregister(id, it->second, it->second.buckets);
+            entity_records.erase(it);
+        }
+
+        for (const shared_ptr<Entity>& entity : changed)
+        {
+            const uint64_t id   = entity->GetObjectId();
+            EntityRecord record = entity_records[id];
+            uint32_t desired    = get_entity_buckets(entity.get());
+
+            // buckets the entity is leaving
+            unregister(id, record, record.buckets & ~desired);
+
+            // buckets the entity is entering
+            uint32_t added = desired & ~record.buckets;
+            for (uint32_t i = 0; i < renderer_entity_bucket_count; i++)
             {
-                m_renderables[Renderer_Entity::Camera].emplace_back(entity);
+                if (added & (1u << i))
+                {
+                    m_renderables[static_cast<Renderer_Entity>(i)].emplace_back(entity);
+                }
             }
 
-            if (shared_ptr<AudioSource> audio_source = entity->GetComponent<AudioSource>())
+            // a mesh can keep its bucket but switch material
+            if (desired & bucket_mesh)
             {
-                m_renderables[Renderer_Entity::AudioSource].emplace_back(entity);
+                Material* material = entity->GetComponent<Renderable>()->GetMaterial();
+                bool had_material  = (record.buckets & bucket_mesh) != 0;
+                if (!had_material || record.material_id != material->GetObjectId())
+                {
+                    bindless_materials::acquire(material);
+                    if (had_material)
+                    {
+                        bindless_materials::release(record.material_id);
+                    }
+                    record.material_id = material->GetObjectId();
+                }
             }
+
+            // a light which stayed a light can still have changed its type
+            lights_changed |= (desired & bucket_light) != 0;
+
+            record.buckets = desired;
+            if (desired != 0)
+            {
+                entity_records[id] = record;
+            }
+            else
+            {
+                entity_records.erase(id);
+            }
+        }
+
+        // the mesh bucket is re-ordered by culling every frame, so removals are a single compaction pass per bucket
+        for (uint32_t i = 0; i < renderer_entity_bucket_count; i++)
+        {
+            if (to_remove[i].empty())
+                continue;
+
+            vector<shared_ptr<Entity>>& bucket = m_renderables[static_cast<Renderer_Entity>(i)];
+            bucket.erase(remove_if(bucket.begin(), bucket.end(), [&to_remove, i](const shared_ptr<Entity>& entity)
+            {
+                return to_remove[i].count(entity->GetObjectId()) != 0;
+            }), bucket.end());
         }
 
+        // update bindless resources, only for what changed
+        bindless_materials::upload_properties();
+
         m_mutex_renderables.unlock();
 
-        // update bindless resources
-        BindlessUpdateMaterials();
-        BindlessUpdateLights();
+        if (lights_changed)
+        {
+            BindlessUpdateLights();
+        }
     }
 
     bool Renderer::CanUseCmdList()
@@ -492,6 +849,7 @@ namespace Spartan
     void Renderer::OnClear()
     {
         m_renderables.clear();
+        entity_records.clear();
     }
 
     void Renderer::OnFullScreenToggled()
@@ -547,11 +905,8 @@ namespace Spartan
             GetStructuredBuffer(Renderer_StructuredBuffer::Spd)->ResetOffset();
             GetConstantBufferFrame()->ResetOffset();
 
-            if (bindless_materials_dirty)
-            {
-                RHI_Device::UpdateBindlessResources(nullptr, &bindless_textures);
-                bindless_materials_dirty = false;
-            }
+            // only the texture descriptors which changed
+            bindless_materials::upload_textures();
         }
 
         UpdateConstantBufferFrame(cmd_list_graphics);
@@ -824,121 +1179,41 @@ namespace Spartan
     
     void Renderer::BindlessUpdateMaterials()
     {
-        static array<Sb_Material, rhi_max_array_size> properties; // mapped to the gpu as a structured properties buffer
-        static unordered_set<uint64_t> unique_material_ids;
-        static uint32_t index = 0;
-
-        auto update_material = [](Material* material)
-        {
-            // check if the material's ID is already processed
-            if (unique_material_ids.find(material->GetObjectId()) != unique_material_ids.end())
-                return;
-
-            // if not, add it to the list
-            unique_material_ids.insert(material->GetObjectId());
-
-            // properties
-            {
-                SP_ASSERT(index < rhi_max_array_size);
-
-                properties[index].world_space_height     = material->GetProperty(MaterialProperty::WorldSpaceHeight);
-                properties[index].color.x                = material->GetProperty(MaterialProperty::ColorR);
-                properties[index].color.y                = material->GetProperty(MaterialProperty::ColorG);
-                properties[index].color.z                = material->GetProperty(MaterialProperty::ColorB);
-                properties[index].color.w                = material->GetProperty(MaterialProperty::ColorA);
-                properties[index].tiling_uv.x            = material->GetProperty(MaterialProperty::TextureTilingX);
-                properties[index].tiling_uv.y            = material->GetProperty(MaterialProperty::TextureTilingY);
-                properties[index].offset_uv.x            = material->GetProperty(MaterialProperty::TextureOffsetX);
-                properties[index].offset_uv.y            = material->GetProperty(MaterialProperty::TextureOffsetY);
-                properties[index].roughness_mul          = material->GetProperty(MaterialProperty::Roughness);
-                properties[index].metallic_mul           = material->GetProperty(MaterialProperty::Metalness);
-                properties[index].normal_mul             = material->GetProperty(MaterialProperty::Normal);
-                properties[index].height_mul             = material->GetProperty(MaterialProperty::Height);
-                properties[index].anisotropic            = material->GetProperty(MaterialProperty::Anisotropic);
-                properties[index].anisotropic_rotation   = material->GetProperty(MaterialProperty::AnisotropicRotation);
-                properties[index].clearcoat              = material->GetProperty(MaterialProperty::Clearcoat);
-                properties[index].clearcoat_roughness    = material->GetProperty(MaterialProperty::Clearcoat_Roughness);
-                properties[index].sheen                  = material->GetProperty(MaterialProperty::Sheen);
-                properties[index].sheen_tint             = material->GetProperty(MaterialProperty::SheenTint);
-                properties[index].subsurface_scattering  = material->GetProperty(MaterialProperty::SubsurfaceScattering);
-                properties[index].ior                    = material->GetProperty(MaterialProperty::Ior);
-                properties[index].flags                 |= material->GetProperty(MaterialProperty::SingleTextureRoughnessMetalness) ? (1U << 0) : 0;
-                properties[index].flags                 |= material->HasTexture(MaterialTexture::Height)               ? (1U << 1)  : 0;
-                properties[index].flags                 |= material->HasTexture(MaterialTexture::Normal)               ? (1U << 2)  : 0;
-                properties[index].flags                 |= material->HasTexture(MaterialTexture::Color)                ? (1U << 3)  : 0;
-                properties[index].flags                 |= material->HasTexture(MaterialTexture::Roughness)            ? (1U << 4)  : 0;
-                properties[index].flags                 |= material->HasTexture(MaterialTexture::Metalness)            ? (1U << 5)  : 0;
-                properties[index].flags                 |= material->HasTexture(MaterialTexture::AlphaMask)            ? (1U << 6)  : 0;
-                properties[index].flags                 |= material->HasTexture(MaterialTexture::Emission)             ? (1U << 7)  : 0;
-                properties[index].flags                 |= material->HasTexture(MaterialTexture::Occlusion)            ? (1U << 8)  : 0;
-                properties[index].flags                 |= material->GetProperty(MaterialProperty::TextureSlopeBased)  ? (1U << 9)  : 0;
-                properties[index].flags                 |= material->GetProperty(MaterialProperty::VertexAnimateWind)  ? (1U << 10) : 0;
-                properties[index].flags                 |= material->GetProperty(MaterialProperty::VertexAnimateWater) ? (1U << 11) : 0;
-                properties[index].flags                 |= material->IsTessellated()                                   ? (1U << 12) : 0;
-                // when changing the bit flags, ensure that you also update the Surface struct in common_structs.hlsl, so that it reads those flags as expected
-            }
-
-            // textures
-            {
-
-                for (uint32_t type = 0; type < material_texture_type_count; type++)
-                {
-                    for (uint32_t variation = 0; variation < material_texture_slots_per_type; variation++)
-                    {
-                        uint32_t texture_index                   = type * material_texture_slots_per_type + variation;
-                        MaterialTexture textureType              = static_cast<MaterialTexture>(texture_index);
-                        bindless_textures[index + texture_index] = material->GetTexture(static_cast<MaterialTexture>(texture_index));
-                    }
-                }
-
-            }
-
-            material->SetIndex(index);
-            index += static_cast<uint32_t>(MaterialTexture::Max);
-        };
+        SP_MEMORY_TAG(MemoryTag::Renderer);
+        lock_guard lock(m_mutex_renderables);
 
-        auto update_entities = [update_material](vector<shared_ptr<Entity>>& entities)
+        // cpu
         {
-            for (shared_ptr<Entity> entity : entities)
+            // start from an empty table, every mesh re-acquires its material
+            bindless_materials::reset();
+            for (const shared_ptr<Entity>& entity : m_renderables[Renderer_Entity::Mesh])
             {
-                if (entity)
-                {
-                    if (shared_ptr<Renderable> renderable = entity->GetComponent<Renderable>())
-                    {
-                        if (Material* material = renderable->GetMaterial())
-                        {
-                            update_material(material);
-                        }
-                    }
-                }
+                Material* material = entity->GetComponent<Renderable>()->GetMaterial();
+                bindless_materials::acquire(material);
+                entity_records[entity->GetObjectId()].material_id = material->GetObjectId();
             }
-        };
+        }
+
+        // gpu
+        bindless_materials::upload_properties();
+    }
 
+    void Renderer::OnMaterialChanged(const uint64_t material_id)
+    {
+        // the world will resolve everything once it's done loading
         if (ProgressTracker::IsLoading())
             return;
 
         lock_guard lock(m_mutex_renderables);
 
-        // cpu
-        {
-            // clear
-            properties.fill(Sb_Material{});
-            bindless_textures.fill(nullptr);
-            unique_material_ids.clear();
-            index = 0;
-            update_entities(m_renderables[Renderer_Entity::Mesh]);
-        }
-
-        // gpu
-        {
-            // material properties
-            Renderer::GetStructuredBuffer(Renderer_StructuredBuffer::Materials)->ResetOffset();
-            uint32_t update_size = static_cast<uint32_t>(sizeof(Sb_Material)) * index;
-            Renderer::GetStructuredBuffer(Renderer_StructuredBuffer::Materials)->Update(&properties[0], update_size);
+        // only materials which are in use by a renderable have a block, the rest will be written when acquired,
+        // this is dispatched after the change was published, so the material may no longer be in use
+        auto it = bindless_materials::blocks.find(material_id);
+        if (it == bindless_materials::blocks.end())
+            return;
 
-            // material textures
-            bindless_materials_dirty = true;
-        }
+        bindless_materials::write(it->second.material, it->second.index);
+        bindless_materials::upload_properties();
     }
 
     void Renderer::BindlessUpdateLights()
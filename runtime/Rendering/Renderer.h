@@ -29,6 +29,7 @@ CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 #include "../Math/Vector4.h"
 #include "../Math/Plane.h"
 #include "Event.h"
+#include "FrameArena.h"
 #include "Mesh.h"
 #include "Renderer_Buffers.h"
 #include "Font/Font.h"
@@ -85,6 +86,7 @@ namespace Spartan
         static RHI_Api_Type GetRhiApiType();
         static void Screenshot(const std::string& file_path);
         static void SetEntities(std::unordered_map<uint64_t, std::shared_ptr<Entity>>& entities);
+        static void UpdateEntities(const frame_vector<std::shared_ptr<Entity>>& changed, const frame_vector<uint64_t>& removed);
         static bool CanUseCmdList();
 
         //= RESOLUTION/SIZE =============================================================================
@@ -149,6 +151,7 @@ namespace Spartan
         static void Pass_VariableRateShading(RHI_CommandList* cmd_list);
         static void Pass_ShadowMaps(RHI_CommandList* cmd_list, const bool is_transparent_pass = false);
         static void Pass_Visibility(RHI_CommandList* cmd_list);
+        static void Pass_Culling(RHI_CommandList* cmd_list, const bool occlusion = false);
         static void Pass_Depth_Prepass(RHI_CommandList* cmd_list, const bool is_transparent_pass = false);
         static void Pass_GBuffer(RHI_CommandList* cmd_list, const bool is_transparent_pass = false);
         static void Pass_Ssgi(RHI_CommandList* cmd_list);
@@ -191,10 +194,12 @@ namespace Spartan
         static void AddLinesToBeRendered();
         static void SetGbufferTextures(RHI_CommandList* cmd_list);
         static void DestroyResources();
+        static void DestroyPassResources(); // what the passes keep across frames
 
         // bindless
         static void BindlessUpdateMaterials();
         static void BindlessUpdateLights();
+        static void OnMaterialChanged(const uint64_t material_id);
 
         // misc
         static std::unordered_map<Renderer_Entity, std::vector<std::shared_ptr<Entity>>> m_renderables;
@@ -65,6 +65,8 @@ namespace Spartan
         ResolutionScale,
         DynamicResolution,
         OcclusionCulling,
+        GpuCulling,
+        AutoInstancing,
         Max
     };
 
@@ -148,15 +150,21 @@ namespace Spartan
 
     enum class Renderer_BindingsUav
     {
-        sb_materials      = 0,
-        sb_lights         = 1,
-        tex               = 2,
-        tex2              = 3,
-        tex3              = 4,
-        tex_uint          = 5,
-        tex_sss           = 6,
-        sb_spd            = 7,
-        tex_spd           = 8,
+        sb_materials                 = 0,
+        sb_lights                    = 1,
+        tex                          = 2,
+        tex2                         = 3,
+        tex3                         = 4,
+        tex_uint                     = 5,
+        tex_sss                      = 6,
+        sb_spd                       = 7,
+        tex_spd                      = 8, // 12 mips, up to 19
+        sb_culling_bounds            = 20,
+        sb_culling_instances         = 21,
+        sb_culling_instances_visible = 22,
+        sb_culling_arguments         = 23,
+        sb_light_clusters            = 24,
+        sb_light_cluster_indices     = 25
     };
 
     enum class Renderer_Shader : uint8_t
@@ -206,6 +214,9 @@ namespace Spartan
         ffx_spd_average_c,
         ffx_spd_highest_c,
         ffx_spd_antiflicker_c,
+        culling_c,
+        culling_occlusion_c,
+        culling_depth_pyramid_c,
         max
     };
     
@@ -238,6 +249,7 @@ namespace Spartan
         blur,
         outline,
         shading_rate,
+        depth_pyramid,
         max
     };
 
@@ -287,7 +299,8 @@ namespace Spartan
         Solid,
         Wireframe,
         Light_point_spot,
-        Light_directional
+        Light_directional,
+        Max
     };
 
     enum class Renderer_DepthStencilState
@@ -302,7 +315,8 @@ namespace Spartan
     {
         Off,
         Alpha,
-        Additive
+        Additive,
+        Max
     };
 
     enum class Renderer_DownsampleFilter
@@ -23,6 +23,11 @@ CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 #include "pch.h"
 #include "Renderer.h"
 #include "ProgressTracker.h"
+#include "InstanceCulling.h"
+#include "LightClusters.h"
+#include "OcclusionBuffer.h"
+#include "Visibility.h"
+#include "../Core/ThreadPool.h"
 #include "../Display/Display.h"
 #include "../Profiling/Profiler.h"
 #include "../World/Entity.h"
@@ -31,9 +36,11 @@ CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 #include "../RHI/RHI_Device.h"
 #include "../RHI/RHI_CommandList.h"
 #include "../RHI/RHI_VertexBuffer.h"
+#include "../RHI/RHI_StructuredBuffer.h"
 #include "../RHI/RHI_Shader.h"
 #include "../RHI/RHI_FidelityFX.h"
 #include "../RHI/RHI_RasterizerState.h"
+#include <bit>
 SP_WARNINGS_OFF
 #include "bend_sss_cpu.h"
 #include "../RHI/RHI_OpenImageDenoise.h"
@@ -54,212 +61,360 @@ namespace Spartan
         int64_t mesh_index_non_instanced_opaque            = 0;
         int64_t mesh_index_non_instanced_transparent       = 0;
 
+        // frees the memory of a container, clear() keeps it
+        template<typename T>
+        void release(T& container)
+        {
+            T().swap(container);
+        }
+
         // The code below is a work in progress, that's why its here
 
         namespace visibility
         {
-            unordered_map<uint64_t, float> distances_squared;
-            unordered_map<uint64_t, Rectangle> rectangles;
-            unordered_map<uint64_t, BoundingBox> boxes;
+            using namespace ::visibility;
+
+            vector<DrawRecord> draw_records;
+            vector<DrawRecord> draw_records_scratch;
+            vector<shared_ptr<Entity>> renderables_scratch;
+
+            struct OccluderCandidate
+            {
+                Renderable* renderable = nullptr;
+                float area             = 0.0f;
+                uint64_t id            = 0;
+            };
+            vector<OccluderCandidate> occluder_candidates;
+            vector<Renderable*> occluders;
 
             void clear()
             {
-                distances_squared.clear();
-                rectangles.clear();
-                boxes.clear();
+                draw_records.clear();
             }
 
-            float get_squared_distance(const shared_ptr<Entity>& entity)
+            void frustum_cull_and_sort(vector<shared_ptr<Entity>>& renderables)
             {
-                Vector3 camera_position = Renderer::GetCamera()->GetEntity()->GetPosition();
-                uint64_t entity_id      = entity->GetObjectId();
-
-                auto it = distances_squared.find(entity_id);
-                if (it != distances_squared.end())
+                if (renderables.empty())
                 {
-                    return it->second;
+                    mesh_index_transparent               = 0;
+                    mesh_index_non_instanced_opaque      = 0;
+                    mesh_index_non_instanced_transparent = 0;
+                    return;
                 }
-                else
-                {
-                    shared_ptr<Renderable> renderable = entity->GetComponent<Renderable>();
-                    BoundingBoxType type              = renderable->HasInstancing() ? BoundingBoxType::TransformedInstances : BoundingBoxType::Transformed;
-                    Vector3 position                  = renderable->GetBoundingBox(type).GetCenter();
-                    float distance_squared            = (position - camera_position).LengthSquared();
-                    distances_squared[entity_id]      = distance_squared;
 
-                    return distance_squared;
-                }
-            }
+                Camera* camera          = Renderer::GetCamera().get();
+                Vector3 camera_position = camera->GetEntity()->GetPosition();
+                float tan_half_fov      = tan(camera->GetFovVerticalRad() * 0.5f);
 
-            void frustum_culling(vector<shared_ptr<Entity>>& renderables)
-            {
-                for (shared_ptr<Entity>& entity : renderables)
+                // build the draw records, touching each entity's components exactly once
+                draw_records.resize(renderables.size());
+                for (uint32_t i = 0; i < static_cast<uint32_t>(renderables.size()); i++)
                 {
-                    shared_ptr<Renderable> renderable = entity->GetComponent<Renderable>();
-                    renderable->SetFlag(RenderableFlags::OccludedCpu, !Renderer::GetCamera()->IsInViewFrustum(renderable));
+                    shared_ptr<Renderable> renderable = renderables[i]->GetComponent<Renderable>();
+                    Material* material                = renderable->GetMaterial();
+
+                    bool is_culled = !camera->IsInViewFrustum(renderable);
+                    renderable->SetFlag(RenderableFlags::OccludedCpu, is_culled);
+                    renderable->SetFlag(RenderableFlags::Occluded, false);
                     renderable->SetFlag(RenderableFlags::Occluder, false);
+
+                    bool is_instanced      = renderable->HasInstancing();
+                    BoundingBoxType type   = is_instanced ? BoundingBoxType::TransformedInstances : BoundingBoxType::Transformed;
+                    const BoundingBox& box = renderable->GetBoundingBox(type);
+                    float distance_squared = (box.GetCenter() - camera_position).LengthSquared();
+
+                    if (!is_culled)
+                    {
+                        renderable->SetLodIndex(select_lod(renderable->GetLodIndex(), renderable->GetLodCount(), box, camera_position, tan_half_fov));
+                    }
+
+                    draw_records[i].index = i;
+                    draw_records[i].key   = compute_key(
+                        material ? material->IsTransparent() : false,
+                        is_instanced,
+                        is_culled,
+                        material ? material->GetIndex() : 0,
+                        distance_squared
+                    );
                 }
-            }
 
-            void sort(vector<shared_ptr<Entity>>& renderables)
-            {
-                // 1. sort by depth
-                sort(renderables.begin(), renderables.end(), [](const shared_ptr<Entity>& a, const shared_ptr<Entity>& b)
-                {
-                    // skip entities which are outside of the view frustum
-                    if (a->GetComponent<Renderable>()->HasFlag(OccludedCpu) || b->GetComponent<Renderable>()->HasFlag(OccludedCpu))
-                        return false;
-                    
-                    // front-to-back for opaque (todo, handle inverse sorting for transparents)
-                    return get_squared_distance(a) < get_squared_distance(b);
-                });
+                radix_sort(draw_records, draw_records_scratch);
 
-                // 2. sort by instancing, instanced objects go to the front
-                stable_sort(renderables.begin(), renderables.end(), [](const shared_ptr<Entity>& a, const shared_ptr<Entity>& b)
+                // reorder the entities to match the sorted records
+                renderables_scratch.resize(renderables.size());
+                for (uint32_t i = 0; i < static_cast<uint32_t>(draw_records.size()); i++)
                 {
-                    return a->GetComponent<Renderable>()->HasInstancing() > b->GetComponent<Renderable>()->HasInstancing();
-                });
+                    renderables_scratch[i] = move(renderables[draw_records[i].index]);
+                }
+                renderables.swap(renderables_scratch);
+                renderables_scratch.clear();
 
-                // 3. sort by transparency, transparent materials go to the end
-                stable_sort(renderables.begin(), renderables.end(), [](const shared_ptr<Entity>& a, const shared_ptr<Entity>& b)
+                // derive the pass ranges from the keys
+                auto first_at_or_above = [](const uint64_t key)
                 {
-                    bool a_transparent = a->GetComponent<Renderable>()->GetMaterial()->IsTransparent();
-                    bool b_transparent = b->GetComponent<Renderable>()->GetMaterial()->IsTransparent();
-
-                    // non-transparent objects should come first, so invert the condition
-                    return !a_transparent && b_transparent;
-                });
+                    auto it = lower_bound(draw_records.begin(), draw_records.end(), key, [](const DrawRecord& record, const uint64_t value)
+                    {
+                        return record.key < value;
+                    });
+
+                    return static_cast<int64_t>(distance(draw_records.begin(), it));
+                };
+                mesh_index_transparent               = first_at_or_above(key_bit_transparent);
+                mesh_index_non_instanced_opaque      = first_at_or_above(key_bit_non_instanced);
+                mesh_index_non_instanced_transparent = first_at_or_above(key_bit_transparent | key_bit_non_instanced);
             }
 
-            void frustum_cull_and_sort(vector<shared_ptr<Entity>>& renderables)
+            // the largest opaque meshes on screen are rasterized into the occlusion buffer, everything else is tested against it
+            void select_occluders(vector<shared_ptr<Entity>>& renderables)
             {
-                frustum_culling(renderables);
-                sort(renderables);
+                const uint32_t occluder_count_max = 32;
+                const float area_min              = 0.02f; // fraction of the screen
 
-                // find transparent index
-                auto transparent_start = find_if(renderables.begin(), renderables.end(), [](const shared_ptr<Entity>& entity)
-                {
-                    return entity->GetComponent<Renderable>()->GetMaterial()->IsTransparent();
-                });
-                mesh_index_transparent = distance(renderables.begin(), transparent_start);
+                Camera* camera     = Renderer::GetCamera().get();
+                float screen_area  = max(Renderer::GetViewport().width * Renderer::GetViewport().height, 1.0f);
 
-                // find non-instanced index for opaque objects
-                auto non_instanced_opaque_start = find_if(renderables.begin(), renderables.end(), [&](const shared_ptr<Entity>& entity)
+                occluder_candidates.clear();
+
+                for (int64_t i = 0; i < mesh_index_transparent; i++)
                 {
-                    shared_ptr<Renderable> renderable = entity->GetComponent<Renderable>();
-                    bool is_transparent               = renderable->GetMaterial()->IsTransparent();
-                    bool is_instanced                 = renderable->HasInstancing();
+                    Renderable* renderable = renderables[i]->GetComponent<Renderable>().get();
+                    Material* material     = renderable->GetMaterial();
 
-                    return !is_transparent && !is_instanced;
-                });
-                mesh_index_non_instanced_opaque = distance(renderables.begin(), non_instanced_opaque_start);
+                    // instanced meshes are mostly foliage, alpha tested and tessellated surfaces don't match their geometry
+                    if (renderable->HasFlag(RenderableFlags::OccludedCpu) || renderable->HasInstancing() || !material)
+                        continue;
+
+                    if (material->IsAlphaTested() || material->IsTessellated())
+                        continue;
 
-                // find non-instanced index for transparent objects
-                auto non_instanced_transparent_start = find_if(transparent_start, renderables.end(), [&](const shared_ptr<Entity>& entity)
+                    // rasterized at full detail, dense meshes would cost more than they save
+                    if (renderable->GetIndexCount() > OcclusionBuffer::occluder_index_count_max)
+                        continue;
+
+                    float area = camera->WorldToScreenCoordinates(renderable->GetBoundingBox(BoundingBoxType::Transformed)).Area() / screen_area;
+                    if (area >= area_min)
+                    {
+                        occluder_candidates.push_back({ renderable, area, renderables[i]->GetObjectId() });
+                    }
+                }
+
+                // the id breaks ties so that the selection doesn't depend on the order of the entities
+                sort(occluder_candidates.begin(), occluder_candidates.end(), [](const OccluderCandidate& a, const OccluderCandidate& b)
                 {
-                    return !entity->GetComponent<Renderable>()->HasInstancing();
+                    return a.area != b.area ? a.area > b.area : a.id < b.id;
                 });
-                mesh_index_non_instanced_transparent = distance(renderables.begin(), non_instanced_transparent_start);
+
+                occluders.clear();
+                for (uint32_t i = 0; i < min(static_cast<uint32_t>(occluder_candidates.size()), occluder_count_max); i++)
+                {
+                    occluder_candidates[i].renderable->SetFlag(RenderableFlags::Occluder, true);
+                    occluders.push_back(occluder_candidates[i].renderable);
+                }
             }
 
-            void determine_occluders(vector<shared_ptr<Entity>>& renderables)
+            void occlusion_cull(vector<shared_ptr<Entity>>& renderables)
             {
-                uint32_t occluder_count = 0;
-                for (shared_ptr<Entity>& entity : renderables)
-                {
-                    shared_ptr<Renderable> renderable = entity->GetComponent<Renderable>();
-                    if (!renderable || renderable->HasFlag(RenderableFlags::OccludedCpu))
-                        continue;
+                select_occluders(renderables);
+                OcclusionBuffer::Rasterize(Renderer::GetCamera()->GetViewProjectionMatrix(), occluders);
 
-                    // compute screen space rectangle
-                    BoundingBoxType box_type          = renderable->HasInstancing() ? BoundingBoxType::TransformedInstances : BoundingBoxType::Transformed;
-                    BoundingBox box                   = renderable->GetBoundingBox(box_type);
-                    Rectangle rectangle               = Renderer::GetCamera()->WorldToScreenCoordinates(box);
-                    boxes[entity->GetObjectId()]      = box;
-                    rectangles[entity->GetObjectId()] = rectangle;
-
-                    bool factor_screen_size = rectangle.Area() >= 65536.0f;
-                    bool factor_inside      = box.Contains(Renderer::GetCamera()->GetEntity()->GetPosition()); // say we are in a building
-                    bool factor_count       = occluder_count < 32;
-                    if (factor_count && factor_screen_size && !factor_inside)
+                // test everything that survived frustum culling, each renderable only writes its own flags
+                atomic<uint32_t> occluded_count = 0;
+                auto test = [&renderables, &occluded_count](uint32_t start, uint32_t end)
+                {
+                    uint32_t occluded_count_local = 0;
+                    for (uint32_t i = start; i < end; i++)
                     {
-                        renderable->SetFlag(RenderableFlags::Occluder, true);
-                        occluder_count++;
+                        Renderable* renderable = renderables[i]->GetComponent<Renderable>().get();
+                        if (renderable->HasFlag(RenderableFlags::OccludedCpu) || renderable->HasFlag(RenderableFlags::Occluder))
+                            continue;
+
+                        BoundingBoxType type = renderable->HasInstancing() ? BoundingBoxType::TransformedInstances : BoundingBoxType::Transformed;
+                        bool occluded        = !OcclusionBuffer::IsVisible(renderable->GetBoundingBox(type));
+                        renderable->SetFlag(RenderableFlags::Occluded, occluded);
+                        occluded_count_local += occluded ? 1 : 0;
                     }
+                    occluded_count += occluded_count_local;
+                };
+
+                uint32_t renderable_count = static_cast<uint32_t>(renderables.size());
+                if (renderable_count > 1 && ThreadPool::GetIdleThreadCount() > 0)
+                {
+                    ThreadPool::ParallelLoop(test, renderable_count);
                 }
+                else
+                {
+                    test(0, renderable_count);
+                }
+
+                Profiler::m_renderer_occluders          = static_cast<uint32_t>(occluders.size());
+                Profiler::m_renderer_occluder_triangles = OcclusionBuffer::GetTriangleCount();
+                Profiler::m_renderer_occluded           = occluded_count;
             }
+        }
 
-            void remove_false_gpu_occlusion(shared_ptr<Entity>& entity_occludee, vector<shared_ptr<Entity>>& entities)
+        namespace light_clusters
+        {
+            // the grid and the index lists are written to host visible buffers, each frame in flight
+            // has its own pair, so that the cpu never writes to buffers that the gpu is still reading
+            struct Buffers
             {
-                // if this entity is outside of the view frustum, don't bother
-                shared_ptr<Renderable> renderable_occludee = entity_occludee->GetComponent<Renderable>();
-                if (!renderable_occludee || renderable_occludee->HasFlag(OccludedCpu))
-                    return;
+                shared_ptr<RHI_StructuredBuffer> clusters;
+                shared_ptr<RHI_StructuredBuffer> indices;
+                uint32_t index_capacity = 0;
+            };
 
-                bool is_visible         = true;
-                uint32_t occluder_count = 0;
-                for (shared_ptr<Entity>& entity_occluder : entities)
+            array<Buffers, resources_frame_lifetime> buffers;
+            Buffers* buffers_frame = nullptr; // null until the clusters are built for the first time
+            vector<LightClusters::LightVolume> volumes;
+
+            void build(Camera* camera, const vector<shared_ptr<Entity>>& entities, const uint32_t resource_index)
+            {
+                // directional lights reach everything, so they are not clustered
+                volumes.clear();
+                for (const shared_ptr<Entity>& entity : entities)
                 {
-                    shared_ptr<Renderable> renderable_occluder = entity_occluder->GetComponent<Renderable>();
-                    if (!renderable_occluder || entity_occludee->GetObjectId() == entity_occluder->GetObjectId())
+                    Light* light = entity->GetComponent<Light>().get();
+                    if (!light || light->GetLightType() == LightType::Directional)
                         continue;
 
-                    if (renderable_occluder->HasFlag(Occluder))
+                    LightClusters::LightVolume& volume = volumes.emplace_back();
+                    volume.position                    = entity->GetPosition();
+                    volume.direction                   = entity->GetForward();
+                    volume.range                       = light->GetRange();
+                    volume.angle                       = light->GetLightType() == LightType::Spot ? light->GetAngle() : 0.0f;
+                    volume.index                       = light->GetIndex();
+                }
+
+                LightClusters::Build(camera->GetViewMatrix(), camera->GetProjectionMatrix(), camera->GetNearPlane(), camera->GetFarPlane(), volumes);
+
+                // upload
+                {
+                    const vector<LightClusters::Cluster>& clusters = LightClusters::GetClusters();
+                    const vector<uint32_t>& indices                = LightClusters::GetIndices();
+                    uint32_t index_count                           = static_cast<uint32_t>(indices.size());
+                    Buffers& frame                                 = buffers[resource_index % resources_frame_lifetime];
+
+                    if (!frame.clusters)
                     {
-                        // project world space axis-aligned bounding boxes into screen space
-                        Rectangle& rectangle_occludee = rectangles[entity_occludee->GetObjectId()];
-                        Rectangle& rectangle_occluder = rectangles[entity_occluder->GetObjectId()];
+                        frame.clusters = make_shared<RHI_StructuredBuffer>(static_cast<uint32_t>(sizeof(LightClusters::Cluster)) * LightClusters::cluster_count, 1, "light_clusters");
+                    }
 
-                        // if it's contained by at least one occluder, it's not visible
-                        if (rectangle_occluder.Contains(rectangle_occludee))
-                        {
-                            is_visible = false;
-                            break;
-                        }
+                    // grow geometrically, the index count changes with every camera move
+                    if (!frame.indices || index_count > frame.index_capacity)
+                    {
+                        frame.index_capacity = max(max(index_count, frame.index_capacity * 2), 1024u);
+                        frame.indices        = make_shared<RHI_StructuredBuffer>(static_cast<uint32_t>(sizeof(uint32_t)) * frame.index_capacity, 1, "light_cluster_indices");
+                    }
 
-                        occluder_count++;
+                    frame.clusters->UpdateRange(clusters.data(), 0, static_cast<uint32_t>(sizeof(LightClusters::Cluster)) * LightClusters::cluster_count);
+                    if (index_count != 0)
+                    {
+                        frame.indices->UpdateRange(indices.data(), 0, static_cast<uint32_t>(sizeof(uint32_t)) * index_count);
                     }
 
-                    // use the 4 first (and front most) occluders
-                    if (occluder_count > 4)
-                        break;
+                    buffers_frame = &frame;
                 }
 
-                if (is_visible)
+                Profiler::m_renderer_lights_clustered      = static_cast<uint32_t>(volumes.size());
+                Profiler::m_renderer_light_cluster_indices = static_cast<uint32_t>(LightClusters::GetIndices().size());
+            }
+        }
+
+        namespace gpu_culling
+        {
+            // every instanced renderable owns the inputs (bounds and transforms) and the outputs (compacted
+            // transforms and indirect draw arguments) of the culling kernel, see InstanceCulling.h
+            // the transforms only change with the geometry, the rest is rewritten while previous frames
+            // can still be reading it, so each frame in flight has its own
+            struct FrameBuffers
+            {
+                shared_ptr<RHI_StructuredBuffer> bounds;
+                shared_ptr<RHI_StructuredBuffer> instances_visible;
+                shared_ptr<RHI_StructuredBuffer> arguments;
+                Matrix transform        = Matrix::Identity;
+                uint64_t geometry_frame = 0;
+            };
+
+            struct Buffers
+            {
+                shared_ptr<RHI_StructuredBuffer> instances;
+                array<FrameBuffers, resources_frame_lifetime> frames;
+                FrameBuffers* frame     = nullptr; // the ones of the current frame
+                uint64_t geometry_frame = 0;
+                uint64_t culled_frame   = 0;
+            };
+
+            // buffers of renderables which haven't been culled for this many frames (removed or out of view) are released
+            const uint64_t eviction_frames = 300;
+
+            unordered_map<uint64_t, Buffers> buffers; // keyed by entity id
+            vector<pair<Renderable*, Buffers*>> targets;
+
+            void evict()
+            {
+                for (auto it = buffers.begin(); it != buffers.end();)
                 {
-                    renderable_occludee->SetFlag(RenderableFlags::OccludedGpu, false);
+                    it = Renderer::GetFrameNum() - it->second.culled_frame > eviction_frames ? buffers.erase(it) : next(it);
                 }
             }
 
-            void get_gpu_occlusion_query_results(RHI_CommandList* cmd_list, unordered_map<Renderer_Entity, vector<shared_ptr<Entity>>>& renderables)
+            Buffers& acquire(Entity* entity, Renderable* renderable, const uint32_t resource_index)
             {
-                cmd_list->UpdateOcclusionQueries();
+                auto [it, inserted] = buffers.try_emplace(entity->GetObjectId());
+                Buffers& buffer     = it->second;
+                uint32_t count      = renderable->GetInstanceCount();
+                uint64_t geometry   = renderable->GetGeometryChangedFrame();
 
-                bool is_transparent_pass = false;
-                uint32_t start_index     = !is_transparent_pass ? 0 : 2;
-                uint32_t end_index       = !is_transparent_pass ? 2 : 4;
-                for (uint32_t i = start_index; i < end_index; i++)
+                // (re)create and upload the transforms when the instances change
+                if (inserted || buffer.geometry_frame != geometry)
                 {
-                    auto& entities = renderables[static_cast<Renderer_Entity>(i)];
-                    if (entities.empty())
-                        continue;
+                    buffer.instances      = make_shared<RHI_StructuredBuffer>(static_cast<uint32_t>(sizeof(Matrix)) * count, 1, "culling_instances");
+                    buffer.geometry_frame = geometry;
+                    buffer.culled_frame   = Renderer::GetFrameNum();
 
-                    for (shared_ptr<Entity>& entity : entities)
+                    // same layout as the instance vertex buffer, see Renderable::SetInstances()
+                    frame_vector<Matrix> instances_transposed(count);
+                    for (uint32_t i = 0; i < count; i++)
                     {
-                        shared_ptr<Renderable> renderable = entity->GetComponent<Renderable>();
-                        if (!renderable)
-                            continue;
+                        instances_transposed[i] = renderable->GetInstances()[i].Transposed();
+                    }
+                    buffer.instances->UpdateRange(instances_transposed.data(), 0, static_cast<uint32_t>(sizeof(Matrix)) * count);
+                }
 
-                        bool occluded = cmd_list->GetOcclusionQueryResult(entity->GetObjectId());
-                        renderable->SetFlag(RenderableFlags::OccludedGpu, occluded);
+                FrameBuffers& frame = buffer.frames[resource_index % resources_frame_lifetime];
+                buffer.frame        = &frame;
 
-                        // counter occlusion query latency by removing false gpu occlusions
-                        if (occluded)
-                        {
-                            remove_false_gpu_occlusion(entity, entities);
-                        }
+                bool recreate = frame.geometry_frame != geometry || !frame.bounds;
+                if (recreate)
+                {
+                    frame.bounds            = make_shared<RHI_StructuredBuffer>(static_cast<uint32_t>(sizeof(instance_culling::Bounds)) * count, 1, "culling_bounds");
+                    frame.instances_visible = make_shared<RHI_StructuredBuffer>(static_cast<uint32_t>(sizeof(Matrix)) * (count + instance_culling::instance_offset), 1, "culling_instances_visible");
+                    frame.arguments         = make_shared<RHI_StructuredBuffer>(static_cast<uint32_t>(sizeof(instance_culling::DrawIndexedArguments)), 1, "culling_arguments");
+                    frame.geometry_frame    = geometry;
+                }
+
+                // upload the bounds when the entity moved since this frame's buffers were last used, they are in world space
+                if (recreate || frame.transform != entity->GetMatrix())
+                {
+                    frame_vector<instance_culling::Bounds> bounds(count);
+                    for (uint32_t i = 0; i < count; i++)
+                    {
+                        const BoundingBox& box = renderable->GetBoundingBox(BoundingBoxType::TransformedInstance, i);
+                        bounds[i].min          = Vector4(box.GetMin(), 0.0f);
+                        bounds[i].max          = Vector4(box.GetMax(), 0.0f);
                     }
+                    frame.bounds->UpdateRange(bounds.data(), 0, static_cast<uint32_t>(sizeof(instance_culling::Bounds)) * count);
+                    frame.transform = entity->GetMatrix();
                 }
+
+                return buffer;
+            }
+
+            // the buffers of a renderable if it was culled this frame
+            Buffers* get_culled(Renderable* renderable)
+            {
+                auto it = buffers.find(renderable->GetEntity()->GetObjectId());
+                return (it != buffers.end() && it->second.culled_frame == Renderer::GetFrameNum()) ? &it->second : nullptr;
             }
         }
 
@@ -268,6 +423,19 @@ namespace Spartan
             uint32_t instance_start_index = 0;
             bool draw_instanced           = pso.instancing && renderable->HasInstancing();
 
+            // the instances were culled on the gpu, draw the survivors with a single indirect draw
+            if (draw_instanced && !light)
+            {
+                // the number of survivors is only known on the gpu, so these don't contribute to the triangle count
+                if (gpu_culling::Buffers* buffers = gpu_culling::get_culled(renderable))
+                {
+                    cmd_list->SetBufferVertex(buffers->frame->instances_visible.get(), 1);
+                    cmd_list->DrawIndexedIndirect(buffers->frame->arguments.get());
+                    cmd_list->SetIgnoreClearValues(true);
+                    return;
+                }
+            }
+
             if (draw_instanced)
             {
                 for (uint32_t group_index = 0; group_index < renderable->GetInstancePartitionCount(); group_index++)
@@ -301,12 +469,13 @@ namespace Spartan
                     if (instance_count > 0)
                     {
                         cmd_list->DrawIndexed(
-                            renderable->GetIndexCount(),
-                            renderable->GetIndexOffset(),
+                            renderable->GetLodIndexCount(),
+                            renderable->GetLodIndexOffset(),
                             renderable->GetVertexOffset(),
                             instance_start_index,
                             instance_count
                         );
+                        Profiler::m_renderer_triangles += renderable->GetLodIndexCount() / 3 * instance_count;
                     }
 
                     instance_start_index = group_end_index;
@@ -315,15 +484,359 @@ namespace Spartan
             else 
             {
                 cmd_list->DrawIndexed(
-                    renderable->GetIndexCount(),
-                    renderable->GetIndexOffset(),
+                    renderable->GetLodIndexCount(),
+                    renderable->GetLodIndexOffset(),
                     renderable->GetVertexOffset()
                 );
+                Profiler::m_renderer_triangles += renderable->GetLodIndexCount() / 3;
             }
 
             cmd_list->SetIgnoreClearValues(true);
         }
 
+        namespace draw_list
+        {
+            // everything a pass needs to record a draw, resolved ahead of recording
+            struct DrawPacket
+            {
+                Entity* entity         = nullptr;
+                Renderable* renderable = nullptr;
+                Material* material     = nullptr;
+
+                // set when the packet stands for a batch of entities (see auto_instancing)
+                RHI_VertexBuffer* instance_buffer = nullptr;
+                uint32_t instance_start           = 0;
+                uint32_t instance_count           = 0;
+
+                bool is_instanced() const { return instance_count != 0 || renderable->HasInstancing(); }
+            };
+
+            // the meshes are split into fixed size chunks, each chunk writes to its own slot and the
+            // slots are concatenated in order, so the output is identical regardless of thread count
+            const uint32_t meshes_per_chunk = 128;
+            vector<vector<DrawPacket>> chunk_packets;
+
+            // the packets of each pass, they keep their capacity across frames
+            vector<DrawPacket> packets_shadow_maps;
+            vector<DrawPacket> packets_shadow_casters;
+            array<vector<DrawPacket>, 2> packets_shadow_dynamic;
+            vector<DrawPacket> packets_depth_prepass;
+            vector<DrawPacket> packets_gbuffer;
+
+            void build(const int64_t index_start, const int64_t index_end, vector<DrawPacket>& packets, const function<bool(Renderable*, Material*)>& filter)
+            {
+                Stopwatch stopwatch;
+                packets.clear();
+
+                vector<shared_ptr<Entity>>& meshes = Renderer::GetEntities()[Renderer_Entity::Mesh];
+                int64_t end                        = min(index_end, static_cast<int64_t>(meshes.size())); // can be out of range during async loading
+                if (end <= index_start)
+                    return;
+
+                uint32_t mesh_count  = static_cast<uint32_t>(end - index_start);
+                uint32_t chunk_count = (mesh_count + meshes_per_chunk - 1) / meshes_per_chunk;
+                if (chunk_packets.size() < chunk_count)
+                {
+                    chunk_packets.resize(chunk_count);
+                }
+
+                auto build_chunks = [&](uint32_t chunk_start, uint32_t chunk_end)
+                {
+                    for (uint32_t chunk = chunk_start; chunk < chunk_end; chunk++)
+                    {
+                        vector<DrawPacket>& chunk_out = chunk_packets[chunk];
+                        chunk_out.clear();
+
+                        uint32_t mesh_start = chunk * meshes_per_chunk;
+                        uint32_t mesh_end   = min(mesh_start + meshes_per_chunk, mesh_count);
+                        for (uint32_t i = mesh_start; i < mesh_end; i++)
+                        {
+                            Entity* entity         = meshes[index_start + i].get();
+                            Renderable* renderable = entity->GetComponent<Renderable>().get();
+                            Material* material     = renderable ? renderable->GetMaterial() : nullptr;
+                            if (!renderable || !material || !filter(renderable, material))
+                                continue;
+
+                            chunk_out.push_back({ entity, renderable, material });
+                        }
+                    }
+                };
+
+                if (chunk_count > 1 && ThreadPool::GetIdleThreadCount() > 0)
+                {
+                    ThreadPool::ParallelLoop(build_chunks, chunk_count);
+                }
+                else
+                {
+                    build_chunks(0, chunk_count);
+                }
+
+                for (uint32_t chunk = 0; chunk < chunk_count; chunk++)
+                {
+                    packets.insert(packets.end(), chunk_packets[chunk].begin(), chunk_packets[chunk].end());
+                }
+
+                Profiler::m_renderer_draw_packets           += static_cast<uint32_t>(packets.size());
+                Profiler::m_renderer_time_draw_list_build_ms += stopwatch.GetElapsedTimeMs();
+            }
+
+            // recording is split across secondary command lists when each of them gets enough packets to
+            // be worth beginning and executing, smaller lists are recorded inline on the primary
+            const uint32_t packets_per_secondary = 256;
+            array<RHI_CommandList*, rhi_max_secondary_cmd_lists> secondaries;
+
+            // record_range() records a range of the packets on the command list it's given, it can run on any thread and it
+            // has to set the pipeline state first, as a secondary inherits nothing from the primary besides the render targets
+            void record(RHI_CommandList* cmd_list, RHI_PipelineState& pso, const vector<DrawPacket>& packets, const function<void(RHI_CommandList*, uint32_t, uint32_t)>& record_range)
+            {
+                Stopwatch stopwatch;
+
+                uint32_t packet_count    = static_cast<uint32_t>(packets.size());
+                uint32_t secondary_count = min(packet_count / packets_per_secondary, min(ThreadPool::GetIdleThreadCount(), static_cast<uint32_t>(secondaries.size())));
+                if (secondary_count < 2)
+                {
+                    record_range(cmd_list, 0, packet_count);
+                }
+                else
+                {
+                    // begin the render pass on the primary, the secondaries continue it
+                    cmd_list->SetPipelineState(pso);
+                    for (uint32_t i = 0; i < secondary_count; i++)
+                    {
+                        secondaries[i] = cmd_list->AcquireSecondary();
+                    }
+
+                    ThreadPool::ParallelLoop([&](uint32_t secondary_start, uint32_t secondary_end)
+                    {
+                        for (uint32_t i = secondary_start; i < secondary_end; i++)
+                        {
+                            secondaries[i]->BeginSecondary(cmd_list);
+                            record_range(secondaries[i], packet_count * i / secondary_count, packet_count * (i + 1) / secondary_count);
+                        }
+                    }, secondary_count);
+
+                    // executed in order, so the packets are drawn in the same order as when recording inline
+                    cmd_list->ExecuteSecondaries(secondaries.data(), secondary_count);
+                }
+
+                Profiler::m_renderer_time_draw_list_record_ms += stopwatch.GetElapsedTimeMs();
+            }
+        }
+
+        namespace auto_instancing
+        {
+            // non-instanced renderables which share a geometry range and a material are drawn with a single instanced draw,
+            // their transforms go to transient instance buffers which are paged, so that a buffer never has to be resized
+            // while a command list references it, and each frame in flight has its own set of pages
+            const uint32_t page_capacity  = 16384; // transforms
+            const uint32_t instance_start = 1;     // the vertex shaders treat an instance id of 0 as non-instanced
+
+            array<vector<shared_ptr<RHI_VertexBuffer>>, resources_frame_lifetime> pages;
+            uint32_t page_set  = 0;
+            uint32_t page      = 0;
+            uint32_t page_used = instance_start;
+
+            // batch lookup, reused across calls
+            unordered_map<uint64_t, uint32_t> batch_heads;
+            vector<uint32_t> batch_next;
+            vector<uint32_t> batch_tail;
+            vector<uint32_t> batch_size;
+            vector<draw_list::DrawPacket> packets_batched;
+
+            void begin_frame(const uint32_t resource_index)
+            {
+                page_set  = resource_index % resources_frame_lifetime;
+                page      = 0;
+                page_used = instance_start;
+            }
+
+            Matrix* allocate(const uint32_t count, RHI_VertexBuffer** buffer, uint32_t* start)
+            {
+                SP_ASSERT(count <= page_capacity - instance_start);
+
+                if (page_used + count > page_capacity)
+                {
+                    page++;
+                    page_used = instance_start;
+                }
+
+                vector<shared_ptr<RHI_VertexBuffer>>& set = pages[page_set];
+                if (page == set.size())
+                {
+                    set.emplace_back(make_shared<RHI_VertexBuffer>(true, "auto_instancing"));
+                    set.back()->CreateDynamic<Matrix>(page_capacity);
+                }
+
+                *buffer    = set[page].get();
+                *start     = page_used;
+                page_used += count;
+
+                return static_cast<Matrix*>((*buffer)->GetMappedData()) + *start;
+            }
+
+            bool is_batchable(const draw_list::DrawPacket& packet, const bool static_only)
+            {
+                // tessellation and moving entities (whose velocity comes from the previous transform) keep their own draws
+                if (packet.renderable->HasInstancing() || packet.material->IsTessellated())
+                    return false;
+
+                return !static_only || packet.entity->GetMatrix() == packet.entity->GetMatrixPrevious();
+            }
+
+            bool is_same_batch(const draw_list::DrawPacket& a, const draw_list::DrawPacket& b)
+            {
+                return a.material                         == b.material                         &&
+                       a.renderable->GetVertexBuffer()    == b.renderable->GetVertexBuffer()    &&
+                       a.renderable->GetLodIndexOffset()  == b.renderable->GetLodIndexOffset()  &&
+                       a.renderable->GetLodIndexCount()   == b.renderable->GetLodIndexCount()   &&
+                       a.renderable->GetVertexOffset()    == b.renderable->GetVertexOffset();
+            }
+
+            // replaces every group of packets which can be drawn together with a single packet, at the position of the
+            // group's first member, the rest keep their order, so the sort of the draw list is mostly preserved
+            void batch(vector<draw_list::DrawPacket>& packets, const bool static_only)
+            {
+                const uint32_t none  = numeric_limits<uint32_t>::max();
+                const uint32_t count = static_cast<uint32_t>(packets.size());
+                Profiler::m_renderer_draws_unbatched += count;
+                if (!Renderer::GetOption<bool>(Renderer_Option::AutoInstancing) || count < 2)
+                {
+                    Profiler::m_renderer_draws_batched += count;
+                    return;
+                }
+
+                // link the members of each batch, in draw list order
+                batch_heads.clear();
+                batch_next.assign(count, none);
+                batch_tail.assign(count, none);
+                batch_size.assign(count, 0);
+                for (uint32_t i = 0; i < count; i++)
+                {
+                    const draw_list::DrawPacket& packet = packets[i];
+                    if (!is_batchable(packet, static_only))
+                        continue;
+
+                    uint64_t key = rhi_hash_combine(reinterpret_cast<uint64_t>(packet.material), reinterpret_cast<uint64_t>(packet.renderable->GetVertexBuffer()));
+                    key          = rhi_hash_combine(key, packet.renderable->GetLodIndexOffset());
+                    key          = rhi_hash_combine(key, packet.renderable->GetVertexOffset());
+
+                    auto it = batch_heads.find(key);
+                    if (it == batch_heads.end())
+                    {
+                        batch_heads[key] = i;
+                        batch_tail[i]    = i;
+                        batch_size[i]    = 1;
+                    }
+                    else if (is_same_batch(packets[it->second], packet)) // a hash collision leaves the packet on its own
+                    {
+                        uint32_t head                = it->second;
+                        batch_next[batch_tail[head]] = i;
+                        batch_tail[head]             = i;
+                        batch_size[i]                = none; // a member, emitted with its head
+                        batch_size[head]++;
+                    }
+                }
+
+                packets_batched.clear();
+                for (uint32_t i = 0; i < count; i++)
+                {
+                    if (batch_size[i] == none)
+                        continue;
+
+                    if (batch_size[i] < 2)
+                    {
+                        packets_batched.push_back(packets[i]);
+                        continue;
+                    }
+
+                    // write the transforms, a batch larger than a page is split
+                    uint32_t member    = i;
+                    uint32_t remaining = batch_size[i];
+                    while (remaining != 0)
+                    {
+                        draw_list::DrawPacket packet = packets[i];
+                        packet.instance_count        = min(remaining, page_capacity - instance_start);
+                        Matrix* transforms           = allocate(packet.instance_count, &packet.instance_buffer, &packet.instance_start);
+                        for (uint32_t j = 0; j < packet.instance_count; j++)
+                        {
+                            // transposed, like Renderable::SetInstances, as the rows are bound as vertex attributes
+                            transforms[j] = packets[member].entity->GetMatrix().Transposed();
+                            member        = batch_next[member];
+                        }
+
+                        packets_batched.push_back(packet);
+                        remaining -= packet.instance_count;
+                    }
+                }
+
+                packets.swap(packets_batched);
+                Profiler::m_renderer_draws_batched += static_cast<uint32_t>(packets.size());
+            }
+
+            void draw(RHI_CommandList* cmd_list, const draw_list::DrawPacket& packet)
+            {
+                Renderable* renderable = packet.renderable;
+                cmd_list->DrawIndexed(
+                    renderable->GetLodIndexCount(),
+                    renderable->GetLodIndexOffset(),
+                    renderable->GetVertexOffset(),
+                    packet.instance_start,
+                    packet.instance_count
+                );
+                Profiler::m_renderer_triangles += renderable->GetLodIndexCount() / 3 * packet.instance_count;
+
+                cmd_list->SetIgnoreClearValues(true);
+            }
+        }
+
+        namespace shadow_cache
+        {
+            // casters which moved (or had their geometry changed) within this many frames are dynamic,
+            // they are drawn every frame on top of the cached static layer instead of being baked into it
+            const uint64_t dynamic_frames = 8;
+
+            // sorted, they keep their capacity so that steady state frames don't allocate
+            vector<uint64_t> dynamic_ids;
+            vector<uint64_t> dynamic_ids_previous;
+            size_t mesh_count_previous = 0;
+
+            bool is_dynamic_id(const uint64_t id)
+            {
+                return binary_search(dynamic_ids.begin(), dynamic_ids.end(), id);
+            }
+
+            bool is_dynamic(Entity* entity, Renderable* renderable)
+            {
+                uint64_t changed_frame = max(entity->GetTransformChangedFrame(), renderable->GetGeometryChangedFrame());
+                return Renderer::GetFrameNum() - changed_frame < dynamic_frames;
+            }
+
+            // returns true if a caster entered or left the static set, which invalidates every static layer
+            bool update(const vector<shared_ptr<Entity>>& meshes)
+            {
+                dynamic_ids_previous.swap(dynamic_ids);
+                dynamic_ids.clear();
+
+                for (const shared_ptr<Entity>& entity : meshes)
+                {
+                    Renderable* renderable = entity->GetComponent<Renderable>().get();
+                    if (!renderable || !renderable->HasFlag(RenderableFlags::CastsShadows))
+                        continue;
+
+                    if (is_dynamic(entity.get(), renderable))
+                    {
+                        dynamic_ids.emplace_back(entity->GetObjectId());
+                    }
+                }
+                sort(dynamic_ids.begin(), dynamic_ids.end());
+
+                bool changed        = meshes.size() != mesh_count_previous || dynamic_ids != dynamic_ids_previous;
+                mesh_count_previous = meshes.size();
+
+                return changed;
+            }
+        }
+
         void dynamic_resolution()
         {
             if (Renderer::GetOption<float>(Renderer_Option::DynamicResolution) != 0.0f)
@@ -350,6 +863,46 @@ namespace Spartan
         }
     }
 
+    void Renderer::DestroyPassResources()
+    {
+        release(visibility::draw_records);
+        release(visibility::draw_records_scratch);
+        release(visibility::renderables_scratch);
+        release(visibility::occluder_candidates);
+        release(visibility::occluders);
+
+        light_clusters::buffers.fill({});
+        light_clusters::buffers_frame = nullptr;
+        release(light_clusters::volumes);
+
+        release(gpu_culling::buffers);
+        release(gpu_culling::targets);
+
+        release(draw_list::chunk_packets);
+        release(draw_list::packets_shadow_maps);
+        release(draw_list::packets_shadow_casters);
+        release(draw_list::packets_shadow_dynamic[0]);
+        release(draw_list::packets_shadow_dynamic[1]);
+        release(draw_list::packets_depth_prepass);
+        release(draw_list::packets_gbuffer);
+
+        for (vector<shared_ptr<RHI_VertexBuffer>>& set : auto_instancing::pages)
+        {
+            release(set);
+        }
+        release(auto_instancing::batch_heads);
+        release(auto_instancing::batch_next);
+        release(auto_instancing::batch_tail);
+        release(auto_instancing::batch_size);
+        release(auto_instancing::packets_batched);
+
+        release(shadow_cache::dynamic_ids);
+        release(shadow_cache::dynamic_ids_previous);
+
+        OcclusionBuffer::Shutdown();
+        LightClusters::Shutdown();
+    }
+
     void Renderer::SetStandardResources(RHI_CommandList* cmd_list)
     {
         // these will only bind if needed
@@ -376,6 +929,7 @@ namespace Spartan
         RHI_Texture* rt_render_2 = GetRenderTarget(Renderer_RenderTarget::frame_render_2).get();
         RHI_Texture* rt_output   = GetRenderTarget(Renderer_RenderTarget::frame_output).get();
 
+        auto_instancing::begin_frame(m_resource_index);
         dynamic_resolution();
         Pass_VariableRateShading(cmd_list_graphics);
         Pass_Skysphere(cmd_list_graphics);
@@ -410,7 +964,9 @@ namespace Spartan
             // opaque
             {
                 Pass_Visibility(cmd_list_graphics);
+                Pass_Culling(cmd_list_graphics);
                 Pass_Depth_Prepass(cmd_list_graphics, false);
+                Pass_Culling(cmd_list_graphics, true); // again, against the depth of the pre-pass
                 Pass_GBuffer(cmd_list_graphics);
                 Pass_Ssgi(cmd_list_graphics);
                 Pass_Ssr(cmd_list_graphics, rt_render);
@@ -487,36 +1043,148 @@ namespace Spartan
         pso.shaders[Compute] = shader_c;
         cmd_list->SetPipelineState(pso);
 
-        // set textures
-        cmd_list->SetTexture(Renderer_BindingsSrv::tex, tex_in);
-        cmd_list->SetTexture(Renderer_BindingsUav::tex_uint, tex_out);
+        // set textures
+        cmd_list->SetTexture(Renderer_BindingsSrv::tex, tex_in);
+        cmd_list->SetTexture(Renderer_BindingsUav::tex_uint, tex_out);
+
+        // render
+        cmd_list->Dispatch(tex_out);
+
+        cmd_list->EndTimeblock();
+    }
+
+    void Renderer::Pass_ShadowMaps(RHI_CommandList* cmd_list, const bool is_transparent_pass)
+    {
+        // acquire resources
+        RHI_Shader* shader_v             = GetShader(Renderer_Shader::depth_light_v).get();
+        RHI_Shader* shader_alpha_color_p = GetShader(Renderer_Shader::depth_light_alpha_color_p).get();
+        auto& lights                     = m_renderables[Renderer_Entity::Light];
+        if (!shader_v->IsCompiled() || !shader_alpha_color_p->IsCompiled())
+            return;
+
+        lock_guard lock(m_mutex_renderables);
+        cmd_list->BeginTimeblock(is_transparent_pass ? "shadow_maps_alpha_color" : "shadow_maps_depth");
+
+        // set pso
+        static RHI_PipelineState pso;
+        pso.shaders[RHI_Shader_Type::Vertex] = shader_v;
+        pso.blend_state                      = is_transparent_pass ? GetBlendState(Renderer_BlendState::Alpha).get() : GetBlendState(Renderer_BlendState::Off).get();
+        pso.depth_stencil_state              = is_transparent_pass ? GetDepthStencilState(Renderer_DepthStencilState::Read).get() : GetDepthStencilState(Renderer_DepthStencilState::ReadWrite).get();
+        pso.name                             = is_transparent_pass ? "shadow_maps_alpha_color" : "shadow_maps_depth";
+        pso.clear_color[0]                   = rhi_color_load; // cleared explicitly, once per frame, since depth slices can be skipped
+
+        vector<draw_list::DrawPacket>& packets = draw_list::packets_shadow_maps;
+
+        // records the gathered packets into the currently set render targets
+        auto record = [cmd_list, shader_alpha_color_p, is_transparent_pass](Light* light, const uint32_t array_index)
+        {
+            // transparent casters blend, so they keep their order
+            if (!is_transparent_pass)
+            {
+                auto_instancing::batch(packets, false);
+            }
+
+            Camera* camera = GetCamera().get();
+            draw_list::record(cmd_list, pso, packets, [shader_alpha_color_p, is_transparent_pass, light, array_index, camera](RHI_CommandList* cmd_list, uint32_t packet_start, uint32_t packet_end)
+            {
+                // ranges can be recorded concurrently, so they work on their own pipeline state and pass constants
+                RHI_PipelineState pso_range = pso;
+                Pcb_Pass pcb_pass           = m_pcb_pass_cpu;
+
+                for (uint32_t i = packet_start; i < packet_end; i++)
+                {
+                    const draw_list::DrawPacket& packet = packets[i];
+                    Renderable* renderable              = packet.renderable;
+                    Material* material                  = packet.material;
+
+                    cmd_list->SetCullMode(static_cast<RHI_CullMode>(material->GetProperty(MaterialProperty::CullMode)));
+
+                    // set pipeline
+                    {
+                        bool needs_pixel_shader                   = material->IsAlphaTested() || is_transparent_pass;
+                        pso_range.shaders[RHI_Shader_Type::Pixel] = needs_pixel_shader ? shader_alpha_color_p : nullptr;
+
+                        pso_range.instancing = packet.is_instanced();
+
+                        cmd_list->SetPipelineState(pso_range);
+                    }
+
+                    // set vertex, index and instance buffers
+                    {
+                        cmd_list->SetBufferVertex(renderable->GetVertexBuffer());
+                        if (pso_range.instancing)
+                        {
+                            cmd_list->SetBufferVertex(packet.instance_buffer ? packet.instance_buffer : renderable->GetInstanceBuffer(), 1);
+                        }
+
+                        cmd_list->SetBufferIndex(renderable->GetIndexBuffer());
+                    }
+
+                    // set pass constants
+                    {
+                        // for the vertex shader, batches carry the transforms in their instances
+                        pcb_pass.set_f3_value2(static_cast<float>(light->GetIndex()), static_cast<float>(array_index), 0.0f);
+                        pcb_pass.transform = packet.instance_count ? Matrix::Identity : packet.entity->GetMatrix();
+
+                        // for the pixel shader
+                        pcb_pass.set_f3_value(
+                            material->HasTexture(MaterialTexture::AlphaMask) ? 1.0f : 0.0f,
+                            material->HasTexture(MaterialTexture::Color)     ? 1.0f : 0.0f
+                        );
+                        pcb_pass.set_is_transparent_and_material_index(is_transparent_pass, material->GetIndex());
+
+                        cmd_list->PushConstants(pcb_pass);
+                    }
 
-        // render
-        cmd_list->Dispatch(tex_out);
+                    if (packet.instance_count)
+                    {
+                        auto_instancing::draw(cmd_list, packet);
+                    }
+                    else
+                    {
+                        draw_renderable(cmd_list, pso_range, camera, renderable, light, array_index);
+                    }
+                }
+            });
+        };
 
-        cmd_list->EndTimeblock();
-    }
+        // when a caster enters or leaves the static set, every static layer has to be re-rendered
+        if (!is_transparent_pass && shadow_cache::update(m_renderables[Renderer_Entity::Mesh]))
+        {
+            for (shared_ptr<Entity>& light_entity : lights)
+            {
+                if (shared_ptr<Light> light = light_entity->GetComponent<Light>())
+                {
+                    light->SetShadowStaticDirty();
+                }
+            }
+        }
 
-    void Renderer::Pass_ShadowMaps(RHI_CommandList* cmd_list, const bool is_transparent_pass)
-    {
-        // acquire resources
-        RHI_Shader* shader_v             = GetShader(Renderer_Shader::depth_light_v).get();
-        RHI_Shader* shader_alpha_color_p = GetShader(Renderer_Shader::depth_light_alpha_color_p).get();
-        auto& lights                     = m_renderables[Renderer_Entity::Light];
-        if (!shader_v->IsCompiled() || !shader_alpha_color_p->IsCompiled())
-            return;
+        int64_t index_start = !is_transparent_pass ? 0 : mesh_index_transparent;
+        int64_t index_end   = !is_transparent_pass ? mesh_index_transparent : static_cast<int64_t>(m_renderables[Renderer_Entity::Mesh].size());
 
-        lock_guard lock(m_mutex_renderables);
-        cmd_list->BeginTimeblock(is_transparent_pass ? "shadow_maps_alpha_color" : "shadow_maps_depth");
+        // the casters are gathered once, the frustum tests of a light's slice are too little work to split across threads
+        vector<draw_list::DrawPacket>& casters = draw_list::packets_shadow_casters;
+        draw_list::build(index_start, index_end, casters, [](Renderable* renderable, Material*)
+        {
+            return renderable->HasFlag(RenderableFlags::CastsShadows);
+        });
 
-        // set pso
-        static RHI_PipelineState pso;
-        pso.shaders[RHI_Shader_Type::Vertex] = shader_v;
-        pso.blend_state                      = is_transparent_pass ? GetBlendState(Renderer_BlendState::Alpha).get() : GetBlendState(Renderer_BlendState::Off).get();
-        pso.depth_stencil_state              = is_transparent_pass ? GetDepthStencilState(Renderer_DepthStencilState::Read).get() : GetDepthStencilState(Renderer_DepthStencilState::ReadWrite).get();
-        pso.name                             = is_transparent_pass ? "shadow_maps_alpha_color" : "shadow_maps_depth";
-        pso.clear_depth                      = 0.0f;
-        pso.clear_color[0]                   = Color::standard_white;
+        auto gather = [](Light* light, const uint32_t array_index, vector<draw_list::DrawPacket>& packets_out)
+        {
+            Stopwatch stopwatch;
+
+            packets_out.clear();
+            for (const draw_list::DrawPacket& packet : casters)
+            {
+                if (light->IsInViewFrustum(packet.renderable, array_index))
+                {
+                    packets_out.push_back(packet);
+                }
+            }
+
+            Profiler::m_renderer_time_draw_list_build_ms += stopwatch.GetElapsedTimeMs();
+        };
 
         // iterate over lights
         for (shared_ptr<Entity>& light_entity : lights)
@@ -529,10 +1197,14 @@ namespace Spartan
             if (is_transparent_pass && !light->IsFlagSet(LightFlags::ShadowsTransparent))
                 continue;
 
+            RHI_Texture* tex_depth        = light->GetDepthTexture();
+            RHI_Texture* tex_depth_static = light->GetDepthTextureStatic();
+            RHI_Texture* tex_color        = light->GetColorTexture();
+            uint32_t array_length         = tex_depth->GetArrayLength();
+
             // set light pso
             {
-                pso.render_target_color_textures[0] = light->GetColorTexture();
-                pso.render_target_depth_texture     = light->GetDepthTexture();
+                pso.render_target_color_textures[0] = tex_color;
                 if (light->GetLightType() == LightType::Directional)
                 {
                     // disable depth clipping so that we can capture silhouettes even behind the light
@@ -544,75 +1216,109 @@ namespace Spartan
                 }
             }
 
-            // iterate over light cascade/faces
-            for (uint32_t array_index = 0; array_index < pso.render_target_depth_texture->GetArrayLength(); array_index++)
+            // transparent casters are cheap and few, they are drawn every frame
+            if (is_transparent_pass)
             {
-                pso.render_target_array_index = array_index;
-                cmd_list->SetIgnoreClearValues(is_transparent_pass);
+                pso.render_target_depth_texture = tex_depth;
+                pso.clear_depth                 = rhi_depth_load;
 
-                // iterate over entities
-                int64_t index_start = !is_transparent_pass ? 0 : mesh_index_transparent;
-                int64_t index_end   = !is_transparent_pass ? mesh_index_transparent : static_cast<int64_t>(m_renderables[Renderer_Entity::Mesh].size());
-                for (int64_t i = index_start; i < index_end; i++)
+                for (uint32_t array_index = 0; array_index < array_length; array_index++)
                 {
-                    // this can happen during async loading
-                    if (i >= static_cast<int64_t>(m_renderables[Renderer_Entity::Mesh].size()))
-                        continue;
-
-                    shared_ptr<Entity>& entity        = m_renderables[Renderer_Entity::Mesh][i];
-                    shared_ptr<Renderable> renderable = entity->GetComponent<Renderable>();
-                    if (!renderable || !renderable->HasFlag(RenderableFlags::CastsShadows))
-                        continue;
+                    pso.render_target_array_index = array_index;
+                    cmd_list->SetIgnoreClearValues(true);
 
-                    if (!light->IsInViewFrustum(renderable.get(), array_index))
-                        continue;
+                    gather(light.get(), array_index, packets);
+                    record(light.get(), array_index);
+                }
 
-                    cmd_list->SetCullMode(static_cast<RHI_CullMode>(renderable->GetMaterial()->GetProperty(MaterialProperty::CullMode)));
+                continue;
+            }
 
-                    // set pipeline
-                    {
-                        bool needs_pixel_shader             = renderable->GetMaterial()->IsAlphaTested() || is_transparent_pass;
-                        pso.shaders[RHI_Shader_Type::Pixel] = needs_pixel_shader ? shader_alpha_color_p : nullptr;
+            if (tex_color)
+            {
+                cmd_list->ClearRenderTarget(tex_color, Color::standard_white);
+            }
 
-                        pso.instancing = renderable->HasInstancing();
+            // static layer, only the dirty slices are re-rendered
+            array<bool, 2> static_rendered = { false, false };
+            pso.render_target_depth_texture = tex_depth_static;
+            pso.clear_depth                 = 0.0f;
+            for (uint32_t array_index = 0; array_index < array_length; array_index++)
+            {
+                if (!light->IsShadowStaticDirty(array_index))
+                    continue;
 
-                        cmd_list->SetPipelineState(pso);
-                    }
+                gather(light.get(), array_index, packets);
 
-                    // set vertex, index and instance buffers
-                    {
-                        cmd_list->SetBufferVertex(renderable->GetVertexBuffer());
-                        if (pso.instancing)
-                        {
-                            cmd_list->SetBufferVertex(renderable->GetInstanceBuffer(), 1);
-                        }
+                // keep the static casters only
+                packets.erase(remove_if(packets.begin(), packets.end(), [](const draw_list::DrawPacket& packet)
+                {
+                    return shadow_cache::is_dynamic_id(packet.entity->GetObjectId());
+                }), packets.end());
+
+                // bind the pipeline with clearing enabled so that the slice is cleared even without any casters
+                pso.render_target_array_index       = array_index;
+                pso.shaders[RHI_Shader_Type::Pixel] = nullptr;
+                pso.instancing                      = false;
+                cmd_list->SetIgnoreClearValues(false);
+                cmd_list->SetPipelineState(pso);
+                cmd_list->SetIgnoreClearValues(true);
+
+                record(light.get(), array_index);
+
+                light->SetShadowStaticDirty(array_index, false);
+                static_rendered[array_index] = true;
+                Profiler::m_renderer_shadow_views_rendered++;
+            }
 
-                        cmd_list->SetBufferIndex(renderable->GetIndexBuffer());
-                    }
+            // dynamic casters, gathered per slice
+            array<vector<draw_list::DrawPacket>, 2>& dynamic_packets = draw_list::packets_shadow_dynamic;
+            bool has_dynamic_casters = false;
+            for (uint32_t array_index = 0; array_index < array_length; array_index++)
+            {
+                dynamic_packets[array_index].clear();
+                if (shadow_cache::dynamic_ids.empty())
+                    continue;
 
-                    // set pass constants
-                    {
-                        // for the vertex shader
-                        m_pcb_pass_cpu.set_f3_value2(static_cast<float>(light->GetIndex()), static_cast<float>(array_index), 0.0f);
-                        m_pcb_pass_cpu.transform = entity->GetMatrix();
+                gather(light.get(), array_index, dynamic_packets[array_index]);
 
-                        // for the pixel shader
-                        if (Material* material = renderable->GetMaterial())
-                        {
-                            m_pcb_pass_cpu.set_f3_value(
-                                material->HasTexture(MaterialTexture::AlphaMask) ? 1.0f : 0.0f,
-                                material->HasTexture(MaterialTexture::Color)     ? 1.0f : 0.0f
-                            );
+                vector<draw_list::DrawPacket>& slice_packets = dynamic_packets[array_index];
+                slice_packets.erase(remove_if(slice_packets.begin(), slice_packets.end(), [](const draw_list::DrawPacket& packet)
+                {
+                    return !shadow_cache::is_dynamic_id(packet.entity->GetObjectId());
+                }), slice_packets.end());
 
-                            m_pcb_pass_cpu.set_is_transparent_and_material_index(is_transparent_pass, material->GetIndex());
-                        }
+                has_dynamic_casters = has_dynamic_casters || !slice_packets.empty();
+            }
 
-                        cmd_list->PushConstants(m_pcb_pass_cpu);
-                    }
+            // nothing changed and no dynamic casters were drawn last frame, the shadow map is still valid
+            bool any_static_rendered = static_rendered[0] || static_rendered[1];
+            if (!any_static_rendered && !has_dynamic_casters && !light->HasShadowDynamicCasters())
+            {
+                Profiler::m_renderer_shadow_views_skipped += array_length;
+                continue;
+            }
 
-                    draw_renderable(cmd_list, pso, GetCamera().get(), renderable.get(), light.get(), array_index);
+            // composite, restore the static layer and draw the dynamic casters on top of it
+            cmd_list->Copy(tex_depth_static, tex_depth, false);
+            pso.render_target_depth_texture = tex_depth;
+            pso.clear_depth                 = rhi_depth_load;
+            for (uint32_t array_index = 0; array_index < array_length; array_index++)
+            {
+                if (dynamic_packets[array_index].empty())
+                {
+                    Profiler::m_renderer_shadow_views_skipped += static_rendered[array_index] ? 0 : 1;
+                    continue;
                 }
+
+                pso.render_target_array_index = array_index;
+                cmd_list->SetIgnoreClearValues(true);
+
+                packets.swap(dynamic_packets[array_index]);
+                record(light.get(), array_index);
+                Profiler::m_renderer_shadow_views_composited++;
             }
+            light->SetShadowDynamicCasters(has_dynamic_casters);
         }
 
         cmd_list->EndTimeblock();
@@ -630,7 +1336,125 @@ namespace Spartan
 
         if (GetOption<bool>(Renderer_Option::OcclusionCulling))
         {
-            visibility::determine_occluders(m_renderables[Renderer_Entity::Mesh]);
+            Stopwatch stopwatch;
+            visibility::occlusion_cull(m_renderables[Renderer_Entity::Mesh]);
+            Profiler::m_renderer_time_occlusion_ms = stopwatch.GetElapsedTimeMs();
+        }
+
+        // light clusters
+        {
+            Stopwatch stopwatch;
+            light_clusters::build(GetCamera().get(), m_renderables[Renderer_Entity::Light], m_resource_index);
+            Profiler::m_renderer_time_light_clusters_ms = stopwatch.GetElapsedTimeMs();
+        }
+
+        cmd_list->EndTimeblock();
+    }
+
+    void Renderer::Pass_Culling(RHI_CommandList* cmd_list, const bool occlusion)
+    {
+        if (!GetOption<bool>(Renderer_Option::GpuCulling))
+        {
+            gpu_culling::buffers.clear();
+            return;
+        }
+
+        // acquire resources
+        RHI_Shader* shader_c         = GetShader(occlusion ? Renderer_Shader::culling_occlusion_c : Renderer_Shader::culling_c).get();
+        RHI_Shader* shader_pyramid_c = GetShader(Renderer_Shader::culling_depth_pyramid_c).get();
+        RHI_Texture* tex_depth       = GetRenderTarget(Renderer_RenderTarget::gbuffer_depth).get();
+        RHI_Texture* tex_pyramid     = GetRenderTarget(Renderer_RenderTarget::depth_pyramid).get();
+        if (!shader_c->IsCompiled() || !shader_pyramid_c->IsCompiled())
+            return;
+
+        cmd_list->BeginTimeblock(occlusion ? "culling_occlusion" : "culling");
+
+        // depth pyramid
+        if (occlusion)
+        {
+            static RHI_PipelineState pso;
+            pso.name             = "culling_depth_pyramid";
+            pso.shaders[Compute] = shader_pyramid_c;
+            cmd_list->SetPipelineState(pso);
+
+            cmd_list->SetTexture(Renderer_BindingsSrv::gbuffer_depth, tex_depth);
+            cmd_list->SetTexture(Renderer_BindingsUav::tex, tex_pyramid, 0, 1);
+            cmd_list->Dispatch(tex_pyramid);
+
+            Pass_Ffx_Spd(cmd_list, tex_pyramid, Renderer_DownsampleFilter::Highest);
+        }
+
+        // gather the instanced opaque renderables which are at least partially in view
+        gpu_culling::evict();
+        gpu_culling::targets.clear();
+        {
+            lock_guard lock(m_mutex_renderables);
+
+            vector<shared_ptr<Entity>>& meshes = m_renderables[Renderer_Entity::Mesh];
+            int64_t index_end                  = min(mesh_index_transparent, static_cast<int64_t>(meshes.size()));
+            for (int64_t i = 0; i < index_end; i++)
+            {
+                Entity* entity         = meshes[i].get();
+                Renderable* renderable = entity->GetComponent<Renderable>().get();
+                if (!renderable || !renderable->GetMaterial() || !renderable->HasInstancing() || !renderable->IsVisible())
+                    continue;
+
+                gpu_culling::targets.emplace_back(renderable, &gpu_culling::acquire(entity, renderable, m_resource_index));
+            }
+        }
+
+        if (!gpu_culling::targets.empty())
+        {
+            // set pipeline state
+            static RHI_PipelineState pso;
+            pso.name             = occlusion ? "culling_occlusion" : "culling";
+            pso.shaders[Compute] = shader_c;
+            cmd_list->SetPipelineState(pso);
+
+            if (occlusion)
+            {
+                cmd_list->SetTexture(Renderer_BindingsSrv::tex, tex_pyramid);
+                m_pcb_pass_cpu.set_f3_value2(static_cast<float>(tex_pyramid->GetWidth()), static_cast<float>(tex_pyramid->GetHeight()), static_cast<float>(tex_pyramid->GetMipCount()));
+            }
+
+            auto dispatch = [cmd_list](Renderable* renderable, gpu_culling::Buffers* buffers, const bool reset)
+            {
+                // the arguments are passed as raw bits, floats can't represent large offsets exactly
+                m_pcb_pass_cpu.set_f3_value(static_cast<float>(renderable->GetInstanceCount()), reset ? 1.0f : 0.0f);
+                m_pcb_pass_cpu.set_f4_value(
+                    bit_cast<float>(renderable->GetLodIndexCount()),
+                    bit_cast<float>(renderable->GetLodIndexOffset()),
+                    bit_cast<float>(renderable->GetVertexOffset()),
+                    0.0f
+                );
+                cmd_list->PushConstants(m_pcb_pass_cpu);
+
+                cmd_list->SetStructuredBuffer(Renderer_BindingsUav::sb_culling_bounds,            buffers->frame->bounds);
+                cmd_list->SetStructuredBuffer(Renderer_BindingsUav::sb_culling_instances,         buffers->instances);
+                cmd_list->SetStructuredBuffer(Renderer_BindingsUav::sb_culling_instances_visible, buffers->frame->instances_visible);
+                cmd_list->SetStructuredBuffer(Renderer_BindingsUav::sb_culling_arguments,         buffers->frame->arguments);
+
+                uint32_t thread_group_count = reset ? 1 : (renderable->GetInstanceCount() + instance_culling::thread_group_size - 1) / instance_culling::thread_group_size;
+                cmd_list->Dispatch(thread_group_count, 1);
+            };
+
+            // previous draws read the outputs, so they have to complete before they are reset
+            cmd_list->InsertBarrierBufferReadWrite();
+            for (auto& [renderable, buffers] : gpu_culling::targets)
+            {
+                dispatch(renderable, buffers, true);
+            }
+
+            // cull
+            cmd_list->InsertBarrierBufferReadWrite();
+            for (auto& [renderable, buffers] : gpu_culling::targets)
+            {
+                dispatch(renderable, buffers, false);
+                buffers->culled_frame = GetFrameNum();
+            }
+
+            // make the outputs visible to the indirect draws
+            cmd_list->InsertBarrierBufferReadWrite();
         }
 
         cmd_list->EndTimeblock();
@@ -652,98 +1476,114 @@ namespace Spartan
 
         auto pass = [cmd_list, shader_h, shader_d, shader_p](RHI_PipelineState& pso, bool is_transparent_pass, bool is_back_face_pass)
         {
-            bool set_pipeline   = true;
+            vector<draw_list::DrawPacket>& packets = draw_list::packets_depth_prepass;
+
+            // gather
             int64_t index_start = !is_transparent_pass ? 0 : mesh_index_transparent;
             int64_t index_end   = !is_transparent_pass ? mesh_index_transparent : static_cast<int64_t>(m_renderables[Renderer_Entity::Mesh].size());
-            for (int64_t i = index_start; i < index_end; i++)
+            draw_list::build(index_start, index_end, packets, [is_back_face_pass](Renderable* renderable, Material* material)
             {
-                // this can happen during async loading
-                if (i >= static_cast<int64_t>(m_renderables[Renderer_Entity::Mesh].size()))
-                    continue;
+                if (!renderable->IsVisible())
+                    return false;
 
-                shared_ptr<Entity>& entity        = m_renderables[Renderer_Entity::Mesh][i];
-                shared_ptr<Renderable> renderable = entity->GetComponent<Renderable>();
-                if (!renderable || renderable->HasFlag(RenderableFlags::OccludedCpu))
-                    continue;
+                // the back face pass is only needed for subsurface scattering
+                return !is_back_face_pass || material->GetProperty(MaterialProperty::SubsurfaceScattering) != 0;
+            });
 
-                // toggles
+            if (!is_transparent_pass)
+            {
+                auto_instancing::batch(packets, false);
+            }
+
+            // record
+            Camera* camera = GetCamera().get();
+            draw_list::record(cmd_list, pso, packets, [&pso, shader_h, shader_d, shader_p, is_transparent_pass, is_back_face_pass, camera](RHI_CommandList* cmd_list, uint32_t packet_start, uint32_t packet_end)
+            {
+                // ranges can be recorded concurrently, so they work on their own pipeline state and pass constants
+                RHI_PipelineState pso_range = pso;
+                Pcb_Pass pcb_pass           = m_pcb_pass_cpu;
+                bool set_pipeline           = true;
+
+                for (uint32_t i = packet_start; i < packet_end; i++)
                 {
-                    // instancing
-                    if (pso.instancing != renderable->HasInstancing())
-                    {
-                        pso.instancing   = renderable->HasInstancing();
-                        pso.shaders[RHI_Shader_Type::Pixel] = pso.instancing ? shader_p : nullptr; // vegetation is instanced and uses alpha testing (not ideal way to handle this)
-                        set_pipeline     = true;
-                    }
+                    const draw_list::DrawPacket& packet = packets[i];
+                    Renderable* renderable              = packet.renderable;
+                    Material* material                  = packet.material;
 
-                    // tessellation & culling
-                    if (Material* material = renderable->GetMaterial())
+                    // toggles
                     {
-                        bool has_sss = renderable->GetMaterial()->GetProperty(MaterialProperty::SubsurfaceScattering) != 0;
-                        if (is_back_face_pass && !has_sss)
-                            continue;
+                        // instancing
+                        if (pso_range.instancing != packet.is_instanced())
+                        {
+                            pso_range.instancing = packet.is_instanced();
+                            set_pipeline         = true;
+                        }
 
-                        RHI_CullMode cull_mode = (is_back_face_pass && has_sss) ? RHI_CullMode::Front : static_cast<RHI_CullMode>(material->GetProperty(MaterialProperty::CullMode));
-                        cull_mode              = (pso.rasterizer_state->GetPolygonMode() == RHI_PolygonMode::Wireframe) ? RHI_CullMode::None : cull_mode;
-                        cmd_list->SetCullMode(cull_mode);
+                        // alpha testing, only those materials need a pixel shader
+                        RHI_Shader* shader_pixel = material->IsAlphaTested() ? shader_p : nullptr;
+                        if (pso_range.shaders[RHI_Shader_Type::Pixel] != shader_pixel)
+                        {
+                            pso_range.shaders[RHI_Shader_Type::Pixel] = shader_pixel;
+                            set_pipeline                              = true;
+                        }
 
-                        bool is_tessellated = material->IsTessellated();
-                        if ((is_tessellated && !pso.shaders[RHI_Shader_Type::Hull]) || (!is_tessellated && pso.shaders[RHI_Shader_Type::Hull]))
+                        // tessellation & culling
                         {
-                            pso.shaders[RHI_Shader_Type::Hull]   = is_tessellated ? shader_h : nullptr;
-                            pso.shaders[RHI_Shader_Type::Domain] = is_tessellated ? shader_d : nullptr;
-                            set_pipeline       = true;
+                            RHI_CullMode cull_mode = is_back_face_pass ? RHI_CullMode::Front : static_cast<RHI_CullMode>(material->GetProperty(MaterialProperty::CullMode));
+                            cull_mode              = (pso_range.rasterizer_state->GetPolygonMode() == RHI_PolygonMode::Wireframe) ? RHI_CullMode::None : cull_mode;
+                            cmd_list->SetCullMode(cull_mode);
+
+                            bool is_tessellated = material->IsTessellated();
+                            if ((is_tessellated && !pso_range.shaders[RHI_Shader_Type::Hull]) || (!is_tessellated && pso_range.shaders[RHI_Shader_Type::Hull]))
+                            {
+                                pso_range.shaders[RHI_Shader_Type::Hull]   = is_tessellated ? shader_h : nullptr;
+                                pso_range.shaders[RHI_Shader_Type::Domain] = is_tessellated ? shader_d : nullptr;
+                                set_pipeline                               = true;
+                            }
                         }
-                    }
 
-                    if (set_pipeline)
-                    {
-                        cmd_list->SetPipelineState(pso);
-                        set_pipeline = false;
+                        if (set_pipeline)
+                        {
+                            cmd_list->SetPipelineState(pso_range);
+                            set_pipeline = false;
+                        }
                     }
-                }
 
-                // set vertex, index and instance buffers
-                {
-                    cmd_list->SetBufferVertex(renderable->GetVertexBuffer());
-                    if (pso.instancing)
+                    // set vertex, index and instance buffers
                     {
-                        cmd_list->SetBufferVertex(renderable->GetInstanceBuffer(), 1);
-                    }
+                        cmd_list->SetBufferVertex(renderable->GetVertexBuffer());
+                        if (pso_range.instancing)
+                        {
+                            cmd_list->SetBufferVertex(packet.instance_buffer ? packet.instance_buffer : renderable->GetInstanceBuffer(), 1);
+                        }
 
-                    cmd_list->SetBufferIndex(renderable->GetIndexBuffer());
-                }
+                        cmd_list->SetBufferIndex(renderable->GetIndexBuffer());
+                    }
 
-                // set pass constants
-                {
-                    if (Material* material = renderable->GetMaterial())
+                    // set pass constants
                     {
                         // for alpha testing
-                        m_pcb_pass_cpu.set_f3_value(
+                        pcb_pass.set_f3_value(
                             material->HasTexture(MaterialTexture::AlphaMask) ? 1.0f : 0.0f,
                             material->HasTexture(MaterialTexture::Color)     ? 1.0f : 0.0f,
                             material->GetProperty(MaterialProperty::ColorA)
                         );
+                        pcb_pass.set_is_transparent_and_material_index(is_transparent_pass, material->GetIndex());
 
-                        m_pcb_pass_cpu.set_is_transparent_and_material_index(is_transparent_pass, material->GetIndex());
+                        pcb_pass.transform = packet.instance_count ? Matrix::Identity : packet.entity->GetMatrix();
+                        cmd_list->PushConstants(pcb_pass);
                     }
 
-                    m_pcb_pass_cpu.transform = entity->GetMatrix();
-                    cmd_list->PushConstants(m_pcb_pass_cpu);
-                }
-
-                if (GetOption<bool>(Renderer_Option::OcclusionCulling) && !is_transparent_pass)
-                {
-                    cmd_list->BeginOcclusionQuery(entity->GetObjectId());
-                }
-
-                draw_renderable(cmd_list, pso, GetCamera().get(), renderable.get());
-
-                if (GetOption<bool>(Renderer_Option::OcclusionCulling) && !is_transparent_pass)
-                {
-                    cmd_list->EndOcclusionQuery();
+                    if (packet.instance_count)
+                    {
+                        auto_instancing::draw(cmd_list, packet);
+                    }
+                    else
+                    {
+                        draw_renderable(cmd_list, pso_range, camera, renderable);
+                    }
                 }
-            }
+            });
         };
 
         cmd_list->BeginTimeblock(!is_transparent_pass ? "depth_prepass" : "depth_prepass_transparent");
@@ -770,7 +1610,6 @@ namespace Spartan
         {
             cmd_list->SetIgnoreClearValues(false);
             pass(pso, false, false);
-            visibility::get_gpu_occlusion_query_results(cmd_list, m_renderables);
             cmd_list->Blit(tex_depth, tex_depth_opaque, false);
         }
         else // transparent
@@ -841,75 +1680,106 @@ namespace Spartan
         cmd_list->SetPipelineState(pso);
 
         lock_guard lock(m_mutex_renderables);
+
+        // gather
+        vector<draw_list::DrawPacket>& packets = draw_list::packets_gbuffer;
         int64_t index_start = !is_transparent_pass ? 0 : mesh_index_transparent;
         int64_t index_end   = !is_transparent_pass ? mesh_index_transparent : static_cast<int64_t>(m_renderables[Renderer_Entity::Mesh].size());
-        for (int64_t i = index_start; i < index_end; i++)
+        draw_list::build(index_start, index_end, packets, [](Renderable* renderable, Material*)
         {
-            // this can happen during async loading
-            if (i >= static_cast<int64_t>(m_renderables[Renderer_Entity::Mesh].size()))
-                continue;
+            return renderable->IsVisible();
+        });
 
-            shared_ptr<Entity>& entity        = m_renderables[Renderer_Entity::Mesh][i];
-            shared_ptr<Renderable> renderable = entity->GetComponent<Renderable>();
-            if (!renderable || !renderable->IsVisible())
-                continue;
+        // only static entities are batched, the velocity of moving ones comes from their previous transform
+        if (!is_transparent_pass)
+        {
+            auto_instancing::batch(packets, true);
+        }
+
+        // record
+        Camera* camera = GetCamera().get();
+        draw_list::record(cmd_list, pso, packets, [shader_h, shader_d, is_transparent_pass, is_wireframe, camera](RHI_CommandList* cmd_list, uint32_t packet_start, uint32_t packet_end)
+        {
+            // ranges can be recorded concurrently, so they work on their own pipeline state and pass constants
+            RHI_PipelineState pso_range = pso;
+            Pcb_Pass pcb_pass           = m_pcb_pass_cpu;
+            bool set_pipeline           = true;
 
-            // toggles
+            for (uint32_t i = packet_start; i < packet_end; i++)
             {
-                bool toggled = false;
+                const draw_list::DrawPacket& packet = packets[i];
+                Entity* entity                      = packet.entity;
+                Renderable* renderable              = packet.renderable;
+                Material* material                  = packet.material;
 
-                // instancing
-                if (pso.instancing != renderable->HasInstancing())
+                // toggles
                 {
-                    pso.instancing = renderable->HasInstancing();
-                    toggled        = true;
-                }
+                    // instancing
+                    if (pso_range.instancing != packet.is_instanced())
+                    {
+                        pso_range.instancing = packet.is_instanced();
+                        set_pipeline         = true;
+                    }
 
-                // tessellation & culling
-                if (Material* material = renderable->GetMaterial())
-                {
-                    RHI_CullMode cull_mode = static_cast<RHI_CullMode>(material->GetProperty(MaterialProperty::CullMode));
-                    cull_mode              = is_wireframe ? RHI_CullMode::None : cull_mode;
-                    cmd_list->SetCullMode(cull_mode);
+                    // tessellation & culling
+                    {
+                        RHI_CullMode cull_mode = static_cast<RHI_CullMode>(material->GetProperty(MaterialProperty::CullMode));
+                        cull_mode              = is_wireframe ? RHI_CullMode::None : cull_mode;
+                        cmd_list->SetCullMode(cull_mode);
+
+                        bool is_tessellated = material->IsTessellated();
+                        if ((is_tessellated && !pso_range.shaders[RHI_Shader_Type::Hull]) || (!is_tessellated && pso_range.shaders[RHI_Shader_Type::Hull]))
+                        {
+                            pso_range.shaders[RHI_Shader_Type::Hull]   = is_tessellated ? shader_h : nullptr;
+                            pso_range.shaders[RHI_Shader_Type::Domain] = is_tessellated ? shader_d : nullptr;
+                            set_pipeline                               = true;
+                        }
+                    }
 
-                    bool is_tessellated = material->IsTessellated();
-                    if ((is_tessellated && !pso.shaders[RHI_Shader_Type::Hull]) || (!is_tessellated && pso.shaders[RHI_Shader_Type::Hull]))
+                    if (set_pipeline)
                     {
-                        pso.shaders[RHI_Shader_Type::Hull]   = is_tessellated ? shader_h : nullptr;
-                        pso.shaders[RHI_Shader_Type::Domain] = is_tessellated ? shader_d : nullptr;
-                        toggled           = true;
+                        cmd_list->SetPipelineState(pso_range);
+                        set_pipeline = false;
                     }
                 }
 
-                if (toggled)
+                // set vertex, index and instance buffers
                 {
-                    cmd_list->SetPipelineState(pso);
+                    cmd_list->SetBufferVertex(renderable->GetVertexBuffer());
+                    if (pso_range.instancing)
+                    {
+                        cmd_list->SetBufferVertex(packet.instance_buffer ? packet.instance_buffer : renderable->GetInstanceBuffer(), 1);
+                    }
+
+                    cmd_list->SetBufferIndex(renderable->GetIndexBuffer());
                 }
-            }
 
-            // set vertex, index and instance buffers
-            {
-                cmd_list->SetBufferVertex(renderable->GetVertexBuffer());
-                if (pso.instancing)
+                // batches are static, their transforms are in the instances and the previous ones are the same
+                if (packet.instance_count)
                 {
-                    cmd_list->SetBufferVertex(renderable->GetInstanceBuffer(), 1);
+                    pcb_pass.transform = Matrix::Identity;
+                    pcb_pass.set_transform_previous(Matrix::Identity);
+                    pcb_pass.set_is_transparent_and_material_index(is_transparent_pass, material->GetIndex());
+                    cmd_list->PushConstants(pcb_pass);
+
+                    auto_instancing::draw(cmd_list, packet);
+                    continue;
                 }
 
-                cmd_list->SetBufferIndex(renderable->GetIndexBuffer());
-            }
+                // set pass constants
+                {
+                    pcb_pass.transform = entity->GetMatrix();
+                    pcb_pass.set_transform_previous(entity->GetMatrixPrevious());
+                    pcb_pass.set_is_transparent_and_material_index(is_transparent_pass, material->GetIndex());
+                    cmd_list->PushConstants(pcb_pass);
 
-            // set pass constants
-            {
-                m_pcb_pass_cpu.transform = entity->GetMatrix();
-                m_pcb_pass_cpu.set_transform_previous(entity->GetMatrixPrevious());
-                m_pcb_pass_cpu.set_is_transparent_and_material_index(is_transparent_pass, renderable->GetMaterial()->GetIndex());
-                cmd_list->PushConstants(m_pcb_pass_cpu);
+                    // an entity is in a single packet, so this doesn't race
+                    entity->SetMatrixPrevious(pcb_pass.transform);
+                }
 
-                entity->SetMatrixPrevious(m_pcb_pass_cpu.transform);
+                draw_renderable(cmd_list, pso_range, camera, renderable);
             }
-
-            draw_renderable(cmd_list, pso, GetCamera().get(), renderable.get());
-        }
+        });
 
         cmd_list->EndTimeblock();
     }
@@ -1146,6 +2016,13 @@ namespace Spartan
    
         SetGbufferTextures(cmd_list);
 
+        // the per-cluster light lists, see LightClusters.h
+        if (light_clusters::buffers_frame)
+        {
+            cmd_list->SetStructuredBuffer(Renderer_BindingsUav::sb_light_clusters,        light_clusters::buffers_frame->clusters);
+            cmd_list->SetStructuredBuffer(Renderer_BindingsUav::sb_light_cluster_indices, light_clusters::buffers_frame->indices);
+        }
+
         // iterate through all the lights
         for (uint32_t light_index = 0; light_index < light_count; light_index++)
         {
@@ -1163,6 +2040,14 @@ namespace Spartan
                 if (light->GetIntensityWatt() == 0.0f)
                     continue;
 
+                // no cluster in view can be reached by the light
+                bool is_clustered = light_clusters::buffers_frame && light->GetLightType() != LightType::Directional;
+                if (is_clustered && !LightClusters::IsLightVisible(light->GetIndex()))
+                {
+                    Profiler::m_renderer_lights_culled += is_transparent_pass ? 0 : 1;
+                    continue;
+                }
+
                 // set shadow maps
                 {
                     RHI_Texture* tex_depth = light->IsFlagSet(LightFlags::Shadows)            ? light->GetDepthTexture() : nullptr;
@@ -1175,7 +2060,7 @@ namespace Spartan
 
                 // push pass constants
                 m_pcb_pass_cpu.set_is_transparent_and_material_index(is_transparent_pass);
-                m_pcb_pass_cpu.set_f3_value2(static_cast<float>(light->GetIndex()), 0.0f, 0.0f);
+                m_pcb_pass_cpu.set_f3_value2(static_cast<float>(light->GetIndex()), 0.0f, is_clustered ? 1.0f : 0.0f);
                 m_pcb_pass_cpu.set_f3_value(GetOption<float>(Renderer_Option::Fog), GetOption<float>(Renderer_Option::ShadowResolution), 0.0f);
                 cmd_list->PushConstants(m_pcb_pass_cpu);
                 
@@ -25,6 +25,7 @@ CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 #include "Renderer.h"
 #include "Geometry.h"
 #include "ThreadPool.h"
+#include "InstanceCulling.h"
 #include "../World/Components/Light.h"
 #include "../Resource/ResourceCache.h"
 #include "../RHI/RHI_Texture2D.h"
@@ -52,9 +53,9 @@ namespace Spartan
     namespace
     {
         // graphics states
-        array<shared_ptr<RHI_RasterizerState>, 4>                                                        rasterizer_states;
+        array<shared_ptr<RHI_RasterizerState>, static_cast<uint32_t>(Renderer_RasterizerState::Max)>     rasterizer_states;
         array<shared_ptr<RHI_DepthStencilState>, static_cast<uint32_t>(Renderer_DepthStencilState::Max)> depth_stencil_states;
-        array<shared_ptr<RHI_BlendState>, 3>                                                             blend_states;
+        array<shared_ptr<RHI_BlendState>, static_cast<uint32_t>(Renderer_BlendState::Max)>               blend_states;
 
         // renderer resources
         array<shared_ptr<RHI_Texture>, static_cast<uint32_t>(Renderer_RenderTarget::max)> render_targets;
@@ -253,6 +254,14 @@ namespace Spartan
             render_target(Renderer_RenderTarget::sss)  = make_shared<RHI_Texture2DArray>(width_render, height_render, RHI_Format::R16_Float, 4, flags | RHI_Texture_ClearBlit, "sss");
             render_target(Renderer_RenderTarget::ssgi) = make_unique<RHI_Texture2D>(width_render, height_render, 1, RHI_Format::R16G16B16A16_Float, flags, "ssgi");
 
+            // hi-z, a power of two so that every mip is an exact 2x2 reduction (see InstanceCulling.h)
+            {
+                uint32_t width_pyramid     = instance_culling::get_pyramid_dimension(width_render);
+                uint32_t height_pyramid    = instance_culling::get_pyramid_dimension(height_render);
+                uint32_t mip_count_pyramid = instance_culling::get_pyramid_mip_count(width_pyramid, height_pyramid);
+                render_target(Renderer_RenderTarget::depth_pyramid) = make_shared<RHI_Texture2D>(width_pyramid, height_pyramid, mip_count_pyramid, RHI_Format::R32_Float, flags | RHI_Texture_PerMipViews, "depth_pyramid");
+            }
+
             if (RHI_Device::PropertyIsShadingRateSupported())
             { 
                 render_target(Renderer_RenderTarget::shading_rate) = make_unique<RHI_Texture2D>(width_render / 4, height_render / 4, 1, RHI_Format::R8_Uint, RHI_Texture_Srv | RHI_Texture_Uav | RHI_Texture_Rtv | RHI_Texture_Vrs, "shading_rate");
@@ -289,209 +298,155 @@ namespace Spartan
     {
         const bool async        = true;
         const string shader_dir = ResourceCache::GetResourceDirectory(ResourceDirectory::Shaders) + "\\";
-        #define shader(x) shaders[static_cast<uint8_t>(x)]
+        const auto essential    = RHI_ShaderCompilationPriority::Essential;
+        const auto normal       = RHI_ShaderCompilationPriority::Normal;
 
-        // debug
+        // constants which are owned by the cpu side, they are passed as defines so that the two can't drift apart
+        const unordered_map<string, vector<pair<string, string>>> defines_shared =
         {
-            // line
-            shader(Renderer_Shader::line_v) = make_shared<RHI_Shader>();
-            shader(Renderer_Shader::line_v)->Compile(RHI_Shader_Type::Vertex, shader_dir + "line.hlsl", async, RHI_Vertex_Type::PosCol);
-            shader(Renderer_Shader::line_p) = make_shared<RHI_Shader>();
-            shader(Renderer_Shader::line_p)->Compile(RHI_Shader_Type::Pixel, shader_dir + "line.hlsl", async);
-
-            // grid
-            {
-                shader(Renderer_Shader::grid_v) = make_shared<RHI_Shader>();
-                shader(Renderer_Shader::grid_v)->Compile(RHI_Shader_Type::Vertex, shader_dir + "grid.hlsl", async, RHI_Vertex_Type::PosUvNorTan);
+            { "culling.hlsl", {
+                { "CULLING_THREAD_GROUP_SIZE", to_string(instance_culling::thread_group_size) },
+                { "CULLING_INSTANCE_OFFSET",   to_string(instance_culling::instance_offset) }
+            }}
+        };
 
-                shader(Renderer_Shader::grid_p) = make_shared<RHI_Shader>();
-                shader(Renderer_Shader::grid_p)->Compile(RHI_Shader_Type::Pixel, shader_dir + "grid.hlsl", async);
-            }
+        // identical permutations (file, stage, vertex type and defines) share a single shader
+        unordered_map<string, shared_ptr<RHI_Shader>> permutations;
+        auto compile = [&](const Renderer_Shader type, const RHI_Shader_Type stage, const string& file, const RHI_ShaderCompilationPriority priority, const RHI_Vertex_Type vertex_type = RHI_Vertex_Type::Max, const char* define = nullptr)
+        {
+            string key = file + "|" + to_string(static_cast<uint32_t>(stage)) + "|" + to_string(static_cast<uint32_t>(vertex_type)) + "|" + (define ? define : "");
 
-            // outline
+            shared_ptr<RHI_Shader>& shader = permutations[key];
+            if (!shader)
             {
-                shader(Renderer_Shader::outline_v) = make_shared<RHI_Shader>();
-                shader(Renderer_Shader::outline_v)->Compile(RHI_Shader_Type::Vertex, shader_dir + "outline.hlsl", async, RHI_Vertex_Type::PosUvNorTan);
-
-                shader(Renderer_Shader::outline_p) = make_shared<RHI_Shader>();
-                shader(Renderer_Shader::outline_p)->Compile(RHI_Shader_Type::Pixel, shader_dir + "outline.hlsl", async);
-
-                shader(Renderer_Shader::outline_c) = make_shared<RHI_Shader>();
-                shader(Renderer_Shader::outline_c)->Compile(RHI_Shader_Type::Compute, shader_dir + "outline.hlsl", async);
+                shader = make_shared<RHI_Shader>();
+                if (define)
+                {
+                    shader->AddDefine(define);
+                }
+
+                auto it = defines_shared.find(file);
+                if (it != defines_shared.end())
+                {
+                    for (const auto& [name, value] : it->second)
+                    {
+                        shader->AddDefine(name, value);
+                    }
+                }
+
+                shader->SetCompilationPriority(priority);
+                shader->Compile(stage, shader_dir + file, async, vertex_type);
             }
-        }
 
-        // depth pre-pass
-        {
-            shader(Renderer_Shader::depth_prepass_v) = make_shared<RHI_Shader>();
-            shader(Renderer_Shader::depth_prepass_v)->Compile(RHI_Shader_Type::Vertex, shader_dir + "depth_prepass.hlsl", async, RHI_Vertex_Type::PosUvNorTan);
-
-            shader(Renderer_Shader::depth_prepass_alpha_test_p) = make_shared<RHI_Shader>();
-            shader(Renderer_Shader::depth_prepass_alpha_test_p)->Compile(RHI_Shader_Type::Pixel, shader_dir + "depth_prepass.hlsl", async);
-        }
+            shaders[static_cast<uint8_t>(type)] = shader;
+        };
 
-        // light depth
+        // essential, these are needed to render the first frame, so they go to the front of the queue
         {
-            shader(Renderer_Shader::depth_light_v) = make_shared<RHI_Shader>();
-            shader(Renderer_Shader::depth_light_v)->Compile(RHI_Shader_Type::Vertex, shader_dir + "depth_light.hlsl", async, RHI_Vertex_Type::PosUvNorTan);
+            // depth pre-pass
+            compile(Renderer_Shader::depth_prepass_v,            RHI_Shader_Type::Vertex, "depth_prepass.hlsl", essential, RHI_Vertex_Type::PosUvNorTan);
+            compile(Renderer_Shader::depth_prepass_alpha_test_p, RHI_Shader_Type::Pixel,  "depth_prepass.hlsl", essential);
 
-            shader(Renderer_Shader::depth_light_alpha_color_p) = make_shared<RHI_Shader>();
-            shader(Renderer_Shader::depth_light_alpha_color_p)->Compile(RHI_Shader_Type::Pixel, shader_dir + "depth_light.hlsl", async);
-        }
+            // light depth
+            compile(Renderer_Shader::depth_light_v,             RHI_Shader_Type::Vertex, "depth_light.hlsl", essential, RHI_Vertex_Type::PosUvNorTan);
+            compile(Renderer_Shader::depth_light_alpha_color_p, RHI_Shader_Type::Pixel,  "depth_light.hlsl", essential);
 
-        // g-buffer
-        {
-            shader(Renderer_Shader::gbuffer_v) = make_shared<RHI_Shader>();
-            shader(Renderer_Shader::gbuffer_v)->Compile(RHI_Shader_Type::Vertex, shader_dir + "g_buffer.hlsl", async, RHI_Vertex_Type::PosUvNorTan);
+            // g-buffer
+            compile(Renderer_Shader::gbuffer_v, RHI_Shader_Type::Vertex, "g_buffer.hlsl", essential, RHI_Vertex_Type::PosUvNorTan);
+            compile(Renderer_Shader::gbuffer_p, RHI_Shader_Type::Pixel,  "g_buffer.hlsl", essential);
+
+            // tessellation
+            compile(Renderer_Shader::tessellation_h, RHI_Shader_Type::Hull,   "common_vertex_processing.hlsl", essential);
+            compile(Renderer_Shader::tessellation_d, RHI_Shader_Type::Domain, "common_vertex_processing.hlsl", essential);
 
-            shader(Renderer_Shader::gbuffer_p) = make_shared<RHI_Shader>();
-            shader(Renderer_Shader::gbuffer_p)->Compile(RHI_Shader_Type::Pixel, shader_dir + "g_buffer.hlsl", async);
+            // light
+            compile(Renderer_Shader::light_integration_brdf_specular_lut_c,  RHI_Shader_Type::Compute, "light_integration.hlsl", essential, RHI_Vertex_Type::Max, "BRDF_SPECULAR_LUT");
+            compile(Renderer_Shader::light_integration_environment_filter_c, RHI_Shader_Type::Compute, "light_integration.hlsl", essential, RHI_Vertex_Type::Max, "ENVIRONMENT_FILTER");
+            compile(Renderer_Shader::light_c,                                RHI_Shader_Type::Compute, "light.hlsl",             essential);
+            compile(Renderer_Shader::light_composition_c,                    RHI_Shader_Type::Compute, "light_composition.hlsl", essential);
+            compile(Renderer_Shader::light_image_based_c,                    RHI_Shader_Type::Compute, "light_image_based.hlsl", essential);
+
+            // amd fidelityfx spd - single pass downsample, used everywhere
+            compile(Renderer_Shader::ffx_spd_average_c,     RHI_Shader_Type::Compute, "amd_fidelity_fx\\spd.hlsl", essential, RHI_Vertex_Type::Max, "AVERAGE");
+            compile(Renderer_Shader::ffx_spd_highest_c,     RHI_Shader_Type::Compute, "amd_fidelity_fx\\spd.hlsl", essential, RHI_Vertex_Type::Max, "HIGHEST");
+            compile(Renderer_Shader::ffx_spd_antiflicker_c, RHI_Shader_Type::Compute, "amd_fidelity_fx\\spd.hlsl", essential, RHI_Vertex_Type::Max, "ANTIFLICKER");
+
+            // skysphere
+            compile(Renderer_Shader::skysphere_c, RHI_Shader_Type::Compute, "skysphere.hlsl", essential);
+
+            // tone-mapping & gamma correction
+            compile(Renderer_Shader::output_c, RHI_Shader_Type::Compute, "output.hlsl", essential);
         }
 
-        // tessellation
+        // instance culling
         {
-            shader(Renderer_Shader::tessellation_h) = make_shared<RHI_Shader>();
-            shader(Renderer_Shader::tessellation_h)->Compile(RHI_Shader_Type::Hull, shader_dir + "common_vertex_processing.hlsl", async);
-
-            shader(Renderer_Shader::tessellation_d) = make_shared<RHI_Shader>();
-            shader(Renderer_Shader::tessellation_d)->Compile(RHI_Shader_Type::Domain, shader_dir + "common_vertex_processing.hlsl", async);
+            compile(Renderer_Shader::culling_c,               RHI_Shader_Type::Compute, "culling.hlsl", normal);
+            compile(Renderer_Shader::culling_occlusion_c,     RHI_Shader_Type::Compute, "culling.hlsl", normal, RHI_Vertex_Type::Max, "OCCLUSION");
+            compile(Renderer_Shader::culling_depth_pyramid_c, RHI_Shader_Type::Compute, "culling.hlsl", normal, RHI_Vertex_Type::Max, "DEPTH_PYRAMID");
         }
 
-        // light
+        // debug
         {
-            // brdf specular lut - compile synchronously as it's needed immediately
-            shader(Renderer_Shader::light_integration_brdf_specular_lut_c) = make_shared<RHI_Shader>();
-            shader(Renderer_Shader::light_integration_brdf_specular_lut_c)->AddDefine("BRDF_SPECULAR_LUT");
-            shader(Renderer_Shader::light_integration_brdf_specular_lut_c)->Compile(RHI_Shader_Type::Compute, shader_dir + "light_integration.hlsl", false);
-
-            // environment prefilter - compile synchronously as it's needed immediately
-            shader(Renderer_Shader::light_integration_environment_filter_c) = make_shared<RHI_Shader>();
-            shader(Renderer_Shader::light_integration_environment_filter_c)->AddDefine("ENVIRONMENT_FILTER");
-            shader(Renderer_Shader::light_integration_environment_filter_c)->Compile(RHI_Shader_Type::Compute, shader_dir + "light_integration.hlsl", async);
-
-            // light
-            shader(Renderer_Shader::light_c) = make_shared<RHI_Shader>();
-            shader(Renderer_Shader::light_c)->Compile(RHI_Shader_Type::Compute, shader_dir + "light.hlsl", async);
+            // line
+            compile(Renderer_Shader::line_v, RHI_Shader_Type::Vertex, "line.hlsl", normal, RHI_Vertex_Type::PosCol);
+            compile(Renderer_Shader::line_p, RHI_Shader_Type::Pixel,  "line.hlsl", normal);
 
-            // composition
-            shader(Renderer_Shader::light_composition_c) = make_shared<RHI_Shader>();
-            shader(Renderer_Shader::light_composition_c)->Compile(RHI_Shader_Type::Compute, shader_dir + "light_composition.hlsl", async);
+            // grid
+            compile(Renderer_Shader::grid_v, RHI_Shader_Type::Vertex, "grid.hlsl", normal, RHI_Vertex_Type::PosUvNorTan);
+            compile(Renderer_Shader::grid_p, RHI_Shader_Type::Pixel,  "grid.hlsl", normal);
 
-            // image based
-            shader(Renderer_Shader::light_image_based_c) = make_shared<RHI_Shader>();
-            shader(Renderer_Shader::light_image_based_c)->Compile(RHI_Shader_Type::Compute, shader_dir + "light_image_based.hlsl", async);
+            // outline
+            compile(Renderer_Shader::outline_v, RHI_Shader_Type::Vertex,  "outline.hlsl", normal, RHI_Vertex_Type::PosUvNorTan);
+            compile(Renderer_Shader::outline_p, RHI_Shader_Type::Pixel,   "outline.hlsl", normal);
+            compile(Renderer_Shader::outline_c, RHI_Shader_Type::Compute, "outline.hlsl", normal);
         }
 
         // quad
-        {
-            shader(Renderer_Shader::quad_v) = make_shared<RHI_Shader>();
-            shader(Renderer_Shader::quad_v)->Compile(RHI_Shader_Type::Vertex, shader_dir + "quad.hlsl", async, RHI_Vertex_Type::PosUvNorTan);
-
-            shader(Renderer_Shader::quad_p) = make_shared<RHI_Shader>();
-            shader(Renderer_Shader::quad_p)->Compile(RHI_Shader_Type::Pixel, shader_dir + "quad.hlsl", async);
-        }
+        compile(Renderer_Shader::quad_v, RHI_Shader_Type::Vertex, "quad.hlsl", normal, RHI_Vertex_Type::PosUvNorTan);
+        compile(Renderer_Shader::quad_p, RHI_Shader_Type::Pixel,  "quad.hlsl", normal);
 
         // blur
-        {
-            // gaussian
-            shader(Renderer_Shader::blur_gaussian_c) = make_shared<RHI_Shader>();
-            shader(Renderer_Shader::blur_gaussian_c)->Compile(RHI_Shader_Type::Compute, shader_dir + "blur.hlsl", async);
-
-            // gaussian bilateral - or depth aware
-            shader(Renderer_Shader::blur_gaussian_bilaterial_c) = make_shared<RHI_Shader>();
-            shader(Renderer_Shader::blur_gaussian_bilaterial_c)->AddDefine("PASS_BLUR_GAUSSIAN_BILATERAL");
-            shader(Renderer_Shader::blur_gaussian_bilaterial_c)->Compile(RHI_Shader_Type::Compute, shader_dir + "blur.hlsl", async);
-        }
+        compile(Renderer_Shader::blur_gaussian_c,            RHI_Shader_Type::Compute, "blur.hlsl", normal);
+        compile(Renderer_Shader::blur_gaussian_bilaterial_c, RHI_Shader_Type::Compute, "blur.hlsl", normal, RHI_Vertex_Type::Max, "PASS_BLUR_GAUSSIAN_BILATERAL"); // depth aware
 
         // bloom
-        {
-            // downsample luminance
-            shader(Renderer_Shader::bloom_luminance_c) = make_shared<RHI_Shader>();
-            shader(Renderer_Shader::bloom_luminance_c)->AddDefine("LUMINANCE");
-            shader(Renderer_Shader::bloom_luminance_c)->Compile(RHI_Shader_Type::Compute, shader_dir + "bloom.hlsl", async);
-
-            // upsample blend (with previous mip)
-            shader(Renderer_Shader::bloom_upsample_blend_mip_c) = make_shared<RHI_Shader>();
-            shader(Renderer_Shader::bloom_upsample_blend_mip_c)->AddDefine("UPSAMPLE_BLEND_MIP");
-            shader(Renderer_Shader::bloom_upsample_blend_mip_c)->Compile(RHI_Shader_Type::Compute, shader_dir + "bloom.hlsl", async);
-
-            // upsample blend (with frame)
-            shader(Renderer_Shader::bloom_blend_frame_c) = make_shared<RHI_Shader>();
-            shader(Renderer_Shader::bloom_blend_frame_c)->AddDefine("BLEND_FRAME");
-            shader(Renderer_Shader::bloom_blend_frame_c)->Compile(RHI_Shader_Type::Compute, shader_dir + "bloom.hlsl", async);
-        }
-
-        // amd fidelityfx
-        {
-            // cas - contrast adaptive sharpening
-            shader(Renderer_Shader::ffx_cas_c) = make_shared<RHI_Shader>();
-            shader(Renderer_Shader::ffx_cas_c)->Compile(RHI_Shader_Type::Compute, shader_dir + "amd_fidelity_fx\\cas.hlsl", async);
-
-            // spd - single pass downsample - compile synchronously as they are needed everywhere
-            {
-                shader(Renderer_Shader::ffx_spd_average_c) = make_shared<RHI_Shader>();
-                shader(Renderer_Shader::ffx_spd_average_c)->AddDefine("AVERAGE");
-                shader(Renderer_Shader::ffx_spd_average_c)->Compile(RHI_Shader_Type::Compute, shader_dir + "amd_fidelity_fx\\spd.hlsl", false);
-
-                shader(Renderer_Shader::ffx_spd_highest_c) = make_shared<RHI_Shader>();
-                shader(Renderer_Shader::ffx_spd_highest_c)->AddDefine("HIGHEST");
-                shader(Renderer_Shader::ffx_spd_highest_c)->Compile(RHI_Shader_Type::Compute, shader_dir + "amd_fidelity_fx\\spd.hlsl", false);
+        compile(Renderer_Shader::bloom_luminance_c,          RHI_Shader_Type::Compute, "bloom.hlsl", normal, RHI_Vertex_Type::Max, "LUMINANCE");          // downsample luminance
+        compile(Renderer_Shader::bloom_upsample_blend_mip_c, RHI_Shader_Type::Compute, "bloom.hlsl", normal, RHI_Vertex_Type::Max, "UPSAMPLE_BLEND_MIP"); // upsample blend (with previous mip)
+        compile(Renderer_Shader::bloom_blend_frame_c,        RHI_Shader_Type::Compute, "bloom.hlsl", normal, RHI_Vertex_Type::Max, "BLEND_FRAME");        // upsample blend (with frame)
 
-                shader(Renderer_Shader::ffx_spd_antiflicker_c) = make_shared<RHI_Shader>();
-                shader(Renderer_Shader::ffx_spd_antiflicker_c)->AddDefine("ANTIFLICKER");
-                shader(Renderer_Shader::ffx_spd_antiflicker_c)->Compile(RHI_Shader_Type::Compute, shader_dir + "amd_fidelity_fx\\spd.hlsl", false);
-            }
-        }
+        // amd fidelityfx cas - contrast adaptive sharpening
+        compile(Renderer_Shader::ffx_cas_c, RHI_Shader_Type::Compute, "amd_fidelity_fx\\cas.hlsl", normal);
 
         // fxaa
-        shader(Renderer_Shader::fxaa_c) = make_shared<RHI_Shader>();
-        shader(Renderer_Shader::fxaa_c)->Compile(RHI_Shader_Type::Compute, shader_dir + "fxaa\\fxaa.hlsl", async);
-
-        // skysphere
-        shader(Renderer_Shader::skysphere_c) = make_shared<RHI_Shader>();
-        shader(Renderer_Shader::skysphere_c)->Compile(RHI_Shader_Type::Compute, shader_dir + "skysphere.hlsl", async);
+        compile(Renderer_Shader::fxaa_c, RHI_Shader_Type::Compute, "fxaa\\fxaa.hlsl", normal);
 
         // font
-        shader(Renderer_Shader::font_v) = make_shared<RHI_Shader>();
-        shader(Renderer_Shader::font_v)->Compile(RHI_Shader_Type::Vertex, shader_dir + "font.hlsl", async, RHI_Vertex_Type::PosUv);
-        shader(Renderer_Shader::font_p) = make_shared<RHI_Shader>();
-        shader(Renderer_Shader::font_p)->Compile(RHI_Shader_Type::Pixel, shader_dir + "font.hlsl", async);
+        compile(Renderer_Shader::font_v, RHI_Shader_Type::Vertex, "font.hlsl", normal, RHI_Vertex_Type::PosUv);
+        compile(Renderer_Shader::font_p, RHI_Shader_Type::Pixel,  "font.hlsl", normal);
 
         // film grain
-        shader(Renderer_Shader::film_grain_c) = make_shared<RHI_Shader>();
-        shader(Renderer_Shader::film_grain_c)->Compile(RHI_Shader_Type::Compute, shader_dir + "film_grain.hlsl", async);
+        compile(Renderer_Shader::film_grain_c, RHI_Shader_Type::Compute, "film_grain.hlsl", normal);
 
         // chromatic aberration
-        shader(Renderer_Shader::chromatic_aberration_c) = make_shared<RHI_Shader>();
-        shader(Renderer_Shader::chromatic_aberration_c)->Compile(RHI_Shader_Type::Compute, shader_dir + "chromatic_aberration.hlsl", async);
-
-        // tone-mapping & gamma correction
-        shader(Renderer_Shader::output_c) = make_shared<RHI_Shader>();
-        shader(Renderer_Shader::output_c)->Compile(RHI_Shader_Type::Compute, shader_dir + "output.hlsl", async);
+        compile(Renderer_Shader::chromatic_aberration_c, RHI_Shader_Type::Compute, "chromatic_aberration.hlsl", normal);
 
         // motion blur
-        shader(Renderer_Shader::motion_blur_c) = make_shared<RHI_Shader>();
-        shader(Renderer_Shader::motion_blur_c)->Compile(RHI_Shader_Type::Compute, shader_dir + "motion_blur.hlsl", async);
+        compile(Renderer_Shader::motion_blur_c, RHI_Shader_Type::Compute, "motion_blur.hlsl", normal);
 
         // screen space global illumination
-        shader(Renderer_Shader::ssgi_c) = make_shared<RHI_Shader>();
-        shader(Renderer_Shader::ssgi_c)->Compile(RHI_Shader_Type::Compute, shader_dir + "ssgi.hlsl", async);
+        compile(Renderer_Shader::ssgi_c, RHI_Shader_Type::Compute, "ssgi.hlsl", normal);
 
         // screen space reflections
-        shader(Renderer_Shader::ssr_c) = make_shared<RHI_Shader>();
-        shader(Renderer_Shader::ssr_c)->Compile(RHI_Shader_Type::Compute, shader_dir + "ssr.hlsl", async);
+        compile(Renderer_Shader::ssr_c, RHI_Shader_Type::Compute, "ssr.hlsl", normal);
 
         // screen space shadows
-        shader(Renderer_Shader::sss_c_bend) = make_shared<RHI_Shader>();
-        shader(Renderer_Shader::sss_c_bend)->Compile(RHI_Shader_Type::Compute, shader_dir + "screen_space_shadows\\bend_sss.hlsl", async);
+        compile(Renderer_Shader::sss_c_bend, RHI_Shader_Type::Compute, "screen_space_shadows\\bend_sss.hlsl", normal);
 
         // depth of field
-        shader(Renderer_Shader::depth_of_field_c) = make_shared<RHI_Shader>();
-        shader(Renderer_Shader::depth_of_field_c)->Compile(RHI_Shader_Type::Compute, shader_dir + "depth_of_field.hlsl", async);
+        compile(Renderer_Shader::depth_of_field_c, RHI_Shader_Type::Compute, "depth_of_field.hlsl", normal);
 
         // variable rate shading
-        shader(Renderer_Shader::variable_rate_shading_c) = make_shared<RHI_Shader>();
-        shader(Renderer_Shader::variable_rate_shading_c)->Compile(RHI_Shader_Type::Compute, shader_dir + "variable_rate_shading.hlsl", async);
+        compile(Renderer_Shader::variable_rate_shading_c, RHI_Shader_Type::Compute, "variable_rate_shading.hlsl", normal);
     }
 
     void Renderer::CreateFonts()
@@ -0,0 +1,145 @@
+/*
+Copyright(c) 2016-2024 Panos Karabelas
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+copies of the Software, and to permit persons to whom the Software is furnished
+to do so, subject to the following conditions :
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE AUTHORS OR
+COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#pragma once
+
+//= INCLUDES ===================
+#include <array>
+#include <algorithm>
+#include <bit>
+#include <limits>
+#include <vector>
+#include "../Math/Vector3.h"
+#include "../Math/BoundingBox.h"
+//==============================
+
+namespace visibility
+{
+    // the parts of the renderer's visibility pass which don't need the renderer, see Renderer_Passes.cpp
+
+    const float lod_screen_size = 0.5f; // the size below which lod 1 is used
+    const float lod_hysteresis  = 0.1f;
+
+    // the screen size at which a lod hands over to the next one, every lod takes over when the size halves
+    inline float get_lod_threshold(const uint32_t lod)
+    {
+        return lod_screen_size / static_cast<float>(1 << lod);
+    }
+
+    // picks a lod from the size of the bounding sphere relative to the screen height, the hysteresis
+    // band around each threshold keeps meshes from flickering between two lods
+    inline uint32_t select_lod(
+        uint32_t lod,
+        const uint32_t lod_count,
+        const Spartan::Math::BoundingBox& box,
+        const Spartan::Math::Vector3& camera_position,
+        const float tan_half_fov
+    )
+    {
+        if (lod_count <= 1)
+            return 0;
+
+        float radius      = box.GetExtents().Length();
+        float distance    = (box.GetCenter() - camera_position).Length();
+        float screen_size = distance > radius ? radius / (distance * tan_half_fov) : std::numeric_limits<float>::max();
+
+        lod = std::min(lod, lod_count - 1);
+        while (lod + 1 < lod_count && screen_size < get_lod_threshold(lod) * (1.0f - lod_hysteresis))
+        {
+            lod++;
+        }
+        while (lod > 0 && screen_size > get_lod_threshold(lod - 1) * (1.0f + lod_hysteresis))
+        {
+            lod--;
+        }
+
+        return lod;
+    }
+
+    // draw record sort key layout (most significant first)
+    // opaque:      transparent (1) | non-instanced (1) | culled (1) | material (29) | depth (32)
+    // transparent: transparent (1) | non-instanced (1) | culled (1) | inverted depth (32) | material (29)
+    // depth is the bit pattern of the squared distance, which for positive floats sorts like an integer
+    const uint64_t key_bit_transparent   = uint64_t(1) << 63;
+    const uint64_t key_bit_non_instanced = uint64_t(1) << 62;
+    const uint64_t key_bit_culled        = uint64_t(1) << 61;
+    const uint64_t key_mask_material     = (uint64_t(1) << 29) - 1;
+
+    struct DrawRecord
+    {
+        uint64_t key   = 0;
+        uint32_t index = 0;
+    };
+
+    inline uint64_t compute_key(const bool is_transparent, const bool is_instanced, const bool is_culled, const uint32_t material_index, const float distance_squared)
+    {
+        uint64_t depth    = static_cast<uint64_t>(std::bit_cast<uint32_t>(std::max(distance_squared, 0.0f)));
+        uint64_t material = static_cast<uint64_t>(material_index) & key_mask_material;
+
+        uint64_t key  = is_transparent ? key_bit_transparent : 0;
+        key          |= is_instanced   ? 0 : key_bit_non_instanced;
+        key          |= is_culled      ? key_bit_culled : 0;
+
+        // opaque: group by material to minimize state changes, then front-to-back to maximize early-z
+        // transparent: back-to-front for correct blending, material only breaks ties
+        key |= is_transparent ? (((~depth & 0xFFFFFFFF) << 29) | material) : ((material << 32) | depth);
+
+        return key;
+    }
+
+    inline void radix_sort(std::vector<DrawRecord>& records, std::vector<DrawRecord>& scratch)
+    {
+        const uint32_t count = static_cast<uint32_t>(records.size());
+        if (count == 0)
+            return;
+
+        scratch.resize(count);
+
+        // lsd radix sort, 8 bits per pass, stable so equal keys keep their submission order
+        for (uint32_t shift = 0; shift < 64; shift += 8)
+        {
+            std::array<uint32_t, 256> histogram = {};
+            for (const DrawRecord& record : records)
+            {
+                histogram[(record.key >> shift) & 0xFF]++;
+            }
+
+            // skip passes where every key shares the same byte (common for the upper bits)
+            if (histogram[(records[0].key >> shift) & 0xFF] == count)
+                continue;
+
+            uint32_t offset = 0;
+            for (uint32_t& bucket : histogram)
+            {
+                uint32_t bucket_count = bucket;
+                bucket                = offset;
+                offset               += bucket_count;
+            }
+
+            for (const DrawRecord& record : records)
+            {
+                scratch[histogram[(record.key >> shift) & 0xFF]++] = record;
+            }
+
+            records.swap(scratch);
+        }
+    }
+}
@@ -0,0 +1,414 @@
+/*
+Copyright(c) 2016-2024 Panos Karabelas
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+copies of the Software, and to permit persons to whom the Software is furnished
+to do so, subject to the following conditions :
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE AUTHORS OR
+COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+//= INCLUDES ======================
+#include "pch.h"
+#include "HotReload.h"
+#include "ResourceCache.h"
+#include "../Core/ThreadPool.h"
+#include "../IO/FileWatcher.h"
+#include "../RHI/RHI_Device.h"
+#include "../RHI/RHI_Shader.h"
+#include "../RHI/RHI_Texture2D.h"
+#include "../RHI/RHI_TextureCube.h"
+#include "../Rendering/Renderer.h"
+#include "../Rendering/Material.h"
+//=================================
+
+//= NAMESPACES =====
+using namespace std;
+//==================
+
+namespace Spartan
+{
+    namespace
+    {
+        // a resource which was loaded again on a worker, it waits for the start of a frame to replace the old one
+        struct Reload
+        {
+            shared_ptr<IResource> resource_old;
+            shared_ptr<IResource> resource_new;
+        };
+
+        mutex mutex_reloads;
+        vector<Reload> reloads_completed;
+        vector<pair<shared_ptr<RHI_Shader>, shared_ptr<RHI_Shader>>> shaders_compiling; // old and new
+        vector<pair<shared_ptr<RHI_Shader>, uint64_t>> shaders_retired; // and the frame they were swapped out, in-flight frames can still use them
+        atomic<bool> is_shutting_down = false;
+        uint32_t reload_count         = 0;
+
+        // the watcher and the resources don't agree on separators or on relative paths
+        string normalize(const string& path)
+        {
+            string path_generic = path;
+            replace(path_generic.begin(), path_generic.end(), '\\', '/');
+
+            error_code error;
+            filesystem::path path_absolute = filesystem::weakly_canonical(filesystem::absolute(path_generic, error), error);
+            return error ? path_generic : path_absolute.generic_string();
+        }
+
+        namespace shaders
+        {
+            // file path -> shaders which include it, directly or through other includes
+            unordered_map<string, vector<RHI_Shader*>> build_dependency_graph()
+            {
+                unordered_map<string, vector<RHI_Shader*>> graph;
+                unordered_set<RHI_Shader*> visited;
+                for (const shared_ptr<RHI_Shader>& shader : Renderer::GetShaders())
+                {
+                    // permutations share shaders
+                    if (!shader || !visited.insert(shader.get()).second)
+                        continue;
+
+                    for (const string& file_path : shader->GetFilePaths())
+                    {
+                        graph[normalize(file_path)].emplace_back(shader.get());
+                    }
+                }
+
+                return graph;
+            }
+
+            void reload(const unordered_set<string>& file_paths)
+            {
+                unordered_map<string, vector<RHI_Shader*>> graph = build_dependency_graph();
+
+                unordered_set<RHI_Shader*> dependents;
+                for (const string& file_path : file_paths)
+                {
+                    auto it = graph.find(file_path);
+                    if (it != graph.end())
+                    {
+                        dependents.insert(it->second.begin(), it->second.end());
+                    }
+                }
+
+                for (RHI_Shader* shader_old : dependents)
+                {
+                    // one at a time, the next change picks up from the latest source anyway
+                    bool is_compiling = any_of(shaders_compiling.begin(), shaders_compiling.end(), [shader_old](const auto& pair) { return pair.first.get() == shader_old; });
+                    if (is_compiling)
+                        continue;
+
+                    // the renderer keeps using the old shader until the new one compiles
+                    shared_ptr<RHI_Shader> shader_new = make_shared<RHI_Shader>();
+                    for (const auto& define : shader_old->GetDefines())
+                    {
+                        shader_new->AddDefine(define.first, define.second);
+                    }
+                    shader_new->Compile(shader_old->GetShaderStage(), shader_old->GetFilePath(), true, shader_old->GetVertexType());
+
+                    for (const shared_ptr<RHI_Shader>& shader : Renderer::GetShaders())
+                    {
+                        if (shader.get() == shader_old)
+                        {
+                            shaders_compiling.emplace_back(shader, shader_new);
+                            break;
+                        }
+                    }
+                }
+            }
+
+            void swap()
+            {
+                for (auto it = shaders_compiling.begin(); it != shaders_compiling.end();)
+                {
+                    shared_ptr<RHI_Shader>& shader_old = it->first;
+                    shared_ptr<RHI_Shader>& shader_new = it->second;
+
+                    RHI_ShaderCompilationState state = shader_new->GetCompilationState();
+                    if (state == RHI_ShaderCompilationState::Succeeded)
+                    {
+                        for (shared_ptr<RHI_Shader>& shader : Renderer::GetShaders())
+                        {
+                            if (shader == shader_old)
+                            {
+                                shader = shader_new;
+                            }
+                        }
+
+                        SP_LOG_INFO("Reloaded \"%s\"", shader_new->GetObjectName().c_str());
+                        shaders_retired.emplace_back(shader_old, Renderer::GetFrameNum());
+                        reload_count++;
+                    }
+                    else if (state != RHI_ShaderCompilationState::Failed)
+                    {
+                        ++it;
+                        continue;
+                    }
+
+                    // the compiler has logged why it failed, the old shader stays
+                    it = shaders_compiling.erase(it);
+                }
+            }
+
+            // cached pipelines keep pointers to the shaders they were created with, so they go first
+            void release_retired()
+            {
+                const uint64_t frame = Renderer::GetFrameNum();
+                for (auto it = shaders_retired.begin(); it != shaders_retired.end();)
+                {
+                    if (frame - it->second <= resources_frame_lifetime)
+                    {
+                        ++it;
+                        continue;
+                    }
+
+                    RHI_Device::DeletePipelines(it->first.get());
+                    it = shaders_retired.erase(it);
+                }
+            }
+        }
+
+        namespace resources
+        {
+            shared_ptr<RHI_Texture> create_texture(const ResourceType type)
+            {
+                if (type == ResourceType::Texture2d)
+                    return make_shared<RHI_Texture2D>();
+
+                if (type == ResourceType::TextureCube)
+                    return make_shared<RHI_TextureCube>();
+
+                return make_shared<RHI_Texture>();
+            }
+
+            bool is_texture(const ResourceType type)
+            {
+                return type == ResourceType::Texture || type == ResourceType::Texture2d || type == ResourceType::TextureCube;
+            }
+
+            // loads the resource again from the file which changed, on a worker
+            void reload_resource(const shared_ptr<IResource>& resource_old, const string& file_path)
+            {
+                ThreadPool::AddTask([resource_old, file_path]()
+                {
+                    shared_ptr<IResource> resource_new;
+                    if (is_texture(resource_old->GetResourceType()))
+                    {
+                        shared_ptr<RHI_Texture> texture = create_texture(resource_old->GetResourceType());
+                        texture->SetFlags(resource_old->GetFlags());
+                        texture->SetResourceFilePath(file_path);
+                        resource_new = texture;
+                    }
+                    else
+                    {
+                        resource_new = make_shared<Material>();
+                    }
+
+                    if (!resource_new->LoadFromFile(file_path))
+                    {
+                        SP_LOG_ERROR("Failed to reload \"%s\"", file_path.c_str());
+                        return;
+                    }
+
+                    if (is_shutting_down)
+                        return;
+
+                    lock_guard lock(mutex_reloads);
+                    reloads_completed.push_back({ resource_old, resource_new });
+                });
+            }
+
+            void swap_texture(const shared_ptr<IResource>& texture_old, const shared_ptr<RHI_Texture>& texture_new)
+            {
+                // replace the cached texture first, as materials cache the textures they are given
+                {
+                    lock_guard<mutex> guard(ResourceCache::GetMutex());
+                    for (shared_ptr<IResource>& resource : ResourceCache::GetResources())
+                    {
+                        if (resource == texture_old)
+                        {
+                            resource = texture_new;
+                        }
+                    }
+                }
+
+                for (const shared_ptr<IResource>& resource : ResourceCache::GetByType(ResourceType::Material))
+                {
+                    Material* material = static_cast<Material*>(resource.get());
+                    for (uint32_t i = 0; i < static_cast<uint32_t>(MaterialTexture::Max); i++)
+                    {
+                        MaterialTexture type = static_cast<MaterialTexture>(i);
+                        if (material->GetTexture(type) != texture_old.get())
+                            continue;
+
+                        // setting a texture resets its multiplier, which has nothing to do with the texture changing
+                        array<float, static_cast<uint32_t>(MaterialProperty::Max)> properties;
+                        for (uint32_t property = 0; property < static_cast<uint32_t>(MaterialProperty::Max); property++)
+                        {
+                            properties[property] = material->GetProperty(static_cast<MaterialProperty>(property));
+                        }
+
+                        material->SetTexture(type, texture_new);
+
+                        for (uint32_t property = 0; property < static_cast<uint32_t>(MaterialProperty::Max); property++)
+                        {
+                            if (material->GetProperty(static_cast<MaterialProperty>(property)) != properties[property])
+                            {
+                                material->SetProperty(static_cast<MaterialProperty>(property), properties[property]);
+                            }
+                        }
+                    }
+                }
+            }
+
+            void swap_material(Material* material, Material* material_loaded)
+            {
+                // the renderables point to the material, so its contents are replaced instead of the material itself
+                for (uint32_t i = 0; i < static_cast<uint32_t>(MaterialTexture::Max); i++)
+                {
+                    MaterialTexture type = static_cast<MaterialTexture>(i);
+                    if (material->GetTexture(type) != material_loaded->GetTexture(type))
+                    {
+                        material->SetTexture(type, material_loaded->GetTexture_PtrShared(type));
+                    }
+                }
+
+                for (uint32_t i = 0; i < static_cast<uint32_t>(MaterialProperty::Max); i++)
+                {
+                    MaterialProperty type = static_cast<MaterialProperty>(i);
+                    if (material->GetProperty(type) != material_loaded->GetProperty(type))
+                    {
+                        material->SetProperty(type, material_loaded->GetProperty(type));
+                    }
+                }
+            }
+
+            void swap()
+            {
+                vector<Reload> reloads;
+                {
+                    lock_guard lock(mutex_reloads);
+                    reloads.swap(reloads_completed);
+                }
+
+                for (Reload& reload : reloads)
+                {
+                    if (is_texture(reload.resource_old->GetResourceType()))
+                    {
+                        swap_texture(reload.resource_old, static_pointer_cast<RHI_Texture>(reload.resource_new));
+                    }
+                    else
+                    {
+                        swap_material(static_cast<Material*>(reload.resource_old.get()), static_cast<Material*>(reload.resource_new.get()));
+                    }
+
+                    SP_LOG_INFO("Reloaded \"%s\"", reload.resource_old->GetObjectName().c_str());
+                    reload_count++;
+                }
+            }
+
+            void reload(const unordered_set<string>& file_paths)
+            {
+                for (const shared_ptr<IResource>& resource : ResourceCache::GetByType())
+                {
+                    ResourceType type = resource->GetResourceType();
+
+                    // textures and models are imported from their source file, materials are authored as engine files
+                    const string& file_path = type == ResourceType::Material ? resource->GetResourceFilePathNative() : resource->GetResourceFilePath();
+                    if (file_path.empty() || file_paths.find(normalize(file_path)) == file_paths.end())
+                        continue;
+
+                    if (is_texture(type) || type == ResourceType::Material)
+                    {
+                        reload_resource(resource, file_path);
+                    }
+                    else if (type == ResourceType::Mesh)
+                    {
+                        // renderables address ranges of a mesh and the import creates the entities, so that's on the user
+                        SP_LOG_WARNING("\"%s\" changed, import it again to see the changes", file_path.c_str());
+                    }
+                }
+            }
+        }
+    }
+
+    void HotReload::Initialize()
+    {
+        FileWatcher::Initialize();
+
+        const string directories[] =
+        {
+            ResourceCache::GetResourceDirectory(ResourceDirectory::Shaders),
+            ResourceCache::GetProjectDirectory()
+        };
+
+        for (const string& directory : directories)
+        {
+            if (FileSystem::IsDirectory(directory))
+            {
+                FileWatcher::AddDirectory(directory);
+            }
+        }
+    }
+
+    void HotReload::Shutdown()
+    {
+        is_shutting_down = true;
+
+        // the compilation queue points to the shaders which are still compiling
+        if (!shaders_compiling.empty())
+        {
+            RHI_Shader::WaitForCompilation(RHI_ShaderCompilationPriority::Normal);
+        }
+
+        shaders_compiling.clear();
+        shaders_retired.clear();
+        {
+            lock_guard lock(mutex_reloads);
+            reloads_completed.clear();
+        }
+
+        FileWatcher::Shutdown();
+    }
+
+    void HotReload::Tick()
+    {
+        // swaps go through the renderer's material events, which are ignored while loading
+        if (ProgressTracker::IsLoading())
+            return;
+
+        shaders::swap();
+        shaders::release_retired();
+        resources::swap();
+
+        vector<string> file_paths;
+        FileWatcher::Poll(file_paths);
+        if (file_paths.empty())
+            return;
+
+        unordered_set<string> file_paths_normalized;
+        for (const string& file_path : file_paths)
+        {
+            file_paths_normalized.insert(normalize(file_path));
+        }
+
+        shaders::reload(file_paths_normalized);
+        resources::reload(file_paths_normalized);
+    }
+
+    uint32_t HotReload::GetReloadCount()
+    {
+        return reload_count;
+    }
+}
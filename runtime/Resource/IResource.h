@@ -111,6 +111,19 @@ namespace Spartan
         // ready to use
         bool IsReadyForUse() const { return m_is_ready_for_use; }
 
+        // memory, the cache budgets resources by these
+        virtual uint64_t GetMemoryUsageCpu() const { return 0; }
+        virtual uint64_t GetMemoryUsageGpu() const { return m_object_size; }
+
+        // users which hold a raw pointer instead of a shared one, the cache only evicts a resource nobody references
+        void AddReference()                { m_reference_count++; }
+        void RemoveReference()             { SP_ASSERT(m_reference_count > 0); m_reference_count--; }
+        uint32_t GetReferenceCount() const { return m_reference_count; }
+
+        // the last frame the resource was referenced, the cache evicts the least recently used first
+        uint64_t GetLastUsedFrame() const           { return m_last_used_frame; }
+        void SetLastUsedFrame(const uint64_t frame) { m_last_used_frame = frame; }
+
         // io
         virtual bool SaveToFile(const std::string& file_path) { return true; }
         virtual bool LoadFromFile(const std::string& file_path) { return true; }
@@ -125,6 +138,9 @@ namespace Spartan
         uint32_t m_flags                     = 0;
 
     private:
+        std::atomic<uint32_t> m_reference_count = 0;
+        uint64_t m_last_used_frame              = 0;
+
         std::string m_resource_directory;
         std::string m_resource_file_path_native;
         std::string m_resource_file_path_foreign;
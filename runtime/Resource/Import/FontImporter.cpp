@@ -19,15 +19,17 @@ IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
 CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 */
 
-//= INCLUDES =========================
+//= INCLUDES =============================
 #include "pch.h"
 #include "FontImporter.h"
 #include "../../RHI/RHI_Texture2D.h"
+#include "../../Profiling/MemoryTracker.h"
+#include "../../IO/VirtualFileSystem.h"
 #include "../../Rendering/Font/Font.h"
 SP_WARNINGS_OFF
 #include "freetype/ftstroke.h"
 SP_WARNINGS_ON
-//====================================
+//========================================
 
 //= NAMESPACES ===============
 using namespace std;
@@ -407,9 +409,20 @@ namespace Spartan
 
     bool FontImporter::LoadFromFile(Font* font, const string& file_path)
     {
-        // load font (called face)
+        SP_MEMORY_TAG(MemoryTag::Importers);
+        // load font (called face), freetype reads it lazily so a font from a pack has to stay in memory until the face is done
         FT_Face ft_font = nullptr;
-        if (!ft_helper::handle_error(FT_New_Face(library, file_path.c_str(), 0, &ft_font)))
+        vector<byte> bytes;
+        if (VirtualFileSystem::Exists(file_path) && !VirtualFileSystem::Read(file_path, bytes))
+        {
+            SP_LOG_ERROR("Failed to read \"%s\"", file_path.c_str());
+            return false;
+        }
+
+        FT_Error error = bytes.empty() ?
+            FT_New_Face(library, file_path.c_str(), 0, &ft_font) :
+            FT_New_Memory_Face(library, reinterpret_cast<const FT_Byte*>(bytes.data()), static_cast<FT_Long>(bytes.size()), 0, &ft_font);
+        if (!ft_helper::handle_error(error))
         {
             ft_helper::handle_error(FT_Done_Face(ft_font));
             return false;
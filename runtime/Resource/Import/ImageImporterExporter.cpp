@@ -19,10 +19,12 @@ IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
 CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 */
 
-//= INCLUDES =======================
+//= INCLUDES =============================
 #include "pch.h"
 #include "ImageImporterExporter.h"
 #include "../../RHI/RHI_Texture2D.h"
+#include "../../Profiling/MemoryTracker.h"
+#include "../../IO/VirtualFileSystem.h"
 SP_WARNINGS_OFF
 #define FREEIMAGE_LIB
 #include <FreeImage/FreeImage.h>
@@ -30,7 +32,7 @@ SP_WARNINGS_OFF
 #define TINYDDSLOADER_IMPLEMENTATION
 #include "tinyddsloader.h"
 SP_WARNINGS_ON
-//==================================
+//========================================
 
 //= NAMESPACES =====
 using namespace std;
@@ -345,6 +347,7 @@ namespace Spartan
 
     bool ImageImporterExporter::Load(const string& file_path, const uint32_t slice_index, RHI_Texture* texture)
     {
+        SP_MEMORY_TAG(MemoryTag::Importers);
         SP_ASSERT(texture != nullptr);
 
         if (!FileSystem::Exists(file_path))
@@ -353,10 +356,24 @@ namespace Spartan
             return false;
         }
 
+        // files in a pack are decoded from memory
+        vector<byte> bytes;
+        FIMEMORY* memory = nullptr;
+        if (VirtualFileSystem::Exists(file_path))
+        {
+            if (!VirtualFileSystem::Read(file_path, bytes))
+            {
+                SP_LOG_ERROR("Failed to read \"%s\"", file_path.c_str());
+                return false;
+            }
+
+            memory = FreeImage_OpenMemory(reinterpret_cast<BYTE*>(bytes.data()), static_cast<DWORD>(bytes.size()));
+        }
+
         // acquire image format
         FREE_IMAGE_FORMAT format = FIF_UNKNOWN;
         {
-            format = FreeImage_GetFileType(file_path.c_str(), 0);
+            format = memory ? FreeImage_GetFileTypeFromMemory(memory, 0) : FreeImage_GetFileType(file_path.c_str(), 0);
 
             // if the format is unknown, try to work it out from the file path
             if (format == FIF_UNKNOWN)
@@ -367,6 +384,11 @@ namespace Spartan
             // if the format is still unknown, give up
             if (!FreeImage_FIFSupportsReading(format)) 
             {
+                if (memory)
+                {
+                    FreeImage_CloseMemory(memory);
+                }
+
                 SP_LOG_ERROR("Unsupported format");
                 return false;
             }
@@ -378,9 +400,14 @@ namespace Spartan
         // So in the case of a dds format in general, we don't rely on freeimage
         if (format == FIF_DDS)
         {
+            if (memory)
+            {
+                FreeImage_CloseMemory(memory);
+            }
+
             // load
             tinyddsloader::DDSFile dds_file;
-            auto result = dds_file.Load(file_path.c_str());
+            auto result = bytes.empty() ? dds_file.Load(file_path.c_str()) : dds_file.Load(reinterpret_cast<const uint8_t*>(bytes.data()), bytes.size());
             if (result != tinyddsloader::Success)
             {
                 SP_LOG_ERROR("Failed to load DSS file");
@@ -421,7 +448,17 @@ namespace Spartan
         }
 
         // load
-        FIBITMAP* bitmap = FreeImage_Load(format, file_path.c_str());
+        FIBITMAP* bitmap = nullptr;
+        if (memory)
+        {
+            bitmap = FreeImage_LoadFromMemory(format, memory);
+            FreeImage_CloseMemory(memory);
+        }
+        else
+        {
+            bitmap = FreeImage_Load(format, file_path.c_str());
+        }
+
         if (!bitmap)
         {
             SP_LOG_ERROR("Failed to load \"%s\"", file_path.c_str());
@@ -19,10 +19,12 @@ IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
 CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 */
 
-//= INCLUDES ==========================
+//= INCLUDES =============================
 #include "pch.h"
 #include "ModelImporter.h"
 #include "../../Core/ProgressTracker.h"
+#include "../../IO/VirtualFileSystem.h"
+#include "../../Profiling/MemoryTracker.h"
 #include "../../RHI/RHI_Texture.h"
 #include "../../Rendering/Animation.h"
 #include "../../Rendering/Mesh.h"
@@ -34,9 +36,11 @@ SP_WARNINGS_OFF
 #include "assimp/ProgressHandler.hpp"
 #include "assimp/version.h"
 #include "assimp/Importer.hpp"
+#include "assimp/DefaultIOSystem.h"
+#include "assimp/MemoryIOWrapper.h"
 #include "assimp/postprocess.h"
 SP_WARNINGS_ON
-//=====================================
+//========================================
 
 //= NAMESPACES ===============
 using namespace std;
@@ -54,6 +58,7 @@ namespace Spartan
         bool model_has_animation = false;
         bool model_is_gltf       = false;
         const aiScene* scene     = nullptr;
+        shared_ptr<AnimationSkeleton> skeleton; // shared by the vertex influences and the clips
 
         Matrix convert_matrix(const aiMatrix4x4& transform)
         {
@@ -102,6 +107,32 @@ namespace Spartan
             entity->SetScaleLocal(matrix_engine.GetScale());
         }
 
+        void build_skeleton(const aiNode* node, const int32_t parent_index, AnimationSkeleton& skeleton)
+        {
+            // depth first, so parents always precede their children
+            const int32_t index = static_cast<int32_t>(skeleton.joint_names.size());
+            skeleton.joint_names.emplace_back(node->mName.C_Str());
+            skeleton.joint_parents.emplace_back(parent_index);
+            skeleton.joint_offsets.emplace_back(Matrix::Identity);
+            skeleton.joint_bind_local.emplace_back(convert_matrix(node->mTransformation));
+
+            for (uint32_t i = 0; i < node->mNumChildren; i++)
+            {
+                build_skeleton(node->mChildren[i], index, skeleton);
+            }
+        }
+
+        bool has_bones(const aiScene* scene)
+        {
+            for (uint32_t i = 0; i < scene->mNumMeshes; i++)
+            {
+                if (scene->mMeshes[i]->HasBones())
+                    return true;
+            }
+
+            return false;
+        }
+
         constexpr void compute_node_count(const aiNode* node, uint32_t* count)
         {
             if (!node)
@@ -153,6 +184,37 @@ namespace Spartan
             string m_file_name;
         };
 
+        // models (and the files they reference, like .bin buffers) can come from a pack, everything else from disk
+        class VirtualIoSystem : public DefaultIOSystem
+        {
+        public:
+            bool Exists(const char* file_path) const override
+            {
+                return VirtualFileSystem::Exists(file_path) || DefaultIOSystem::Exists(file_path);
+            }
+
+            IOStream* Open(const char* file_path, const char* mode = "rb") override
+            {
+                if (!VirtualFileSystem::Exists(file_path))
+                    return DefaultIOSystem::Open(file_path, mode);
+
+                // uncompressed, read in place
+                const byte* data = nullptr;
+                uint64_t size    = 0;
+                if (VirtualFileSystem::Map(file_path, &data, &size))
+                    return new MemoryIOStream(reinterpret_cast<const uint8_t*>(data), static_cast<size_t>(size));
+
+                // compressed, the stream owns the decompressed copy
+                vector<byte> bytes;
+                if (!VirtualFileSystem::Read(file_path, bytes))
+                    return nullptr;
+
+                uint8_t* buffer = new uint8_t[bytes.size()];
+                memcpy(buffer, bytes.data(), bytes.size());
+                return new MemoryIOStream(buffer, bytes.size(), true);
+            }
+        };
+
         string texture_try_multiple_extensions(const string& file_path)
         {
             // Remove extension
@@ -408,6 +470,7 @@ namespace Spartan
 
     bool ModelImporter::Load(Mesh* mesh_in, const string& file_path)
     {
+        SP_MEMORY_TAG(MemoryTag::Importers);
         SP_ASSERT_MSG(mesh_in != nullptr, "Invalid parameter");
 
         if (!FileSystem::IsFile(file_path))
@@ -435,6 +498,9 @@ namespace Spartan
             // enable progress tracking
             importer.SetPropertyBool(AI_CONFIG_GLOB_MEASURE_TIME, true);
             importer.SetProgressHandler(new AssimpProgress(file_path));
+
+            // read through the mounted packs
+            importer.SetIOHandler(new VirtualIoSystem());
         }
 
         // import flags
@@ -485,9 +551,38 @@ namespace Spartan
 
             model_has_animation = scene->mNumAnimations != 0;
 
+            // the skeleton is needed before the meshes are parsed, they map their bone weights to its joints
+            skeleton = nullptr;
+            if (model_has_animation || has_bones(scene))
+            {
+                skeleton = make_shared<AnimationSkeleton>();
+                build_skeleton(scene->mRootNode, -1, *skeleton);
+
+                // inverse bind matrices
+                for (uint32_t i = 0; i < scene->mNumMeshes; i++)
+                {
+                    const aiMesh* assimp_mesh = scene->mMeshes[i];
+                    for (uint32_t j = 0; j < assimp_mesh->mNumBones; j++)
+                    {
+                        const aiBone* assimp_bone = assimp_mesh->mBones[j];
+                        int32_t joint_index       = skeleton->GetJointIndex(assimp_bone->mName.C_Str());
+                        if (joint_index != -1)
+                        {
+                            skeleton->joint_offsets[joint_index] = convert_matrix(assimp_bone->mOffsetMatrix);
+                        }
+                    }
+                }
+            }
+
             // recursively parse nodes
             ParseNode(scene->mRootNode);
 
+            // animations
+            if (model_has_animation)
+            {
+                ParseAnimations();
+            }
+
             // update model geometry
             {
                 while (ProgressTracker::GetProgress(ProgressType::ModelImporter).GetFraction() != 1.0f)
@@ -518,8 +613,16 @@ namespace Spartan
             }
 
             // make the root entity active since it's now thread-safe
-            mesh->GetRootEntity().lock()->SetActive(true);
-            World::Resolve();
+            shared_ptr<Entity> root_entity = mesh->GetRootEntity().lock();
+            root_entity->SetActive(true);
+
+            // only the imported hierarchy needs to be registered with the renderer
+            vector<Entity*> imported_entities = { root_entity.get() };
+            root_entity->GetDescendants(&imported_entities);
+            for (Entity* entity : imported_entities)
+            {
+                World::Resolve(entity);
+            }
         }
         else
         {
@@ -528,7 +631,8 @@ namespace Spartan
         }
 
         importer.FreeScene();
-        mesh = nullptr;
+        mesh     = nullptr;
+        skeleton = nullptr;
 
         return scene != nullptr;
     }
@@ -729,6 +833,15 @@ namespace Spartan
         // compute AABB (before doing move operation on vertices)
         const BoundingBox aabb = BoundingBox(vertices.data(), static_cast<uint32_t>(vertices.size()));
 
+        // lods, appended right after the full resolution indices so that a single add keeps them together
+        vector<vector<uint32_t>> lods;
+        if (mesh->GetFlags() & static_cast<uint32_t>(MeshFlags::GenerateLods))
+        {
+            Mesh::GenerateLods(indices, vertices, lods);
+        }
+        const uint32_t lod0_index_count = static_cast<uint32_t>(indices.size());
+        vector<MeshLod> renderable_lods = Mesh::AppendLods(indices, lods);
+
         // add vertex and index data to the mesh
         uint32_t index_offset  = 0;
         uint32_t vertex_offset = 0;
@@ -743,11 +856,20 @@ namespace Spartan
             mesh,
             aabb,
             index_offset,
-            static_cast<uint32_t>(indices.size()),
+            lod0_index_count,
             vertex_offset,
             static_cast<uint32_t>(vertices.size())
         );
 
+        if (!renderable_lods.empty())
+        {
+            for (MeshLod& lod : renderable_lods)
+            {
+                lod.index_offset += index_offset;
+            }
+            renderable->SetLods(renderable_lods);
+        }
+
         // material
         if (scene->HasMaterials())
         {
@@ -760,12 +882,14 @@ namespace Spartan
             mesh->SetMaterial(material, entity_parent.get());
         }
 
-        // Bones
-        ParseNodes(assimp_mesh);
+        // bones
+        ParseBones(assimp_mesh, vertex_offset);
     }
 
     void ModelImporter::ParseAnimations()
     {
+        SP_ASSERT(skeleton != nullptr);
+
         for (uint32_t i = 0; i < scene->mNumAnimations; i++)
         {
             const auto assimp_animation = scene->mAnimations[i];
@@ -796,7 +920,7 @@ namespace Spartan
                 // Rotation keys
                 for (uint32_t k = 0; k < static_cast<uint32_t>(assimp_node_anim->mNumRotationKeys); k++)
                 {
-                    const auto time = assimp_node_anim->mPositionKeys[k].mTime;
+                    const auto time = assimp_node_anim->mRotationKeys[k].mTime;
                     const auto value = convert_quaternion(assimp_node_anim->mRotationKeys[k].mValue);
 
                     animation_node.rotationFrames.emplace_back(KeyQuaternion{ time, value });
@@ -805,52 +929,74 @@ namespace Spartan
                 // Scaling keys
                 for (uint32_t k = 0; k < static_cast<uint32_t>(assimp_node_anim->mNumScalingKeys); k++)
                 {
-                    const auto time = assimp_node_anim->mPositionKeys[k].mTime;
+                    const auto time = assimp_node_anim->mScalingKeys[k].mTime;
                     const auto value = convert_vector3(assimp_node_anim->mScalingKeys[k].mValue);
 
                     animation_node.scaleFrames.emplace_back(KeyVector{ time, value });
                 }
+
+                animation->AddChannel(move(animation_node));
             }
+
+            // convert to the compact runtime layout
+            animation->Compress(skeleton);
+
+            mesh->AddAnimation(animation);
         }
     }
 
-    void ModelImporter::ParseNodes(const aiMesh* assimp_mesh)
+    void ModelImporter::ParseBones(const aiMesh* assimp_mesh, const uint32_t vertex_offset)
     {
-        // Maximum number of bones per mesh
-        // Must not be higher than same const in skinning shader
-        constexpr uint8_t MAX_BONES = 64;
-        // Maximum number of bones per vertex
-        constexpr uint8_t MAX_BONES_PER_VERTEX = 4;
-
-        //for (uint32_t i = 0; i < assimp_mesh->mNumBones; i++)
-        //{
-        //    uint32_t index = 0;
-
-        //    assert(assimp_mesh->mNumBones <= MAX_BONES);
-
-        //    string name = assimp_mesh->mBones[i]->mName.data;
-
-        //    if (boneMapping.find(name) == boneMapping.end())
-        //    {
-        //        // Bone not present, add new one
-        //        index = numBones;
-        //        numBones++;
-        //        BoneInfo bone;
-        //        boneInfo.push_back(bone);
-        //        boneInfo[index].offset = pMesh->mBones[i]->mOffsetMatrix;
-        //        boneMapping[name] = index;
-        //    }
-        //    else
-        //    {
-        //        index = boneMapping[name];
-        //    }
-
-        //    for (uint32_t j = 0; j < assimp_mesh->mBones[i]->mNumWeights; j++)
-        //    {
-        //        uint32_t vertexID = vertexOffset + pMesh->mBones[i]->mWeights[j].mVertexId;
-        //        Bones[vertexID].add(index, pMesh->mBones[i]->mWeights[j].mWeight);
-        //    }
-        //}
-        //boneTransforms.resize(numBones);
+        if (!assimp_mesh->HasBones() || !skeleton)
+            return;
+
+        // keep the four strongest weights of every vertex
+        const uint32_t vertex_count = assimp_mesh->mNumVertices;
+        vector<AnimationVertexInfluence> influences(vertex_count);
+        for (uint32_t i = 0; i < assimp_mesh->mNumBones; i++)
+        {
+            const aiBone* assimp_bone = assimp_mesh->mBones[i];
+            const int32_t joint_index = skeleton->GetJointIndex(assimp_bone->mName.C_Str());
+            if (joint_index == -1)
+                continue;
+
+            for (uint32_t j = 0; j < assimp_bone->mNumWeights; j++)
+            {
+                const aiVertexWeight& weight = assimp_bone->mWeights[j];
+                if (weight.mVertexId >= vertex_count)
+                    continue;
+
+                AnimationVertexInfluence& influence = influences[weight.mVertexId];
+                uint32_t weakest = 0;
+                for (uint32_t k = 1; k < 4; k++)
+                {
+                    if (influence.weights[k] < influence.weights[weakest])
+                    {
+                        weakest = k;
+                    }
+                }
+
+                if (weight.mWeight > influence.weights[weakest])
+                {
+                    influence.joints[weakest]  = static_cast<uint16_t>(joint_index);
+                    influence.weights[weakest] = weight.mWeight;
+                }
+            }
+        }
+
+        // renormalize, dropped weights would otherwise shrink the vertex towards the origin
+        for (AnimationVertexInfluence& influence : influences)
+        {
+            const float weight_sum = influence.weights[0] + influence.weights[1] + influence.weights[2] + influence.weights[3];
+            if (weight_sum > 0.0f)
+            {
+                for (float& weight : influence.weights)
+                {
+                    weight /= weight_sum;
+                }
+            }
+        }
+
+        mesh->AddInfluences(influences, vertex_offset);
     }
 }
@@ -46,6 +46,6 @@ namespace Spartan
         static void ParseNodeLight(const aiNode* node, std::shared_ptr<Entity> new_entity);
         static void ParseAnimations();
         static void ParseMesh(aiMesh* mesh, std::shared_ptr<Entity> entity_parent);
-        static void ParseNodes(const aiMesh* mesh);
+        static void ParseBones(const aiMesh* mesh, uint32_t vertex_offset);
     };
 }
@@ -40,11 +40,26 @@ namespace Spartan
 {
     namespace
     {
-        array<string, 6> m_standard_resource_directories;
+        array<string, 7> m_standard_resource_directories;
         string m_project_directory;
         vector<shared_ptr<IResource>> m_resources;
         mutex m_mutex;
         bool use_root_shader_directory = false;
+
+        // lifetime
+        const uint64_t eviction_age_min = 8; // frames a resource has to be unreferenced for, enough for the renderer to release its bindless slots
+        array<uint64_t, static_cast<uint32_t>(ResourceType::Max)> budgets;
+        array<bool, static_cast<uint32_t>(ResourceType::Max)> budgets_exceeded;
+        map<pair<ResourceType, string>, string> evicted_file_paths; // type and name -> native file path
+        atomic<uint64_t> frame  = 1; // ticked on the main thread, loader threads read it when caching
+        uint64_t frame_cleared  = 0; // what was last referenced before the world was cleared goes, regardless of budgets
+        uint32_t eviction_count = 0;
+
+        bool is_referenced(const shared_ptr<IResource>& resource)
+        {
+            // the cache holds a shared reference itself, the reference count covers users with raw pointers
+            return resource.use_count() > 1 || resource->GetReferenceCount() > 0;
+        }
     }
 
     void ResourceCache::Initialize()
@@ -54,6 +69,7 @@ namespace Spartan
 
         // add engine standard resource directories
         const string data_dir = "data\\";
+        AddResourceDirectory(ResourceDirectory::Cache,          m_project_directory + "cache");
         AddResourceDirectory(ResourceDirectory::Environment,    m_project_directory + "environment");
         AddResourceDirectory(ResourceDirectory::Fonts,          data_dir + "fonts");
         AddResourceDirectory(ResourceDirectory::Icons,          data_dir + "icons");
@@ -61,10 +77,19 @@ namespace Spartan
         AddResourceDirectory(ResourceDirectory::Shaders,        data_dir + "shaders");
         AddResourceDirectory(ResourceDirectory::Textures,       data_dir + "textures");
 
+        // budgets, cpu and gpu bytes combined, the rest of the types are unbounded
+        const uint64_t megabyte = 1024 * 1024;
+        budgets.fill(numeric_limits<uint64_t>::max());
+        budgets_exceeded.fill(false);
+        SetMemoryBudget(ResourceType::Texture,   2048 * megabyte);
+        SetMemoryBudget(ResourceType::Texture2d, 2048 * megabyte);
+        SetMemoryBudget(ResourceType::Mesh,      1024 * megabyte);
+        SetMemoryBudget(ResourceType::Audio,     512  * megabyte);
+
         // subscribe to events
         SP_SUBSCRIBE_TO_EVENT(EventType::WorldSaveStart, SP_EVENT_HANDLER_STATIC(Serialize));
         SP_SUBSCRIBE_TO_EVENT(EventType::WorldLoadStart, SP_EVENT_HANDLER_STATIC(Deserialize));
-        SP_SUBSCRIBE_TO_EVENT(EventType::WorldClear,     SP_EVENT_HANDLER_STATIC(Shutdown));
+        SP_SUBSCRIBE_TO_EVENT(EventType::WorldClear,     SP_EVENT_HANDLER_EXPRESSION_STATIC( frame_cleared = frame; ));
     }
 
     bool ResourceCache::IsCached(const string& resource_file_path_native, const ResourceType resource_type)
@@ -105,7 +130,10 @@ namespace Spartan
         for (shared_ptr<IResource>& resource : m_resources)
         {
             if (name == resource->GetObjectName())
+            {
+                resource->SetLastUsedFrame(frame);
                 return resource;
+            }
         }
 
         static shared_ptr<IResource> empty;
@@ -147,6 +175,168 @@ namespace Spartan
         return size;
     }
 
+    uint64_t ResourceCache::GetMemoryUsageCpu(ResourceType type /*= ResourceType::Max*/)
+    {
+        lock_guard<mutex> guard(m_mutex);
+
+        uint64_t size = 0;
+        for (shared_ptr<IResource>& resource : m_resources)
+        {
+            if (resource->GetResourceType() == type || type == ResourceType::Max)
+            {
+                size += resource->GetMemoryUsageCpu();
+            }
+        }
+
+        return size;
+    }
+
+    uint64_t ResourceCache::GetMemoryUsageGpu(ResourceType type /*= ResourceType::Max*/)
+    {
+        lock_guard<mutex> guard(m_mutex);
+
+        uint64_t size = 0;
+        for (shared_ptr<IResource>& resource : m_resources)
+        {
+            if (resource->GetResourceType() == type || type == ResourceType::Max)
+            {
+                size += resource->GetMemoryUsageGpu();
+            }
+        }
+
+        return size;
+    }
+
+    void ResourceCache::Tick()
+    {
+        frame++;
+
+        // a loading world hasn't referenced its resources yet
+        if (ProgressTracker::IsLoading())
+            return;
+
+        const uint32_t type_count = static_cast<uint32_t>(ResourceType::Max);
+
+        // released outside of the lock, the rhi defers destroying the gpu side to its deletion queue
+        vector<shared_ptr<IResource>> evicted;
+        {
+            lock_guard<mutex> guard(m_mutex);
+
+            // usage per type and what could be evicted
+            array<uint64_t, type_count> usage = {};
+            vector<uint32_t> candidates;
+            for (uint32_t i = 0; i < static_cast<uint32_t>(m_resources.size()); i++)
+            {
+                shared_ptr<IResource>& resource = m_resources[i];
+                if (resource->GetResourceType() == ResourceType::Max)
+                    continue;
+
+                usage[static_cast<uint32_t>(resource->GetResourceType())] += resource->GetMemoryUsageCpu() + resource->GetMemoryUsageGpu();
+
+                if (is_referenced(resource))
+                {
+                    resource->SetLastUsedFrame(frame);
+                }
+                else if (frame - resource->GetLastUsedFrame() >= eviction_age_min)
+                {
+                    candidates.emplace_back(i);
+                }
+            }
+
+            // least recently used first
+            sort(candidates.begin(), candidates.end(), [](const uint32_t a, const uint32_t b)
+            {
+                return m_resources[a]->GetLastUsedFrame() < m_resources[b]->GetLastUsedFrame();
+            });
+
+            vector<bool> evict(m_resources.size(), false);
+            for (const uint32_t index : candidates)
+            {
+                shared_ptr<IResource>& resource = m_resources[index];
+                const uint32_t type             = static_cast<uint32_t>(resource->GetResourceType());
+                const bool cleared              = resource->GetLastUsedFrame() <= frame_cleared;
+                if (!cleared && usage[type] <= budgets[type])
+                    continue;
+
+                // over budget, only what can be loaded again
+                const bool reloadable = resource->HasFilePathNative() && FileSystem::Exists(resource->GetResourceFilePathNative());
+                if (!cleared && !reloadable)
+                    continue;
+
+                if (reloadable)
+                {
+                    evicted_file_paths[{ resource->GetResourceType(), resource->GetObjectName() }] = resource->GetResourceFilePathNative();
+                }
+
+                usage[type] -= min(usage[type], resource->GetMemoryUsageCpu() + resource->GetMemoryUsageGpu());
+                evict[index] = true;
+            }
+
+            // warn once whenever a type goes over its budget with nothing left to evict
+            for (uint32_t type = 0; type < type_count; type++)
+            {
+                bool exceeded = usage[type] > budgets[type];
+                if (exceeded && !budgets_exceeded[type])
+                {
+                    SP_LOG_WARNING("Resources of type %d use %.1f MB which exceeds their budget of %.1f MB, the rest are in use",
+                        type, usage[type] / (1024.0 * 1024.0), budgets[type] / (1024.0 * 1024.0));
+                }
+                budgets_exceeded[type] = exceeded;
+            }
+
+            // compact
+            uint32_t index_write = 0;
+            for (uint32_t i = 0; i < static_cast<uint32_t>(m_resources.size()); i++)
+            {
+                if (evict[i])
+                {
+                    evicted.emplace_back(move(m_resources[i]));
+                }
+                else
+                {
+                    m_resources[index_write++] = move(m_resources[i]);
+                }
+            }
+            m_resources.resize(index_write);
+        }
+
+        if (!evicted.empty())
+        {
+            eviction_count += static_cast<uint32_t>(evicted.size());
+            SP_LOG_INFO("%d unreferenced resources have been evicted", static_cast<uint32_t>(evicted.size()));
+        }
+    }
+
+    void ResourceCache::SetMemoryBudget(const ResourceType type, const uint64_t bytes)
+    {
+        SP_ASSERT(type != ResourceType::Max);
+        budgets[static_cast<uint32_t>(type)] = bytes;
+    }
+
+    uint64_t ResourceCache::GetMemoryBudget(const ResourceType type)
+    {
+        SP_ASSERT(type != ResourceType::Max);
+        return budgets[static_cast<uint32_t>(type)];
+    }
+
+    uint32_t ResourceCache::GetEvictionCount()
+    {
+        return eviction_count;
+    }
+
+    string ResourceCache::GetEvictedFilePath(const string& name, const ResourceType type)
+    {
+        lock_guard<mutex> guard(m_mutex);
+
+        auto it = evicted_file_paths.find({ type, name });
+        return it != evicted_file_paths.end() ? it->second : string();
+    }
+
+    uint64_t ResourceCache::GetFrame()
+    {
+        return frame;
+    }
+
     void ResourceCache::Serialize()
     {
         // create resource list file
@@ -230,6 +420,7 @@ namespace Spartan
     {
         uint32_t resource_count = static_cast<uint32_t>(m_resources.size());
         m_resources.clear();
+        evicted_file_paths.clear();
         SP_LOG_INFO("%d resources have been cleared", resource_count);
     }
 
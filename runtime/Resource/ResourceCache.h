@@ -21,16 +21,18 @@ CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 
 #pragma once
 
-//= INCLUDES ===============
+//= INCLUDES ============================
 #include <algorithm>
 #include "IResource.h"
 #include "ProgressTracker.h"
-//==========================
+#include "../Profiling/MemoryTracker.h"
+//=======================================
 
 namespace Spartan
 {
     enum class ResourceDirectory
     {
+        Cache,
         Environment,
         Fonts,
         Icons,
@@ -50,7 +52,19 @@ namespace Spartan
         template <class T> 
         static std::shared_ptr<T> GetByName(const std::string& name) 
         { 
-            return std::static_pointer_cast<T>(GetByName(name, IResource::TypeToEnum<T>()));
+            std::shared_ptr<T> resource = std::static_pointer_cast<T>(GetByName(name, IResource::TypeToEnum<T>()));
+
+            // evicted resources are reloaded on demand
+            if (!resource)
+            {
+                const std::string file_path = GetEvictedFilePath(name, IResource::TypeToEnum<T>());
+                if (!file_path.empty())
+                {
+                    resource = Load<T>(file_path);
+                }
+            }
+
+            return resource;
         }
 
         // get by type
@@ -97,6 +111,7 @@ namespace Spartan
 
             // cache it
             std::lock_guard<std::mutex> guard(GetMutex());
+            resource->SetLastUsedFrame(GetFrame());
             return std::static_pointer_cast<T>(GetResources().emplace_back(resource));
         }
 
@@ -104,6 +119,8 @@ namespace Spartan
         template <class T>
         static std::shared_ptr<T> Load(const std::string& file_path, uint32_t flags = 0)
         {
+            SP_MEMORY_TAG(MemoryTag::Resources);
+
             if (!FileSystem::Exists(file_path))
             {
                 SP_LOG_ERROR("\"%s\" doesn't exist.", file_path.c_str());
@@ -160,8 +177,17 @@ namespace Spartan
 
         // memory
         static uint64_t GetMemoryUsage(ResourceType type = ResourceType::Max);
+        static uint64_t GetMemoryUsageCpu(ResourceType type = ResourceType::Max);
+        static uint64_t GetMemoryUsageGpu(ResourceType type = ResourceType::Max);
         static uint32_t GetResourceCount(ResourceType type = ResourceType::Max);
 
+        // lifetime, every type which exceeds its budget (cpu + gpu bytes) evicts its least recently used
+        // resources which nothing references, evicted resources are reloaded when they are asked for by name
+        static void Tick();
+        static void SetMemoryBudget(ResourceType type, uint64_t bytes);
+        static uint64_t GetMemoryBudget(ResourceType type);
+        static uint32_t GetEvictionCount();
+
         // directories
         static void AddResourceDirectory(ResourceDirectory type, const std::string& directory);
         static std::string GetResourceDirectory(ResourceDirectory type);
@@ -179,6 +205,8 @@ namespace Spartan
     private:
         static bool IsCached(const uint64_t resource_id);
         static bool IsCached(const std::string& resource_name, const ResourceType resource_type);
+        static std::string GetEvictedFilePath(const std::string& name, const ResourceType type);
+        static uint64_t GetFrame();
 
         // event handlers
         static void Serialize();
@@ -45,6 +45,10 @@ namespace Spartan
         float orthographic_extent_near = 12.0f;
         float orthographic_extent_far  = 64.0f;
 
+        // when only the camera moves, the far cascade follows it every n frames, offset by the light index
+        // so that the far cascades of different lights re-render on different frames
+        uint64_t far_cascade_refresh_interval = 4;
+
         float get_sensible_range(const float range, const LightType type)
         {
             if (type == LightType::Directional)
@@ -128,20 +132,33 @@ namespace Spartan
 
     void Light::OnTick()
     {
-        // if the light or the camera moves...
-        bool update = GetEntity()->HasTransformChanged();
+        // if the light moves, update everything
+        if (GetEntity()->HasTransformChanged())
+        {
+            UpdateMatrices();
+            m_far_cascade_pending = false;
+            return;
+        }
+
+        // only the directional light follows the camera
+        if (m_light_type != LightType::Directional)
+            return;
+
         if (shared_ptr<Camera> camera = Renderer::GetCamera())
         {
             if (camera->GetEntity()->HasTransformChanged())
             {
-                update = true;
+                m_far_cascade_pending = true;
+                bool far_cascade_turn = (Renderer::GetFrameNum() + m_index) % far_cascade_refresh_interval == 0;
+                UpdateMatrices(far_cascade_turn);
+                m_far_cascade_pending = !far_cascade_turn;
+            }
+            else if (m_far_cascade_pending && (Renderer::GetFrameNum() + m_index) % far_cascade_refresh_interval == 0)
+            {
+                // the camera stopped, catch up
+                UpdateMatrices();
+                m_far_cascade_pending = false;
             }
-        }
-
-        // ... update the matrices
-        if (update)
-        {
-            UpdateMatrices();
         }
     }
 
@@ -201,7 +218,7 @@ namespace Spartan
                 RefreshShadowMap();
             }
 
-            SP_FIRE_EVENT(EventType::LightOnChanged);
+            SP_PUBLISH_EVENT(EventType::LightOnChanged);
         }
     }
 
@@ -222,7 +239,7 @@ namespace Spartan
         }
 
         UpdateMatrices();
-        World::Resolve();
+        World::Resolve(GetEntity());
     }
 
     void Light::SetTemperature(const float temperature_kelvin)
@@ -230,7 +247,7 @@ namespace Spartan
         m_temperature_kelvin = temperature_kelvin;
         m_color_rgb          = Color(temperature_kelvin);
 
-        SP_FIRE_EVENT(EventType::LightOnChanged);
+        SP_PUBLISH_EVENT(EventType::LightOnChanged);
     }
 
     void Light::SetColor(const Color& rgb)
@@ -260,7 +277,7 @@ namespace Spartan
         else if (rgb == Color::light_photo_flash)
             m_temperature_kelvin = 5500.0f;
 
-        SP_FIRE_EVENT(EventType::LightOnChanged);
+        SP_PUBLISH_EVENT(EventType::LightOnChanged);
     }
 
     void Light::SetIntensity(const LightIntensity intensity)
@@ -316,7 +333,7 @@ namespace Spartan
             m_intensity_lumens = 0.0f;
         }
 
-        SP_FIRE_EVENT(EventType::LightOnChanged);
+        SP_PUBLISH_EVENT(EventType::LightOnChanged);
     }
 
     void Light::SetIntensityLumens(const float lumens)
@@ -324,7 +341,7 @@ namespace Spartan
         m_intensity_lumens = lumens;
         m_intensity        = LightIntensity::custom;
 
-        SP_FIRE_EVENT(EventType::LightOnChanged);
+        SP_PUBLISH_EVENT(EventType::LightOnChanged);
     }
 
     float Light::GetIntensityWatt() const
@@ -373,14 +390,21 @@ namespace Spartan
         UpdateMatrices();
     }
 
-    void Light::UpdateMatrices()
+    void Light::UpdateMatrices(const bool include_far_cascade)
     {
-        ComputeViewMatrix();
-        ComputeProjectionMatrix();
-        SP_FIRE_EVENT(EventType::LightOnChanged);
+        ComputeViewMatrix(include_far_cascade);
+        ComputeProjectionMatrix(include_far_cascade);
+
+        m_shadow_static_dirty[0] = true;
+        if (include_far_cascade)
+        {
+            m_shadow_static_dirty[1] = true;
+        }
+
+        SP_PUBLISH_EVENT(EventType::LightOnChanged);
     }
     
-    void Light::ComputeViewMatrix()
+    void Light::ComputeViewMatrix(const bool include_far_cascade)
     {
         const Vector3 position = GetEntity()->GetPosition();
 
@@ -394,7 +418,10 @@ namespace Spartan
             Vector3 position = target - GetEntity()->GetForward() * orthographic_depth * 0.8f;
 
             m_matrix_view[0] = Matrix::CreateLookAtLH(position, target, Vector3::Up); // near
-            m_matrix_view[1] = m_matrix_view[0];                                      // far
+            if (include_far_cascade)
+            {
+                m_matrix_view[1] = m_matrix_view[0];                                  // far
+            }
         }
         else if (m_light_type == LightType::Spot)
         {
@@ -407,7 +434,7 @@ namespace Spartan
         }
     }
 
-    void Light::ComputeProjectionMatrix()
+    void Light::ComputeProjectionMatrix(const bool include_far_cascade)
     {
         if (!m_texture_depth)
             return;
@@ -416,7 +443,7 @@ namespace Spartan
 
         if (m_light_type == LightType::Directional)
         {
-            for (uint32_t i = 0; i < 2; i++)
+            for (uint32_t i = 0; i < (include_far_cascade ? 2u : 1u); i++)
             {
                 // determine the orthographic extent based on the cascade index
                 float extent = (i == 0) ? orthographic_extent_near : orthographic_extent_far;
@@ -492,6 +519,7 @@ namespace Spartan
         RHI_Format format_color = RHI_Format::R8G8B8A8_Unorm;
         uint32_t flags          = RHI_Texture_Rtv | RHI_Texture_Srv | RHI_Texture_ClearBlit;
         m_texture_depth         = nullptr;
+        m_texture_depth_static  = nullptr;
         m_texture_color         = nullptr;
         uint32_t array_length   = (GetLightType() == LightType::Spot) ? 1 : 2;
 
@@ -499,10 +527,14 @@ namespace Spartan
         // directional light: 2 slices for cascades
         // point light:       2 slices for front and back paraboloid
 
-        m_texture_depth = make_unique<RHI_Texture2DArray>(resolution, resolution, format_depth, 2, flags, "light_depth");
+        m_texture_depth        = make_unique<RHI_Texture2DArray>(resolution, resolution, format_depth, 2, flags, "light_depth");
+        m_texture_depth_static = make_unique<RHI_Texture2DArray>(resolution, resolution, format_depth, 2, flags, "light_depth_static");
         if (IsFlagSet(LightFlags::ShadowsTransparent))
         {
             m_texture_color = make_unique<RHI_Texture2DArray>(resolution, resolution, format_color, 2, flags, "light_color");
         }
+
+        // the projection depends on the texture and the cached shadows are gone
+        UpdateMatrices();
     }
 }  
@@ -126,6 +126,15 @@ namespace Spartan
         RHI_Texture* GetColorTexture() const { return m_texture_color.get(); }
         void RefreshShadowMap();
 
+        // shadow cache, static casters are rendered into a separate layer which is only
+        // re-rendered when its slice is dirty, dynamic casters are composited on top of it
+        RHI_Texture* GetDepthTextureStatic() const                        { return m_texture_depth_static.get(); }
+        bool IsShadowStaticDirty(const uint32_t index) const              { return m_shadow_static_dirty[index]; }
+        void SetShadowStaticDirty(const uint32_t index, const bool dirty) { m_shadow_static_dirty[index] = dirty; }
+        void SetShadowStaticDirty()                                       { m_shadow_static_dirty.fill(true); }
+        bool HasShadowDynamicCasters() const                              { return m_shadow_has_dynamic_casters; }
+        void SetShadowDynamicCasters(const bool has_casters)              { m_shadow_has_dynamic_casters = has_casters; }
+
         // frustum
         bool IsInViewFrustum(const Math::BoundingBox& bounding_box, const uint32_t index) const;
         bool IsInViewFrustum(Renderable* renderable, const uint32_t index) const;
@@ -135,9 +144,9 @@ namespace Spartan
         uint32_t GetIndex() const           { return m_index; }
 
     private:
-        void UpdateMatrices();
-        void ComputeViewMatrix();
-        void ComputeProjectionMatrix();
+        void UpdateMatrices(const bool include_far_cascade = true);
+        void ComputeViewMatrix(const bool include_far_cascade);
+        void ComputeProjectionMatrix(const bool include_far_cascade);
 
         // intensity
         LightIntensity m_intensity = LightIntensity::bulb_500_watt;
@@ -146,6 +155,10 @@ namespace Spartan
         // shadows
         std::shared_ptr<RHI_Texture> m_texture_color;
         std::shared_ptr<RHI_Texture> m_texture_depth;
+        std::shared_ptr<RHI_Texture> m_texture_depth_static;
+        std::array<bool, 2> m_shadow_static_dirty = { true, true };
+        bool m_shadow_has_dynamic_casters         = false;
+        bool m_far_cascade_pending                = false;
         std::array<Math::Frustum, 2> m_frustums;
         std::array<Math::Matrix, 2> m_matrix_view;
         std::array<Math::Matrix, 2> m_matrix_projection;
@@ -37,32 +37,49 @@ using namespace Spartan::Math;
 
 namespace Spartan
 {
+    namespace
+    {
+        // the stream starts with a marker and a version, older streams start with the index offset which is never the marker
+        const uint32_t stream_marker  = numeric_limits<uint32_t>::max();
+        const uint32_t stream_version = 1; // 0: no marker, 1: lod ranges
+    }
+
     Renderable::Renderable(weak_ptr<Entity> entity) : Component(entity)
     {
         SP_REGISTER_ATTRIBUTE_VALUE_VALUE(m_material_default,           bool);
-        SP_REGISTER_ATTRIBUTE_VALUE_VALUE(m_material,                   Material*);
+        SP_REGISTER_ATTRIBUTE_VALUE_SET(m_material,                     SetMaterialReference, Material*);
         SP_REGISTER_ATTRIBUTE_VALUE_VALUE(m_flags,                      uint32_t);
         SP_REGISTER_ATTRIBUTE_VALUE_VALUE(m_geometry_index_offset,      uint32_t);
         SP_REGISTER_ATTRIBUTE_VALUE_VALUE(m_geometry_index_count,       uint32_t);
         SP_REGISTER_ATTRIBUTE_VALUE_VALUE(m_geometry_vertex_offset,     uint32_t);
         SP_REGISTER_ATTRIBUTE_VALUE_VALUE(m_geometry_vertex_count,      uint32_t);
-        SP_REGISTER_ATTRIBUTE_VALUE_VALUE(m_mesh,                       Mesh*);
+        SP_REGISTER_ATTRIBUTE_VALUE_SET(m_mesh,                         SetMeshReference,     Mesh*);
         SP_REGISTER_ATTRIBUTE_VALUE_VALUE(m_bounding_box_untransformed, BoundingBox);
     }
 
     Renderable::~Renderable()
     {
-        m_mesh = nullptr;
+        SetMeshReference(nullptr);
+        SetMaterialReference(nullptr);
     }
     
     void Renderable::Serialize(FileStream* stream)
     {
+        stream->Write(stream_marker);
+        stream->Write(stream_version);
+
         // mesh
         stream->Write(m_geometry_index_offset);
         stream->Write(m_geometry_index_count);
         stream->Write(m_geometry_vertex_offset);
         stream->Write(m_geometry_vertex_count);
         stream->Write(m_bounding_box_untransformed);
+        stream->Write(static_cast<uint32_t>(m_lods.size()));
+        for (const MeshLod& lod : m_lods)
+        {
+            stream->Write(lod.index_offset);
+            stream->Write(lod.index_count);
+        }
         MeshType mesh_type = m_mesh ? m_mesh->GetType() : MeshType::Max;
         stream->Write(static_cast<uint32_t>(mesh_type));
         if (mesh_type == MeshType::Custom)
@@ -81,23 +98,44 @@ namespace Spartan
 
     void Renderable::Deserialize(FileStream* stream)
     {
+        uint32_t version      = 0;
+        uint32_t index_offset = stream->ReadAs<uint32_t>();
+        if (index_offset == stream_marker)
+        {
+            version      = stream->ReadAs<uint32_t>();
+            index_offset = stream->ReadAs<uint32_t>();
+        }
+
+        if (version > stream_version)
+        {
+            SP_LOG_ERROR("Renderable stream version %d is newer than the supported version %d", version, stream_version);
+            return;
+        }
+
         // geometry
-        m_geometry_index_offset  = stream->ReadAs<uint32_t>();
+        m_geometry_index_offset  = index_offset;
         m_geometry_index_count   = stream->ReadAs<uint32_t>();
         m_geometry_vertex_offset = stream->ReadAs<uint32_t>();
         m_geometry_vertex_count  = stream->ReadAs<uint32_t>();
         stream->Read(&m_bounding_box_untransformed);
+        vector<MeshLod> lods(version >= 1 ? stream->ReadAs<uint32_t>() : 0);
+        for (MeshLod& lod : lods)
+        {
+            lod.index_offset = stream->ReadAs<uint32_t>();
+            lod.index_count  = stream->ReadAs<uint32_t>();
+        }
         MeshType mesh_type = static_cast<MeshType>(stream->ReadAs<uint32_t>());
         if (mesh_type == MeshType::Custom)
         {
             string model_name;
             stream->Read(&model_name);
-            m_mesh = ResourceCache::GetByName<Mesh>(model_name).get();
+            SetMeshReference(ResourceCache::GetByName<Mesh>(model_name).get());
         }
         else if (mesh_type != MeshType::Max)
         {
             SetGeometry(mesh_type);
         }
+        SetLods(lods); // after the mesh, setting a standard mesh resets them
 
         // material
         stream->Read(&m_flags);
@@ -110,7 +148,7 @@ namespace Spartan
         {
             string material_name;
             stream->Read(&material_name);
-            m_material = ResourceCache::GetByName<Material>(material_name).get();
+            SetMaterialReference(ResourceCache::GetByName<Material>(material_name).get());
         }
     }
 
@@ -121,12 +159,15 @@ namespace Spartan
         uint32_t vertex_offset /*= 0*/, uint32_t vertex_count /*= 0 */
     )
     {
-        m_mesh                       = mesh;
+        SetMeshReference(mesh);
         m_bounding_box_untransformed = aabb;
         m_geometry_index_offset      = index_offset;
         m_geometry_index_count       = index_count;
         m_geometry_vertex_offset     = vertex_offset;
         m_geometry_vertex_count      = vertex_count;
+        m_geometry_changed_frame     = Renderer::GetFrameNum();
+        m_lod_index                  = 0;
+        m_lods.clear();
 
         if (m_geometry_index_count == 0)
         {
@@ -153,13 +194,32 @@ namespace Spartan
         SetGeometry(Renderer::GetStandardMesh(type).get());
     }
 
+    void Renderable::SetIndexRange(const uint32_t index_offset, const uint32_t index_count)
+    {
+        SP_ASSERT(index_count != 0);
+
+        m_geometry_index_offset = index_offset;
+        m_geometry_index_count  = index_count;
+    }
+
+    void Renderable::SetLods(const vector<MeshLod>& lods)
+    {
+        m_lods      = lods;
+        m_lod_index = 0;
+    }
+
+    void Renderable::SetLodIndex(const uint32_t index)
+    {
+        m_lod_index = min(index, GetLodCount() - 1);
+    }
+
     void Renderable::GetGeometry(vector<uint32_t>* indices, vector<RHI_Vertex_PosTexNorTan>* vertices) const
     {
         SP_ASSERT_MSG(m_mesh != nullptr, "invalid mesh");
         m_mesh->GetGeometry(m_geometry_index_offset, m_geometry_index_count, m_geometry_vertex_offset, m_geometry_vertex_count, indices, vertices);
     }
 
-	const BoundingBox& Renderable::GetBoundingBox(const BoundingBoxType type, const uint32_t instance_group_index)
+	const BoundingBox& Renderable::GetBoundingBox(const BoundingBoxType type, const uint32_t index)
 	{
         // compute if dirty
         if (m_bounding_box_dirty || m_transform_previous != GetEntity()->GetMatrix())
@@ -175,12 +235,13 @@ namespace Spartan
             {
                 // loop through each instance and expand the bounding box
                 m_bounding_box_instances = BoundingBox::Undefined;
-                for (const Matrix& instance_transform : m_instances)
+                m_bounding_box_instance.resize(m_instances.size());
+                for (uint32_t i = 0; i < static_cast<uint32_t>(m_instances.size()); i++)
                 {
                     // transform * instance_transform, this is not the order of operation the engine is using but in this case it works
                     // possibly due to how the transform is calculated, the space it's in and relative to what
-                    BoundingBox bounding_box_instance = m_bounding_box_untransformed.Transform(transform * instance_transform);
-                    m_bounding_box_instances.Merge(bounding_box_instance);
+                    m_bounding_box_instance[i] = m_bounding_box_untransformed.Transform(transform * m_instances[i]);
+                    m_bounding_box_instances.Merge(m_bounding_box_instance[i]);
                 }
             }
 
@@ -195,8 +256,7 @@ namespace Spartan
                     BoundingBox bounding_box_group = BoundingBox::Undefined;
                     for (uint32_t i = start_index; i < group_end_index; i++)
                     {
-                        BoundingBox bounding_box_instance = m_bounding_box_untransformed.Transform(transform * m_instances[i]);
-                        bounding_box_group.Merge(bounding_box_instance);
+                        bounding_box_group.Merge(m_bounding_box_instance[i]);
                     }
 
                     m_bounding_box_instance_group.push_back(bounding_box_group);
@@ -223,7 +283,11 @@ namespace Spartan
         }
         else if (type == BoundingBoxType::TransformedInstanceGroup)
         {
-            return m_bounding_box_instance_group[instance_group_index];
+            return m_bounding_box_instance_group[index];
+        }
+        else if (type == BoundingBoxType::TransformedInstance)
+        {
+            return m_bounding_box_instance[index];
         }
 
         return BoundingBox::Undefined;
@@ -236,11 +300,14 @@ namespace Spartan
         // in order for the component to guarantee serialization/deserialization, we cache the material
         shared_ptr<Material> _material = ResourceCache::Cache(material);
 
-        m_material = _material.get();
+        SetMaterialReference(_material.get());
 
         // set to false otherwise material won't serialize/deserialize
         m_material_default = false;
 
+        // the renderer needs to move the entity to the new material's bindless slot
+        World::Resolve(GetEntity());
+
         return _material;
     }
 
@@ -264,6 +331,42 @@ namespace Spartan
         m_material_default = true;
     }
 
+    void Renderable::SetMeshReference(Mesh* mesh)
+    {
+        if (m_mesh == mesh)
+            return;
+
+        if (m_mesh)
+        {
+            m_mesh->RemoveReference();
+        }
+
+        m_mesh = mesh;
+
+        if (m_mesh)
+        {
+            m_mesh->AddReference();
+        }
+    }
+
+    void Renderable::SetMaterialReference(Material* material)
+    {
+        if (m_material == material)
+            return;
+
+        if (m_material)
+        {
+            m_material->RemoveReference();
+        }
+
+        m_material = material;
+
+        if (m_material)
+        {
+            m_material->AddReference();
+        }
+    }
+
     string Renderable::GetMaterialName() const
     {
         return m_material ? m_material->GetObjectName() : "";
@@ -296,7 +399,8 @@ namespace Spartan
 
     void Renderable::SetInstances(const vector<Matrix>& instances)
     {
-        m_instances = instances;
+        m_instances              = instances;
+        m_geometry_changed_frame = Renderer::GetFrameNum();
 
         grid_partitioning::reorder_instances_into_cell_chunks(m_instances, m_instance_group_end_indices);
 
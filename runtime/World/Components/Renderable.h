@@ -42,13 +42,14 @@ namespace Spartan
         Transformed,              // the transformed bounding box of the mesh
         TransformedInstances,     // the transformed bounding box of all the instances
         TransformedInstanceGroup, // the transformed bounding box of an instance group
+        TransformedInstance,      // the transformed bounding box of a single instance
     };
 
     enum RenderableFlags : uint32_t
     {
         OccludedCpu  = 1U << 0, // frustum culling
-        OccludedGpu  = 1U << 1, // occlusion culling (depth culling)
-        Occluder     = 1U << 2,
+        Occluded     = 1U << 1, // occlusion culling (software depth buffer)
+        Occluder     = 1U << 2, // rasterized into the occlusion buffer
         CastsShadows = 1U << 3
     };
 
@@ -70,12 +71,24 @@ namespace Spartan
             uint32_t vertex_offset = 0, uint32_t vertex_count = 0
         );
         void SetGeometry(const MeshType type);
+
+        // switches to another index range of the same vertices (e.g. a lod the owner picked), unlike SetGeometry()
+        // this doesn't count as a geometry change, so it doesn't invalidate cached shadows
+        void SetIndexRange(uint32_t index_offset, uint32_t index_count);
         void GetGeometry(std::vector<uint32_t>* indices, std::vector<RHI_Vertex_PosTexNorTan>* vertices) const;
 
+        // lods, lod 0 is the geometry above and the rest are simplified index ranges which share its vertices
+        void SetLods(const std::vector<MeshLod>& lods);
+        uint32_t GetLodCount() const       { return static_cast<uint32_t>(m_lods.size()) + 1; }
+        uint32_t GetLodIndex() const       { return m_lod_index; }
+        void SetLodIndex(const uint32_t index);
+        uint32_t GetLodIndexOffset() const { return m_lod_index == 0 ? m_geometry_index_offset : m_lods[m_lod_index - 1].index_offset; }
+        uint32_t GetLodIndexCount() const  { return m_lod_index == 0 ? m_geometry_index_count  : m_lods[m_lod_index - 1].index_count; }
+
         // bounding box
         const std::vector<uint32_t>& GetBoundingBoxGroupEndIndices() const { return m_instance_group_end_indices; }
         uint32_t GetInstancePartitionCount() const                         { return static_cast<uint32_t>(m_instance_group_end_indices.size()); }
-        const Math::BoundingBox& GetBoundingBox(const BoundingBoxType type, const uint32_t instance_group_index = 0);
+        const Math::BoundingBox& GetBoundingBox(const BoundingBoxType type, const uint32_t index = 0);
 
         //= MATERIAL ====================================================================
         // Sets a material from memory (adds it to the resource cache by default)
@@ -96,9 +109,10 @@ namespace Spartan
         const std::string& GetMeshName() const;
 
         // instancing
-        bool HasInstancing() const                  { return !m_instances.empty(); }
-        RHI_VertexBuffer* GetInstanceBuffer() const { return m_instance_buffer.get(); }
-        uint32_t GetInstanceCount()  const          { return static_cast<uint32_t>(m_instances.size()); }
+        bool HasInstancing() const                            { return !m_instances.empty(); }
+        RHI_VertexBuffer* GetInstanceBuffer() const           { return m_instance_buffer.get(); }
+        uint32_t GetInstanceCount()  const                    { return static_cast<uint32_t>(m_instances.size()); }
+        const std::vector<Math::Matrix>& GetInstances() const { return m_instances; }
         void SetInstances(const std::vector<Math::Matrix>& instances);
 
         // misc
@@ -106,24 +120,34 @@ namespace Spartan
         uint32_t GetIndexCount() const   { return m_geometry_index_count; }
         uint32_t GetVertexOffset() const { return m_geometry_vertex_offset; }
         uint32_t GetVertexCount() const  { return m_geometry_vertex_count; }
-        bool IsVisible() const           { return !(m_flags & RenderableFlags::OccludedCpu) && !(m_flags & RenderableFlags::OccludedGpu); }
+        bool IsVisible() const           { return !(m_flags & RenderableFlags::OccludedCpu) && !(m_flags & RenderableFlags::Occluded); }
         bool HasMesh() const             { return m_mesh != nullptr; }
 
+        // the frame the geometry or the instances were last changed, used to invalidate cached shadows
+        uint64_t GetGeometryChangedFrame() const { return m_geometry_changed_frame; }
+
         // flags
         bool HasFlag(const RenderableFlags flag) { return m_flags & flag; }
         void SetFlag(const RenderableFlags flag, const bool enable = true);
 
     private:
+        // the mesh and the material are held by raw pointers, these count them so that the resource cache knows they are in use
+        void SetMeshReference(Mesh* mesh);
+        void SetMaterialReference(Material* material);
+
         // geometry/mesh
         uint32_t m_geometry_index_offset  = 0;
         uint32_t m_geometry_index_count   = 0;
         uint32_t m_geometry_vertex_offset = 0;
         uint32_t m_geometry_vertex_count  = 0;
         Mesh* m_mesh                      = nullptr;
+        std::vector<MeshLod> m_lods;
+        uint32_t m_lod_index              = 0;
         bool m_bounding_box_dirty         = true;
         Math::BoundingBox m_bounding_box_untransformed;
         Math::BoundingBox m_bounding_box;
         Math::BoundingBox m_bounding_box_instances;
+        std::vector<Math::BoundingBox> m_bounding_box_instance;
         std::vector<Math::BoundingBox> m_bounding_box_instance_group;
 
         // material
@@ -138,5 +162,6 @@ namespace Spartan
         // misc
         Math::Matrix m_transform_previous = Math::Matrix::Identity;
         uint32_t m_flags                  = RenderableFlags::CastsShadows;
+        uint64_t m_geometry_changed_frame = 0;
     };
 }
@@ -30,6 +30,10 @@ CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 #include "../../Resource/ResourceCache.h"
 #include "../../Rendering/Mesh.h"
 #include "../../Core/ThreadPool.h"
+#include "../../Profiling/Profiler.h"
+#include "../../Rendering/Renderer.h"
+#include "Camera.h"
+#include "../../Rendering/GridPartitioning.h"
 //=======================================
 
 //= NAMESPACES ===============
@@ -43,6 +47,80 @@ namespace Spartan
     {
         const uint32_t smoothing_iterations = 1; // the number of height map neighboring pixel averaging
         const uint32_t tile_count           = 8; // the number of tiles in each dimension to split the terrain into
+        const uint32_t lod_count            = 4; // every lod halves the vertex density of the previous one
+        const float lod_distance_scale      = 1.0f; // lod 0 is used up to this many tile sizes away, every next lod doubles that
+        const float skirt_depth             = 10.0f; // tiles hang a skirt of this depth around their edges to hide cracks between lods
+
+        // runs a function over [0, work_total) on the thread pool, or inline if there is too little work to split
+        void parallel_for(const uint32_t work_total, function<void(uint32_t start, uint32_t end)>&& function)
+        {
+            if (work_total > 1 && ThreadPool::GetIdleThreadCount() > 0)
+            {
+                ThreadPool::ParallelLoop(move(function), work_total);
+            }
+            else
+            {
+                function(0, work_total);
+            }
+        }
+
+        void smooth_height_map(vector<float>& height_data, const uint32_t width, const uint32_t height)
+        {
+            // a 3x3 box filter (with the neighbour count normalized at the edges) is separable into
+            // a horizontal and a vertical 3 tap pass, the inner loops are branchless and vectorize
+            const float third = 1.0f / 3.0f;
+            vector<float> horizontal(height_data.size());
+
+            for (uint32_t iteration = 0; iteration < smoothing_iterations; iteration++)
+            {
+                parallel_for(height, [&](uint32_t row_start, uint32_t row_end)
+                {
+                    for (uint32_t y = row_start; y < row_end; y++)
+                    {
+                        const float* in = &height_data[y * width];
+                        float* out      = &horizontal[y * width];
+
+                        out[0] = width > 1 ? (in[0] + in[1]) * 0.5f : in[0];
+                        for (uint32_t x = 1; x < width - 1; x++)
+                        {
+                            out[x] = (in[x - 1] + in[x] + in[x + 1]) * third;
+                        }
+                        if (width > 1)
+                        {
+                            out[width - 1] = (in[width - 2] + in[width - 1]) * 0.5f;
+                        }
+                    }
+                });
+
+                parallel_for(height, [&](uint32_t row_start, uint32_t row_end)
+                {
+                    for (uint32_t y = row_start; y < row_end; y++)
+                    {
+                        const float* above = &horizontal[(y > 0 ? y - 1 : y) * width];
+                        const float* row   = &horizontal[y * width];
+                        const float* below = &horizontal[(y < height - 1 ? y + 1 : y) * width];
+                        float* out         = &height_data[y * width];
+
+                        if (y > 0 && y < height - 1)
+                        {
+                            for (uint32_t x = 0; x < width; x++)
+                            {
+                                out[x] = (above[x] + row[x] + below[x]) * third;
+                            }
+                        }
+                        else
+                        {
+                            // at the edges above or below points to the row itself
+                            const float* neighbour = y > 0 ? above : below;
+                            for (uint32_t x = 0; x < width; x++)
+                            {
+                                out[x] = height > 1 ? (row[x] + neighbour[x]) * 0.5f : row[x];
+                            }
+                        }
+                    }
+                });
+            }
+        }
 
         bool generate_height_points_from_height_map(vector<float>& height_data_out, shared_ptr<RHI_Texture> height_texture, float min_y, float max_y)
         {
@@ -64,461 +142,576 @@ namespace Spartan
                 }
             }
 
+            const uint32_t width  = height_texture->GetWidth();
+            const uint32_t height = height_texture->GetHeight();
+
             // read from the red channel and save a normalized height value
             {
                 // bytes per pixel
-                uint32_t bytes_per_pixel = (height_texture->GetChannelCount() * height_texture->GetBitsPerChannel()) / 8;
+                const uint32_t bytes_per_pixel = (height_texture->GetChannelCount() * height_texture->GetBitsPerChannel()) / 8;
+                const float scale              = (max_y - min_y) / 255.0f;
 
                 // normalize and scale height data
                 height_data_out.resize(height_data.size() / bytes_per_pixel);
-                for (uint32_t i = 0; i < height_data.size(); i += bytes_per_pixel)
+                parallel_for(height, [&](uint32_t row_start, uint32_t row_end)
                 {
-                    // assuming the height is stored in the red channel (first channel)
-                    height_data_out[i / bytes_per_pixel] = min_y + (static_cast<float>(height_data[i]) / 255.0f) * (max_y - min_y);
-                }
+                    for (uint32_t i = row_start * width; i < row_end * width; i++)
+                    {
+                        // assuming the height is stored in the red channel (first channel)
+                        height_data_out[i] = min_y + static_cast<float>(height_data[i * bytes_per_pixel]) * scale;
+                    }
+                });
             }
 
             // smooth out the height map values, this will reduce hard terrain edges
-            {
-                const uint32_t width  = height_texture->GetWidth();
-                const uint32_t height = height_texture->GetHeight();
+            smooth_height_map(height_data_out, width, height);
+
+            return true;
+        }
+
+        void generate_vertices(vector<RHI_Vertex_PosTexNorTan>& vertices, const vector<float>& height_map, const uint32_t width, const uint32_t height)
+        {
+            SP_ASSERT_MSG(!height_map.empty(), "Height map is empty");
 
-                for (uint32_t iteration = 0; iteration < smoothing_iterations; iteration++)
+            const float u_step = 1.0f / static_cast<float>(width - 1);
+            const float v_step = 1.0f / static_cast<float>(height - 1);
+
+            parallel_for(height, [&](uint32_t row_start, uint32_t row_end)
+            {
+                for (uint32_t y = row_start; y < row_end; y++)
                 {
-                    vector<float> smoothed_height_data = height_data_out; // create a copy to store the smoothed data
+                    // neighbouring rows, clamped at the edges
+                    const float* row   = &height_map[y * width];
+                    const float* above = &height_map[(y > 0 ? y - 1 : y) * width];
+                    const float* below = &height_map[(y < height - 1 ? y + 1 : y) * width];
+                    const float dz     = (y > 0 && y < height - 1) ? 2.0f : 1.0f;
 
-                    for (uint32_t y = 0; y < height; y++)
+                    for (uint32_t x = 0; x < width; x++)
                     {
-                        for (uint32_t x = 0; x < width; x++)
-                        {
-                            float sum      = height_data_out[y * width + x];
-                            uint32_t count = 1;
+                        RHI_Vertex_PosTexNorTan& vertex = vertices[y * width + x];
 
-                            // iterate over neighboring pixels
-                            for (int ny = -1; ny <= 1; ++ny)
-                            {
-                                for (int nx = -1; nx <= 1; ++nx)
-                                {
-                                    // skip self/center pixel
-                                    if (nx == 0 && ny == 0)
-                                        continue;
-
-                                    uint32_t neighbor_x = x + nx;
-                                    uint32_t neighbor_y = y + ny;
-
-                                    // check boundaries
-                                    if (neighbor_x >= 0 && neighbor_x < width && neighbor_y >= 0 && neighbor_y < height)
-                                    {
-                                        sum += height_data_out[neighbor_y * width + neighbor_x];
-                                        count++;
-                                    }
-                                }
-                            }
+                        // center on the X and Z axis
+                        vertex.pos[0] = static_cast<float>(x) - width * 0.5f;
+                        vertex.pos[1] = row[x];
+                        vertex.pos[2] = static_cast<float>(y) - height * 0.5f;
 
-                            // average the sum
-                            smoothed_height_data[y * width + x] = sum / static_cast<float>(count);
-                        }
-                    }
+                        vertex.tex[0] = static_cast<float>(x) * u_step;
+                        vertex.tex[1] = static_cast<float>(y) * v_step;
 
-                    height_data_out = smoothed_height_data;
-                }
+                        // normal and tangent straight from the height grid (central differences), no adjacency needed
+                        const uint32_t x_left  = x > 0 ? x - 1 : x;
+                        const uint32_t x_right = x < width - 1 ? x + 1 : x;
+                        const float slope_x    = (row[x_right] - row[x_left]) / static_cast<float>(x_right - x_left);
+                        const float slope_z    = (below[x] - above[x]) / dz;
 
-            }
+                        const Vector3 normal  = Vector3(-slope_x, 1.0f, -slope_z).Normalized();
+                        const Vector3 tangent = Vector3(1.0f, slope_x, 0.0f).Normalized();
 
-            return true;
+                        vertex.nor[0] = normal.x;
+                        vertex.nor[1] = normal.y;
+                        vertex.nor[2] = normal.z;
+
+                        vertex.tan[0] = tangent.x;
+                        vertex.tan[1] = tangent.y;
+                        vertex.tan[2] = tangent.z;
+                    }
+                }
+            });
         }
 
-        void generate_positions(vector<Vector3>& positions, const vector<float>& height_map, const uint32_t width, const uint32_t height)
+        // writes the two triangles of every quad in [x_start, x_end) x [y_start, y_end), vertex indices are relative to the
+        // top left corner of the range and rows are vertex_stride apart, so the same code serves the whole terrain and its tiles
+        void generate_indices(uint32_t* indices, const uint32_t x_start, const uint32_t x_end, const uint32_t y_start, const uint32_t y_end, const uint32_t vertex_stride)
         {
-            SP_ASSERT_MSG(!height_map.empty(), "Height map is empty");
-
-            for (uint32_t y = 0; y < height; y++)
+            uint32_t k = 0;
+            for (uint32_t y = y_start; y < y_end; y++)
             {
-                for (uint32_t x = 0; x < width; x++)
+                for (uint32_t x = x_start; x < x_end; x++)
                 {
-                    uint32_t index = y * width + x;
-
-                    // center on the X and Z axis
-                    float centered_x = static_cast<float>(x) - width * 0.5f;
-                    float centered_z = static_cast<float>(y) - height * 0.5f;
+                    const uint32_t index_bottom_left  = (y - y_start) * vertex_stride + (x - x_start);
+                    const uint32_t index_bottom_right = index_bottom_left + 1;
+                    const uint32_t index_top_left     = index_bottom_left + vertex_stride;
+                    const uint32_t index_top_right    = index_top_left + 1;
+
+                    indices[k + 0] = index_bottom_right;
+                    indices[k + 1] = index_bottom_left;
+                    indices[k + 2] = index_top_left;
+                    indices[k + 3] = index_bottom_right;
+                    indices[k + 4] = index_top_left;
+                    indices[k + 5] = index_top_right;
 
-                    // get height from height_map
-                    float height_value = height_map[index]; 
-
-                    positions[index] = Vector3(centered_x, height_value, centered_z);
+                    k += 6; // next quad
                 }
             }
         }
 
-        void generate_vertices_and_indices(vector<RHI_Vertex_PosTexNorTan>& vertices, vector<uint32_t>& indices, const vector<Vector3>& positions, const uint32_t width, const uint32_t height)
+        // counter based random numbers, the same (seed, stream, counter) always gives the same value,
+        // regardless of which thread asks or in what order, which keeps parallel scattering reproducible
+        uint32_t hash(uint32_t x)
+        {
+            x ^= x >> 16;
+            x *= 0x7feb352d;
+            x ^= x >> 15;
+            x *= 0x846ca68b;
+            x ^= x >> 16;
+            return x;
+        }
+
+        float get_random_float(const uint32_t seed, const uint32_t stream, const uint32_t counter, const float min, const float max)
         {
-            SP_ASSERT_MSG(!positions.empty(), "Positions are empty");
+            const uint32_t bits = hash(seed ^ hash(stream ^ hash(counter)));
+            return min + static_cast<float>(bits >> 8) * (1.0f / 16777216.0f) * (max - min);
+        }
+
+        // a hash grid over the xz plane, used to enforce a minimum distance between scattered objects
+        class SpatialHash
+        {
+        public:
+            SpatialHash(const float cell_size, const uint32_t capacity) : m_cell_size(cell_size)
+            {
+                uint32_t bucket_count = 1;
+                while (bucket_count < capacity * 2)
+                {
+                    bucket_count <<= 1;
+                }
+
+                m_bucket_mask = bucket_count - 1;
+                m_buckets.assign(bucket_count, numeric_limits<uint32_t>::max());
+                m_positions.reserve(capacity);
+                m_next.reserve(capacity);
+            }
 
-            Vector3 offset = Vector3::Zero;
+            bool IsFree(const Vector3& position) const
             {
-                // calculate offsets to center the terrain
-                float offset_x   = -static_cast<float>(width) * 0.5f;
-                float offset_z   = -static_cast<float>(height) * 0.5f;
-                float min_height = FLT_MAX;
+                const int32_t cell_x           = get_cell(position.x);
+                const int32_t cell_z           = get_cell(position.z);
+                const float distance_squared   = m_cell_size * m_cell_size;
 
-                // find the minimum height to align the lower part of the terrain at y = 0
-                for (const Vector3& pos : positions)
+                for (int32_t z = cell_z - 1; z <= cell_z + 1; z++)
                 {
-                    if (pos.y < min_height)
+                    for (int32_t x = cell_x - 1; x <= cell_x + 1; x++)
                     {
-                        min_height = pos.y;
+                        // buckets can contain other cells too, the distance test filters them out
+                        for (uint32_t i = m_buckets[get_bucket(x, z)]; i != numeric_limits<uint32_t>::max(); i = m_next[i])
+                        {
+                            const float dx = m_positions[i].x - position.x;
+                            const float dz = m_positions[i].z - position.z;
+                            if (dx * dx + dz * dz < distance_squared)
+                                return false;
+                        }
                     }
                 }
 
-                offset = Vector3(offset_x, -min_height, offset_z);
+                return true;
             }
 
-            uint32_t index = 0;
-            uint32_t k     = 0;
-            for (uint32_t y = 0; y < height - 1; y++)
+            void Insert(const Vector3& position)
             {
-                for (uint32_t x = 0; x < width - 1; x++)
-                {
-                    Vector3 position = positions[index] + offset;
-
-                    float u = static_cast<float>(x) / static_cast<float>(width - 1);
-                    float v = static_cast<float>(y) / static_cast<float>(height - 1);
-
-                    const uint32_t index_bottom_left  = y * width + x;
-                    const uint32_t index_bottom_right = y * width + x + 1;
-                    const uint32_t index_top_left     = (y + 1) * width + x;
-                    const uint32_t index_top_right    = (y + 1) * width + x + 1;
-
-                    // bottom right of quad
-                    index           = index_bottom_right;
-                    indices[k]      = index;
-                    vertices[index] = RHI_Vertex_PosTexNorTan(positions[index], Vector2(u + 1.0f / (width - 1), v + 1.0f / (height - 1)));
-
-                    // bottom left of quad
-                    index           = index_bottom_left;
-                    indices[k + 1]  = index;
-                    vertices[index] = RHI_Vertex_PosTexNorTan(positions[index], Vector2(u, v + 1.0f / (height - 1)));
-
-                    // top left of quad
-                    index           = index_top_left;
-                    indices[k + 2]  = index;
-                    vertices[index] = RHI_Vertex_PosTexNorTan(positions[index], Vector2(u, v));
-
-                    // bottom right of quad
-                    index           = index_bottom_right;
-                    indices[k + 3]  = index;
-                    vertices[index] = RHI_Vertex_PosTexNorTan(positions[index], Vector2(u + 1.0f / (width - 1), v + 1.0f / (height - 1)));
-
-                    // top left of quad
-                    index           = index_top_left;
-                    indices[k + 4]  = index;
-                    vertices[index] = RHI_Vertex_PosTexNorTan(positions[index], Vector2(u, v));
-
-                    // top right of quad
-                    index           = index_top_right;
-                    indices[k + 5]  = index;
-                    vertices[index] = RHI_Vertex_PosTexNorTan(positions[index], Vector2(u + 1.0f / (width - 1), v));
+                const uint32_t bucket = get_bucket(get_cell(position.x), get_cell(position.z));
+                m_next.emplace_back(m_buckets[bucket]);
+                m_buckets[bucket] = static_cast<uint32_t>(m_positions.size());
+                m_positions.emplace_back(position);
+            }
 
-                    k += 6; // next quad
-                }
+        private:
+            int32_t get_cell(const float value) const
+            {
+                return static_cast<int32_t>(floor(value / m_cell_size));
+            }
+
+            uint32_t get_bucket(const int32_t x, const int32_t z) const
+            {
+                return hash(static_cast<uint32_t>(x) * 73856093u ^ static_cast<uint32_t>(z) * 19349663u) & m_bucket_mask;
             }
-        }
 
-        void generate_normals(const vector<uint32_t>& indices, vector<RHI_Vertex_PosTexNorTan>& vertices)
+            float m_cell_size      = 1.0f;
+            uint32_t m_bucket_mask = 0;
+            vector<uint32_t> m_buckets;
+            vector<uint32_t> m_next;
+            vector<Vector3> m_positions;
+        };
+
+        struct ScatterParameters
+        {
+            uint32_t count                 = 0;
+            uint32_t seed                  = 0;
+            float max_slope_radians        = 0.0f;
+            float min_spacing              = 0.0f;
+            float terrain_offset           = 0.0f;
+            bool rotate_to_match_normal    = false;
+        };
+
+        vector<Matrix> generate_transforms(const vector<RHI_Vertex_PosTexNorTan>& vertices, const uint32_t width, const uint32_t height, const ScatterParameters& parameters)
         {
-            SP_ASSERT_MSG(!indices.empty(), "Indices are empty");
-            SP_ASSERT_MSG(!vertices.empty(), "Vertices are empty");
+            const uint32_t quad_count_x     = width - 1;
+            const uint32_t quad_count_y     = height - 1;
+            const uint32_t tile_total       = tile_count * tile_count;
+            const uint32_t attempts_per_obj = 30; // candidates rejected by spacing get retried, up to this many times per object
+            const float sea_level           = 0.0f;             // this is a fact across the engine
+            const float height_threshold    = sea_level + 4.0f; // don't want things to grow too close to see level (where sand could be)
+            const float min_normal_y        = cos(parameters.max_slope_radians);
+
+            auto get_position = [&vertices, width](const uint32_t x, const uint32_t y)
+            {
+                const RHI_Vertex_PosTexNorTan& vertex = vertices[y * width + x];
+                return Vector3(vertex.pos[0], vertex.pos[1], vertex.pos[2]);
+            };
+
+            // a tile is a range of grid quads, the triangles of each quad are the same as in generate_indices()
+            auto get_triangle = [&get_position](const uint32_t x, const uint32_t y, const uint32_t triangle, Vector3& v0, Vector3& v1, Vector3& v2)
+            {
+                v0 = get_position(x + 1, y);
+                v1 = triangle == 0 ? get_position(x, y)     : get_position(x, y + 1);
+                v2 = triangle == 0 ? get_position(x, y + 1) : get_position(x + 1, y + 1);
+            };
 
-            uint32_t triangle_count = static_cast<uint32_t>(indices.size()) / 3;
-            vector<Vector3> face_normals(triangle_count);
-            vector<Vector3> face_tangents(triangle_count);
-            vector<vector<uint32_t>> vertex_to_triangle_map(vertices.size());
-            Vector3 edge_a, edge_b;
+            struct Tile
+            {
+                uint32_t x_start = 0, x_end = 0, y_start = 0, y_end = 0;
+                vector<float> area_cdf; // over all the triangles of the tile, unsuitable ones have zero area
+                vector<Vector3> positions;
+                vector<Vector3> normals;
+            };
+            vector<Tile> tiles(tile_total);
 
-            for (uint32_t i = 0; i < triangle_count; ++i)
+            // 1. the suitable area of every tile, in parallel
+            parallel_for(tile_total, [&](uint32_t tile_start, uint32_t tile_end)
             {
-                uint32_t index_a = indices[i * 3];
-                uint32_t index_b = indices[i * 3 + 1];
-                uint32_t index_c = indices[i * 3 + 2];
+                for (uint32_t tile_index = tile_start; tile_index < tile_end; tile_index++)
+                {
+                    Tile& tile   = tiles[tile_index];
+                    tile.x_start = (tile_index % tile_count) * quad_count_x / tile_count;
+                    tile.x_end   = (tile_index % tile_count + 1) * quad_count_x / tile_count;
+                    tile.y_start = (tile_index / tile_count) * quad_count_y / tile_count;
+                    tile.y_end   = (tile_index / tile_count + 1) * quad_count_y / tile_count;
+                    tile.area_cdf.resize((tile.x_end - tile.x_start) * (tile.y_end - tile.y_start) * 2);
+
+                    float area_total = 0.0f;
+                    uint32_t k       = 0;
+                    for (uint32_t y = tile.y_start; y < tile.y_end; y++)
+                    {
+                        for (uint32_t x = tile.x_start; x < tile.x_end; x++)
+                        {
+                            for (uint32_t triangle = 0; triangle < 2; triangle++)
+                            {
+                                Vector3 v0, v1, v2;
+                                get_triangle(x, y, triangle, v0, v1, v2);
+
+                                const Vector3 cross           = Vector3::Cross(v1 - v0, v2 - v0);
+                                const float area              = cross.Length() * 0.5f;
+                                const bool is_relatively_flat = area > 0.0f && abs(cross.y) / (area * 2.0f) >= min_normal_y;
+                                const bool is_above_threshold = v0.y >= height_threshold && v1.y >= height_threshold && v2.y >= height_threshold;
 
-                vertex_to_triangle_map[index_a].push_back(i);
-                vertex_to_triangle_map[index_b].push_back(i);
-                vertex_to_triangle_map[index_c].push_back(i);
+                                area_total        += (is_relatively_flat && is_above_threshold) ? area : 0.0f;
+                                tile.area_cdf[k++] = area_total;
+                            }
+                        }
+                    }
+                }
+            });
 
-                edge_a.x = vertices[index_a].pos[0] - vertices[index_b].pos[0];
-                edge_a.y = vertices[index_a].pos[1] - vertices[index_b].pos[1];
-                edge_a.z = vertices[index_a].pos[2] - vertices[index_b].pos[2];
+            float area_total = 0.0f;
+            for (const Tile& tile : tiles)
+            {
+                area_total += tile.area_cdf.empty() ? 0.0f : tile.area_cdf.back();
+            }
 
-                edge_b.x = vertices[index_b].pos[0] - vertices[index_c].pos[0];
-                edge_b.y = vertices[index_b].pos[1] - vertices[index_c].pos[1];
-                edge_b.z = vertices[index_b].pos[2] - vertices[index_c].pos[2];
+            if (area_total <= 0.0f)
+            {
+                SP_LOG_WARNING("The terrain has no area suitable for scattering");
+                return {};
+            }
 
-                face_normals[i] = Vector3::Cross(edge_a, edge_b);
+            // a random point on the suitable area of a tile, it consumes three counters starting at the given one
+            auto sample = [&](const Tile& tile, const uint32_t stream, const uint32_t counter, Vector3& position, Vector3& normal)
+            {
+                // pick a triangle, weighted by area
+                const float tile_area   = tile.area_cdf.empty() ? 0.0f : tile.area_cdf.back();
+                const float r           = get_random_float(parameters.seed, stream, counter, 0.0f, tile_area);
+                const uint32_t triangle = static_cast<uint32_t>(upper_bound(tile.area_cdf.begin(), tile.area_cdf.end(), r) - tile.area_cdf.begin());
+                if (triangle >= tile.area_cdf.size())
+                    return false;
+
+                const uint32_t quads_x = tile.x_end - tile.x_start;
+                const uint32_t quad    = triangle / 2;
+                Vector3 v0, v1, v2;
+                get_triangle(tile.x_start + quad % quads_x, tile.y_start + quad / quads_x, triangle % 2, v0, v1, v2);
+
+                // uniform barycentric coordinates
+                float u = get_random_float(parameters.seed, stream, counter + 1, 0.0f, 1.0f);
+                float v = get_random_float(parameters.seed, stream, counter + 2, 0.0f, 1.0f);
+                if (u + v > 1.0f)
+                {
+                    u = 1.0f - u;
+                    v = 1.0f - v;
+                }
 
-                const float tc_u1 = vertices[index_a].tex[0] - vertices[index_b].tex[0];
-                const float tc_v1 = vertices[index_a].tex[1] - vertices[index_b].tex[1];
-                const float tc_u2 = vertices[index_b].tex[0] - vertices[index_c].tex[0];
-                const float tc_v2 = vertices[index_b].tex[1] - vertices[index_c].tex[1];
+                position = v0 + u * (v1 - v0) + v * (v2 - v0);
+                normal   = Vector3::Cross(v1 - v0, v2 - v0).Normalized();
+                return true;
+            };
 
-                float coef = 1.0f / (tc_u1 * tc_v2 - tc_u2 * tc_v1);
-                face_tangents[i] = coef * (tc_v2 * edge_a - tc_v1 * edge_b);
+            // 2. scatter within every tile, in parallel, with a count proportional to the tile's suitable area,
+            // rounding the running total rather than every tile keeps the counts from adding up to more than requested
+            vector<uint32_t> tile_targets(tile_total);
+            {
+                double area_before    = 0.0;
+                uint32_t count_before = 0;
+                for (uint32_t tile_index = 0; tile_index < tile_total; tile_index++)
+                {
+                    area_before               += tiles[tile_index].area_cdf.empty() ? 0.0f : tiles[tile_index].area_cdf.back();
+                    const uint32_t count_after = static_cast<uint32_t>(round(static_cast<double>(parameters.count) * min(area_before / area_total, 1.0)));
+                    tile_targets[tile_index]   = count_after - count_before;
+                    count_before               = count_after;
+                }
             }
 
-            auto compute_vertex_normals_tangents = [&vertices, &vertex_to_triangle_map, &face_normals, &face_tangents](uint32_t start_index, uint32_t end_index)
+            parallel_for(tile_total, [&](uint32_t tile_start, uint32_t tile_end)
             {
-                for (uint32_t i = start_index; i < end_index; i++)
+                for (uint32_t tile_index = tile_start; tile_index < tile_end; tile_index++)
                 {
-                    Vector3 normal_average  = Vector3::Zero;
-                    Vector3 tangent_average = Vector3::Zero;
-                    float face_usage_count  = 0;
+                    Tile& tile                 = tiles[tile_index];
+                    const uint32_t tile_target = tile_targets[tile_index];
+                    if (tile_target == 0)
+                        continue;
 
-                    for (uint32_t j : vertex_to_triangle_map[i])
-                    {
-                        normal_average  += face_normals[j];
-                        tangent_average += face_tangents[j];
-                        face_usage_count++;
-                    }
+                    SpatialHash spatial_hash(max(parameters.min_spacing, 0.001f), tile_target);
 
-                    if (face_usage_count > 0)
+                    for (uint32_t attempt = 0; attempt < tile_target * attempts_per_obj && tile.positions.size() < tile_target; attempt++)
                     {
-                        normal_average  /= face_usage_count;
-                        tangent_average /= face_usage_count;
-
-                        normal_average.Normalize();
-                        tangent_average.Normalize();
+                        Vector3 position, normal;
+                        if (!sample(tile, tile_index, attempt * 4, position, normal))
+                            continue;
 
-                        vertices[i].nor[0] = normal_average.x;
-                        vertices[i].nor[1] = normal_average.y;
-                        vertices[i].nor[2] = normal_average.z;
+                        if (parameters.min_spacing > 0.0f && !spatial_hash.IsFree(position))
+                            continue;
 
-                        vertices[i].tan[0] = tangent_average.x;
-                        vertices[i].tan[1] = tangent_average.y;
-                        vertices[i].tan[2] = tangent_average.z;
+                        spatial_hash.Insert(position);
+                        tile.positions.emplace_back(position);
+                        tile.normals.emplace_back(normal);
                     }
                 }
-            };
-
-            uint32_t vertex_count = static_cast<uint32_t>(vertices.size());
-            ThreadPool::ParallelLoop(compute_vertex_normals_tangents, vertex_count);
-        }
+            });
 
-        float get_random_float(float x, float y)
-        {
-            random_device rd;                        // obtain a random number from hardware
-            mt19937 gen(rd());                       // seed the generator
-            uniform_real_distribution<> distr(x, y); // define the distribution
-
-            return static_cast<float>(distr(gen));
-        }
+            // 3. merge in tile order, only objects close to a tile edge can conflict with another tile
+            uint32_t object_count = 0;
+            for (const Tile& tile : tiles)
+            {
+                object_count += static_cast<uint32_t>(tile.positions.size());
+            }
 
-        vector<Matrix> generate_transforms(const vector<RHI_Vertex_PosTexNorTan>& vertices, const vector<uint32_t>& indices,
-            uint32_t tree_count, float max_slope_radians, bool rotate_to_match_surface_normal,float terrain_offset)
-        {
             vector<Matrix> transforms;
-            random_device seed;
-            mt19937 generator(seed());
-            uniform_int_distribution<> distribution(0, static_cast<int>(indices.size() / 3 - 1));
+            transforms.reserve(max(object_count, parameters.count));
+            SpatialHash spatial_hash(max(parameters.min_spacing, 0.001f), max(object_count, parameters.count));
 
-            for (uint32_t i = 0; i < tree_count; ++i)
+            auto place = [&](const Vector3& position, const Vector3& normal, const uint32_t stream, const uint32_t counter)
             {
-                // randomly select a triangle from the mesh
-                uint32_t triangle_index = distribution(generator) * 3;
+                spatial_hash.Insert(position);
 
-                // get the vertices of the triangle
-                Vector3 v0 = Vector3(vertices[indices[triangle_index]].pos[0],     vertices[indices[triangle_index]].pos[1],     vertices[indices[triangle_index]].pos[2]);
-                Vector3 v1 = Vector3(vertices[indices[triangle_index + 1]].pos[0], vertices[indices[triangle_index + 1]].pos[1], vertices[indices[triangle_index + 1]].pos[2]);
-                Vector3 v2 = Vector3(vertices[indices[triangle_index + 2]].pos[0], vertices[indices[triangle_index + 2]].pos[1], vertices[indices[triangle_index + 2]].pos[2]);
+                // scale is a random value between 0.5 and 1.5
+                const Vector3 scale = Vector3(get_random_float(parameters.seed, stream, counter, 0.5f, 1.5f));
 
-                // compute the slope of the triangle
-                Vector3 normal          = Vector3::Cross(v1 - v0, v2 - v0).Normalized();
-                float slope_radians     = acos(Vector3::Dot(normal, Vector3::Up));
-                bool is_relatively_flat = slope_radians <= max_slope_radians;
+                // rotation is a random rotation around the Y axis, and then rotated to match the normal of the triangle
+                const Quaternion rotate_to_normal = parameters.rotate_to_match_normal ? Quaternion::FromToRotation(Vector3::Up, normal) : Quaternion::Identity;
+                const Quaternion rotation         = rotate_to_normal * Quaternion::FromEulerAngles(0.0f, get_random_float(parameters.seed, stream, counter - 1, 0.0f, 360.0f), 0.0f);
 
-                // compute height threshold
-                float sea_level                = 0.0f;             // this is a fact across the engine
-                float height_threshold         = sea_level + 4.0f; // don't want things to grow too close to see level (where sand could be)
-                bool is_above_height_threshold = v0.y >= height_threshold && v1.y >= height_threshold && v2.y >= height_threshold;
+                // a vertical offset, to avoid floating objects
+                transforms.emplace_back(position + Vector3(0.0f, parameters.terrain_offset, 0.0f), rotation, scale);
+            };
 
-                if (is_relatively_flat && is_above_height_threshold)
+            for (uint32_t tile_index = 0; tile_index < tile_total; tile_index++)
+            {
+                const Tile& tile = tiles[tile_index];
+                for (uint32_t i = 0; i < static_cast<uint32_t>(tile.positions.size()); i++)
                 {
-                    // generate barycentric coordinates
-                    float u = static_cast<float>(rand()) / static_cast<float>(RAND_MAX);
-                    float v = static_cast<float>(rand()) / static_cast<float>(RAND_MAX);
-                    if (u + v > 1.0f)
-                    {
-                        u = 1.0f - u;
-                        v = 1.0f - v;
-                    }
+                    const Vector3& position = tile.positions[i];
+                    if (parameters.min_spacing > 0.0f && !spatial_hash.IsFree(position))
+                        continue;
+
+                    place(position, tile.normals[i], tile_index, numeric_limits<uint32_t>::max() - i * 2);
+                }
+            }
+
+            // 4. top up what rounding, spacing and the merge rejected, serially so that the result stays deterministic,
+            // on a stream of its own, tiles are picked by their suitable area just like the counts were distributed
+            if (transforms.size() < parameters.count)
+            {
+                vector<float> tile_cdf(tile_total);
+                float tile_cdf_total = 0.0f;
+                for (uint32_t tile_index = 0; tile_index < tile_total; tile_index++)
+                {
+                    tile_cdf_total      += tiles[tile_index].area_cdf.empty() ? 0.0f : tiles[tile_index].area_cdf.back();
+                    tile_cdf[tile_index] = tile_cdf_total;
+                }
 
-                    // scale is a random value between 0.5 and 1.5
-                    Vector3 scale = Vector3(get_random_float(0.5f, 1.5f));
+                const uint32_t stream       = tile_total;
+                const uint32_t attempts_max = (parameters.count - static_cast<uint32_t>(transforms.size())) * attempts_per_obj;
+                for (uint32_t attempt = 0; attempt < attempts_max && transforms.size() < parameters.count; attempt++)
+                {
+                    const uint32_t counter    = attempt * 4;
+                    const float r             = get_random_float(parameters.seed, stream, counter, 0.0f, tile_cdf_total);
+                    const uint32_t tile_index = min(static_cast<uint32_t>(upper_bound(tile_cdf.begin(), tile_cdf.end(), r) - tile_cdf.begin()), tile_total - 1);
 
-                    // position is the barycentric coordinates multiplied by the vertices of the triangle, plus a terrain_offset to avoid floating object
-                    Vector3 position = v0 + (u * (v1 - v0) + terrain_offset) + v * (v2 - v0);
+                    Vector3 position, normal;
+                    if (!sample(tiles[tile_index], stream, counter + 1, position, normal))
+                        continue;
 
-                    // rotation is a random rotation around the Y axis, and then rotated to match the normal of the triangle
-                    Quaternion rotate_to_normal = rotate_to_match_surface_normal ? Quaternion::FromToRotation(Vector3::Up, normal) : Quaternion::Identity;
-                    Quaternion rotation         = rotate_to_normal * Quaternion::FromEulerAngles(0.0f, get_random_float(0.0f, 360.0f), 0.0f);
+                    if (parameters.min_spacing > 0.0f && !spatial_hash.IsFree(position))
+                        continue;
 
-                    transforms.emplace_back(position, rotation, scale);
+                    place(position, normal, stream + 1, numeric_limits<uint32_t>::max() - static_cast<uint32_t>(transforms.size()) * 2);
                 }
-                else
+
+                if (transforms.size() < parameters.count)
                 {
-                    // if the slope is too steep or the object is underwater, try again
-                    --i;
+                    SP_LOG_WARNING("Placed %u of %u objects, the suitable area can't fit more at a spacing of %.2f",
+                        static_cast<uint32_t>(transforms.size()), parameters.count, parameters.min_spacing);
                 }
             }
 
+            // emit them already grouped the way the renderer culls instances
+            grid_partitioning::sort_instances_by_cell(transforms);
+
             return transforms;
         }
 
-        void split_terrain_into_tiles(
-            const vector<RHI_Vertex_PosTexNorTan>& vertices, const vector<uint32_t>& indices,
-            vector<vector<RHI_Vertex_PosTexNorTan>>& tiled_vertices, vector<vector<uint32_t>>& tiled_indices)
+        // the grid coordinates a lod keeps along one axis, the last one is always kept so that tiles share their borders
+        void get_lod_coordinates(const uint32_t last, const uint32_t step, vector<uint32_t>& coordinates)
         {
-            // initialize min and max values for terrain bounds
-            float min_x = numeric_limits<float>::max();
-            float max_x = numeric_limits<float>::lowest();
-            float min_z = numeric_limits<float>::max();
-            float max_z = numeric_limits<float>::lowest();
-
-            // iterate over all vertices to find the minimum and maximum x and z values
-            for (const RHI_Vertex_PosTexNorTan& vertex : vertices)
-            {
-                // compare and store the minimum and maximum x coordinates
-                if (vertex.pos[0] < min_x) min_x = vertex.pos[0];
-                if (vertex.pos[0] > max_x) max_x = vertex.pos[0];
-
-                // compare and store the minimum and maximum z coordinates
-                if (vertex.pos[2] < min_z) min_z = vertex.pos[2];
-                if (vertex.pos[2] > max_z) max_z = vertex.pos[2];
+            coordinates.clear();
+            for (uint32_t i = 0; i < last; i += step)
+            {
+                coordinates.emplace_back(i);
             }
+            coordinates.emplace_back(last);
+        }
 
-            // calculate dimensions
-            float terrain_width = max_x - min_x;
-            float terrain_depth = max_z - min_z;
-            float tile_width    = terrain_width / static_cast<float>(tile_count);
-            float tile_depth    = terrain_depth / static_cast<float>(tile_count);
-
-            // initialize tiled vertices and indices
-            tiled_vertices.resize(tile_count * tile_count);
-            tiled_indices.resize(tile_count * tile_count);
-
-            // create a mapping for each tile to track vertex global indices to their new local indices
-            vector<unordered_map<uint32_t, uint32_t>> global_to_local_indices(tile_count * tile_count);
+        void generate_tile(
+            const vector<RHI_Vertex_PosTexNorTan>& vertices, const uint32_t width,
+            const uint32_t x_start, const uint32_t x_end, const uint32_t y_start, const uint32_t y_end,
+            vector<RHI_Vertex_PosTexNorTan>& tile_vertices, vector<uint32_t>& tile_indices, vector<TerrainTileLod>& tile_lods)
+        {
+            const uint32_t stride     = x_end - x_start + 1;
+            const uint32_t rows       = y_end - y_start + 1;
+            const uint32_t grid_count = stride * rows;
 
-            // assign vertices to tiles and track their indices
-            for (uint32_t global_index = 0; global_index < vertices.size(); ++global_index)
+            // grid vertices, followed by the skirt vertices of the bottom, top, left and right edges
+            tile_vertices.resize(grid_count + 2 * stride + 2 * rows);
+            for (uint32_t y = y_start; y <= y_end; y++)
             {
-                const RHI_Vertex_PosTexNorTan& vertex = vertices[global_index];
-
-                uint32_t tile_x = static_cast<uint32_t>((vertex.pos[0] - min_x) / tile_width);
-                uint32_t tile_z = static_cast<uint32_t>((vertex.pos[2] - min_z) / tile_depth);
-                tile_x          = min(tile_x, tile_count - 1);
-                tile_z          = min(tile_z, tile_count - 1);
-
-                // convert the 2D tile coordinates into a single index for the 1D output array
-                uint32_t tile_index = tile_z * tile_count + tile_x;
-
-                // add vertex to the appropriate tile
-                tiled_vertices[tile_index].push_back(vertex);
-
-                // track the local index of this vertex in the tile
-                uint32_t local_index = static_cast<uint32_t>(tiled_vertices[tile_index].size() - 1);
-                global_to_local_indices[tile_index][global_index] = local_index;
+                const RHI_Vertex_PosTexNorTan* row = &vertices[y * width + x_start];
+                copy(row, row + stride, &tile_vertices[(y - y_start) * stride]);
             }
 
-            auto add_shared_vertex = [](
-                uint32_t tile_x, uint32_t tile_z, uint32_t global_index,
-                const vector<RHI_Vertex_PosTexNorTan>&vertices, vector<vector<RHI_Vertex_PosTexNorTan>>&tiled_vertices,
-                vector<unordered_map<uint32_t, uint32_t>>&global_to_local_indices, vector<vector<uint32_t>>&tiled_indices)
+            const uint32_t skirt_bottom = grid_count;
+            const uint32_t skirt_top    = skirt_bottom + stride;
+            const uint32_t skirt_left   = skirt_top + stride;
+            const uint32_t skirt_right  = skirt_left + rows;
+            auto add_skirt_vertex = [&tile_vertices](const uint32_t index_skirt, const uint32_t index_grid)
             {
-                // check if tile_x and tile_z are within the valid range
-                if (tile_x >= tile_count || tile_z >= tile_count)
-                    return; // out of valid tile range, do nothing
-
-                uint32_t tile_count = static_cast<uint32_t>(sqrt(tiled_vertices.size())); // assuming square number of tiles
-                uint32_t tile_index = tile_z * tile_count + tile_x;
-                const RHI_Vertex_PosTexNorTan& vertex = vertices[global_index];
-
-                // add the vertex if it doesn't exist in the tile
-                if (global_to_local_indices[tile_index].find(global_index) == global_to_local_indices[tile_index].end())
-                {
-                    tiled_vertices[tile_index].push_back(vertex);
-                    uint32_t local_index = static_cast<uint32_t>(tiled_vertices[tile_index].size() - 1);
-                    global_to_local_indices[tile_index][global_index] = local_index;
-                }
+                tile_vertices[index_skirt]         = tile_vertices[index_grid];
+                tile_vertices[index_skirt].pos[1] -= skirt_depth;
             };
+            for (uint32_t x = 0; x < stride; x++)
+            {
+                add_skirt_vertex(skirt_bottom + x, x);
+                add_skirt_vertex(skirt_top + x,    (rows - 1) * stride + x);
+            }
+            for (uint32_t y = 0; y < rows; y++)
+            {
+                add_skirt_vertex(skirt_left + y,  y * stride);
+                add_skirt_vertex(skirt_right + y, y * stride + stride - 1);
+            }
 
-            // adjust and assign indices to tiles
-            for (uint32_t global_index = 0; global_index < indices.size(); global_index += 3)
+            // every lod is an index range in the same index buffer
+            tile_indices.clear();
+            tile_lods.resize(lod_count);
+            vector<uint32_t> xs;
+            vector<uint32_t> ys;
+            for (uint32_t lod = 0; lod < lod_count; lod++)
             {
-                // find the tile for the first vertex of the triangle
-                const RHI_Vertex_PosTexNorTan& vertex = vertices[indices[global_index]];
-                uint32_t tile_x                       = static_cast<uint32_t>((vertex.pos[0] - min_x) / tile_width);
-                uint32_t tile_z                       = static_cast<uint32_t>((vertex.pos[2] - min_z) / tile_depth);
-                tile_x                                = min(tile_x, tile_count - 1);
-                tile_z                                = min(tile_z, tile_count - 1);
-                uint32_t tile_index                   = tile_z * tile_count + tile_x;
+                get_lod_coordinates(stride - 1, 1 << lod, xs);
+                get_lod_coordinates(rows - 1,   1 << lod, ys);
 
-                // add all vertices of the triangle to the current tile
-                for (uint32_t j = 0; j < 3; ++j)
-                {
-                    uint32_t current_global_index = indices[global_index + j];
-                    const RHI_Vertex_PosTexNorTan& current_vertex = vertices[current_global_index];
-                    uint32_t local_index;
+                tile_lods[lod].index_offset = static_cast<uint32_t>(tile_indices.size());
 
-                    // check if the vertex index already exists in the local index map for the current tile
-                    auto it = global_to_local_indices[tile_index].find(current_global_index);
-                    if (it != global_to_local_indices[tile_index].end())
-                    {
-                        local_index = it->second;
-                    }
-                    else
+                // surface
+                for (uint32_t j = 0; j + 1 < ys.size(); j++)
+                {
+                    for (uint32_t i = 0; i + 1 < xs.size(); i++)
                     {
-                        // If the vertex is not already in the tile, add it and update the index map
-                        tiled_vertices[tile_index].push_back(current_vertex);
-                        local_index = static_cast<uint32_t>(tiled_vertices[tile_index].size() - 1);
-                        global_to_local_indices[tile_index][current_global_index] = local_index;
+                        const uint32_t index_bottom_left  = ys[j] * stride + xs[i];
+                        const uint32_t index_bottom_right = ys[j] * stride + xs[i + 1];
+                        const uint32_t index_top_left     = ys[j + 1] * stride + xs[i];
+                        const uint32_t index_top_right    = ys[j + 1] * stride + xs[i + 1];
+
+                        tile_indices.insert(tile_indices.end(), { index_bottom_right, index_bottom_left, index_top_left, index_bottom_right, index_top_left, index_top_right });
                     }
-                    tiled_indices[tile_index].push_back(local_index);
                 }
 
-                // check for shared edges and corners
-                for (uint32_t j = 0; j < 3; ++j)
+                // skirts, each edge is walked so that its quads face away from the tile
+                auto add_skirt = [&tile_indices](const uint32_t p0, const uint32_t p1, const uint32_t q0, const uint32_t q1)
                 {
-                    // for each vertex of the triangle, check if it's on a shared edge
-                    uint32_t current_global_index = indices[global_index + j];
-                    const RHI_Vertex_PosTexNorTan& current_vertex = vertices[current_global_index];
-
-                    // calculate the local tile coordinates again
-                    tile_x = static_cast<uint32_t>((current_vertex.pos[0] - min_x) / tile_width);
-                    tile_z = static_cast<uint32_t>((current_vertex.pos[2] - min_z) / tile_depth);
+                    tile_indices.insert(tile_indices.end(), { p0, p1, q0, p1, q1, q0 });
+                };
+                for (uint32_t i = 0; i + 1 < xs.size(); i++)
+                {
+                    const uint32_t x0 = xs[i];
+                    const uint32_t x1 = xs[i + 1];
+                    add_skirt(x0, x1, skirt_bottom + x0, skirt_bottom + x1);                                             // bottom, towards +x
+                    add_skirt((rows - 1) * stride + x1, (rows - 1) * stride + x0, skirt_top + x1, skirt_top + x0);       // top, towards -x
+                }
+                for (uint32_t j = 0; j + 1 < ys.size(); j++)
+                {
+                    const uint32_t y0 = ys[j];
+                    const uint32_t y1 = ys[j + 1];
+                    add_skirt(y1 * stride, y0 * stride, skirt_left + y1, skirt_left + y0);                               // left, towards -z
+                    add_skirt(y0 * stride + stride - 1, y1 * stride + stride - 1, skirt_right + y0, skirt_right + y1);   // right, towards +z
+                }
 
-                    // determine if the vertex is on an edge or corner
-                    bool is_on_horizontal_edge = fmod(current_vertex.pos[0] - min_x, tile_width) <= numeric_limits<float>::epsilon() && tile_x > 0;
-                    bool is_on_vertical_edge   = fmod(current_vertex.pos[2] - min_z, tile_depth) <= numeric_limits<float>::epsilon() && tile_z > 0;
+                tile_lods[lod].index_count  = static_cast<uint32_t>(tile_indices.size()) - tile_lods[lod].index_offset;
+                tile_lods[lod].vertex_count = static_cast<uint32_t>(xs.size() * ys.size() + 2 * (xs.size() + ys.size()));
+            }
+        }
 
-                    // add the vertex to the shared edges/corners tiles if needed
-                    if (is_on_horizontal_edge)
-                    {
-                        // add to tile on the left
-                        add_shared_vertex(tile_x - 1, tile_z, current_global_index, vertices, tiled_vertices, global_to_local_indices, tiled_indices);
-                    }
+        void split_terrain_into_tiles(
+            const vector<RHI_Vertex_PosTexNorTan>& vertices, const uint32_t width, const uint32_t height,
+            vector<vector<RHI_Vertex_PosTexNorTan>>& tiled_vertices, vector<vector<uint32_t>>& tiled_indices, vector<vector<TerrainTileLod>>& tiled_lods)
+        {
+            tiled_vertices.resize(tile_count * tile_count);
+            tiled_indices.resize(tile_count * tile_count);
+            tiled_lods.resize(tile_count * tile_count);
 
-                    if (is_on_vertical_edge)
-                    {
-                        // add to tile below
-                        add_shared_vertex(tile_x, tile_z - 1, current_global_index, vertices, tiled_vertices, global_to_local_indices, tiled_indices);
-                    }
+            // tiles are ranges of grid quads, the vertices on their borders are duplicated into both neighbours
+            const uint32_t quad_count_x = width - 1;
+            const uint32_t quad_count_y = height - 1;
 
-                    if (is_on_horizontal_edge && is_on_vertical_edge)
-                    {
-                        // add to the diagonal tile (bottom left)
-                        add_shared_vertex(tile_x - 1, tile_z - 1, current_global_index, vertices, tiled_vertices, global_to_local_indices, tiled_indices);
-                    }
+            parallel_for(tile_count * tile_count, [&](uint32_t tile_start, uint32_t tile_end)
+            {
+                for (uint32_t tile_index = tile_start; tile_index < tile_end; tile_index++)
+                {
+                    const uint32_t tile_x = tile_index % tile_count;
+                    const uint32_t tile_z = tile_index / tile_count;
+
+                    generate_tile(
+                        vertices, width,
+                        tile_x * quad_count_x / tile_count, (tile_x + 1) * quad_count_x / tile_count,
+                        tile_z * quad_count_y / tile_count, (tile_z + 1) * quad_count_y / tile_count,
+                        tiled_vertices[tile_index], tiled_indices[tile_index], tiled_lods[tile_index]
+                    );
                 }
-            }
+            });
+        }
+
+        float get_distance_to_box(const Vector3& point, const BoundingBox& box)
+        {
+            const Vector3 closest = Vector3(
+                Helper::Clamp(point.x, box.GetMin().x, box.GetMax().x),
+                Helper::Clamp(point.y, box.GetMin().y, box.GetMax().y),
+                Helper::Clamp(point.z, box.GetMin().z, box.GetMax().z)
+            );
+
+            return Vector3::Distance(point, closest);
         }
     }
 
@@ -554,35 +747,105 @@ namespace Spartan
         m_height_texture->LoadFromFile(file_path);
     }
 
-    void Terrain::GenerateTransforms(vector<Matrix>* transforms, const uint32_t count, const TerrainProp terrain_prop)
+    void Terrain::OnTick()
+    {
+        if (m_is_generating || m_tile_renderables.empty())
+            return;
+
+        shared_ptr<Camera> camera = Renderer::GetCamera();
+        if (!camera)
+            return;
+
+        const Vector3 camera_position = camera->GetEntity()->GetPosition();
+        uint32_t vertex_count         = 0;
+        uint32_t triangle_count       = 0;
+
+        for (uint32_t tile_index = 0; tile_index < static_cast<uint32_t>(m_tile_renderables.size()); tile_index++)
+        {
+            shared_ptr<Renderable> renderable = m_tile_renderables[tile_index].lock();
+            if (!renderable)
+                continue;
+
+            // pick a lod based on the distance to the tile, every lod covers twice the distance of the previous one
+            const BoundingBox& aabb = renderable->GetBoundingBox(BoundingBoxType::Transformed);
+            const float tile_size   = max(aabb.GetSize().x, aabb.GetSize().z);
+            const float distance    = get_distance_to_box(camera_position, aabb);
+            float threshold         = tile_size * lod_distance_scale;
+            uint32_t lod            = 0;
+            while (lod < lod_count - 1 && distance > threshold)
+            {
+                lod++;
+                threshold *= 2.0f;
+            }
+
+            if (m_tile_lod_current[tile_index] != lod)
+            {
+                // same vertices and bounds, so it's not a geometry change as far as the shadow cache is concerned
+                const TerrainTileLod& tile_lod = m_tile_lods[tile_index][lod];
+                renderable->SetIndexRange(tile_lod.index_offset, tile_lod.index_count);
+                m_tile_lod_current[tile_index] = lod;
+            }
+
+            if (renderable->IsVisible())
+            {
+                vertex_count   += m_tile_lods[tile_index][lod].vertex_count;
+                triangle_count += m_tile_lods[tile_index][lod].index_count / 3;
+            }
+        }
+
+        Profiler::m_terrain_vertices  = vertex_count;
+        Profiler::m_terrain_triangles = triangle_count;
+    }
+
+    void Terrain::GenerateTransforms(vector<Matrix>* transforms, const uint32_t count, const TerrainProp terrain_prop, const float min_spacing, const uint32_t seed)
 	{
-        bool rotate_match_surface_normal = false;
-        float max_slope                  = 0.0f;
-        float terrain_offset             = 0.0f;
+        const uint32_t width  = m_height_texture ? m_height_texture->GetWidth()  : 0;
+        const uint32_t height = m_height_texture ? m_height_texture->GetHeight() : 0;
+        if (m_vertices.empty() || width * height != static_cast<uint32_t>(m_vertices.size()))
+        {
+            SP_LOG_WARNING("The terrain has to be generated before scattering objects on it");
+            transforms->clear();
+            return;
+        }
+
+        GenerateTransforms(m_vertices, width, height, transforms, count, terrain_prop, min_spacing, seed);
+	}
+
+    void Terrain::GenerateTransforms(
+        const vector<RHI_Vertex_PosTexNorTan>& vertices, const uint32_t width, const uint32_t height,
+        vector<Matrix>* transforms, const uint32_t count, const TerrainProp terrain_prop, const float min_spacing, const uint32_t seed
+    )
+    {
+        SP_ASSERT(width >= 2 && height >= 2 && width * height == static_cast<uint32_t>(vertices.size()));
+
+        ScatterParameters parameters;
+        parameters.count       = count;
+        parameters.min_spacing = min_spacing;
+        parameters.seed        = hash(seed ^ hash(static_cast<uint32_t>(terrain_prop))); // different props don't land on the same spots
 
         if (terrain_prop == TerrainProp::Tree)
         {
-            max_slope                   = 30.0f * Math::Helper::DEG_TO_RAD;
-            rotate_match_surface_normal = false; // trees tend to grow upwards, towards the sun
-            terrain_offset              = -0.5f;
+            parameters.max_slope_radians      = 30.0f * Math::Helper::DEG_TO_RAD;
+            parameters.rotate_to_match_normal = false; // trees tend to grow upwards, towards the sun
+            parameters.terrain_offset         = -0.5f;
         }
 
         if (terrain_prop == TerrainProp::Plant)
         {
-            max_slope                   = 40.0f * Math::Helper::DEG_TO_RAD;
-            rotate_match_surface_normal = true; // small plants tend to grow towards the sun but they can have some wonky angles due to low mass
-            terrain_offset              = 0.0f;
+            parameters.max_slope_radians      = 40.0f * Math::Helper::DEG_TO_RAD;
+            parameters.rotate_to_match_normal = true; // small plants tend to grow towards the sun but they can have some wonky angles due to low mass
+            parameters.terrain_offset         = 0.0f;
         }
 
         if (terrain_prop == TerrainProp::Grass)
         {
-            max_slope                   = 40.0f * Math::Helper::DEG_TO_RAD;
-            rotate_match_surface_normal = true;
-            terrain_offset              = -0.9f;
+            parameters.max_slope_radians      = 40.0f * Math::Helper::DEG_TO_RAD;
+            parameters.rotate_to_match_normal = true;
+            parameters.terrain_offset         = -0.9f;
         }
 
-        *transforms = generate_transforms(m_vertices, m_indices, count, max_slope, rotate_match_surface_normal, terrain_offset);
-	}
+        *transforms = generate_transforms(vertices, width, height, parameters);
+    }
 
     void Terrain::Generate()
     {
@@ -603,12 +866,13 @@ namespace Spartan
         m_is_generating = true;
 
         // star progress tracking
-        uint32_t job_count = 6;
+        uint32_t job_count = 5;
         ProgressTracker::GetProgress(ProgressType::Terrain).Start(job_count, "Generating terrain...");
 
         uint32_t width  = 0;
         uint32_t height = 0;
-        vector<Vector3> positions;
+        Stopwatch timer_total;
+        Stopwatch timer_stage;
 
         // 1. process height map
         {
@@ -625,57 +889,70 @@ namespace Spartan
             height           = m_height_texture->GetHeight();
             m_height_samples = width * height;
             m_vertex_count   = m_height_samples;
-            m_index_count    = m_vertex_count * 6;
+            m_index_count    = (width - 1) * (height - 1) * 6;
             m_triangle_count = m_index_count / 3;
 
             // allocate memory for the calculations that follow
-            positions  = vector<Vector3>(m_height_samples);
             m_vertices = vector<RHI_Vertex_PosTexNorTan>(m_vertex_count);
             m_indices  = vector<uint32_t>(m_index_count);
 
+            SP_LOG_INFO("Height map processed in %.2f ms", timer_stage.GetElapsedTimeMs());
             ProgressTracker::GetProgress(ProgressType::Terrain).JobDone();
         }
 
-        // 2. compute positions
+        // 2. compute vertices, normals and tangents
         {
-            ProgressTracker::GetProgress(ProgressType::Terrain).SetText("Generating positions...");
-            generate_positions(positions, m_height_data, width, height);
+            ProgressTracker::GetProgress(ProgressType::Terrain).SetText("Generating vertices...");
+            timer_stage.Start();
+            generate_vertices(m_vertices, m_height_data, width, height);
+            SP_LOG_INFO("Vertices generated in %.2f ms", timer_stage.GetElapsedTimeMs());
             ProgressTracker::GetProgress(ProgressType::Terrain).JobDone();
         }
 
-        // 3. compute vertices and indices
+        // 3. compute indices
         {
-            ProgressTracker::GetProgress(ProgressType::Terrain).SetText("Generating vertices and indices...");
-            generate_vertices_and_indices(m_vertices, m_indices, positions, width, height);
-            ProgressTracker::GetProgress(ProgressType::Terrain).JobDone();
-        }
+            ProgressTracker::GetProgress(ProgressType::Terrain).SetText("Generating indices...");
+            timer_stage.Start();
+            const uint32_t quad_count_x = width - 1;
+            parallel_for(height - 1, [this, quad_count_x, width](uint32_t row_start, uint32_t row_end)
+            {
+                generate_indices(&m_indices[row_start * quad_count_x * 6], 0, quad_count_x, row_start, row_end, width);
 
-        // 4. compute normals and tangents
-        {
-            ProgressTracker::GetProgress(ProgressType::Terrain).SetText("Generating normals...");
-            generate_normals(m_indices, m_vertices);
+                // generate_indices() is relative to the first row of the range
+                for (uint32_t i = row_start * quad_count_x * 6; i < row_end * quad_count_x * 6; i++)
+                {
+                    m_indices[i] += row_start * width;
+                }
+            });
+            SP_LOG_INFO("Indices generated in %.2f ms", timer_stage.GetElapsedTimeMs());
             ProgressTracker::GetProgress(ProgressType::Terrain).JobDone();
         }
 
-        // 5. split into tiles
+        // 4. split into tiles
         {
             ProgressTracker::GetProgress(ProgressType::Terrain).SetText("Splitting into tiles...");
-            split_terrain_into_tiles(m_vertices, m_indices, m_tile_vertices, m_tile_indices);
+            timer_stage.Start();
+            split_terrain_into_tiles(m_vertices, width, height, m_tile_vertices, m_tile_indices, m_tile_lods);
+            SP_LOG_INFO("Split into tiles in %.2f ms", timer_stage.GetElapsedTimeMs());
             ProgressTracker::GetProgress(ProgressType::Terrain).JobDone();
         }
 
-        // 6. create a mesh for each tile
+        // 5. create a mesh for each tile
         {
             ProgressTracker::GetProgress(ProgressType::Terrain).SetText("Creating tile meshes");
+            timer_stage.Start();
 
             for (uint32_t tile_index = 0; tile_index < static_cast<uint32_t>(m_tile_vertices.size()); tile_index++)
             {
                 UpdateMesh(tile_index);
             }
 
+            SP_LOG_INFO("Tile meshes created in %.2f ms", timer_stage.GetElapsedTimeMs());
             ProgressTracker::GetProgress(ProgressType::Terrain).JobDone();
         }
 
+        SP_LOG_INFO("Terrain of %ux%u generated in %.2f ms", width, height, timer_total.GetElapsedTimeMs());
+
         // todo: we don't free vertices and indices, we should
 
         m_is_generating = false;
@@ -709,16 +986,23 @@ namespace Spartan
 
             if (shared_ptr<Renderable> renderable = entity->AddComponent<Renderable>())
             {
+                // start at the highest detail, OnTick() will pick the appropriate lod
+                const TerrainTileLod& tile_lod = m_tile_lods[tile_index][0];
                 renderable->SetGeometry(
                     mesh.get(),
                     mesh->GetAabb(),
-                    0,                     // index offset
-                    mesh->GetIndexCount(), // index count
+                    tile_lod.index_offset, // index offset
+                    tile_lod.index_count,  // index count
                     0,                     // vertex offset
                     mesh->GetVertexCount() // vertex count
                 );
 
                 renderable->SetMaterial(m_material);
+
+                m_tile_renderables.resize(max(static_cast<uint32_t>(m_tile_renderables.size()), tile_index + 1));
+                m_tile_lod_current.resize(m_tile_renderables.size(), 0);
+                m_tile_renderables[tile_index] = renderable;
+                m_tile_lod_current[tile_index] = 0;
             }
         }
     }
@@ -730,6 +1014,9 @@ namespace Spartan
         m_tile_meshes.clear();
         m_tile_vertices.clear();
         m_tile_indices.clear();
+        m_tile_lods.clear();
+        m_tile_renderables.clear();
+        m_tile_lod_current.clear();
 
         for (auto& mesh : m_tile_meshes)
         {
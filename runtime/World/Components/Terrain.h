@@ -31,6 +31,7 @@ namespace Spartan
 {
     class Mesh;
     class Material;
+    class Renderable;
     namespace Math
     {
         class Vector3;
@@ -43,6 +44,14 @@ namespace Spartan
         Grass
     };
 
+    // an index range of a tile's index buffer, one per level of detail
+    struct TerrainTileLod
+    {
+        uint32_t index_offset = 0;
+        uint32_t index_count  = 0;
+        uint32_t vertex_count = 0; // referenced by the index range
+    };
+
     class SP_CLASS Terrain : public Component
     {
     public:
@@ -52,6 +61,7 @@ namespace Spartan
         //= Component ================================
         void Serialize(FileStream* stream) override;
         void Deserialize(FileStream* stream) override;
+        void OnTick() override;
         //============================================
 
         const std::shared_ptr<RHI_Texture> GetHeightMap() const { return m_height_texture; }
@@ -65,7 +75,14 @@ namespace Spartan
         void SetMaxY(float max_z) { m_max_y = max_z; }
 
         void Generate();
-        void GenerateTransforms(std::vector<Math::Matrix>* transforms, const uint32_t count, const TerrainProp terrain_prop);
+        // scatters objects deterministically, the same seed always produces the same transforms, no two objects are closer
+        // than min_spacing (on the xz plane) and placement is retried until the count is met or the area can't fit more
+        void GenerateTransforms(std::vector<Math::Matrix>* transforms, const uint32_t count, const TerrainProp terrain_prop, const float min_spacing, const uint32_t seed = 0);
+        // the same on a height field given as a width x height grid of vertices, the result doesn't depend on the thread count
+        static void GenerateTransforms(
+            const std::vector<RHI_Vertex_PosTexNorTan>& vertices, const uint32_t width, const uint32_t height,
+            std::vector<Math::Matrix>* transforms, const uint32_t count, const TerrainProp terrain_prop, const float min_spacing, const uint32_t seed = 0
+        );
 
         uint32_t GetVertexCount() const         { return m_vertex_count; }
         uint32_t GetIndexCount() const          { return m_index_count; }
@@ -92,6 +109,9 @@ namespace Spartan
         std::vector<uint32_t> m_indices;
         std::vector<std::vector<uint32_t>> m_tile_indices;
         std::vector<std::shared_ptr<Mesh>> m_tile_meshes;
+        std::vector<std::vector<TerrainTileLod>> m_tile_lods;
+        std::vector<std::weak_ptr<Renderable>> m_tile_renderables;
+        std::vector<uint32_t> m_tile_lod_current;
         std::shared_ptr<Material> m_material;
     };
 }
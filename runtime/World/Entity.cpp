@@ -343,7 +343,7 @@ namespace Spartan
             }
         }
 
-        World::Resolve();
+        World::Resolve(this);
     }
 
     void Entity::UpdateTransform()
@@ -83,7 +83,7 @@ namespace Spartan
             component->SetType(type);
             component->OnInitialize();
 
-            World::Resolve();
+            World::Resolve(this);
 
             return component;
         }
@@ -106,7 +106,7 @@ namespace Spartan
             const ComponentType component_type = Component::TypeToEnum<T>();
             m_components[static_cast<uint32_t>(component_type)] = nullptr;
 
-            World::Resolve();
+            World::Resolve(this);
         }
 
         void RemoveComponentById(uint64_t id);
@@ -170,6 +170,7 @@ namespace Spartan
         const Math::Matrix& GetMatrixPrevious() const      { return m_matrix_previous; }
         void SetMatrixPrevious(const Math::Matrix& matrix) { m_matrix_previous = matrix; }
         bool HasTransformChanged() const;
+        uint64_t GetTransformChangedFrame() const { return m_transform_changed_frame; }
 
     private:
         std::atomic<bool> m_is_active = true;
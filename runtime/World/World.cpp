@@ -56,6 +56,12 @@ namespace Spartan
         bool resolve            = false;
         bool was_in_editor_mode = false;
 
+        // entities which were added, removed or had their components changed since the last tick
+        // they are resolved against the entity map at tick time, so an id which no longer exists is a removal
+        // note: this is a vector which keeps its capacity, duplicates are removed at tick time
+        vector<uint64_t> entities_dirty;
+        mutex entities_dirty_mutex;
+
         // default worlds resources
         shared_ptr<Entity> m_default_terrain             = nullptr;
         shared_ptr<Entity> m_default_cube                = nullptr;
@@ -183,6 +189,7 @@ namespace Spartan
     void World::Tick()
     {
         SP_PROFILE_CPU();
+        SP_MEMORY_TAG(MemoryTag::World);
 
         lock_guard<mutex> lock(entity_access_mutex);
 
@@ -219,10 +226,53 @@ namespace Spartan
         }
 
         // notify renderer
-        if (resolve && !ProgressTracker::IsLoading())
+        if (!ProgressTracker::IsLoading())
         {
-            Renderer::SetEntities(entities);
-            resolve = false;
+            if (resolve)
+            {
+                Renderer::SetEntities(entities);
+                resolve = false;
+
+                lock_guard lock(entities_dirty_mutex);
+                entities_dirty.clear();
+            }
+            else
+            {
+                frame_vector<uint64_t> dirty;
+                {
+                    lock_guard lock(entities_dirty_mutex);
+                    dirty.assign(entities_dirty.begin(), entities_dirty.end());
+                    entities_dirty.clear();
+                }
+
+                if (!dirty.empty())
+                {
+                    sort(dirty.begin(), dirty.end());
+                    dirty.erase(unique(dirty.begin(), dirty.end()), dirty.end());
+
+                    frame_vector<shared_ptr<Entity>> changed;
+                    frame_vector<uint64_t> removed;
+                    changed.reserve(dirty.size());
+                    {
+                        lock_guard lock(entity_access_mutex);
+
+                        for (uint64_t id : dirty)
+                        {
+                            auto it = entities.find(id);
+                            if (it != entities.end())
+                            {
+                                changed.emplace_back(it->second);
+                            }
+                            else
+                            {
+                                removed.emplace_back(id);
+                            }
+                        }
+                    }
+
+                    Renderer::UpdateEntities(changed, removed);
+                }
+            }
         }
 
         TickDefaultWorlds();
@@ -375,6 +425,14 @@ namespace Spartan
         resolve = true;
     }
 
+    void World::Resolve(Entity* entity)
+    {
+        SP_ASSERT_MSG(entity != nullptr, "Entity is null");
+
+        lock_guard lock(entities_dirty_mutex);
+        entities_dirty.emplace_back(entity->GetObjectId());
+    }
+
     shared_ptr<Entity> World::CreateEntity()
     {
         lock_guard lock(entity_access_mutex);
@@ -411,6 +469,12 @@ namespace Spartan
                 ids_to_remove.insert(entity->GetObjectId());
             }
 
+            // let the renderer drop them
+            {
+                lock_guard lock_dirty(entities_dirty_mutex);
+                entities_dirty.insert(entities_dirty.end(), ids_to_remove.begin(), ids_to_remove.end());
+            }
+
             // Remove entities using a single loop
             for (auto it = entities.begin(); it != entities.end(); )
             {
@@ -430,8 +494,6 @@ namespace Spartan
                 parent->AcquireChildren();
             }
         }
-
-        resolve = true;
     }
 
     vector<shared_ptr<Entity>> World::GetRootEntities()
@@ -474,6 +536,10 @@ namespace Spartan
 
         // clear
         entities.clear();
+        {
+            lock_guard lock(entities_dirty_mutex);
+            entities_dirty.clear();
+        }
         name.clear();
         file_path.clear();
 
@@ -971,7 +1037,7 @@ namespace Spartan
                         renderable->GetMaterial()->SetTexture(MaterialTexture::Normal, "project\\terrain\\vegetation_tree_2\\trunk_normal.png");
 
                         // generate instances
-                        terrain->GenerateTransforms(&instances, 5000, TerrainProp::Tree);
+                        terrain->GenerateTransforms(&instances, 5000, TerrainProp::Tree, 4.0f);
                         renderable->SetInstances(instances);
                     }
 
@@ -1019,7 +1085,7 @@ namespace Spartan
 
                         // generate instances
                         vector<Matrix> instances;
-                        terrain->GenerateTransforms(&instances, 20000, TerrainProp::Plant);
+                        terrain->GenerateTransforms(&instances, 20000, TerrainProp::Plant, 1.0f);
                         renderable->SetInstances(instances);
                     }
                 }
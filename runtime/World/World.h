@@ -63,7 +63,8 @@ namespace Spartan
 
         // misc
         static void New();
-        static void Resolve();
+        static void Resolve();               // rebuilds everything the renderer knows about the world
+        static void Resolve(Entity* entity); // only updates what the renderer knows about this entity
         static void LoadDefaultWorld(DefaultWorld default_world);
         static const std::string GetName();
         static const std::string& GetFilePath();
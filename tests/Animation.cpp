@@ -0,0 +1,469 @@
+/*
+Copyright(c) 2016-2024 Panos Karabelas
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+copies of the Software, and to permit persons to whom the Software is furnished
+to do so, subject to the following conditions :
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE AUTHORS OR
+COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+//= INCLUDES =========================
+#include "Test.h"
+#include "Core/ThreadPool.h"
+#include "Rendering/Animation.h"
+#include <cmath>
+//====================================
+
+//= NAMESPACES ===============
+using namespace std;
+using namespace Spartan;
+using namespace Spartan::Math;
+//============================
+
+namespace
+{
+    const float duration   = 2.0f;  // seconds
+    const float frame_rate = 30.0f;
+
+    // 16 bit quantization of a stream which spans the given extent, plus float rounding
+    float tolerance(const float extent)
+    {
+        return extent / 65535.0f + 1e-5f;
+    }
+
+    // a chain of joints, one unit apart along y
+    shared_ptr<AnimationSkeleton> create_chain(const uint32_t joint_count)
+    {
+        shared_ptr<AnimationSkeleton> skeleton = make_shared<AnimationSkeleton>();
+
+        Matrix model = Matrix::Identity;
+        for (uint32_t i = 0; i < joint_count; i++)
+        {
+            Matrix local = i == 0 ? Matrix::Identity : Matrix::CreateTranslation(Vector3(0.0f, 1.0f, 0.0f));
+            model        = local * model;
+
+            skeleton->joint_names.emplace_back("joint_" + to_string(i));
+            skeleton->joint_parents.emplace_back(static_cast<int32_t>(i) - 1);
+            skeleton->joint_bind_local.emplace_back(local);
+            skeleton->joint_offsets.emplace_back(model.Inverted());
+        }
+
+        return skeleton;
+    }
+
+    // the reference motion of a joint, translations move linearly and rotations turn around y
+    Vector3 translation_at(const uint32_t joint, const float time)
+    {
+        return Vector3(time * 0.5f, 1.0f, static_cast<float>(joint) * 0.1f - time);
+    }
+
+    Quaternion rotation_at(const uint32_t joint, const float time)
+    {
+        return Quaternion::FromAngleAxis((time / duration) * Helper::PI * 0.5f + static_cast<float>(joint) * 0.05f, Vector3::Up);
+    }
+
+    // keys at the sampling rate, every other joint is left without a channel so that it holds its bind pose
+    shared_ptr<Animation> create_clip(const shared_ptr<AnimationSkeleton>& skeleton, const float frame_rate_keys = frame_rate)
+    {
+        shared_ptr<Animation> clip = make_shared<Animation>();
+        clip->SetDuration(duration);
+        clip->SetTicksPerSec(1.0);
+
+        uint32_t key_count = static_cast<uint32_t>(duration * frame_rate_keys) + 1;
+        for (uint32_t joint = 0; joint < skeleton->GetJointCount(); joint += 2)
+        {
+            AnimationNode channel;
+            channel.name = skeleton->joint_names[joint];
+            for (uint32_t key = 0; key < key_count; key++)
+            {
+                float time = static_cast<float>(key) / frame_rate_keys;
+                channel.positionFrames.push_back({ time, translation_at(joint, time) });
+                channel.rotationFrames.push_back({ time, rotation_at(joint, time) });
+                channel.scaleFrames.push_back({ time, Vector3::One });
+            }
+            clip->AddChannel(move(channel));
+        }
+
+        clip->Compress(skeleton, frame_rate);
+        return clip;
+    }
+
+    Vector3 get_translation(const AnimationPose& pose, const uint32_t joint)
+    {
+        return Vector3(pose.GetStream(AnimationStream::TranslationX)[joint], pose.GetStream(AnimationStream::TranslationY)[joint], pose.GetStream(AnimationStream::TranslationZ)[joint]);
+    }
+
+    Quaternion get_rotation(const AnimationPose& pose, const uint32_t joint)
+    {
+        return Quaternion(pose.GetStream(AnimationStream::RotationX)[joint], pose.GetStream(AnimationStream::RotationY)[joint], pose.GetStream(AnimationStream::RotationZ)[joint], pose.GetStream(AnimationStream::RotationW)[joint]);
+    }
+
+    // the same orientation, q and -q included
+    bool is_same_rotation(const Quaternion& a, const Quaternion& b, const float epsilon)
+    {
+        return fabsf(a.Dot(b)) >= 1.0f - epsilon;
+    }
+
+    bool is_near(const Vector3& a, const Vector3& b, const float epsilon)
+    {
+        return fabsf(a.x - b.x) <= epsilon && fabsf(a.y - b.y) <= epsilon && fabsf(a.z - b.z) <= epsilon;
+    }
+
+    bool is_near(const Matrix& a, const Matrix& b, const float epsilon)
+    {
+        const float* data_a = a.Data();
+        const float* data_b = b.Data();
+        for (uint32_t i = 0; i < 16; i++)
+        {
+            if (fabsf(data_a[i] - data_b[i]) > epsilon)
+                return false;
+        }
+        return true;
+    }
+}
+
+TEST(animation_compress_and_sample_stay_within_the_quantization_error)
+{
+    // an odd joint count, so the last simd register carries padding
+    shared_ptr<AnimationSkeleton> skeleton = create_chain(7);
+    shared_ptr<Animation> clip             = create_clip(skeleton);
+
+    CHECK(clip->IsCompressed());
+    CHECK(clip->GetChannels().empty());
+
+    // the x translation spans a second, z spans two
+    float error_translation = tolerance(2.0f);
+    float error_rotation    = 1e-4f;
+
+    AnimationPose pose;
+    bool translations_match = true;
+    bool rotations_match    = true;
+    bool bind_pose_held     = true;
+    for (float time : { 0.0f, 1.0f / 30.0f, 0.25f, 0.5f + 1.0f / 60.0f, 1.0f, 1.999f })
+    {
+        clip->Sample(time, pose);
+        CHECK(pose.joint_count == 7 && pose.lane_count == 8);
+
+        for (uint32_t joint = 0; joint < 7; joint++)
+        {
+            if (joint % 2 == 0)
+            {
+                translations_match &= is_near(get_translation(pose, joint), translation_at(joint, time), error_translation);
+                rotations_match    &= is_same_rotation(get_rotation(pose, joint), rotation_at(joint, time), error_rotation);
+            }
+            else
+            {
+                bind_pose_held &= is_near(get_translation(pose, joint), Vector3(0.0f, 1.0f, 0.0f), 1e-6f);
+                bind_pose_held &= is_same_rotation(get_rotation(pose, joint), Quaternion::Identity, 1e-6f);
+            }
+        }
+    }
+
+    CHECK(translations_match);
+    CHECK(rotations_match);
+    CHECK(bind_pose_held);
+}
+
+TEST(animation_sample_loops_over_the_duration)
+{
+    shared_ptr<AnimationSkeleton> skeleton = create_chain(4);
+    shared_ptr<Animation> clip             = create_clip(skeleton);
+
+    AnimationPose pose_a;
+    AnimationPose pose_b;
+    AnimationPose pose_c;
+    clip->Sample(0.4f, pose_a);
+    clip->Sample(0.4f + duration * 3.0f, pose_b);
+    clip->Sample(0.4f - duration, pose_c);
+
+    bool same = true;
+    for (uint32_t joint = 0; joint < 4; joint++)
+    {
+        same &= is_near(get_translation(pose_a, joint), get_translation(pose_b, joint), 1e-4f);
+        same &= is_near(get_translation(pose_a, joint), get_translation(pose_c, joint), 1e-4f);
+    }
+    CHECK(same);
+}
+
+TEST(animation_resampling_interpolates_between_sparse_keys)
+{
+    // keys at 4 fps get resampled at 30 fps, the translations are linear so no error is introduced
+    shared_ptr<AnimationSkeleton> skeleton = create_chain(2);
+    shared_ptr<Animation> clip             = create_clip(skeleton, 4.0f);
+
+    AnimationPose pose;
+    bool match = true;
+    for (float time : { 0.1f, 0.6f, 1.3f })
+    {
+        clip->Sample(time, pose);
+        match &= is_near(get_translation(pose, 0), translation_at(0, time), tolerance(2.0f));
+    }
+    CHECK(match);
+}
+
+TEST(animation_blend_weights_and_shortest_path)
+{
+    shared_ptr<AnimationSkeleton> skeleton = create_chain(4);
+
+    AnimationPose a;
+    AnimationPose b;
+    AnimationPose out;
+    a.Resize(4);
+    b.Resize(4);
+    b.GetStream(AnimationStream::TranslationX)[0] = 2.0f;
+
+    // the same rotation in the opposite hemisphere, a naive lerp would pass through zero at 0.5
+    Quaternion rotation = Quaternion::FromAngleAxis(0.5f, Vector3::Up);
+    b.GetStream(AnimationStream::RotationY)[1] = -rotation.y;
+    b.GetStream(AnimationStream::RotationW)[1] = -rotation.w;
+    a.GetStream(AnimationStream::RotationY)[1] = rotation.y;
+    a.GetStream(AnimationStream::RotationW)[1] = rotation.w;
+
+    AnimationPose::Blend(a, b, 0.0f, out);
+    CHECK(get_translation(out, 0).x == 0.0f);
+
+    AnimationPose::Blend(a, b, 1.0f, out);
+    CHECK(get_translation(out, 0).x == 2.0f);
+
+    AnimationPose::Blend(a, b, 0.5f, out);
+    CHECK(fabsf(get_translation(out, 0).x - 1.0f) < 1e-6f);
+    CHECK(is_same_rotation(get_rotation(out, 1), rotation, 1e-5f));
+
+    // the padding lanes stay identity rotations
+    CHECK(out.GetStream(AnimationStream::RotationW)[3] == 1.0f);
+}
+
+namespace
+{
+    // the bind pose of a chain, which create_clip() leaves untouched on odd joints
+    void set_bind_pose(AnimationPose& pose, const uint32_t joint_count)
+    {
+        pose.Resize(joint_count);
+        for (uint32_t joint = 1; joint < joint_count; joint++)
+        {
+            pose.GetStream(AnimationStream::TranslationY)[joint] = 1.0f;
+        }
+    }
+
+    vector<RHI_Vertex_PosTexNorTan> create_vertices(const uint32_t joint_count)
+    {
+        // one vertex at every joint, pointing along x
+        vector<RHI_Vertex_PosTexNorTan> vertices;
+        for (uint32_t joint = 0; joint < joint_count; joint++)
+        {
+            vertices.emplace_back(Vector3(0.0f, static_cast<float>(joint), 0.0f), Vector2(0.5f, static_cast<float>(joint)), Vector3::Right, Vector3::Forward);
+        }
+        return vertices;
+    }
+}
+
+TEST(animation_palette_follows_the_hierarchy)
+{
+    shared_ptr<AnimationSkeleton> skeleton = create_chain(5);
+
+    AnimationPose pose;
+    set_bind_pose(pose, 5);
+
+    vector<Matrix> palette;
+    skeleton->ComputePalette(pose, palette);
+
+    bool identity = palette.size() == 5;
+    for (const Matrix& matrix : palette)
+    {
+        identity &= is_near(matrix, Matrix::Identity, 1e-5f);
+    }
+    CHECK(identity);
+
+    // turning the root turns everything below it
+    Quaternion rotation = Quaternion::FromAngleAxis(Helper::PI * 0.5f, Vector3::Forward);
+    pose.GetStream(AnimationStream::RotationZ)[0] = rotation.z;
+    pose.GetStream(AnimationStream::RotationW)[0] = rotation.w;
+    skeleton->ComputePalette(pose, palette);
+
+    Matrix root = Matrix::CreateRotation(rotation);
+    bool rotated = true;
+    for (uint32_t joint = 0; joint < 5; joint++)
+    {
+        Vector3 bind = Vector3(0.0f, static_cast<float>(joint), 0.0f);
+        rotated     &= is_near(bind * palette[joint], bind * root, 1e-4f);
+    }
+    CHECK(rotated);
+}
+
+TEST(animation_evaluate_matches_serial_sampling)
+{
+    ThreadPool::Initialize();
+
+    shared_ptr<AnimationSkeleton> skeleton = create_chain(9);
+    shared_ptr<Animation> clip_a           = create_clip(skeleton);
+    shared_ptr<Animation> clip_b           = create_clip(skeleton, 10.0f);
+
+    const uint32_t character_count = 64;
+    vector<AnimationPose> poses(character_count);
+    vector<vector<Matrix>> palettes(character_count);
+    vector<AnimationJob> jobs(character_count);
+    for (uint32_t i = 0; i < character_count; i++)
+    {
+        jobs[i].clip_a       = clip_a.get();
+        jobs[i].clip_b       = i % 2 == 0 ? clip_b.get() : nullptr;
+        jobs[i].time_a       = static_cast<float>(i) * 0.07f;
+        jobs[i].time_b       = static_cast<float>(i) * 0.03f;
+        jobs[i].blend_weight = 0.3f;
+        jobs[i].pose         = &poses[i];
+        jobs[i].palette      = &palettes[i];
+    }
+
+    Animation::Evaluate(jobs);
+
+    bool match = true;
+    for (uint32_t i = 0; i < character_count; i++)
+    {
+        AnimationPose pose;
+        clip_a->Sample(jobs[i].time_a, pose);
+        if (jobs[i].clip_b)
+        {
+            AnimationPose pose_b;
+            clip_b->Sample(jobs[i].time_b, pose_b);
+            AnimationPose::Blend(pose, pose_b, jobs[i].blend_weight, pose);
+        }
+
+        vector<Matrix> palette;
+        skeleton->ComputePalette(pose, palette);
+
+        match &= poses[i].data == pose.data;
+        match &= palettes[i] == palette;
+    }
+    CHECK(match);
+
+    ThreadPool::Shutdown();
+}
+
+TEST(animation_skin_blends_the_influences)
+{
+    const uint32_t joint_count                = 3;
+    shared_ptr<AnimationSkeleton> skeleton    = create_chain(joint_count);
+    vector<RHI_Vertex_PosTexNorTan> vertices  = create_vertices(joint_count);
+    vector<RHI_Vertex_PosTexNorTan> skinned(joint_count);
+    vector<AnimationVertexInfluence> influences(joint_count);
+    for (uint32_t joint = 0; joint < joint_count; joint++)
+    {
+        influences[joint].joints[0]  = static_cast<uint16_t>(joint);
+        influences[joint].weights[0] = 1.0f;
+    }
+
+    // the last vertex is split between the last two joints
+    influences[2].joints[1]  = 1;
+    influences[2].weights[0] = 0.5f;
+    influences[2].weights[1] = 0.5f;
+
+    // bind pose, nothing moves
+    AnimationPose pose;
+    set_bind_pose(pose, joint_count);
+    vector<Matrix> palette;
+    skeleton->ComputePalette(pose, palette);
+    Animation::Skin(palette, vertices.data(), influences.data(), joint_count, skinned.data());
+
+    bool unchanged = true;
+    for (uint32_t i = 0; i < joint_count; i++)
+    {
+        unchanged &= is_near(Vector3(skinned[i].pos), Vector3(vertices[i].pos), 1e-5f);
+        unchanged &= is_near(Vector3(skinned[i].nor), Vector3(vertices[i].nor), 1e-5f);
+        unchanged &= skinned[i].tex[0] == vertices[i].tex[0] && skinned[i].tex[1] == vertices[i].tex[1];
+    }
+    CHECK(unchanged);
+
+    // move the last joint by two units along x, the full vertex follows and the split one goes half way
+    pose.GetStream(AnimationStream::TranslationX)[2] = 2.0f;
+    skeleton->ComputePalette(pose, palette);
+    Animation::Skin(palette, vertices.data(), influences.data(), joint_count, skinned.data());
+
+    CHECK(is_near(Vector3(skinned[1].pos), Vector3(0.0f, 1.0f, 0.0f), 1e-5f));
+    CHECK(is_near(Vector3(skinned[2].pos), Vector3(1.0f, 2.0f, 0.0f), 1e-5f));
+
+    // directions ignore the translation and stay unit length
+    CHECK(is_near(Vector3(skinned[2].nor), Vector3::Right, 1e-5f));
+    CHECK(is_near(Vector3(skinned[2].tan), Vector3::Forward, 1e-5f));
+}
+
+BENCHMARK(animation_1000_characters)
+{
+    ThreadPool::Initialize();
+
+    // a humanoid sized skeleton, four clips and every other character blending two of them
+    const uint32_t joint_count     = 64;
+    const uint32_t character_count = 1000;
+    shared_ptr<AnimationSkeleton> skeleton = create_chain(joint_count);
+    vector<shared_ptr<Animation>> clips;
+    for (uint32_t i = 0; i < 4; i++)
+    {
+        clips.emplace_back(create_clip(skeleton, 10.0f + static_cast<float>(i) * 5.0f));
+    }
+
+    vector<AnimationPose> poses(character_count);
+    vector<vector<Matrix>> palettes(character_count);
+    vector<AnimationJob> jobs(character_count);
+    for (uint32_t i = 0; i < character_count; i++)
+    {
+        jobs[i].clip_a       = clips[i % 4].get();
+        jobs[i].clip_b       = i % 2 == 0 ? clips[(i + 1) % 4].get() : nullptr;
+        jobs[i].blend_weight = 0.5f;
+        jobs[i].pose         = &poses[i];
+        jobs[i].palette      = &palettes[i];
+    }
+
+    auto advance = [&jobs]()
+    {
+        for (AnimationJob& job : jobs)
+        {
+            job.time_a += 1.0f / 60.0f;
+            job.time_b += 1.0f / 60.0f;
+        }
+    };
+
+    // warm up, so that the poses and palettes are allocated
+    Animation::Evaluate(jobs);
+
+    tests::measure("evaluate (sample, blend, palette)", 100, [&]() { advance(); Animation::Evaluate(jobs); });
+
+    // the sampler alone, on a single thread
+    tests::measure("sample on one thread", 100, [&]()
+    {
+        advance();
+        for (AnimationJob& job : jobs)
+        {
+            job.clip_a->Sample(job.time_a, *job.pose);
+        }
+    });
+
+    // cpu skinning of a 5K vertex mesh per character
+    const uint32_t vertex_count = 5000;
+    vector<RHI_Vertex_PosTexNorTan> vertices(vertex_count);
+    vector<RHI_Vertex_PosTexNorTan> skinned(vertex_count);
+    vector<AnimationVertexInfluence> influences(vertex_count);
+    for (uint32_t i = 0; i < vertex_count; i++)
+    {
+        vertices[i] = RHI_Vertex_PosTexNorTan(Vector3(0.0f, static_cast<float>(i % joint_count), 0.0f), Vector2::Zero, Vector3::Right, Vector3::Forward);
+        for (uint32_t k = 0; k < 4; k++)
+        {
+            influences[i].joints[k]  = static_cast<uint16_t>((i + k) % joint_count);
+            influences[i].weights[k] = 0.25f;
+        }
+    }
+
+    double ms = tests::measure("skin 5K vertices", 100, [&]() { Animation::Skin(palettes[0], vertices.data(), influences.data(), vertex_count, skinned.data()); });
+    tests::report("skin 5K vertices x 1000 characters", ms * character_count, "ms");
+
+    ThreadPool::Shutdown();
+}
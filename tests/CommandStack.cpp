@@ -0,0 +1,245 @@
+/*
+Copyright(c) 2016-2024 Panos Karabelas
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+copies of the Software, and to permit persons to whom the Software is furnished
+to do so, subject to the following conditions :
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE AUTHORS OR
+COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+//= INCLUDES ======================
+#include "Test.h"
+#include "Commands/CommandStack.h"
+//=================================
+
+//= NAMESPACES ===============
+using namespace std;
+using namespace Spartan;
+//============================
+
+namespace
+{
+    // sets an integer, the padding controls how many bytes the command takes in the arena
+    template<uint32_t padding>
+    class CommandSet : public Command
+    {
+    public:
+        CommandSet(int* target, const int value_old, const int value_new) : m_target(target), m_value_old(value_old), m_value_new(value_new)
+        {
+            *m_target = value_new;
+        }
+
+        void OnApply() override  { *m_target = m_value_new; }
+        void OnRevert() override { *m_target = m_value_old; }
+
+        bool Merge(const Command& command) override
+        {
+            const CommandSet* command_set = dynamic_cast<const CommandSet*>(&command);
+            if (!command_set || command_set->m_target != m_target)
+                return false;
+
+            m_value_new = command_set->m_value_new;
+            return true;
+        }
+
+    private:
+        int* m_target   = nullptr;
+        int m_value_old = 0;
+        int m_value_new = 0;
+        uint8_t m_padding[padding] = {};
+    };
+
+    using CommandSmall = CommandSet<8>;
+    using CommandLarge = CommandSet<64>;
+
+    void set_value(int& target, const int value)
+    {
+        CommandStack::Add<CommandSmall>(&target, target, value);
+    }
+
+    void undo(const uint32_t count)
+    {
+        for (uint32_t i = 0; i < count; i++)
+        {
+            CommandStack::Undo();
+        }
+    }
+
+    // every test starts from an empty stack with the default budget
+    void reset()
+    {
+        CommandStack::SetBudget(command_stack_budget);
+    }
+}
+
+TEST(command_stack_merges_within_an_interaction_only)
+{
+    reset();
+    int value = 0;
+
+    // a drag, one command per frame
+    CommandStack::BeginInteraction();
+    for (int i = 1; i <= 10; i++)
+    {
+        set_value(value, i);
+    }
+    CommandStack::EndInteraction();
+    CHECK(CommandStack::GetCommandCount() == 1);
+
+    // a second drag of the same target is its own step
+    CommandStack::BeginInteraction();
+    set_value(value, 20);
+    set_value(value, 30);
+    CommandStack::EndInteraction();
+    CHECK(CommandStack::GetCommandCount() == 2);
+
+    // outside of an interaction nothing merges
+    set_value(value, 40);
+    set_value(value, 50);
+    CHECK(CommandStack::GetCommandCount() == 4);
+
+    undo(2);
+    CHECK(value == 30);
+    CommandStack::Undo();
+    CHECK(value == 10);
+    CommandStack::Undo();
+    CHECK(value == 0);
+
+    CommandStack::Redo();
+    CHECK(value == 10);
+
+    // a new command discards what could be redone
+    set_value(value, 99);
+    CHECK(CommandStack::GetCommandCount() == 2);
+    CommandStack::Redo();
+    CHECK(value == 99);
+
+    reset();
+}
+
+TEST(command_stack_batch_is_a_single_step)
+{
+    reset();
+    int a = 0;
+    int b = 0;
+    int c = 0;
+
+    set_value(a, 1);
+
+    CommandStack::BeginBatch();
+    set_value(a, 2);
+    set_value(b, 2);
+    set_value(c, 2);
+    CommandStack::EndBatch();
+    CHECK(CommandStack::GetCommandCount() == 4);
+
+    // an interaction right after the batch doesn't fold into it
+    CommandStack::BeginInteraction();
+    set_value(c, 3);
+    CommandStack::EndInteraction();
+    CHECK(CommandStack::GetCommandCount() == 5);
+
+    CommandStack::Undo();
+    CHECK(a == 2 && b == 2 && c == 2);
+
+    CommandStack::Undo();
+    CHECK(a == 1 && b == 0 && c == 0);
+
+    CommandStack::Redo();
+    CHECK(a == 2 && b == 2 && c == 2);
+
+    CommandStack::Undo();
+    CommandStack::Undo();
+    CHECK(a == 0);
+
+    reset();
+}
+
+TEST(command_stack_evicts_the_oldest_steps_by_byte_budget)
+{
+    // room for exactly four large commands
+    const uint32_t command_size = static_cast<uint32_t>(sizeof(CommandLarge));
+    CommandStack::SetBudget(command_size * 4);
+    CHECK(CommandStack::GetBudget() == command_size * 4);
+
+    int value = 0;
+    for (int i = 1; i <= 7; i++)
+    {
+        CommandStack::Add<CommandLarge>(&value, value, i);
+        CHECK(CommandStack::GetUsedBytes() <= CommandStack::GetBudget());
+    }
+    CHECK(CommandStack::GetCommandCount() == 4);
+    CHECK(CommandStack::GetUsedBytes() == CommandStack::GetBudget());
+
+    // only the four latest steps can be undone
+    undo(10);
+    CHECK(value == 3);
+
+    CommandStack::Clear();
+    CHECK(CommandStack::GetCommandCount() == 0 && CommandStack::GetUsedBytes() == 0);
+
+    // a batch is evicted as a whole, never leaving a partial step behind
+    int a = 0;
+    int b = 0;
+    CommandStack::BeginBatch();
+    CommandStack::Add<CommandLarge>(&a, a, 1);
+    CommandStack::Add<CommandLarge>(&b, b, 1);
+    CommandStack::EndBatch();
+    CommandStack::Add<CommandLarge>(&value, value, 10);
+    CommandStack::Add<CommandLarge>(&value, value, 11);
+    CHECK(CommandStack::GetCommandCount() == 4);
+
+    CommandStack::Add<CommandLarge>(&value, value, 12);
+    CHECK(CommandStack::GetCommandCount() == 3);
+
+    undo(10);
+    CHECK(value == 3 && a == 1 && b == 1);
+
+    // commands of mixed sizes wrap around the arena
+    CommandStack::Clear();
+    for (int i = 0; i < 100; i++)
+    {
+        if (i % 3 == 0)
+        {
+            CommandStack::Add<CommandLarge>(&value, value, i);
+        }
+        else
+        {
+            CommandStack::Add<CommandSmall>(&value, value, i);
+        }
+        CHECK(CommandStack::GetUsedBytes() <= CommandStack::GetBudget());
+    }
+    CHECK(value == 99);
+    CommandStack::Undo();
+    CHECK(value == 98);
+
+    reset();
+}
+
+TEST(command_stack_evicts_by_count_when_commands_are_small)
+{
+    reset();
+    int value = 0;
+    for (uint32_t i = 1; i <= command_stack_max_commands + 10; i++)
+    {
+        set_value(value, static_cast<int>(i));
+    }
+    CHECK(CommandStack::GetCommandCount() == command_stack_max_commands);
+
+    undo(command_stack_max_commands + 10);
+    CHECK(value == 10);
+
+    reset();
+}
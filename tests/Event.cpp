@@ -0,0 +1,252 @@
+/*
+Copyright(c) 2016-2024 Panos Karabelas
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+copies of the Software, and to permit persons to whom the Software is furnished
+to do so, subject to the following conditions :
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE AUTHORS OR
+COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+//= INCLUDES =====
+#include "Test.h"
+#include <thread>
+//================
+
+//= NAMESPACES =====
+using namespace std;
+using namespace Spartan;
+//==================
+
+namespace
+{
+    // typed and nothing subscribes to it without the engine
+    const EventType event_type = EventType::MaterialOnChanged;
+
+    // more than the queue holds, so that the overflow is exercised too
+    const uint64_t event_count = 20000;
+}
+
+TEST(event_publish_is_deferred_until_dispatch)
+{
+    vector<uint64_t> received;
+    EventSubscription subscription = SP_SUBSCRIBE_TO_EVENT_DATA(event_type, [&received](const uint64_t id) { received.push_back(id); });
+
+    SP_PUBLISH_EVENT_DATA(event_type, 42);
+    CHECK(received.empty());
+
+    Event::Dispatch();
+    CHECK(received.size() == 1 && received[0] == 42);
+
+    // fired events don't wait
+    SP_FIRE_EVENT_DATA(event_type, 7);
+    CHECK(received.size() == 2 && received[1] == 7);
+
+    Event::Unsubscribe(subscription);
+}
+
+TEST(event_dispatch_keeps_the_publish_order)
+{
+    vector<uint64_t> received;
+    EventSubscription subscription = SP_SUBSCRIBE_TO_EVENT_DATA(event_type, [&received](const uint64_t id) { received.push_back(id); });
+
+    for (uint64_t i = 0; i < event_count; i++)
+    {
+        SP_PUBLISH_EVENT_DATA(event_type, i);
+    }
+    Event::Dispatch();
+
+    bool in_order = received.size() == event_count;
+    for (uint64_t i = 0; in_order && i < event_count; i++)
+    {
+        in_order = received[i] == i;
+    }
+    CHECK(in_order);
+
+    Event::Unsubscribe(subscription);
+}
+
+TEST(event_overflow_during_dispatch_waits_for_the_next_dispatch)
+{
+    const uint64_t marker = event_count * 2;
+
+    // the first event publishes two more while the queue is still full but for the cell it came from,
+    // the second of them overflows, and it must neither be fired now nor overtake the first
+    vector<uint64_t> received;
+    EventSubscription subscription = SP_SUBSCRIBE_TO_EVENT_DATA(event_type, [&](const uint64_t id)
+    {
+        received.push_back(id);
+        if (id == 0)
+        {
+            SP_PUBLISH_EVENT_DATA(event_type, marker);
+            SP_PUBLISH_EVENT_DATA(event_type, marker + 1);
+        }
+    });
+
+    for (uint64_t i = 0; i < event_count; i++)
+    {
+        SP_PUBLISH_EVENT_DATA(event_type, i);
+    }
+    Event::Dispatch();
+
+    bool in_order = received.size() == event_count;
+    for (uint64_t i = 0; in_order && i < event_count; i++)
+    {
+        in_order = received[i] == i;
+    }
+    CHECK(in_order);
+
+    received.clear();
+    Event::Dispatch();
+    CHECK(received.size() == 2 && received[0] == marker && received[1] == marker + 1);
+
+    Event::Unsubscribe(subscription);
+}
+
+TEST(event_publish_from_many_threads)
+{
+    const uint32_t thread_count = 4;
+
+    uint64_t count = 0;
+    uint64_t sum   = 0;
+    EventSubscription subscription = SP_SUBSCRIBE_TO_EVENT_DATA(event_type, [&](const uint64_t id) { count++; sum += id; });
+
+    vector<thread> threads;
+    for (uint32_t t = 0; t < thread_count; t++)
+    {
+        threads.emplace_back([]()
+        {
+            for (uint64_t i = 1; i <= event_count; i++)
+            {
+                SP_PUBLISH_EVENT_DATA(event_type, i);
+            }
+        });
+    }
+    for (thread& thread : threads)
+    {
+        thread.join();
+    }
+
+    Event::Dispatch();
+    CHECK(count == thread_count * event_count);
+    CHECK(sum == thread_count * (event_count * (event_count + 1) / 2));
+
+    Event::Unsubscribe(subscription);
+}
+
+TEST(event_published_while_dispatching_waits_for_the_next_dispatch)
+{
+    uint32_t count = 0;
+    EventSubscription subscription = SP_SUBSCRIBE_TO_EVENT_DATA(event_type, [&count](const uint64_t)
+    {
+        count++;
+        SP_PUBLISH_EVENT_DATA(event_type, 0);
+    });
+
+    SP_PUBLISH_EVENT_DATA(event_type, 0);
+    Event::Dispatch();
+    CHECK(count == 1);
+    Event::Dispatch();
+    CHECK(count == 2);
+
+    Event::Unsubscribe(subscription);
+    Event::Dispatch();
+    CHECK(count == 2);
+}
+
+TEST(event_unsubscribe_while_firing)
+{
+    uint32_t count_a = 0;
+    uint32_t count_b = 0;
+    EventSubscription subscription_a = 0;
+    EventSubscription subscription_b = 0;
+
+    // a removes itself and b, b still runs this time since it was already being fired
+    subscription_a = SP_SUBSCRIBE_TO_EVENT_DATA(event_type, [&](const uint64_t)
+    {
+        count_a++;
+        Event::Unsubscribe(subscription_a);
+        Event::Unsubscribe(subscription_b);
+    });
+    subscription_b = SP_SUBSCRIBE_TO_EVENT_DATA(event_type, [&](const uint64_t) { count_b++; });
+
+    SP_FIRE_EVENT_DATA(event_type, 0);
+    SP_FIRE_EVENT_DATA(event_type, 0);
+    CHECK(count_a == 1);
+    CHECK(count_b == 0);
+}
+
+BENCHMARK(event_many_subscribers)
+{
+    const uint32_t subscriber_count = 64;
+    const uint32_t thread_count     = 4;
+    const uint64_t events           = 1000000;
+
+    vector<uint64_t> sums(subscriber_count, 0);
+    vector<EventSubscription> subscriptions;
+    for (uint32_t i = 0; i < subscriber_count; i++)
+    {
+        subscriptions.push_back(Event::Subscribe<event_type>([&sums, i](const uint64_t id) { sums[i] += id; }));
+    }
+
+    // publish from several threads and dispatch on this one, in frames, like the engine does
+    Stopwatch stopwatch;
+    uint64_t published = 0;
+    while (published < events)
+    {
+        uint64_t frame_events = min<uint64_t>(events - published, 8192);
+
+        vector<thread> threads;
+        for (uint32_t t = 0; t < thread_count; t++)
+        {
+            threads.emplace_back([frame_events, t]()
+            {
+                for (uint64_t i = t; i < frame_events; i += thread_count)
+                {
+                    SP_PUBLISH_EVENT_DATA(event_type, i);
+                }
+            });
+        }
+        for (thread& thread : threads)
+        {
+            thread.join();
+        }
+
+        Event::Dispatch();
+        published += frame_events;
+    }
+    double seconds = stopwatch.GetElapsedTimeSec();
+
+    tests::report("events per second", static_cast<double>(events) / seconds / 1e6, "million");
+    tests::report("subscriber calls per second", static_cast<double>(events) * subscriber_count / seconds / 1e6, "million");
+
+    // the same on one thread, without starting threads every frame
+    Stopwatch stopwatch_publish;
+    for (uint64_t i = 0; i < events; i++)
+    {
+        SP_PUBLISH_EVENT_DATA(event_type, i);
+        if ((i & 4095) == 4095)
+        {
+            Event::Dispatch();
+        }
+    }
+    double seconds_publish = stopwatch_publish.GetElapsedTimeSec();
+    Event::Dispatch();
+    tests::report("events per second, one thread", static_cast<double>(events) / seconds_publish / 1e6, "million");
+
+    for (EventSubscription subscription : subscriptions)
+    {
+        Event::Unsubscribe(subscription);
+    }
+}
@@ -0,0 +1,207 @@
+/*
+Copyright(c) 2016-2024 Panos Karabelas
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+copies of the Software, and to permit persons to whom the Software is furnished
+to do so, subject to the following conditions :
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE AUTHORS OR
+COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+//= INCLUDES ===========================
+#include "Test.h"
+#include "IO/FileWatcher.h"
+#include "Resource/HotReload.h"
+#include "Resource/ResourceCache.h"
+#include "RHI/RHI_Shader.h"
+#include "Rendering/Renderer.h"
+#include <fstream>
+#include <thread>
+//======================================
+
+//= NAMESPACES =====
+using namespace std;
+using namespace Spartan;
+//==================
+
+namespace
+{
+    const float coalesce_time_ms = 50.0f;
+
+    // a fresh directory per test, being watched
+    filesystem::path watch_directory()
+    {
+        filesystem::path directory = filesystem::temp_directory_path() / "spartan_file_watcher";
+        filesystem::remove_all(directory);
+        filesystem::create_directories(directory);
+
+        FileWatcher::Initialize();
+        FileWatcher::SetCoalesceTimeMs(coalesce_time_ms);
+        FileWatcher::AddDirectory(directory.string());
+
+        return directory;
+    }
+
+    void write(const filesystem::path& file_path, const string& text)
+    {
+        ofstream(file_path) << text;
+    }
+
+    // polls until nothing is pending anymore, long enough for everything written before the call to settle
+    vector<string> poll_settled()
+    {
+        vector<string> file_paths;
+        for (uint32_t i = 0; i < 10; i++)
+        {
+            this_thread::sleep_for(chrono::milliseconds(static_cast<int>(coalesce_time_ms)));
+            FileWatcher::Poll(file_paths);
+        }
+
+        return file_paths;
+    }
+
+    uint32_t count(const vector<string>& file_paths, const filesystem::path& file_path)
+    {
+        uint32_t count = 0;
+        for (const string& path : file_paths)
+        {
+            error_code error;
+            count += filesystem::equivalent(path, file_path, error) ? 1 : 0;
+        }
+
+        return count;
+    }
+}
+
+TEST(file_watcher_coalesces_a_burst_of_writes)
+{
+    filesystem::path directory = watch_directory();
+    filesystem::path file_path = directory / "shader.hlsl";
+
+    // like an editor which saves in several steps
+    for (uint32_t i = 0; i < 5; i++)
+    {
+        write(file_path, to_string(i));
+        this_thread::sleep_for(chrono::milliseconds(5));
+    }
+
+    // nothing before the file has been quiet for the coalesce time
+    vector<string> file_paths;
+    FileWatcher::Poll(file_paths);
+    CHECK(file_paths.empty());
+
+    file_paths = poll_settled();
+    CHECK(file_paths.size() == 1);
+    CHECK(count(file_paths, file_path) == 1);
+
+    FileWatcher::Shutdown();
+}
+
+TEST(file_watcher_reports_a_write_to_temp_then_rename)
+{
+    filesystem::path directory = watch_directory();
+    filesystem::path file_path = directory / "material.xml";
+
+    // how most tools save atomically, the temporary file is gone by the time the change settles
+    write(directory / "material.xml.tmp", "<material/>");
+    filesystem::rename(directory / "material.xml.tmp", file_path);
+
+    vector<string> file_paths = poll_settled();
+    CHECK(file_paths.size() == 1);
+    CHECK(count(file_paths, file_path) == 1);
+
+    FileWatcher::Shutdown();
+}
+
+TEST(file_watcher_watches_new_subdirectories)
+{
+    filesystem::path directory = watch_directory();
+
+    // the files are written right away, before the watcher has had a chance to watch the new directories
+    filesystem::create_directories(directory / "textures" / "brick");
+    write(directory / "textures" / "albedo.png", "0");
+    write(directory / "textures" / "brick" / "normal.png", "0");
+
+    vector<string> file_paths = poll_settled();
+    CHECK(count(file_paths, directory / "textures" / "albedo.png") == 1);
+    CHECK(count(file_paths, directory / "textures" / "brick" / "normal.png") == 1);
+
+    // and later changes in them are reported too
+    write(directory / "textures" / "brick" / "normal.png", "1");
+    file_paths = poll_settled();
+    CHECK(file_paths.size() == 1);
+    CHECK(count(file_paths, directory / "textures" / "brick" / "normal.png") == 1);
+
+    FileWatcher::Shutdown();
+}
+
+TEST(file_watcher_rescans_when_the_os_drops_changes)
+{
+    filesystem::path directory = watch_directory();
+
+    // every file is at least three events (create, modify, close), more than the default inotify queue of 16384 holds
+    const uint32_t file_count = 8000;
+    for (uint32_t i = 0; i < file_count; i++)
+    {
+        write(directory / (to_string(i) + ".txt"), "0");
+    }
+
+    vector<string> file_paths = poll_settled();
+    CHECK(file_paths.size() == file_count);
+
+    FileWatcher::Shutdown();
+}
+
+TEST_ENGINE(hot_reload_recompiles_every_shader_including_a_file)
+{
+    const filesystem::path file_path = filesystem::path(ResourceCache::GetResourceDirectory(ResourceDirectory::Shaders)) / "common_colorspace.hlsl";
+
+    // the shaders which include it, directly or through other includes
+    uint32_t dependents = 0;
+    unordered_set<RHI_Shader*> visited;
+    for (const shared_ptr<RHI_Shader>& shader : Renderer::GetShaders())
+    {
+        if (!shader || !visited.insert(shader.get()).second)
+            continue;
+
+        error_code error;
+        for (const string& path : shader->GetFilePaths())
+        {
+            if (filesystem::equivalent(path, file_path, error))
+            {
+                dependents++;
+                break;
+            }
+        }
+    }
+    CHECK(dependents > 1);
+
+    // write it back as it is
+    string source;
+    {
+        ifstream stream(file_path, ios::binary);
+        source.assign(istreambuf_iterator<char>(stream), istreambuf_iterator<char>());
+    }
+    CHECK(!source.empty());
+    ofstream(file_path, ios::binary) << source;
+
+    // the shaders compile on the thread pool and are swapped in at the start of a frame
+    uint32_t reload_count = HotReload::GetReloadCount();
+    Stopwatch stopwatch;
+    while (HotReload::GetReloadCount() - reload_count < dependents && stopwatch.GetElapsedTimeSec() < 120.0f)
+    {
+        tests::tick(1);
+    }
+    CHECK(HotReload::GetReloadCount() - reload_count == dependents);
+}
@@ -0,0 +1,185 @@
+/*
+Copyright(c) 2016-2024 Panos Karabelas
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+copies of the Software, and to permit persons to whom the Software is furnished
+to do so, subject to the following conditions :
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE AUTHORS OR
+COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+//= INCLUDES ===========================
+#include "Test.h"
+#include "Core/Engine.h"
+#include "Core/FrameArena.h"
+#include "Profiling/MemoryTracker.h"
+#include <barrier>
+#include <thread>
+//======================================
+
+//= NAMESPACES ===============
+using namespace std;
+using namespace Spartan;
+using namespace Spartan::Math;
+//============================
+
+namespace
+{
+    const uint32_t thread_count         = 4;
+    const uint32_t frames_warmup        = 4; // both arenas of every thread have seen a full frame
+    const uint32_t frames_warmup_engine = 120; // game mode has started, lods, streaming and shadow caches have settled
+    const uint32_t frames               = 64;
+    const uint64_t mb                   = 1024 * 1024;
+
+    // nothing else allocates with this tag in the tests
+    const MemoryTag tag = MemoryTag::Importers;
+
+    // the kind of work a frame does, containers grow without reserving so that they reallocate and span blocks
+    uint64_t simulate_frame(const uint32_t seed)
+    {
+        frame_vector<Matrix> transforms;
+        for (uint32_t i = 0; i < 8192; i++)
+        {
+            transforms.push_back(Matrix::CreateTranslation(Vector3(static_cast<float>(i + seed), 0.0f, 0.0f)));
+        }
+
+        frame_unordered_map<uint64_t, uint32_t> indices;
+        frame_unordered_set<uint32_t> visible;
+        for (uint32_t i = 0; i < 4096; i++)
+        {
+            indices[static_cast<uint64_t>(i) * 2654435761ull + seed] = i;
+            if (i % 3 == 0)
+            {
+                visible.insert(i);
+            }
+        }
+
+        return transforms.size() + indices.size() + visible.size();
+    }
+}
+
+TEST(frame_arena_steady_state_frames_dont_allocate)
+{
+    uint32_t frame                  = 0;
+    uint64_t allocations            = 0;
+    uint64_t block_allocations_warm = 0;
+    uint64_t bytes_capacity_warm    = 0;
+    uint64_t bytes_capacity_last    = 0;
+
+    // runs on one thread once all of them have finished the frame, before any of them starts the next one
+    auto on_frame_end = [&]() noexcept
+    {
+        MemoryTracker::Tick();
+        if (frame >= frames_warmup)
+        {
+            allocations         += MemoryTracker::GetStats(MemoryTag::Renderer).allocations_per_frame;
+            bytes_capacity_last  = FrameArena::GetBytesCapacity(); // the arenas of a thread are freed when it exits
+        }
+        else if (frame == frames_warmup - 1)
+        {
+            block_allocations_warm = FrameArena::GetBlockAllocations();
+            bytes_capacity_warm    = FrameArena::GetBytesCapacity();
+        }
+
+        frame++;
+        FrameArena::Tick();
+    };
+    barrier sync(thread_count, on_frame_end);
+
+    atomic<uint64_t> work = 0;
+    vector<thread> threads;
+    for (uint32_t i = 0; i < thread_count; i++)
+    {
+        threads.emplace_back([&, i]()
+        {
+            // only what the frames allocate is attributed to this tag
+            SP_MEMORY_TAG(MemoryTag::Renderer);
+
+            for (uint32_t f = 0; f < frames_warmup + frames; f++)
+            {
+                work += simulate_frame(i * 1000 + f);
+                sync.arrive_and_wait();
+            }
+        });
+    }
+
+    for (thread& thread : threads)
+    {
+        thread.join();
+    }
+
+    CHECK(work.load() != 0);
+    CHECK(block_allocations_warm != 0);
+    CHECK(allocations == 0);
+    CHECK(FrameArena::GetBlockAllocations() == block_allocations_warm);
+    CHECK(bytes_capacity_last == bytes_capacity_warm);
+}
+
+TEST_ENGINE(frame_arena_steady_state_engine_frames_dont_allocate)
+{
+    // world ticking, renderable updates, light binning, culling uploads and physics stepping all run on frame memory
+    tests::load_default_world(DefaultWorld::Objects);
+    Engine::SetFlag(EngineMode::Game, true); // so that physics simulates
+    tests::tick(frames_warmup_engine);
+
+    const MemoryTag tags[] = { MemoryTag::World, MemoryTag::Renderer, MemoryTag::Physics };
+    uint64_t allocations[size(tags)] = {};
+    for (uint32_t frame = 0; frame < frames; frame++)
+    {
+        tests::tick(1); // the tracker computes the rates at the end of the frame
+
+        for (uint32_t i = 0; i < size(tags); i++)
+        {
+            allocations[i] += MemoryTracker::GetStats(tags[i]).allocations_per_frame;
+        }
+    }
+
+    Engine::SetFlag(EngineMode::Game, false);
+
+    for (uint32_t i = 0; i < size(tags); i++)
+    {
+        if (allocations[i] != 0)
+        {
+            tests::report_count(MemoryTracker::GetTagName(tags[i]), allocations[i]);
+        }
+        CHECK(allocations[i] == 0);
+    }
+}
+
+TEST(frame_arena_blocks_are_persistent)
+{
+    // the blocks outlive Engine::Shutdown(), so they must not count towards the tag of whoever grew the arena
+    uint64_t bytes_tag              = MemoryTracker::GetStats(tag).bytes_live;
+    uint64_t bytes_persistent       = MemoryTracker::GetStats(MemoryTag::Persistent).bytes_live;
+    uint64_t bytes_tag_grown        = 0;
+    uint64_t bytes_persistent_grown = 0;
+
+    // a new thread, so that its arenas start out empty
+    thread worker([&]()
+    {
+        SP_MEMORY_TAG(tag);
+        FrameArena::Tick();
+        frame_vector<uint8_t> bytes(3 * mb);
+
+        bytes_tag_grown        = MemoryTracker::GetStats(tag).bytes_live;
+        bytes_persistent_grown = MemoryTracker::GetStats(MemoryTag::Persistent).bytes_live;
+    });
+    worker.join();
+
+    CHECK(bytes_tag_grown == bytes_tag);
+    CHECK(bytes_persistent_grown >= bytes_persistent + 3 * mb);
+
+    // and they are freed when the thread exits
+    CHECK(MemoryTracker::GetStats(MemoryTag::Persistent).bytes_live == bytes_persistent);
+}
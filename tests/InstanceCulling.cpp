@@ -0,0 +1,182 @@
+/*
+Copyright(c) 2016-2024 Panos Karabelas
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+copies of the Software, and to permit persons to whom the Software is furnished
+to do so, subject to the following conditions :
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE AUTHORS OR
+COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+//= INCLUDES =========================
+#include "Test.h"
+#include "Rendering/InstanceCulling.h"
+//====================================
+
+//= NAMESPACES ===============
+using namespace std;
+using namespace Spartan;
+using namespace Spartan::Math;
+using namespace instance_culling;
+//============================
+
+// the view projection is the identity, so the bounds are in ndc and z is reverse-z depth
+
+namespace
+{
+    Bounds box(const float x_min, const float y_min, const float z_min, const float x_max, const float y_max, const float z_max)
+    {
+        return { Vector4(x_min, y_min, z_min, 0.0f), Vector4(x_max, y_max, z_max, 0.0f) };
+    }
+
+    // what the reset dispatch writes before culling
+    DrawIndexedArguments arguments_reset()
+    {
+        DrawIndexedArguments arguments;
+        arguments.index_count   = 36;
+        arguments.index_offset  = 120;
+        arguments.vertex_offset = 24;
+        return arguments;
+    }
+
+    // a depth buffer with a wall at the given depth over its left half, the rest is the far plane
+    vector<float> depth_half_wall(const uint32_t width, const uint32_t height, const float depth)
+    {
+        vector<float> buffer(width * height, 0.0f);
+        for (uint32_t y = 0; y < height; y++)
+        {
+            for (uint32_t x = 0; x < width / 2; x++)
+            {
+                buffer[y * width + x] = depth;
+            }
+        }
+        return buffer;
+    }
+}
+
+TEST(instance_culling_pyramid_is_a_conservative_power_of_two_chain)
+{
+    const uint32_t width  = 100;
+    const uint32_t height = 60;
+    vector<float> depth   = depth_half_wall(width, height, 0.5f);
+    depth[59 * width + 99] = 0.9f; // a near texel which must not survive the reduction
+
+    DepthPyramid pyramid;
+    pyramid.build(depth.data(), width, height);
+
+    CHECK(pyramid.widths[0] == 64 && pyramid.heights[0] == 32);
+    CHECK(pyramid.mips.size() == get_pyramid_mip_count(64, 32));
+    for (uint32_t mip = 1; mip < static_cast<uint32_t>(pyramid.mips.size()); mip++)
+    {
+        CHECK(pyramid.widths[mip] == pyramid.widths[mip - 1] / 2);
+        CHECK(pyramid.heights[mip] == pyramid.heights[mip - 1] / 2);
+    }
+
+    // every texel keeps the farthest depth it covers
+    CHECK(pyramid.load(0, 0, 0) == 0.5f);
+    CHECK(pyramid.load(0, 63, 31) == 0.0f);
+
+    // the chain stops once a side reaches one texel
+    uint32_t mip_last = static_cast<uint32_t>(pyramid.mips.size()) - 1;
+    CHECK(pyramid.widths[mip_last] == 2 && pyramid.heights[mip_last] == 1);
+    CHECK(pyramid.load(mip_last, 0, 0) == 0.5f);
+    CHECK(pyramid.load(mip_last, 1, 0) == 0.0f);
+}
+
+TEST(instance_culling_frustum_compacts_the_survivors)
+{
+    vector<Bounds> bounds =
+    {
+        box(-0.2f, -0.2f,  0.2f,  0.2f,  0.2f,  0.4f), // inside
+        box( 1.5f, -0.2f,  0.2f,  2.0f,  0.2f,  0.4f), // right
+        box(-0.2f,  1.5f,  0.2f,  0.2f,  2.0f,  0.4f), // top
+        box( 0.8f,  0.8f,  0.2f,  1.5f,  1.5f,  0.4f), // crossing a corner
+        box(-0.2f, -0.2f, -0.5f,  0.2f,  0.2f, -0.1f), // beyond the far plane
+        box(-0.2f, -0.2f,  1.2f,  0.2f,  0.2f,  1.5f), // before the near plane
+        box(-2.0f, -2.0f,  0.2f,  2.0f,  2.0f,  0.4f), // larger than the view
+    };
+
+    DrawIndexedArguments arguments = arguments_reset();
+    vector<uint32_t> instances_visible;
+    cull(bounds, Matrix::Identity, nullptr, arguments, instances_visible);
+
+    CHECK(instances_visible == vector<uint32_t>({ 0, 3, 6 }));
+    CHECK(arguments.instance_count == 3);
+    CHECK(arguments.instance_start == instance_offset);
+
+    // the rest of the arguments belong to the reset
+    CHECK(arguments.index_count == 36 && arguments.index_offset == 120 && arguments.vertex_offset == 24);
+}
+
+TEST(instance_culling_hi_z_rejects_only_what_is_behind_the_occluder)
+{
+    const uint32_t width  = 100;
+    const uint32_t height = 60;
+    vector<float> depth   = depth_half_wall(width, height, 0.5f);
+
+    DepthPyramid pyramid;
+    pyramid.build(depth.data(), width, height);
+
+    vector<Bounds> bounds =
+    {
+        box(-0.6f, -0.1f, 0.1f, -0.4f, 0.1f, 0.2f), // behind the wall
+        box(-0.6f, -0.1f, 0.6f, -0.4f, 0.1f, 0.7f), // in front of the wall
+        box(-0.6f, -0.1f, 0.4f, -0.4f, 0.1f, 0.6f), // crossing the wall's depth
+        box( 0.4f, -0.1f, 0.1f,  0.6f, 0.1f, 0.2f), // next to the wall
+        box(-0.1f, -0.1f, 0.1f,  0.1f, 0.1f, 0.2f), // straddling the wall's edge
+        box(-0.9f, -0.9f, 0.1f, -0.1f, 0.9f, 0.2f), // behind the wall, large
+    };
+
+    DrawIndexedArguments arguments = arguments_reset();
+    vector<uint32_t> instances_visible;
+    cull(bounds, Matrix::Identity, &pyramid, arguments, instances_visible);
+
+    CHECK(instances_visible == vector<uint32_t>({ 1, 2, 3, 4 }));
+    CHECK(arguments.instance_count == 4);
+
+    // without the pyramid only the frustum applies
+    cull(bounds, Matrix::Identity, nullptr, arguments, instances_visible);
+    CHECK(arguments.instance_count == static_cast<uint32_t>(bounds.size()));
+}
+
+TEST(instance_culling_arguments_across_thread_groups)
+{
+    // a row of instances spanning several thread groups, every other one is off screen
+    const uint32_t count = thread_group_size * 3 + 7;
+    vector<Bounds> bounds;
+    for (uint32_t i = 0; i < count; i++)
+    {
+        float x = (i % 2 == 0) ? -0.5f : 1.5f;
+        bounds.push_back(box(x, -0.1f, 0.2f, x + 0.1f, 0.1f, 0.3f));
+    }
+
+    DrawIndexedArguments arguments = arguments_reset();
+    vector<uint32_t> instances_visible;
+    cull(bounds, Matrix::Identity, nullptr, arguments, instances_visible);
+
+    CHECK(arguments.instance_count == (count + 1) / 2);
+    CHECK(instances_visible.size() == arguments.instance_count);
+
+    bool compacted = true;
+    for (uint32_t i = 0; i < static_cast<uint32_t>(instances_visible.size()); i++)
+    {
+        compacted &= instances_visible[i] == i * 2;
+    }
+    CHECK(compacted);
+
+    // culling again starts over
+    bounds.resize(1);
+    cull(bounds, Matrix::Identity, nullptr, arguments, instances_visible);
+    CHECK(arguments.instance_count == 1 && instances_visible.size() == 1);
+}
@@ -0,0 +1,279 @@
+/*
+Copyright(c) 2016-2024 Panos Karabelas
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+copies of the Software, and to permit persons to whom the Software is furnished
+to do so, subject to the following conditions :
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE AUTHORS OR
+COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+//= INCLUDES =======================
+#include "Test.h"
+#include "Core/FrameArena.h"
+#include "Core/ThreadPool.h"
+#include "Rendering/LightClusters.h"
+#include <random>
+//==================================
+
+//= NAMESPACES ===============
+using namespace std;
+using namespace Spartan;
+using namespace Spartan::Math;
+//============================
+
+// the camera sits at the origin looking down +z, so world space is view space
+
+namespace
+{
+    const float near_plane  = 0.3f;
+    const float far_plane   = 1000.0f;
+    const Matrix projection = Matrix::CreatePerspectiveFieldOfViewLH(1.0f, 16.0f / 9.0f, far_plane, near_plane); // reverse-z, like the camera
+
+    void build(const vector<LightClusters::LightVolume>& lights)
+    {
+        FrameArena::Tick();
+        LightClusters::Build(Matrix::Identity, projection, near_plane, far_plane, lights);
+    }
+
+    LightClusters::LightVolume point_light(const Vector3& position, const float range, const uint32_t index)
+    {
+        LightClusters::LightVolume light;
+        light.position = position;
+        light.range    = range;
+        light.index    = index;
+        return light;
+    }
+
+    LightClusters::LightVolume spot_light(const Vector3& position, const Vector3& direction, const float range, const float angle, const uint32_t index)
+    {
+        LightClusters::LightVolume light = point_light(position, range, index);
+        light.direction                  = direction.Normalized();
+        light.angle                      = angle;
+        return light;
+    }
+
+    vector<LightClusters::LightVolume> random_lights(const uint32_t count, const uint32_t seed)
+    {
+        mt19937 generator(seed);
+        uniform_real_distribution<float> xy(-40.0f, 40.0f);
+        uniform_real_distribution<float> z(-10.0f, 120.0f);
+        uniform_real_distribution<float> range(0.5f, 12.0f);
+        uniform_real_distribution<float> unit(-1.0f, 1.0f);
+        uniform_real_distribution<float> angle(0.1f, 1.2f);
+
+        vector<LightClusters::LightVolume> lights;
+        for (uint32_t i = 0; i < count; i++)
+        {
+            Vector3 position = Vector3(xy(generator), xy(generator) * 0.5f, z(generator));
+            if (i % 3 == 0)
+            {
+                Vector3 direction = Vector3(unit(generator), unit(generator), unit(generator));
+                direction         = direction.Length() > 0.01f ? direction : Vector3::Forward;
+                lights.push_back(spot_light(position, direction, range(generator), angle(generator), i));
+            }
+            else
+            {
+                lights.push_back(point_light(position, range(generator), i));
+            }
+        }
+        return lights;
+    }
+
+    // the cluster a view space point falls in, the same grid as light.hlsl
+    uint32_t get_cluster(const Vector3& point)
+    {
+        Vector4 clip = Vector4(point, 1.0f) * projection;
+        float ndc_x  = clip.x / clip.w;
+        float ndc_y  = clip.y / clip.w;
+        uint32_t x   = min(static_cast<uint32_t>((ndc_x *  0.5f + 0.5f) * LightClusters::grid_x), LightClusters::grid_x - 1);
+        uint32_t y   = min(static_cast<uint32_t>((ndc_y * -0.5f + 0.5f) * LightClusters::grid_y), LightClusters::grid_y - 1);
+        float slice  = floor(log(point.z / near_plane) / log(far_plane / near_plane) * static_cast<float>(LightClusters::grid_z));
+        uint32_t z   = min(static_cast<uint32_t>(max(slice, 0.0f)), LightClusters::grid_z - 1);
+
+        return (z * LightClusters::grid_y + y) * LightClusters::grid_x + x;
+    }
+
+    bool reaches(const LightClusters::LightVolume& light, const Vector3& point)
+    {
+        Vector3 to_point = point - light.position;
+        float distance   = to_point.Length();
+        if (distance > light.range)
+            return false;
+
+        if (light.angle <= 0.0f || distance < 1e-4f)
+            return true;
+
+        return Vector3::Dot(to_point / distance, light.direction) >= cos(light.angle);
+    }
+
+    bool cluster_contains(const uint32_t cluster, const uint32_t light_index)
+    {
+        const LightClusters::Cluster& range = LightClusters::GetClusters()[cluster];
+        const vector<uint32_t>& indices     = LightClusters::GetIndices();
+        return binary_search(indices.begin() + range.offset, indices.begin() + range.offset + range.count, light_index);
+    }
+}
+
+TEST(light_clusters_empty)
+{
+    build({});
+
+    CHECK(LightClusters::GetClusters().size() == LightClusters::cluster_count);
+    CHECK(LightClusters::GetIndices().empty());
+    for (const LightClusters::Cluster& cluster : LightClusters::GetClusters())
+    {
+        CHECK(cluster.count == 0);
+    }
+    CHECK(!LightClusters::IsLightVisible(0));
+}
+
+TEST(light_clusters_point_light)
+{
+    Vector3 position = Vector3(2.0f, 1.0f, 20.0f);
+    build({ point_light(position, 3.0f, 5) });
+
+    CHECK(LightClusters::IsLightVisible(5));
+    CHECK(!LightClusters::IsLightVisible(4));
+    CHECK(cluster_contains(get_cluster(position), 5));
+    CHECK(cluster_contains(get_cluster(position + Vector3(0.0f, 0.0f, 2.9f)), 5));
+
+    // far from the light, in depth and on screen
+    CHECK(!cluster_contains(get_cluster(Vector3(2.0f, 1.0f, 200.0f)), 5));
+    CHECK(!cluster_contains(get_cluster(Vector3(-20.0f, -8.0f, 20.0f)), 5));
+}
+
+TEST(light_clusters_lights_out_of_view)
+{
+    build({
+        point_light(Vector3(0.0f, 0.0f, -10.0f), 5.0f, 0),  // behind the camera
+        point_light(Vector3(0.0f, 0.0f, 1100.0f), 5.0f, 1), // beyond the far plane
+        point_light(Vector3(0.0f, 0.0f, 10.0f), 5.0f, 2)
+    });
+
+    CHECK(!LightClusters::IsLightVisible(0));
+    CHECK(!LightClusters::IsLightVisible(1));
+    CHECK(LightClusters::IsLightVisible(2));
+}
+
+TEST(light_clusters_spot_light_cone)
+{
+    // a narrow spot light pointing right, the clusters to its left are within its range but not its cone
+    Vector3 position = Vector3(0.0f, 0.0f, 30.0f);
+    build({ spot_light(position, Vector3::Right, 10.0f, 0.3f, 0) });
+
+    CHECK(cluster_contains(get_cluster(position + Vector3(8.0f, 0.0f, 0.0f)), 0));
+    CHECK(!cluster_contains(get_cluster(position + Vector3(-8.0f, 0.0f, 0.0f)), 0));
+}
+
+TEST(light_clusters_lists_are_sorted_and_compact)
+{
+    build(random_lights(500, 1));
+
+    const vector<LightClusters::Cluster>& clusters = LightClusters::GetClusters();
+    const vector<uint32_t>& indices                = LightClusters::GetIndices();
+
+    uint32_t offset_expected = 0;
+    bool sorted              = true;
+    for (const LightClusters::Cluster& cluster : clusters)
+    {
+        CHECK(cluster.offset == offset_expected);
+        offset_expected += cluster.count;
+
+        for (uint32_t i = cluster.offset + 1; i < cluster.offset + cluster.count; i++)
+        {
+            sorted = sorted && indices[i - 1] < indices[i];
+        }
+    }
+    CHECK(offset_expected == indices.size());
+    CHECK(sorted);
+}
+
+TEST(light_clusters_no_missing_lights)
+{
+    // any light which reaches a point has to be in the cluster of that point
+    vector<LightClusters::LightVolume> lights = random_lights(300, 2);
+    build(lights);
+
+    mt19937 generator(3);
+    uniform_real_distribution<float> ndc(-0.999f, 0.999f);
+    uniform_real_distribution<float> depth_t(0.0f, 1.0f);
+    Matrix projection_inverted = projection.Inverted();
+
+    uint32_t missing = 0;
+    uint32_t checked = 0;
+    for (uint32_t i = 0; i < 20000; i++)
+    {
+        Vector3 ray   = Vector3(ndc(generator), ndc(generator), 0.5f) * projection_inverted;
+        float depth   = near_plane * pow(150.0f / near_plane, depth_t(generator));
+        Vector3 point = ray / ray.z * depth;
+
+        uint32_t cluster = get_cluster(point);
+        for (const LightClusters::LightVolume& light : lights)
+        {
+            if (reaches(light, point))
+            {
+                missing += cluster_contains(cluster, light.index) ? 0 : 1;
+                checked++;
+            }
+        }
+    }
+    CHECK(checked > 1000);
+    CHECK(missing == 0);
+}
+
+TEST(light_clusters_deterministic)
+{
+    vector<LightClusters::LightVolume> lights = random_lights(1000, 4);
+    build(lights);
+    vector<LightClusters::Cluster> clusters = LightClusters::GetClusters();
+    vector<uint32_t> indices                = LightClusters::GetIndices();
+
+    // input order
+    shuffle(lights.begin(), lights.end(), mt19937(5));
+    build(lights);
+    CHECK(LightClusters::GetIndices() == indices);
+
+    // thread count
+    ThreadPool::Initialize();
+    build(lights);
+    ThreadPool::Shutdown();
+    CHECK(LightClusters::GetIndices() == indices);
+
+    bool clusters_equal = true;
+    for (uint32_t i = 0; i < LightClusters::cluster_count; i++)
+    {
+        clusters_equal = clusters_equal && LightClusters::GetClusters()[i].offset == clusters[i].offset && LightClusters::GetClusters()[i].count == clusters[i].count;
+    }
+    CHECK(clusters_equal);
+}
+
+BENCHMARK(light_clusters_10k_lights)
+{
+    vector<LightClusters::LightVolume> lights = random_lights(10000, 6);
+
+    tests::measure("build (single thread)", 20, [&lights]() { build(lights); });
+    ThreadPool::Initialize();
+    tests::measure("build (thread pool)", 20, [&lights]() { build(lights); });
+    ThreadPool::Shutdown();
+
+    uint32_t visible = 0;
+    for (const LightClusters::LightVolume& light : lights)
+    {
+        visible += LightClusters::IsLightVisible(light.index) ? 1 : 0;
+    }
+    tests::report_count("lights visible", visible);
+    tests::report_count("indices", LightClusters::GetIndices().size());
+    tests::report("indices per cluster", static_cast<double>(LightClusters::GetIndices().size()) / LightClusters::cluster_count, "");
+}
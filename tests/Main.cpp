@@ -0,0 +1,164 @@
+/*
+Copyright(c) 2016-2024 Panos Karabelas
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+copies of the Software, and to permit persons to whom the Software is furnished
+to do so, subject to the following conditions :
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE AUTHORS OR
+COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+//= INCLUDES ====================
+#include "Test.h"
+#include "Core/Engine.h"
+#include "Core/ProgressTracker.h"
+#include "Core/Window.h"
+#include <cstdio>
+#include <string>
+#include <algorithm>
+//===============================
+
+//= NAMESPACES ===============
+using namespace std;
+using namespace Spartan;
+//============================
+
+namespace
+{
+    uint32_t failure_count = 0;
+}
+
+namespace tests
+{
+    vector<Case>& get_cases()
+    {
+        static vector<Case> cases;
+        return cases;
+    }
+
+    void fail(const char* expression, const char* file, const int line)
+    {
+        printf("    failed: %s (%s:%d)\n", expression, file, line);
+        failure_count++;
+    }
+
+    void report(const char* label, const double value, const char* unit)
+    {
+        printf("    %-48s %12.4f %s\n", label, value, unit);
+    }
+
+    void report_count(const char* label, const uint64_t count)
+    {
+        printf("    %-48s %12llu\n", label, static_cast<unsigned long long>(count));
+    }
+
+    void tick(const uint32_t frame_count)
+    {
+        for (uint32_t i = 0; i < frame_count && !Window::WantsToClose(); i++)
+        {
+            Engine::Tick();
+        }
+    }
+
+    void load_default_world(const DefaultWorld world)
+    {
+        World::LoadDefaultWorld(world);
+
+        // the world loads on the thread pool, keep the engine ticking so that the renderer picks it up
+        do
+        {
+            tick(1);
+        } while (ProgressTracker::IsLoading() && !Window::WantsToClose());
+
+        // let resolving, streaming and the first frames of temporal effects settle
+        tick(60);
+    }
+}
+
+int main(int argc, char** argv)
+{
+    vector<string> args(argv, argv + argc);
+
+    bool run_benchmarks = false;
+    bool run_engine     = false;
+    string filter;
+    for (uint32_t i = 1; i < static_cast<uint32_t>(args.size()); i++)
+    {
+        if (args[i] == "-benchmark")
+        {
+            run_benchmarks = true;
+        }
+        else if (args[i] == "-engine")
+        {
+            run_engine = true;
+        }
+        else if (args[i] == "-filter" && i + 1 < static_cast<uint32_t>(args.size()))
+        {
+            filter = args[++i];
+        }
+    }
+
+    // pick the cases to run
+    vector<tests::Case> cases;
+    bool needs_engine = false;
+    for (const tests::Case& test_case : tests::get_cases())
+    {
+        if ((test_case.kind == tests::Kind::Benchmark) != run_benchmarks)
+            continue;
+
+        if (test_case.needs_engine && !run_engine)
+            continue;
+
+        if (!filter.empty() && string(test_case.name).find(filter) == string::npos)
+            continue;
+
+        cases.push_back(test_case);
+        needs_engine = needs_engine || test_case.needs_engine;
+    }
+
+    // unit tests run first, before the engine changes any global state
+    stable_sort(cases.begin(), cases.end(), [](const tests::Case& a, const tests::Case& b)
+    {
+        return !a.needs_engine && b.needs_engine;
+    });
+
+    bool engine_initialized = false;
+    uint32_t failed_cases   = 0;
+    for (const tests::Case& test_case : cases)
+    {
+        if (test_case.needs_engine && !engine_initialized)
+        {
+            Engine::Initialize(args);
+            Engine::SetFlag(EngineMode::Editor, false); // the renderer presents on its own
+            engine_initialized = true;
+        }
+
+        printf("%s\n", test_case.name);
+        uint32_t failures_before = failure_count;
+        test_case.function();
+        if (failure_count != failures_before)
+        {
+            failed_cases++;
+        }
+    }
+
+    if (engine_initialized)
+    {
+        Engine::Shutdown();
+    }
+
+    printf("%u of %u passed\n", static_cast<uint32_t>(cases.size()) - failed_cases, static_cast<uint32_t>(cases.size()));
+
+    return failed_cases == 0 ? 0 : 1;
+}
@@ -0,0 +1,100 @@
+/*
+Copyright(c) 2016-2024 Panos Karabelas
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+copies of the Software, and to permit persons to whom the Software is furnished
+to do so, subject to the following conditions :
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE AUTHORS OR
+COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+//= INCLUDES =======================
+#include "Test.h"
+#include "Profiling/MemoryTracker.h"
+//==================================
+
+//= NAMESPACES =====
+using namespace std;
+using namespace Spartan;
+//==================
+
+namespace
+{
+    // nothing else allocates with this tag in the tests
+    const MemoryTag tag = MemoryTag::Importers;
+    const uint64_t mb   = 1024 * 1024;
+}
+
+TEST(memory_budget_is_checked_against_live_bytes)
+{
+    uint64_t bytes_live = MemoryTracker::GetStats(tag).bytes_live;
+    MemoryTracker::SetBudget(tag, bytes_live + mb);
+    CHECK(MemoryTracker::GetStats(tag).budget == bytes_live + mb);
+    CHECK(MemoryTracker::IsWithinBudgets());
+
+    vector<uint8_t>* bytes = nullptr;
+    {
+        SP_MEMORY_TAG(tag);
+        bytes = new vector<uint8_t>(2 * mb);
+    }
+    CHECK(!MemoryTracker::IsWithinBudgets());
+    MemoryTracker::Tick(); // warns once
+
+    // freeing it from another tag still returns the bytes to the tag they were allocated with
+    {
+        SP_MEMORY_TAG(MemoryTag::World);
+        delete bytes;
+    }
+    CHECK(MemoryTracker::GetStats(tag).bytes_live == bytes_live);
+    CHECK(MemoryTracker::IsWithinBudgets());
+    MemoryTracker::Tick();
+
+    // no budget
+    MemoryTracker::SetBudget(tag, 0);
+    {
+        SP_MEMORY_TAG(tag);
+        unique_ptr<uint8_t[]> large = make_unique<uint8_t[]>(4 * mb);
+        CHECK(MemoryTracker::IsWithinBudgets());
+    }
+}
+
+TEST(memory_tracker_sees_heap_allocations)
+{
+    // without this, a tracker that isn't hooked up would make the frame arena tests pass trivially
+    SP_MEMORY_TAG(MemoryTag::Renderer);
+    MemoryTracker::Tick();
+
+    uint64_t* heap = new uint64_t(64);
+    MemoryTracker::Tick();
+    CHECK(MemoryTracker::GetStats(MemoryTag::Renderer).allocations_per_frame == 1);
+    delete heap;
+}
+
+TEST(memory_tracker_huge_allocations_throw)
+{
+    // the size plus the header would wrap around to a tiny block
+    bool thrown = false;
+    try
+    {
+        void* data = ::operator new(SIZE_MAX - 8);
+        ::operator delete(data);
+    }
+    catch (const bad_alloc&)
+    {
+        thrown = true;
+    }
+    CHECK(thrown);
+
+    CHECK(::operator new(SIZE_MAX - 8, nothrow) == nullptr);
+}
@@ -0,0 +1,360 @@
+/*
+Copyright(c) 2016-2024 Panos Karabelas
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+copies of the Software, and to permit persons to whom the Software is furnished
+to do so, subject to the following conditions :
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE AUTHORS OR
+COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+//= INCLUDES =========================
+#include "Test.h"
+#include "Core/ThreadPool.h"
+#include "Math/BoundingBox.h"
+#include "Profiling/Profiler.h"
+#include "Rendering/Renderer.h"
+#include "Rendering/OcclusionBuffer.h"
+#include <cmath>
+#include <random>
+//====================================
+
+//= NAMESPACES ===============
+using namespace std;
+using namespace Spartan;
+using namespace Spartan::Math;
+//============================
+
+// the view projection is the identity in most tests, so positions are in ndc and z is reverse-z depth
+
+namespace
+{
+    struct Shape
+    {
+        vector<Vector3> positions;
+        vector<uint32_t> indices;
+
+        OcclusionBuffer::Occluder occluder(const Matrix& transform = Matrix::Identity) const
+        {
+            return { &positions, &indices, transform };
+        }
+    };
+
+    Shape quad(const float x_min, const float y_min, const float x_max, const float y_max, const float z_left, const float z_right)
+    {
+        Shape mesh;
+        mesh.positions = { Vector3(x_min, y_min, z_left), Vector3(x_max, y_min, z_right), Vector3(x_max, y_max, z_right), Vector3(x_min, y_max, z_left) };
+        mesh.indices   = { 0, 1, 2, 0, 2, 3 };
+        return mesh;
+    }
+
+    Shape disc(const float radius, const float z, const uint32_t segments)
+    {
+        Shape mesh;
+        mesh.positions.emplace_back(0.0f, 0.0f, z);
+        for (uint32_t i = 0; i < segments; i++)
+        {
+            float angle = 2.0f * Math::Helper::PI * static_cast<float>(i) / static_cast<float>(segments);
+            mesh.positions.emplace_back(radius * cos(angle), radius * sin(angle), z);
+            mesh.indices.insert(mesh.indices.end(), { 0, 1 + i, 1 + (i + 1) % segments });
+        }
+        return mesh;
+    }
+
+    // the ndc position of a pixel center
+    Vector2 pixel_center(const uint32_t x, const uint32_t y)
+    {
+        return Vector2(
+            (static_cast<float>(x) + 0.5f) / static_cast<float>(OcclusionBuffer::width)  *  2.0f - 1.0f,
+            (static_cast<float>(y) + 0.5f) / static_cast<float>(OcclusionBuffer::height) * -2.0f + 1.0f
+        );
+    }
+
+    vector<float> read_depth()
+    {
+        vector<float> depth;
+        depth.reserve(OcclusionBuffer::width * OcclusionBuffer::height);
+        for (uint32_t y = 0; y < OcclusionBuffer::height; y++)
+        {
+            for (uint32_t x = 0; x < OcclusionBuffer::width; x++)
+            {
+                depth.push_back(OcclusionBuffer::GetDepth(x, y));
+            }
+        }
+        return depth;
+    }
+}
+
+TEST(occlusion_buffer_empty)
+{
+    OcclusionBuffer::Rasterize(Matrix::Identity, vector<OcclusionBuffer::Occluder>());
+
+    CHECK(OcclusionBuffer::GetTriangleCount() == 0);
+    CHECK(OcclusionBuffer::IsVisible(BoundingBox(Vector3(-0.1f, -0.1f, 0.1f), Vector3(0.1f, 0.1f, 0.2f))));
+}
+
+TEST(occlusion_buffer_box_behind_and_in_front)
+{
+    Shape wall = quad(-0.5f, -0.5f, 0.5f, 0.5f, 0.5f, 0.5f);
+    OcclusionBuffer::Rasterize(Matrix::Identity, { wall.occluder() });
+
+    CHECK(OcclusionBuffer::GetTriangleCount() == 2);
+    CHECK(!OcclusionBuffer::IsVisible(BoundingBox(Vector3(-0.25f, -0.25f, 0.1f), Vector3(0.25f, 0.25f, 0.2f))));
+    CHECK(OcclusionBuffer::IsVisible(BoundingBox(Vector3(-0.25f, -0.25f, 0.6f), Vector3(0.25f, 0.25f, 0.7f))));
+
+    // crossing the occluder's depth
+    CHECK(OcclusionBuffer::IsVisible(BoundingBox(Vector3(-0.25f, -0.25f, 0.4f), Vector3(0.25f, 0.25f, 0.6f))));
+}
+
+TEST(occlusion_buffer_box_past_silhouette)
+{
+    Shape wall = quad(-0.5f, -0.5f, 0.5f, 0.5f, 0.5f, 0.5f);
+    OcclusionBuffer::Rasterize(Matrix::Identity, { wall.occluder() });
+
+    // half in, half out
+    CHECK(OcclusionBuffer::IsVisible(BoundingBox(Vector3(0.4f, -0.1f, 0.1f), Vector3(0.6f, 0.1f, 0.2f))));
+
+    // a thin box right next to the edge, a couple of pixels wide
+    float pixel = 2.0f / static_cast<float>(OcclusionBuffer::width);
+    CHECK(OcclusionBuffer::IsVisible(BoundingBox(Vector3(0.5f + pixel, -0.1f, 0.1f), Vector3(0.5f + pixel * 2.0f, 0.1f, 0.2f))));
+    CHECK(OcclusionBuffer::IsVisible(BoundingBox(Vector3(-0.1f, 0.5f + pixel, 0.1f), Vector3(0.1f, 0.5f + pixel * 2.0f, 0.2f))));
+}
+
+TEST(occlusion_buffer_outside_frustum)
+{
+    OcclusionBuffer::Rasterize(Matrix::Identity, vector<OcclusionBuffer::Occluder>());
+
+    CHECK(!OcclusionBuffer::IsVisible(BoundingBox(Vector3(1.5f, -0.1f, 0.1f), Vector3(2.0f, 0.1f, 0.2f))));
+    CHECK(!OcclusionBuffer::IsVisible(BoundingBox(Vector3(-0.1f, -0.1f, -0.5f), Vector3(0.1f, 0.1f, -0.1f))));
+}
+
+TEST(occlusion_buffer_shared_edges_leave_no_holes)
+{
+    Shape screen = quad(-1.0f, -1.0f, 1.0f, 1.0f, 0.5f, 0.5f);
+    OcclusionBuffer::Rasterize(Matrix::Identity, { screen.occluder() });
+
+    uint32_t holes = 0;
+    for (float depth : read_depth())
+    {
+        holes += depth == 0.0f ? 1 : 0;
+    }
+    CHECK(holes == 0);
+}
+
+TEST(occlusion_buffer_winding_independent)
+{
+    Shape wall = quad(-0.7f, -0.3f, 0.4f, 0.8f, 0.3f, 0.6f);
+    OcclusionBuffer::Rasterize(Matrix::Identity, { wall.occluder() });
+    vector<float> depth_ccw = read_depth();
+
+    for (uint32_t i = 0; i < static_cast<uint32_t>(wall.indices.size()); i += 3)
+    {
+        swap(wall.indices[i + 1], wall.indices[i + 2]);
+    }
+    OcclusionBuffer::Rasterize(Matrix::Identity, { wall.occluder() });
+
+    CHECK(read_depth() == depth_ccw);
+}
+
+TEST(occlusion_buffer_depth_is_conservative)
+{
+    // a plane which gets nearer towards the right, every pixel has to keep the farthest depth the plane has over it
+    const float z_left  = 0.2f;
+    const float z_right = 0.8f;
+    Shape slope = quad(-1.0f, -1.0f, 1.0f, 1.0f, z_left, z_right);
+    OcclusionBuffer::Rasterize(Matrix::Identity, { slope.occluder() });
+
+    const float z_per_pixel = (z_right - z_left) / static_cast<float>(OcclusionBuffer::width);
+    uint32_t too_near       = 0;
+    uint32_t too_far        = 0;
+    for (uint32_t y = 0; y < OcclusionBuffer::height; y++)
+    {
+        for (uint32_t x = 0; x < OcclusionBuffer::width; x++)
+        {
+            float depth          = OcclusionBuffer::GetDepth(x, y);
+            float depth_farthest = z_left + z_per_pixel * static_cast<float>(x); // the left edge of the pixel
+            too_near            += depth > depth_farthest + 1e-5f ? 1 : 0;
+            too_far             += depth < depth_farthest - z_per_pixel ? 1 : 0;
+        }
+    }
+    CHECK(too_near == 0);
+    CHECK(too_far == 0);
+}
+
+TEST(occlusion_buffer_stays_within_silhouette)
+{
+    // the chords of a tessellated disc are inside its circle, so no pixel center outside the circle may be covered
+    const float radius = 0.5f;
+    Shape round         = disc(radius, 0.5f, 1024);
+    CHECK(round.indices.size() > 3 * 512); // above what occluders used to be simplified to
+    OcclusionBuffer::Rasterize(Matrix::Identity, { round.occluder() });
+
+    uint32_t outside_covered = 0;
+    uint32_t inside_empty    = 0;
+    for (uint32_t y = 0; y < OcclusionBuffer::height; y++)
+    {
+        for (uint32_t x = 0; x < OcclusionBuffer::width; x++)
+        {
+            Vector2 center = pixel_center(x, y);
+            float distance = sqrt(center.x * center.x + center.y * center.y);
+            float depth    = OcclusionBuffer::GetDepth(x, y);
+
+            outside_covered += (distance > radius && depth != 0.0f) ? 1 : 0;
+            inside_empty    += (distance < radius * 0.95f && depth == 0.0f) ? 1 : 0;
+        }
+    }
+    CHECK(outside_covered == 0);
+    CHECK(inside_empty == 0);
+}
+
+TEST(occlusion_buffer_near_plane_triangles_are_dropped)
+{
+    // reverse-z, anything with z > w is in front of the near plane
+    Shape wall = quad(-0.5f, -0.5f, 0.5f, 0.5f, 1.5f, 1.5f);
+    OcclusionBuffer::Rasterize(Matrix::Identity, { wall.occluder() });
+
+    CHECK(OcclusionBuffer::GetTriangleCount() == 0);
+    CHECK(OcclusionBuffer::IsVisible(BoundingBox(Vector3(-0.1f, -0.1f, 0.1f), Vector3(0.1f, 0.1f, 0.2f))));
+}
+
+TEST(occlusion_buffer_perspective)
+{
+    Matrix view            = Matrix::CreateLookAtLH(Vector3(0.0f, 0.0f, -10.0f), Vector3::Zero, Vector3::Up);
+    Matrix projection      = Matrix::CreatePerspectiveFieldOfViewLH(1.0f, 320.0f / 192.0f, 1000.0f, 0.1f); // reverse-z
+    Matrix view_projection = view * projection;
+
+    Shape wall = quad(-2.0f, -2.0f, 2.0f, 2.0f, 0.0f, 0.0f);
+    OcclusionBuffer::Rasterize(view_projection, { wall.occluder() });
+
+    CHECK(!OcclusionBuffer::IsVisible(BoundingBox(Vector3(-1.0f, -1.0f, 5.0f), Vector3(1.0f, 1.0f, 6.0f))));
+    CHECK(OcclusionBuffer::IsVisible(BoundingBox(Vector3(-1.0f, -1.0f, -6.0f), Vector3(1.0f, 1.0f, -5.0f))));
+
+    // a box behind the wall but larger than it on screen
+    CHECK(OcclusionBuffer::IsVisible(BoundingBox(Vector3(-4.0f, -1.0f, 5.0f), Vector3(4.0f, 1.0f, 6.0f))));
+
+    // a box around the camera
+    CHECK(OcclusionBuffer::IsVisible(BoundingBox(Vector3(-1.0f, -1.0f, -11.0f), Vector3(1.0f, 1.0f, -9.0f))));
+}
+
+TEST(occlusion_buffer_thread_count_independent)
+{
+    mt19937 generator(7);
+    uniform_real_distribution<float> position(-1.0f, 1.0f);
+    uniform_real_distribution<float> depth(0.05f, 0.95f);
+
+    vector<Shape> meshes(64);
+    for (Shape& mesh : meshes)
+    {
+        mesh.positions = { Vector3(position(generator), position(generator), depth(generator)), Vector3(position(generator), position(generator), depth(generator)), Vector3(position(generator), position(generator), depth(generator)) };
+        mesh.indices   = { 0, 1, 2 };
+    }
+
+    vector<OcclusionBuffer::Occluder> occluders;
+    for (const Shape& mesh : meshes)
+    {
+        occluders.push_back(mesh.occluder());
+    }
+
+    OcclusionBuffer::Rasterize(Matrix::Identity, occluders);
+    vector<float> depth_serial = read_depth();
+
+    ThreadPool::Initialize();
+    OcclusionBuffer::Rasterize(Matrix::Identity, occluders);
+    vector<float> depth_parallel = read_depth();
+    ThreadPool::Shutdown();
+
+    CHECK(depth_parallel == depth_serial);
+}
+
+BENCHMARK(occlusion_buffer_synthetic)
+{
+    // a street of building blocks seen from ground level, plus a dense occluder and a lot of small boxes to test
+    Matrix view            = Matrix::CreateLookAtLH(Vector3(0.0f, 2.0f, -50.0f), Vector3(0.0f, 2.0f, 0.0f), Vector3::Up);
+    Matrix projection      = Matrix::CreatePerspectiveFieldOfViewLH(1.0f, 16.0f / 9.0f, 1000.0f, 0.1f);
+    Matrix view_projection = view * projection;
+
+    // every wall is the same quad, placed with its transform
+    Shape wall_left  = quad(-30.0f, 0.0f, -5.0f, 20.0f, 0.0f, 0.0f);
+    Shape wall_right = quad(5.0f,   0.0f, 30.0f, 20.0f, 0.0f, 0.0f);
+    Shape round      = disc(4.0f, 0.0f, 4000);
+
+    vector<OcclusionBuffer::Occluder> occluders;
+    for (uint32_t i = 0; i < 16; i++)
+    {
+        Matrix transform = Matrix::CreateTranslation(Vector3(0.0f, 0.0f, -40.0f + 10.0f * static_cast<float>(i)));
+        occluders.push_back(wall_left.occluder(transform));
+        occluders.push_back(wall_right.occluder(transform));
+    }
+    occluders.push_back(round.occluder(Matrix::CreateTranslation(Vector3(0.0f, 4.0f, -20.0f))));
+
+    mt19937 generator(7);
+    uniform_real_distribution<float> x(-40.0f, 40.0f);
+    uniform_real_distribution<float> z(-30.0f, 120.0f);
+    vector<BoundingBox> boxes;
+    for (uint32_t i = 0; i < 10000; i++)
+    {
+        Vector3 min = Vector3(x(generator), 0.0f, z(generator));
+        boxes.emplace_back(min, min + Vector3(1.0f, 2.0f, 1.0f));
+    }
+
+    ThreadPool::Initialize();
+    tests::measure("rasterize (thread pool)", 200, [&]() { OcclusionBuffer::Rasterize(view_projection, occluders); });
+    ThreadPool::Shutdown();
+    tests::measure("rasterize (single thread)", 200, [&]() { OcclusionBuffer::Rasterize(view_projection, occluders); });
+
+    uint32_t visible = 0;
+    tests::measure("test 10000 boxes", 100, [&]()
+    {
+        visible = 0;
+        for (const BoundingBox& box : boxes)
+        {
+            visible += OcclusionBuffer::IsVisible(box) ? 1 : 0;
+        }
+    });
+    tests::report_count("triangles", OcclusionBuffer::GetTriangleCount());
+    tests::report_count("boxes visible", visible);
+}
+
+namespace
+{
+    void benchmark_world(const DefaultWorld world)
+    {
+        tests::load_default_world(world);
+
+        for (float enabled : { 0.0f, 1.0f })
+        {
+            Renderer::SetOption(Renderer_Option::OcclusionCulling, enabled);
+            tests::tick(10);
+
+            printf("  occlusion culling %s\n", enabled != 0.0f ? "on" : "off");
+            tests::measure("frame", 300, []() { tests::tick(1); });
+            tests::report("cpu", Profiler::GetTimeCpuLast(), "ms");
+            tests::report("gpu", Profiler::GetTimeGpuLast(), "ms");
+            tests::report("occlusion", Profiler::m_renderer_time_occlusion_ms, "ms");
+            tests::report_count("occluders", Profiler::m_renderer_occluders);
+            tests::report_count("occluder triangles", Profiler::m_renderer_occluder_triangles);
+            tests::report_count("occluded", Profiler::m_renderer_occluded);
+        }
+    }
+}
+
+BENCHMARK_ENGINE(occlusion_culling_sponza)
+{
+    benchmark_world(DefaultWorld::Sponza);
+}
+
+BENCHMARK_ENGINE(occlusion_culling_bistro)
+{
+    benchmark_world(DefaultWorld::Bistro);
+}
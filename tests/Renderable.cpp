@@ -0,0 +1,221 @@
+/*
+Copyright(c) 2016-2024 Panos Karabelas
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+copies of the Software, and to permit persons to whom the Software is furnished
+to do so, subject to the following conditions :
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE AUTHORS OR
+COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+//= INCLUDES =================================
+#include "Test.h"
+#include "IO/FileStream.h"
+#include "Rendering/Mesh.h"
+#include "Rendering/Geometry.h"
+#include "Rendering/Visibility.h"
+#include "World/Entity.h"
+#include "World/Components/Renderable.h"
+//============================================
+
+//= NAMESPACES ===============
+using namespace std;
+using namespace Spartan;
+using namespace Spartan::Math;
+//============================
+
+namespace
+{
+    const char* file_path   = "test_renderable.bin";
+    const uint32_t sentinel = 0xC0FFEE; // written after the component, reading it back proves the stream stayed aligned
+
+    shared_ptr<Renderable> create_renderable()
+    {
+        return World::CreateEntity()->AddComponent<Renderable>();
+    }
+
+    // generates the lods the way the model importer does and checks where they land in the index buffer
+    void check_lods(const vector<RHI_Vertex_PosTexNorTan>& vertices, vector<uint32_t> indices)
+    {
+        vector<vector<uint32_t>> lods;
+        Mesh::GenerateLods(indices, vertices, lods);
+        CHECK(!lods.empty());
+
+        const vector<uint32_t> lod0  = indices;
+        const vector<MeshLod> ranges = Mesh::AppendLods(indices, lods);
+        CHECK(ranges.size() == lods.size());
+        CHECK(equal(lod0.begin(), lod0.end(), indices.begin())); // the full resolution indices are untouched
+
+        uint32_t index_count_previous = static_cast<uint32_t>(lod0.size());
+        uint32_t index_end_previous   = static_cast<uint32_t>(lod0.size());
+        for (const MeshLod& range : ranges)
+        {
+            // fewer indices than the previous lod, by at least the reduction GenerateLods() asks for
+            CHECK(range.index_count > 0);
+            CHECK(range.index_count % 3 == 0);
+            CHECK(range.index_count <= index_count_previous * 4 / 5);
+
+            // packed right after the previous range and inside the buffer
+            CHECK(range.index_offset == index_end_previous);
+            CHECK(range.index_offset + range.index_count <= indices.size());
+
+            // and only referencing the shared vertices
+            for (uint32_t i = range.index_offset; i < range.index_offset + range.index_count; i++)
+            {
+                CHECK(indices[i] < vertices.size());
+            }
+
+            index_count_previous = range.index_count;
+            index_end_previous   = range.index_offset + range.index_count;
+        }
+        CHECK(index_end_previous == indices.size());
+    }
+}
+
+TEST_ENGINE(renderable_serialization_procedural)
+{
+    for (MeshType type : { MeshType::Cube, MeshType::Quad, MeshType::Grid, MeshType::Sphere, MeshType::Cylinder, MeshType::Cone })
+    {
+        shared_ptr<Renderable> source = create_renderable();
+        source->SetGeometry(type);
+        source->SetFlag(RenderableFlags::CastsShadows, true);
+
+        // two made up lods inside the mesh's index range
+        uint32_t index_count = source->GetIndexCount();
+        source->SetLods({ { 0, (index_count / 6) * 3 }, { 0, (index_count / 12) * 3 } });
+
+        {
+            FileStream stream(file_path, FileStream_Write);
+            source->Serialize(&stream);
+            stream.Write(sentinel);
+        }
+
+        shared_ptr<Renderable> target = create_renderable();
+        {
+            FileStream stream(file_path, FileStream_Read);
+            target->Deserialize(&stream);
+            CHECK(stream.ReadAs<uint32_t>() == sentinel);
+        }
+
+        CHECK(target->HasMesh());
+        CHECK(target->GetIndexOffset()  == source->GetIndexOffset());
+        CHECK(target->GetIndexCount()   == source->GetIndexCount());
+        CHECK(target->GetVertexOffset() == source->GetVertexOffset());
+        CHECK(target->GetVertexCount()  == source->GetVertexCount());
+        CHECK(target->GetBoundingBox(BoundingBoxType::Untransformed) == source->GetBoundingBox(BoundingBoxType::Untransformed));
+        CHECK(target->HasFlag(RenderableFlags::CastsShadows));
+        CHECK(target->GetLodCount() == source->GetLodCount());
+        for (uint32_t lod = 0; lod < min(target->GetLodCount(), source->GetLodCount()); lod++)
+        {
+            source->SetLodIndex(lod);
+            target->SetLodIndex(lod);
+            CHECK(target->GetLodIndexOffset() == source->GetLodIndexOffset());
+            CHECK(target->GetLodIndexCount()  == source->GetLodIndexCount());
+        }
+
+        World::RemoveEntity(source->GetEntity());
+        World::RemoveEntity(target->GetEntity());
+    }
+
+    FileSystem::Delete(file_path);
+}
+
+TEST_ENGINE(renderable_deserialization_without_version)
+{
+    // the layout before the stream had a version, it had no lod ranges
+    shared_ptr<Renderable> source = create_renderable();
+    source->SetGeometry(MeshType::Sphere);
+    {
+        FileStream stream(file_path, FileStream_Write);
+        stream.Write(source->GetIndexOffset());
+        stream.Write(source->GetIndexCount());
+        stream.Write(source->GetVertexOffset());
+        stream.Write(source->GetVertexCount());
+        stream.Write(source->GetBoundingBox(BoundingBoxType::Untransformed));
+        stream.Write(static_cast<uint32_t>(MeshType::Sphere));
+        stream.Write(static_cast<uint32_t>(RenderableFlags::CastsShadows));
+        stream.Write(true); // default material
+        stream.Write(sentinel);
+    }
+
+    shared_ptr<Renderable> target = create_renderable();
+    {
+        FileStream stream(file_path, FileStream_Read);
+        target->Deserialize(&stream);
+        CHECK(stream.ReadAs<uint32_t>() == sentinel);
+    }
+
+    CHECK(target->HasMesh());
+    CHECK(target->GetIndexCount() == source->GetIndexCount());
+    CHECK(target->GetVertexCount() == source->GetVertexCount());
+    CHECK(target->HasFlag(RenderableFlags::CastsShadows));
+    CHECK(target->GetLodCount() == 1);
+
+    World::RemoveEntity(source->GetEntity());
+    World::RemoveEntity(target->GetEntity());
+    FileSystem::Delete(file_path);
+}
+
+TEST(renderable_lods_sphere)
+{
+    vector<RHI_Vertex_PosTexNorTan> vertices;
+    vector<uint32_t> indices;
+    Geometry::CreateSphere(&vertices, &indices, 1.0f, 64, 64);
+    check_lods(vertices, indices);
+}
+
+TEST(renderable_lods_grid)
+{
+    vector<RHI_Vertex_PosTexNorTan> vertices;
+    vector<uint32_t> indices;
+    Geometry::CreateGrid(&vertices, &indices, 64);
+    check_lods(vertices, indices);
+}
+
+TEST(renderable_lod_hysteresis)
+{
+    const uint32_t lod_count  = 4;
+    const float tan_half_fov  = 1.0f;
+    const BoundingBox box     = BoundingBox(Vector3(-1.0f), Vector3(1.0f));
+    const float radius        = box.GetExtents().Length();
+    const float threshold     = visibility::get_lod_threshold(0);
+
+    // the distance at which the screen size equals the handover threshold of lod 0
+    auto distance_at = [&](const float screen_size) { return radius / (screen_size * tan_half_fov); };
+    auto select      = [&](const uint32_t lod, const float screen_size)
+    {
+        return visibility::select_lod(lod, lod_count, box, Vector3(0.0f, 0.0f, -distance_at(screen_size)), tan_half_fov);
+    };
+
+    // moving back and forth across the threshold, inside the band, keeps whichever lod is current
+    for (float scale : { 0.95f, 1.0f, 1.05f, 0.92f, 1.08f, 0.95f })
+    {
+        CHECK(select(0, threshold * scale) == 0);
+        CHECK(select(1, threshold * scale) == 1);
+    }
+
+    // and leaving the band switches once
+    uint32_t lod = select(0, threshold * 0.85f);
+    CHECK(lod == 1);
+    CHECK(select(lod, threshold * 0.95f) == 1);
+    CHECK(select(lod, threshold * 1.05f) == 1);
+    lod = select(lod, threshold * 1.15f);
+    CHECK(lod == 0);
+    CHECK(select(lod, threshold * 0.95f) == 0);
+
+    // far away it goes to the last lod and close up to the first, a single lod never changes
+    CHECK(select(0, threshold / 64.0f) == lod_count - 1);
+    CHECK(select(lod_count - 1, threshold * 4.0f) == 0);
+    CHECK(visibility::select_lod(0, 1, box, Vector3(0.0f, 0.0f, -1000.0f), tan_half_fov) == 0);
+}
@@ -0,0 +1,89 @@
+/*
+Copyright(c) 2016-2024 Panos Karabelas
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+copies of the Software, and to permit persons to whom the Software is furnished
+to do so, subject to the following conditions :
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE AUTHORS OR
+COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+//= INCLUDES =================================
+#include "Test.h"
+#include "Core/FrameArena.h"
+#include "Rendering/Renderer.h"
+#include "World/Entity.h"
+#include "World/Components/Renderable.h"
+//============================================
+
+//= NAMESPACES ===============
+using namespace std;
+using namespace Spartan;
+using namespace Spartan::Math;
+//============================
+
+namespace
+{
+    shared_ptr<Entity> create_cube(const uint32_t index)
+    {
+        shared_ptr<Entity> entity = World::CreateEntity();
+        entity->SetPosition(Vector3(static_cast<float>(index % 500) * 2.0f, 0.0f, static_cast<float>(index / 500) * 2.0f));
+        entity->AddComponent<Renderable>()->SetGeometry(MeshType::Cube);
+        return entity;
+    }
+}
+
+BENCHMARK_ENGINE(renderer_update_entities_200k)
+{
+    const uint32_t entity_count    = 200000;
+    const uint32_t added_per_frame = 1000;
+    const uint32_t frame_count     = 20;
+
+    World::New();
+    for (uint32_t i = 0; i < entity_count; i++)
+    {
+        create_cube(i);
+    }
+    tests::tick(2); // the world registers them with the renderer
+
+    // 1,000 new entities a frame, registered the way the world does it, then a frame so that the arenas reset
+    double ms_update = 0.0;
+    for (uint32_t frame = 0; frame < frame_count; frame++)
+    {
+        frame_vector<shared_ptr<Entity>> changed;
+        frame_vector<uint64_t> removed;
+        changed.reserve(added_per_frame);
+        for (uint32_t i = 0; i < added_per_frame; i++)
+        {
+            changed.emplace_back(create_cube(entity_count + frame * added_per_frame + i));
+        }
+
+        Stopwatch stopwatch;
+        Renderer::UpdateEntities(changed, removed);
+        ms_update += stopwatch.GetElapsedTimeMs();
+
+        tests::tick(1);
+    }
+    tests::report("update 1,000 added entities", ms_update / frame_count, "ms");
+
+    // what every change used to cost, a rebuild from every entity in the world
+    unordered_map<uint64_t, shared_ptr<Entity>> entities = World::GetAllEntities();
+    tests::measure("rebuild from all entities", 3, [&entities]() { Renderer::SetEntities(entities); });
+    tests::report_count("entities", entities.size());
+
+    tests::measure("frame", 10, []() { tests::tick(1); });
+
+    World::New();
+    tests::tick(2);
+}
@@ -0,0 +1,159 @@
+/*
+Copyright(c) 2016-2024 Panos Karabelas
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+copies of the Software, and to permit persons to whom the Software is furnished
+to do so, subject to the following conditions :
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE AUTHORS OR
+COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+//= INCLUDES ======================
+#include "Test.h"
+#include "Resource/ResourceCache.h"
+#include "RHI/RHI_Texture2D.h"
+//=================================
+
+//= NAMESPACES =====
+using namespace std;
+using namespace Spartan;
+//==================
+
+namespace
+{
+    // the cache evicts what has been unreferenced for 8 frames, the renderer also needs a frame or two to let go
+    const uint32_t frames_to_evict = 32;
+
+    // what the renderer and the editor create on their own, like shaders compiling in the background, can come and go
+    const uint64_t slack_bytes = 1024 * 1024;
+
+    struct Usage
+    {
+        uint64_t cpu   = 0;
+        uint64_t gpu   = 0;
+        uint32_t count = 0;
+    };
+
+    Usage get_usage()
+    {
+        Usage usage;
+        usage.cpu   = ResourceCache::GetMemoryUsageCpu();
+        usage.gpu   = ResourceCache::GetMemoryUsageGpu();
+        usage.count = ResourceCache::GetResourceCount();
+        return usage;
+    }
+
+    Usage unload_world()
+    {
+        World::New();
+        tests::tick(frames_to_evict);
+        return get_usage();
+    }
+
+    // a small native texture file, which the cache can evict and load again
+    string create_texture_file(const string& name, const uint8_t value)
+    {
+        const uint32_t size = 64;
+
+        vector<RHI_Texture_Slice> data(1);
+        data[0].mips.emplace_back().bytes.assign(size * size * 4, static_cast<byte>(value));
+
+        const string file_path = (filesystem::temp_directory_path() / "spartan_resource_cache" / (name + EXTENSION_TEXTURE)).string();
+        filesystem::create_directories(filesystem::path(file_path).parent_path());
+        filesystem::remove(file_path); // the texture appends its properties to an existing file
+
+        RHI_Texture2D texture(size, size, RHI_Format::R8G8B8A8_Unorm, RHI_Texture_Srv | RHI_Texture_DontCompress, data, name.c_str());
+        texture.SaveToFile(file_path);
+
+        return file_path;
+    }
+
+    bool is_cached(const string& name)
+    {
+        for (const shared_ptr<IResource>& resource : ResourceCache::GetResources())
+        {
+            if (resource->GetObjectName() == name)
+                return true;
+        }
+
+        return false;
+    }
+}
+
+TEST_ENGINE(resource_cache_returns_to_baseline_after_unloading_worlds)
+{
+    Usage baseline = unload_world();
+
+    for (uint32_t cycle = 0; cycle < 3; cycle++)
+    {
+        for (DefaultWorld world : { DefaultWorld::Objects, DefaultWorld::Sponza })
+        {
+            tests::load_default_world(world);
+            Usage loaded = get_usage();
+            CHECK(loaded.count > baseline.count);
+            CHECK(loaded.cpu + loaded.gpu > baseline.cpu + baseline.gpu);
+
+            Usage unloaded = unload_world();
+            CHECK(unloaded.count <= baseline.count);
+            CHECK(unloaded.cpu <= baseline.cpu + slack_bytes);
+            CHECK(unloaded.gpu <= baseline.gpu + slack_bytes);
+        }
+    }
+}
+
+TEST_ENGINE(resource_cache_evicts_least_recently_used_first_and_reloads_by_name)
+{
+    // whatever the previous world left unreferenced is gone, the rest is referenced or can't be loaded again
+    unload_world();
+    uint64_t usage_baseline = ResourceCache::GetMemoryUsageCpu(ResourceType::Texture2d) + ResourceCache::GetMemoryUsageGpu(ResourceType::Texture2d);
+    uint64_t budget         = ResourceCache::GetMemoryBudget(ResourceType::Texture2d);
+    uint32_t evictions      = ResourceCache::GetEvictionCount();
+
+    const array<string, 3> names = { "lru_oldest", "lru_middle", "lru_newest" };
+    array<shared_ptr<RHI_Texture2D>, 3> textures;
+    for (uint32_t i = 0; i < names.size(); i++)
+    {
+        textures[i] = ResourceCache::Load<RHI_Texture2D>(create_texture_file(names[i], static_cast<uint8_t>(i * 100)), RHI_Texture_Srv | RHI_Texture_DontCompress);
+        CHECK(textures[i] != nullptr);
+    }
+    if (!textures[0] || !textures[1] || !textures[2])
+        return;
+
+    uint64_t texture_size = textures[0]->GetMemoryUsageCpu() + textures[0]->GetMemoryUsageGpu();
+    CHECK(texture_size != 0);
+
+    // let go of them a frame apart, oldest first
+    for (shared_ptr<RHI_Texture2D>& texture : textures)
+    {
+        texture = nullptr;
+        tests::tick(1);
+    }
+
+    // room for two of the three, so exactly the least recently used one has to go
+    ResourceCache::SetMemoryBudget(ResourceType::Texture2d, usage_baseline + 2 * texture_size);
+    tests::tick(frames_to_evict);
+    CHECK(ResourceCache::GetEvictionCount() == evictions + 1);
+    CHECK(!is_cached(names[0]));
+    CHECK(is_cached(names[1]));
+    CHECK(is_cached(names[2]));
+
+    // asking for it by name loads it again
+    shared_ptr<RHI_Texture2D> reloaded = ResourceCache::GetByName<RHI_Texture2D>(names[0]);
+    CHECK(reloaded != nullptr);
+    CHECK(is_cached(names[0]));
+    CHECK(reloaded && reloaded->GetWidth() == 64);
+
+    reloaded = nullptr;
+    ResourceCache::SetMemoryBudget(ResourceType::Texture2d, budget);
+}
@@ -0,0 +1,174 @@
+/*
+Copyright(c) 2016-2024 Panos Karabelas
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+copies of the Software, and to permit persons to whom the Software is furnished
+to do so, subject to the following conditions :
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE AUTHORS OR
+COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+//= INCLUDES ==========================
+#include "Test.h"
+#include "Core/ThreadPool.h"
+#include "IO/FileStream.h"
+#include "RHI/RHI_Device.h"
+#include "RHI/RHI_Shader.h"
+#include "Rendering/Renderer.h"
+#include "Resource/ResourceCache.h"
+//=====================================
+
+//= NAMESPACES ===============
+using namespace std;
+using namespace Spartan;
+//============================
+
+namespace
+{
+    string get_cache_file_path(const string& file_name)
+    {
+        return ResourceCache::GetResourceDirectory(ResourceDirectory::Cache) + "\\" + file_name;
+    }
+
+    // lets the renderer create its pipelines and the background shaders finish
+    void settle()
+    {
+        tests::tick(10);
+        RHI_Shader::WaitForCompilation(RHI_ShaderCompilationPriority::Normal);
+
+        // the pre-warm runs on the thread pool once the shaders are done, it uses the pipeline cache
+        for (uint32_t i = 0; i < 600 && ThreadPool::AreTasksRunning(); i++)
+        {
+            tests::tick(1);
+        }
+    }
+
+    // recompiles every renderer shader into new shader objects and reports how long waiting for them took
+    void compile_renderer_shaders(const char* label)
+    {
+        const RHI_ShaderCompilationStats stats_before = RHI_Shader::GetCompilationStats();
+        const Stopwatch stopwatch;
+
+        vector<shared_ptr<RHI_Shader>> shaders;
+        for (const shared_ptr<RHI_Shader>& shader_renderer : Renderer::GetShaders())
+        {
+            if (!shader_renderer)
+                continue;
+
+            shared_ptr<RHI_Shader> shader = make_shared<RHI_Shader>();
+            for (const auto& define : shader_renderer->GetDefines())
+            {
+                shader->AddDefine(define.first, define.second);
+            }
+            shader->Compile(shader_renderer->GetShaderStage(), shader_renderer->GetFilePath(), true, shader_renderer->GetVertexType());
+            shaders.emplace_back(shader);
+        }
+        RHI_Shader::WaitForCompilation(RHI_ShaderCompilationPriority::Normal);
+
+        const double ms                              = stopwatch.GetElapsedTimeMs();
+        const RHI_ShaderCompilationStats stats_after = RHI_Shader::GetCompilationStats();
+
+        printf("  %s\n", label);
+        tests::report("wait for compilation", ms, "ms");
+        tests::report("compilation time (all threads)", stats_after.time_ms - stats_before.time_ms, "ms");
+        tests::report_count("shaders", stats_after.compiled - stats_before.compiled);
+        tests::report_count("cache hits", stats_after.cache_hits - stats_before.cache_hits);
+    }
+}
+
+TEST_ENGINE(pipeline_cache_round_trip)
+{
+    settle();
+
+    const string path_cache   = get_cache_file_path("pipelines.cache");
+    const string path_records = get_cache_file_path("pipelines.rec");
+
+    // save and load back
+    const uint32_t record_count = RHI_Device::PipelineCacheGetRecordCount();
+    const uint64_t size         = RHI_Device::PipelineCacheGetSize();
+    CHECK(record_count > 0);
+    RHI_Device::PipelineCacheSave();
+    CHECK(FileSystem::IsFile(path_cache));
+    CHECK(FileSystem::IsFile(path_records));
+    CHECK(RHI_Device::PipelineCacheLoad());
+    CHECK(RHI_Device::PipelineCacheGetRecordCount() == record_count);
+    CHECK(RHI_Device::PipelineCacheGetSize() == size);
+
+    // keep what was saved, the cases below break it
+    FileSystem::CopyFileFromTo(path_cache, path_cache + ".test");
+    FileSystem::CopyFileFromTo(path_records, path_records + ".test");
+
+    // no cache on disk
+    FileSystem::Delete(path_cache);
+    CHECK(!RHI_Device::PipelineCacheLoad());
+    const uint64_t size_empty = RHI_Device::PipelineCacheGetSize();
+    CHECK(size_empty <= size);
+    CHECK(RHI_Device::PipelineCacheGetRecordCount() == record_count);
+
+    // a cache from another device, the header doesn't match so it starts empty, the records don't depend on the device
+    {
+        vector<unsigned char> data;
+        {
+            FileStream stream(path_cache + ".test", FileStream_Read);
+            stream.Read(&data);
+        }
+
+        // the vulkan header is its size, version, vendor id, device id and the cache uuid, all 32 bit except the uuid
+        CHECK(data.size() >= 32);
+        if (data.size() >= 32)
+        {
+            data[12] ^= 0xFF;
+            FileStream stream(path_cache, FileStream_Write);
+            stream.Write(data);
+        }
+    }
+    CHECK(!RHI_Device::PipelineCacheLoad());
+    CHECK(RHI_Device::PipelineCacheGetSize() == size_empty);
+    CHECK(RHI_Device::PipelineCacheGetRecordCount() == record_count);
+
+    // records from another version of the format are ignored
+    {
+        FileStream stream(path_records, FileStream_Write);
+        stream.Write(static_cast<uint32_t>(0));
+        stream.Write(static_cast<uint32_t>(0));
+        stream.Write(static_cast<uint32_t>(Renderer_Shader::max));
+        stream.Write(static_cast<uint32_t>(1));
+    }
+    RHI_Device::PipelineCacheLoad();
+    CHECK(RHI_Device::PipelineCacheGetRecordCount() == 0);
+
+    // restore
+    FileSystem::CopyFileFromTo(path_cache + ".test", path_cache);
+    FileSystem::CopyFileFromTo(path_records + ".test", path_records);
+    FileSystem::Delete(path_cache + ".test");
+    FileSystem::Delete(path_records + ".test");
+    CHECK(RHI_Device::PipelineCacheLoad());
+    CHECK(RHI_Device::PipelineCacheGetRecordCount() == record_count);
+}
+
+BENCHMARK_ENGINE(shader_startup_cold_vs_warm)
+{
+    settle();
+
+    // cold, as on a first run
+    FileSystem::Delete(ResourceCache::GetResourceDirectory(ResourceDirectory::Cache) + "\\shaders\\");
+    compile_renderer_shaders("cold (no bytecode cache)");
+
+    // warm, everything comes from the cache the cold run just filled
+    compile_renderer_shaders("warm");
+
+    // the pipelines the next startup would pre-warm, and the driver data that makes them cheap
+    tests::report_count("pipeline records", RHI_Device::PipelineCacheGetRecordCount());
+    tests::report_count("pipeline cache bytes", RHI_Device::PipelineCacheGetSize());
+}
@@ -0,0 +1,149 @@
+/*
+Copyright(c) 2016-2024 Panos Karabelas
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+copies of the Software, and to permit persons to whom the Software is furnished
+to do so, subject to the following conditions :
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE AUTHORS OR
+COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+//= INCLUDES ==========================
+#include "Test.h"
+#include "Core/ThreadPool.h"
+#include "RHI/RHI_Vertex.h"
+#include "World/Components/Terrain.h"
+#include <atomic>
+#include <cmath>
+#include <cstring>
+#include <thread>
+//=====================================
+
+//= NAMESPACES ===============
+using namespace std;
+using namespace Spartan;
+using namespace Spartan::Math;
+//============================
+
+namespace
+{
+    const uint32_t size = 256; // height field vertices per side
+
+    // rolling hills above the height scattering starts at, laid out the way Terrain::Generate() lays out its vertices
+    vector<RHI_Vertex_PosTexNorTan> create_hills()
+    {
+        vector<RHI_Vertex_PosTexNorTan> vertices(size * size);
+        for (uint32_t y = 0; y < size; y++)
+        {
+            for (uint32_t x = 0; x < size; x++)
+            {
+                const float height = 12.0f + 6.0f * sin(static_cast<float>(x) * 0.05f) * cos(static_cast<float>(y) * 0.07f);
+                const Vector3 position(static_cast<float>(x) - size * 0.5f, height, static_cast<float>(y) - size * 0.5f);
+                vertices[y * size + x] = RHI_Vertex_PosTexNorTan(position, Vector2::Zero, Vector3::Up, Vector3::Right);
+            }
+        }
+
+        return vertices;
+    }
+
+    vector<Matrix> scatter(const vector<RHI_Vertex_PosTexNorTan>& vertices, const TerrainProp prop, const uint32_t count, const float min_spacing, const uint32_t seed)
+    {
+        vector<Matrix> transforms;
+        Terrain::GenerateTransforms(vertices, size, size, &transforms, count, prop, min_spacing, seed);
+        return transforms;
+    }
+
+    bool identical(const vector<Matrix>& a, const vector<Matrix>& b)
+    {
+        return a.size() == b.size() && (a.empty() || memcmp(a.data(), b.data(), a.size() * sizeof(Matrix)) == 0);
+    }
+
+    // keeps the given number of workers busy, the parallel loops then split their work across the idle ones
+    class WorkerBlocker
+    {
+    public:
+        WorkerBlocker(const uint32_t count)
+        {
+            for (uint32_t i = 0; i < count; i++)
+            {
+                ThreadPool::AddTask([this]() { while (!m_release) { this_thread::yield(); } });
+            }
+
+            while (ThreadPool::GetWorkingThreadCount() < count)
+            {
+                this_thread::yield();
+            }
+        }
+
+        ~WorkerBlocker()
+        {
+            m_release = true;
+            while (ThreadPool::AreTasksRunning())
+            {
+                this_thread::yield();
+            }
+        }
+
+    private:
+        atomic<bool> m_release = false;
+    };
+}
+
+TEST(terrain_scatter_deterministic_across_thread_counts)
+{
+    const vector<RHI_Vertex_PosTexNorTan> vertices = create_hills();
+
+    // serial, the thread pool isn't running so the parallel loops run inline
+    const vector<Matrix> trees  = scatter(vertices, TerrainProp::Tree, 2000, 2.0f, 7);
+    const vector<Matrix> plants = scatter(vertices, TerrainProp::Plant, 20000, 0.0f, 7);
+    CHECK(trees.size() == 2000);
+    CHECK(plants.size() == 20000);
+
+    // the same seed again, and a different seed gives something else
+    CHECK(identical(trees, scatter(vertices, TerrainProp::Tree, 2000, 2.0f, 7)));
+    CHECK(!identical(trees, scatter(vertices, TerrainProp::Tree, 2000, 2.0f, 8)));
+
+    // with every number of idle workers the pool can offer
+    ThreadPool::Initialize();
+    const uint32_t thread_count = ThreadPool::GetThreadCount();
+    for (uint32_t blocked = 0; blocked < thread_count; blocked++)
+    {
+        WorkerBlocker blocker(blocked);
+        CHECK(identical(trees, scatter(vertices, TerrainProp::Tree, 2000, 2.0f, 7)));
+        CHECK(identical(plants, scatter(vertices, TerrainProp::Plant, 20000, 0.0f, 7)));
+    }
+    ThreadPool::Shutdown();
+}
+
+TEST(terrain_scatter_spacing)
+{
+    const vector<RHI_Vertex_PosTexNorTan> vertices = create_hills();
+    const float min_spacing = 2.0f;
+
+    const vector<Matrix> trees = scatter(vertices, TerrainProp::Tree, 2000, min_spacing, 1);
+    CHECK(trees.size() == 2000);
+
+    // no two objects closer than the spacing on the xz plane, brute force
+    float distance_min = numeric_limits<float>::max();
+    for (size_t i = 0; i < trees.size(); i++)
+    {
+        const Vector3 a = trees[i].GetTranslation();
+        for (size_t j = i + 1; j < trees.size(); j++)
+        {
+            const Vector3 b = trees[j].GetTranslation();
+            distance_min    = min(distance_min, Vector2(a.x - b.x, a.z - b.z).Length());
+        }
+    }
+    CHECK(distance_min >= min_spacing);
+}
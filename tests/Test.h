@@ -0,0 +1,107 @@
+/*
+Copyright(c) 2016-2024 Panos Karabelas
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+copies of the Software, and to permit persons to whom the Software is furnished
+to do so, subject to the following conditions :
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE AUTHORS OR
+COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#pragma once
+
+//= INCLUDES =========
+#include "pch.h"
+#include "World/World.h"
+//======================
+
+// a minimal test runner, every test and benchmark registers itself and main runs them
+// - pch.h comes first since the runtime's headers expect it, like in the runtime's own translation units
+// - tests run by default and don't need anything but the runtime
+// - engine tests need Engine::Initialize(), a gpu and the assets of the default worlds, they run with -engine
+// - benchmarks run with -benchmark, engine benchmarks also need -engine
+// - -filter <text> only runs the cases whose name contains the text
+
+namespace tests
+{
+    enum class Kind
+    {
+        Test,
+        Benchmark
+    };
+
+    struct Case
+    {
+        const char* name   = nullptr;
+        void (*function)() = nullptr;
+        Kind kind          = Kind::Test;
+        bool needs_engine  = false;
+    };
+
+    std::vector<Case>& get_cases();
+
+    struct Registrar
+    {
+        Registrar(const char* name, void (*function)(), const Kind kind, const bool needs_engine)
+        {
+            get_cases().push_back({ name, function, kind, needs_engine });
+        }
+    };
+
+    // marks the running case as failed, it keeps running so that all failures are reported
+    void fail(const char* expression, const char* file, const int line);
+
+    // print a line of benchmark output
+    void report(const char* label, const double value, const char* unit);
+    void report_count(const char* label, const uint64_t count);
+
+    // runs the function the given number of times and reports the average in milliseconds
+    template<typename Function>
+    double measure(const char* label, const uint32_t iterations, Function&& function)
+    {
+        Spartan::Stopwatch stopwatch;
+        for (uint32_t i = 0; i < iterations; i++)
+        {
+            function();
+        }
+
+        double ms = static_cast<double>(stopwatch.GetElapsedTimeMs()) / static_cast<double>(iterations);
+        report(label, ms, "ms");
+
+        return ms;
+    }
+
+    // engine helpers, only valid in engine cases
+    void tick(const uint32_t frame_count);
+    void load_default_world(const Spartan::DefaultWorld world); // returns once the world has loaded and rendered a few frames
+}
+
+#define SP_TEST_CASE(name, kind, needs_engine)                                              \
+    static void name();                                                                     \
+    static tests::Registrar registrar_##name(#name, name, tests::Kind::kind, needs_engine); \
+    static void name()
+
+#define TEST(name)             SP_TEST_CASE(name, Test,      false)
+#define TEST_ENGINE(name)      SP_TEST_CASE(name, Test,      true)
+#define BENCHMARK(name)        SP_TEST_CASE(name, Benchmark, false)
+#define BENCHMARK_ENGINE(name) SP_TEST_CASE(name, Benchmark, true)
+
+#define CHECK(expression)                                    \
+    do                                                       \
+    {                                                        \
+        if (!(expression))                                   \
+        {                                                    \
+            tests::fail(#expression, __FILE__, __LINE__);    \
+        }                                                    \
+    } while (false)
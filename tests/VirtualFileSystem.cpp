@@ -0,0 +1,290 @@
+/*
+Copyright(c) 2016-2024 Panos Karabelas
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+copies of the Software, and to permit persons to whom the Software is furnished
+to do so, subject to the following conditions :
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE AUTHORS OR
+COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+//= INCLUDES ====================
+#include "Test.h"
+#include "IO/VirtualFileSystem.h"
+#include <fstream>
+#include <random>
+//===============================
+
+//= NAMESPACES =====
+using namespace std;
+using namespace Spartan;
+//==================
+
+namespace
+{
+    // mirrors the layout in VirtualFileSystem.cpp, so that packs can be corrupted on purpose
+    struct PackHeader
+    {
+        uint32_t magic        = 0;
+        uint32_t version      = 0;
+        uint32_t entry_count  = 0;
+        uint32_t alignment    = 0;
+        uint64_t entry_offset = 0;
+        uint64_t path_offset  = 0;
+    };
+
+    struct PackEntry
+    {
+        uint64_t hash        = 0;
+        uint64_t offset      = 0;
+        uint64_t size_stored = 0;
+        uint64_t size        = 0;
+        uint32_t path_offset = 0;
+        uint32_t path_length = 0;
+        uint32_t compression = 0;
+        uint32_t padding     = 0;
+    };
+
+    const filesystem::path directory_root = filesystem::temp_directory_path() / "spartan_vfs";
+    const filesystem::path directory      = directory_root / "files";
+    const filesystem::path pack_path      = directory_root / "files.pak";
+
+    vector<byte> read_file(const filesystem::path& file_path)
+    {
+        ifstream file(file_path, ios::binary | ios::ate);
+        vector<byte> bytes(static_cast<size_t>(file.tellg()));
+        file.seekg(0);
+        file.read(reinterpret_cast<char*>(bytes.data()), bytes.size());
+        return bytes;
+    }
+
+    void write_file(const filesystem::path& file_path, const vector<byte>& bytes)
+    {
+        filesystem::create_directories(file_path.parent_path());
+        ofstream(file_path, ios::binary).write(reinterpret_cast<const char*>(bytes.data()), bytes.size());
+    }
+
+    vector<byte> random_bytes(const size_t size, const uint32_t seed)
+    {
+        mt19937 generator(seed);
+        vector<byte> bytes(size);
+        for (byte& value : bytes)
+        {
+            value = static_cast<byte>(generator() & 0xFF);
+        }
+        return bytes;
+    }
+
+    // compresses well, with repeats further apart than lz4's 64 KiB window as well as close ones
+    vector<byte> text_bytes(const uint32_t line_count)
+    {
+        string text;
+        for (uint32_t i = 0; i < line_count; i++)
+        {
+            text += "entity " + to_string(i % 997) + " position " + to_string(i * 0.25f) + " material brick_" + to_string(i % 13) + "\n";
+        }
+
+        vector<byte> bytes(text.size());
+        memcpy(bytes.data(), text.data(), text.size());
+        return bytes;
+    }
+
+    // the files of the round trip tests, by path relative to the directory
+    vector<pair<string, vector<byte>>> create_files()
+    {
+        vector<pair<string, vector<byte>>> files =
+        {
+            { "empty.bin",            {} },
+            { "incompressible.bin",   random_bytes(300000, 1) },
+            { "repetitive.bin",       vector<byte>(1024 * 1024, byte{ 'a' }) },
+            { "sub/Text.txt",         text_bytes(20000) },
+            { "sub/deeper/small.txt", text_bytes(1) }
+        };
+
+        filesystem::remove_all(directory_root);
+        for (const auto& [path, bytes] : files)
+        {
+            write_file(directory / path, bytes);
+        }
+
+        return files;
+    }
+
+    // after packing, so that every read below has to come from the pack
+    void remove_loose_files()
+    {
+        filesystem::remove_all(directory);
+    }
+
+    string key(const string& path)
+    {
+        return (directory / path).string();
+    }
+}
+
+TEST(vfs_round_trip)
+{
+    vector<pair<string, vector<byte>>> files = create_files();
+    CHECK(VirtualFileSystem::Pack(directory.string(), pack_path.string(), true));
+    remove_loose_files();
+    CHECK(VirtualFileSystem::Mount(pack_path.string()));
+
+    for (const auto& [path, bytes] : files)
+    {
+        vector<byte> bytes_read;
+        CHECK(VirtualFileSystem::Exists(key(path)));
+        CHECK(VirtualFileSystem::Read(key(path), bytes_read));
+        CHECK(bytes_read == bytes);
+    }
+
+    // lookups ignore case and separators
+    vector<byte> bytes_read;
+    CHECK(VirtualFileSystem::Read((directory / "SUB\\TEXT.TXT").string(), bytes_read) && bytes_read == files[3].second);
+    CHECK(!VirtualFileSystem::Exists(key("missing.bin")));
+
+    // what doesn't shrink is stored as is and can be mapped in place, aligned
+    const byte* data = nullptr;
+    uint64_t size    = 0;
+    CHECK(VirtualFileSystem::Map(key("incompressible.bin"), &data, &size));
+    CHECK(size == files[1].second.size() && memcmp(data, files[1].second.data(), size) == 0);
+    CHECK(reinterpret_cast<uintptr_t>(data) % 64 == 0);
+    CHECK(!VirtualFileSystem::Map(key("repetitive.bin"), &data, &size));
+
+    // the repetitive file and the text make up most of the input
+    CHECK(filesystem::file_size(pack_path) < 600000);
+
+    VirtualFileSystem::Shutdown();
+}
+
+TEST(vfs_round_trip_uncompressed)
+{
+    vector<pair<string, vector<byte>>> files = create_files();
+    CHECK(VirtualFileSystem::Pack(directory.string(), pack_path.string(), false));
+    remove_loose_files();
+    CHECK(VirtualFileSystem::Mount(pack_path.string()));
+
+    for (const auto& [path, bytes] : files)
+    {
+        const byte* data = nullptr;
+        uint64_t size    = 0;
+        CHECK(VirtualFileSystem::Map(key(path), &data, &size));
+        CHECK(size == bytes.size() && (size == 0 || memcmp(data, bytes.data(), size) == 0));
+    }
+
+    VirtualFileSystem::Shutdown();
+}
+
+TEST(vfs_mount_rejects_corrupt_packs)
+{
+    create_files();
+    CHECK(VirtualFileSystem::Pack(directory.string(), pack_path.string(), true));
+    const vector<byte> pack = read_file(pack_path);
+
+    PackHeader header;
+    memcpy(&header, pack.data(), sizeof(header));
+    vector<PackEntry> entries(header.entry_count);
+    memcpy(entries.data(), pack.data() + header.entry_offset, entries.size() * sizeof(PackEntry));
+
+    // the first non empty entry of either kind
+    uint32_t index_stored     = 0;
+    uint32_t index_compressed = 0;
+    for (uint32_t i = 0; i < header.entry_count; i++)
+    {
+        if (entries[i].size != 0 && entries[i].compression == 0)
+            index_stored = i;
+        if (entries[i].compression != 0)
+            index_compressed = i;
+    }
+    CHECK(entries[index_stored].size != 0 && entries[index_compressed].compression != 0);
+
+    auto mounts = [&pack, &header](const function<void(PackHeader&, PackEntry*)>& corrupt)
+    {
+        vector<byte> bytes = pack;
+        PackHeader* header_corrupt = reinterpret_cast<PackHeader*>(bytes.data());
+        corrupt(*header_corrupt, reinterpret_cast<PackEntry*>(bytes.data() + header.entry_offset));
+
+        const filesystem::path path = directory_root / "corrupt.pak";
+        write_file(path, bytes);
+        bool mounted = VirtualFileSystem::Mount(path.string());
+        VirtualFileSystem::Shutdown();
+        return mounted;
+    };
+
+    const uint64_t size = pack.size();
+    CHECK(mounts([](PackHeader&, PackEntry*) {}));
+    CHECK(!mounts([](PackHeader& header, PackEntry*) { header.magic = 0; }));
+    CHECK(!mounts([](PackHeader& header, PackEntry*) { header.entry_count = 0xFFFFFFFF; }));
+    CHECK(!mounts([](PackHeader& header, PackEntry*) { header.entry_offset = numeric_limits<uint64_t>::max() - 7; }));
+    CHECK(!mounts([size](PackHeader& header, PackEntry*) { header.path_offset = size + 1; }));
+    CHECK(!mounts([=](PackHeader&, PackEntry* entries) { entries[index_stored].offset = size; }));
+    CHECK(!mounts([=](PackHeader&, PackEntry* entries) { entries[index_stored].offset = numeric_limits<uint64_t>::max(); }));
+    CHECK(!mounts([=](PackHeader&, PackEntry* entries) { entries[index_compressed].size_stored = size; }));
+    CHECK(!mounts([=](PackHeader&, PackEntry* entries) { entries[index_stored].path_offset = 0xFFFFFFF0; }));
+    CHECK(!mounts([=](PackHeader&, PackEntry* entries) { entries[index_stored].path_length = 0xFFFFFFF0; }));
+    CHECK(!mounts([=](PackHeader&, PackEntry* entries) { entries[index_stored].size++; }));
+    CHECK(!mounts([=](PackHeader&, PackEntry* entries) { entries[index_compressed].size = entries[index_compressed].size_stored * 256; }));
+    CHECK(!mounts([=](PackHeader&, PackEntry* entries) { entries[index_compressed].compression = 7; }));
+}
+
+BENCHMARK(vfs_load_cold_and_warm)
+{
+    // a few hundred text and binary files, like the data directory
+    const uint32_t file_count = 256;
+    filesystem::remove_all(directory_root);
+    vector<string> paths;
+    uint64_t size_total = 0;
+    for (uint32_t i = 0; i < file_count; i++)
+    {
+        vector<byte> bytes = i % 2 ? text_bytes(4000) : random_bytes(200000, i);
+        paths.emplace_back((directory / ("file_" + to_string(i) + ".bin")).string());
+        write_file(paths.back(), bytes);
+        size_total += bytes.size();
+    }
+    tests::report("data", size_total / (1024.0 * 1024.0), "MB");
+
+    auto read_all = [&paths]()
+    {
+        vector<byte> bytes;
+        for (const string& path : paths)
+        {
+            VirtualFileSystem::Read(path, bytes);
+        }
+    };
+
+    tests::measure("loose files", 1, read_all);
+
+    tests::measure("pack", 1, []() { VirtualFileSystem::Pack(directory.string(), pack_path.string(), true); });
+    tests::report("pack size", filesystem::file_size(pack_path) / (1024.0 * 1024.0), "MB");
+
+    // the first reads fault the mapping in, the pack was just written so it's in the os cache either way
+    tests::measure("mount and read, cold", 1, [&read_all]()
+    {
+        VirtualFileSystem::Mount(pack_path.string());
+        read_all();
+    });
+    tests::measure("read, warm", 5, read_all);
+
+    tests::measure("map, warm", 5, [&paths]()
+    {
+        const byte* data = nullptr;
+        uint64_t size    = 0;
+        for (const string& path : paths)
+        {
+            VirtualFileSystem::Map(path, &data, &size);
+        }
+    });
+
+    VirtualFileSystem::Shutdown();
+    filesystem::remove_all(directory_root);
+}
@@ -0,0 +1,142 @@
+/*
+Copyright(c) 2016-2024 Panos Karabelas
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+copies of the Software, and to permit persons to whom the Software is furnished
+to do so, subject to the following conditions :
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE AUTHORS OR
+COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+//= INCLUDES ====================
+#include "Test.h"
+#include "Rendering/Visibility.h"
+#include <random>
+//===============================
+
+//= NAMESPACES ===============
+using namespace std;
+using namespace visibility;
+//============================
+
+namespace
+{
+    // keys the way the visibility pass builds them, a few hundred materials and a mix of everything else
+    vector<DrawRecord> random_records(const uint32_t count, const uint32_t seed)
+    {
+        mt19937 generator(seed);
+        uniform_int_distribution<uint32_t> material(0, 300);
+        uniform_real_distribution<float> distance(0.0f, 1000.0f);
+        bernoulli_distribution transparent(0.1), instanced(0.5), culled(0.3);
+
+        vector<DrawRecord> records(count);
+        for (uint32_t i = 0; i < count; i++)
+        {
+            float distance_squared = distance(generator) * distance(generator);
+            records[i].key         = compute_key(transparent(generator), instanced(generator), culled(generator), material(generator), distance_squared);
+            records[i].index       = i;
+        }
+
+        return records;
+    }
+
+    bool by_key(const DrawRecord& a, const DrawRecord& b)
+    {
+        return a.key < b.key;
+    }
+
+    void check_matches_std(vector<DrawRecord> records)
+    {
+        vector<DrawRecord> expected = records;
+        stable_sort(expected.begin(), expected.end(), by_key);
+
+        vector<DrawRecord> scratch;
+        radix_sort(records, scratch);
+
+        // same keys in the same order, and since both sorts are stable, the same indices as well
+        CHECK(records.size() == expected.size());
+        bool matches = true;
+        for (size_t i = 0; i < min(records.size(), expected.size()); i++)
+        {
+            matches &= records[i].key == expected[i].key && records[i].index == expected[i].index;
+        }
+        CHECK(matches);
+    }
+}
+
+TEST(visibility_radix_sort_matches_std_sort)
+{
+    // draw keys
+    check_matches_std(random_records(10000, 1));
+
+    // arbitrary 64-bit keys, every byte differs so no pass is skipped
+    {
+        mt19937_64 generator(2);
+        vector<DrawRecord> records(10000);
+        for (uint32_t i = 0; i < records.size(); i++)
+        {
+            records[i] = { generator(), i };
+        }
+        check_matches_std(records);
+    }
+
+    // duplicates, a single key and nothing at all
+    {
+        vector<DrawRecord> records(1000);
+        for (uint32_t i = 0; i < records.size(); i++)
+        {
+            records[i] = { static_cast<uint64_t>(i % 7) << 40, i };
+        }
+        check_matches_std(records);
+        check_matches_std({ { 42, 0 } });
+        check_matches_std({});
+    }
+}
+
+TEST(visibility_draw_key_order)
+{
+    // opaque before transparent, instanced before non-instanced, visible before culled
+    CHECK(compute_key(false, true, false, 5, 1.0f) < compute_key(true, true, false, 0, 1.0f));
+    CHECK(compute_key(false, true, false, 5, 1.0f) < compute_key(false, false, false, 0, 1.0f));
+    CHECK(compute_key(false, true, false, 5, 1.0f) < compute_key(false, true, true, 0, 1.0f));
+
+    // opaque: by material, then front to back
+    CHECK(compute_key(false, true, false, 1, 100.0f) < compute_key(false, true, false, 2, 1.0f));
+    CHECK(compute_key(false, true, false, 1, 1.0f) < compute_key(false, true, false, 1, 100.0f));
+
+    // transparent: back to front, then by material
+    CHECK(compute_key(true, true, false, 2, 100.0f) < compute_key(true, true, false, 1, 1.0f));
+    CHECK(compute_key(true, true, false, 1, 1.0f) < compute_key(true, true, false, 2, 1.0f));
+}
+
+BENCHMARK(visibility_radix_sort_100k)
+{
+    const vector<DrawRecord> records = random_records(100000, 3);
+    vector<DrawRecord> sorted;
+    vector<DrawRecord> scratch;
+    sorted.reserve(records.size());
+    scratch.reserve(records.size());
+
+    tests::measure("radix_sort 100K keys", 100, [&]()
+    {
+        sorted.assign(records.begin(), records.end());
+        radix_sort(sorted, scratch);
+    });
+
+    tests::measure("std::sort 100K keys", 100, [&]()
+    {
+        sorted.assign(records.begin(), records.end());
+        sort(sorted.begin(), sorted.end(), by_key);
+    });
+}